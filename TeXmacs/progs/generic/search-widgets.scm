@@ -247,7 +247,8 @@
   (search-show-all)
   (set! search-serial (+ search-serial 1))
   (with-buffer (master-buffer)
-    (cancel-alt-selection "alternate")))
+    (cancel-alt-selection "alternate")
+    (tree-search-done (buffer-tree))))
 
 ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 ;; Replace occurrences
@@ -563,6 +564,7 @@
 
 (tm-define (toolbar-search-end)
   (cancel-alt-selection "alternate")
+  (tree-search-done (buffer-tree))
   (search-show-all)
   (set! search-filter-out? #f)
   (set! toolbar-search-active? #f)
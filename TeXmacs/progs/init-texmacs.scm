@@ -74,6 +74,20 @@
                       '(old-primitive-load new-primitive-load))
       (set! primitive-load new-primitive-load)))
 
+;; Startup timeline: with -debug-bench, the loading time of each file
+;; is reported together with the other startup timings.
+;; Loading times of files include the files loaded by them.
+;; The timer is also stopped when loading fails.
+(if (debug-get "bench")
+    (let ((untimed-primitive-load primitive-load))
+      (set! primitive-load
+            (lambda (filename)
+              (let ((task (string-append "load " filename)))
+                (dynamic-wind
+                  (lambda () (bench-start task))
+                  (lambda () (untimed-primitive-load filename))
+                  (lambda () (bench-cumul task))))))))
+
 ;; TODO: scheme file caching using (set! primitive-load ...) and
 ;; (set! %search-load-path)
 
@@ -636,7 +636,7 @@
 (define (math-correct-tree t)
   (with r (manual-correct-math t)
     (when (!= r t)
-      (tree-set! t r))))
+      (tree-assign-changes t r))))
 
 (define (math-manually-correct-tree t)
   (with r (manual-correct-math t)
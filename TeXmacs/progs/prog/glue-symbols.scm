@@ -66,6 +66,7 @@
 "get-texmacs-home-path"
 "plugin-list"
 "set-fast-environments"
+"set-history-limits"
 "font-exists-in-tt?"
 "eval-system"
 "var-eval-system"
@@ -77,6 +78,8 @@
 "texmacs-time"
 "pretty-time"
 "texmacs-memory"
+"bench-start"
+"bench-cumul"
 "bench-print"
 "bench-print-all"
 "system-wait"
@@ -237,6 +240,7 @@
 "tree-search-sections"
 "tree-search-tree"
 "tree-search-tree-at"
+"tree-search-done"
 "tree-spell"
 "tree-spell-at"
 "tree-spell-selection"
@@ -254,6 +258,7 @@
 "tree-split"
 "tree-join"
 "tree-assign-node"
+"tree-assign-changes"
 "tree-insert-node"
 "tree-remove-node"
 "cpp-tree-correct-node"
@@ -461,6 +466,8 @@
 "texmacs->stm"
 "stm->texmacs"
 "stm-snippet->texmacs"
+"texmacs->binary"
+"binary->texmacs"
 "cpp-texmacs->verbatim"
 "cpp-verbatim-snippet->texmacs"
 "cpp-verbatim->texmacs"
@@ -592,6 +599,16 @@
 "supports-sql?"
 "sql-exec"
 "sql-quote"
+"sql-exec-with"
+"sql-close"
+"sql-begin"
+"sql-commit"
+"sql-rollback"
+"sql-exec-batch"
+"sql-cursor-open"
+"sql-cursor-columns"
+"sql-cursor-fetch"
+"sql-cursor-close"
 "server-start"
 "server-stop"
 "server-read"
@@ -688,6 +705,10 @@
 "buffer-load"
 "buffer-export"
 "buffer-save"
+"buffer-autosave"
+"autosave-cancel"
+"autosave-reap"
+"autosave-recover"
 "tree-import-loaded"
 "tree-import"
 "tree-inclusion"
@@ -195,6 +195,7 @@
               (toggle ("Expand beamer slides" "texmacs->pdf:expand slides"))
 	      (toggle ("Distill encapsulated Pdf files" "texmacs->pdf:distill inclusion"))
 	      (toggle ("Check exported files" "texmacs->pdf:check"))
+	      (toggle ("Compress pages in parallel" "texmacs->pdf:parallel pages"))
 	      (enum ("Pdf version" "texmacs->pdf:version")
 		    ("Default" "default")
 		    ("1.4" "1.4")
@@ -242,6 +243,7 @@
           ("300 s" "300")
           ---
           ("Disable" "0"))
+    (toggle ("Autosave journal" "autosave journal"))
     (enum ("Bibtex command" "bibtex command")
           "bibtex" "biber" "biblatex" "rubibtex" *)))
 
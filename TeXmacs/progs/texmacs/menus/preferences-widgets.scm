@@ -525,6 +525,9 @@
       (aligned (meti (hlist // (text "Check exported Pdf files for correctness"))
         (toggle (set-boolean-preference "texmacs->pdf:check" answer)
                 (get-boolean-preference "texmacs->pdf:check"))))
+      (aligned (meti (hlist // (text "Compress pages in parallel"))
+        (toggle (set-boolean-preference "texmacs->pdf:parallel pages" answer)
+                (get-boolean-preference "texmacs->pdf:parallel pages"))))
       (aligned (item (text "Pdf version number:")
         (enum (set-preference "texmacs->pdf:version" answer)
               '("default" "1.4" "1.5" "1.6" "1.7")
@@ -340,8 +340,12 @@
        (== (most-recent-suffix name) "#")))
 
 (define (autosave-remove name)
+  ;; a writer which is still running would restore the obsolete file
+  (autosave-cancel (url-glue name "~"))
   (when (url-exists? (url-glue name "~"))
     (url-remove (url-glue name "~")))
+  (when (url-exists? (url-glue name "~.journal"))
+    (url-remove (url-glue name "~.journal")))
   (when (url-exists? (url-glue name "#"))
     (url-remove (url-glue name "#"))))
 
@@ -359,17 +363,22 @@
              (when (not (rescue-mode?))
                (set-message `(concat "Warning: " ,vname " not auto-saved")
                             "Auto-save file")))
-            ((buffer-export name aname fm)
-             (when (not (rescue-mode?))
-               (set-message `(concat "Failed to auto-save " ,vname)
-                            "Auto-save file")))
+            ((rescue-mode?)
+             (buffer-export name aname fm))
             (else
-             (when (not (rescue-mode?))
-               (buffer-pretend-autosaved name)
-               (set-temporary-message `(concat "Auto-saved " ,vname)
-                                      "Auto-save file" 2500)))))))
+             (with status (buffer-autosave name aname fm)
+               (cond ((== status "error")
+                      (set-message `(concat "Failed to auto-save " ,vname)
+                                   "Auto-save file"))
+                     ((== status "busy")
+                      ;; the previous autosave is still being written
+                      (noop))
+                     (else
+                      (set-temporary-message `(concat "Auto-saved " ,vname)
+                                             "Auto-save file" 2500)))))))))
 
 (tm-define (autosave-all)
+  (autosave-reap)
   (for-each autosave-buffer (buffer-list)))
 
 (tm-define (autosave-now)
@@ -390,7 +399,8 @@
       (autosave-delayed)))
 
 (define-preferences
-  ("autosave" "120" notify-autosave))
+  ("autosave" "120" notify-autosave)
+  ("autosave journal" "off" noop))
 
 ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 ;; Opening files using external tools
@@ -479,7 +489,7 @@
             (if answ
                 (let* ((autosave-name (autosave-propose name))
                        (format (url-format name))
-                       (doc (tree-import autosave-name format)))
+                       (doc (autosave-recover autosave-name format)))
                   (buffer-set name doc)
                   (load-buffer-open name opts)
                   (buffer-pretend-modified name))
@@ -80,6 +80,7 @@
   ("native postscript" "on" noop)
   ("texmacs->pdf:expand slides" "off" noop)
   ("texmacs->pdf:check" "off" noop)
+  ("texmacs->pdf:parallel pages" "off" noop)
   ("preview command" "default" notify-preview-command)
   ("printing command" (get-default-printing-command) notify-printing-command)
   ("paper type" (get-default-paper-size) notify-paper-type)
@@ -70,6 +70,12 @@
 (define (notify-fast-environments var val)
   (set-fast-environments (== val "on")))
 
+(define (notify-history-limits var val)
+  (let ((steps (string->number (get-preference "undo steps")))
+        (mb (string->number (get-preference "undo memory"))))
+    (set-history-limits (if steps (max steps 1) -1)
+                        (* (if mb (min (max mb 1) 2047) 64) 1024 1024))))
+
 (define (notify-new-page-breaking var val)
   (noop))
 
@@ -84,6 +90,8 @@
   ("language" (get-locale-language) notify-language)
   ("page medium" "paper" (lambda args (noop)))
   ("fast environments" "on" notify-fast-environments)
+  ("undo steps" "unlimited" notify-history-limits)
+  ("undo memory" "64" notify-history-limits)
   ("show full context" "on" (lambda args (noop)))
   ("show table cells" (get-default-show-table-cells) (lambda args (noop)))
   ("show focus" "on" (lambda args (noop)))
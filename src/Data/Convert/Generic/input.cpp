@@ -34,6 +34,10 @@
 #define MODE_XFORMAT  8
 #define MODE_FILE     9
 
+#define FRAMING_OFF   0
+#define FRAMING_PROBE 1
+#define FRAMING_ON    2
+
 /******************************************************************************
 * Universal data input
 ******************************************************************************/
@@ -47,7 +51,9 @@ texmacs_input_rep::texmacs_input_rep (string type2):
   channel (type),
   stack (""),
   ignore_verb (false),
-  docs (tree (DOCUMENT, "")) { bof (); }
+  docs (tree (DOCUMENT, "")),
+  framing (FRAMING_OFF),
+  pending ("") { bof (); }
 
 texmacs_input::texmacs_input (string type):
   rep (tm_new<texmacs_input_rep> (type)) {}
@@ -121,12 +127,7 @@ texmacs_input_rep::put (char c) { // returns true when expecting input
       // Aborting sessions allows completion with a naive read-eval loop
       ignore_verb= true;
     }
-    else if (c == DATA_END) {
-      flush (true);
-      end ();
-      block_done= (stack == "");
-      ignore_verb= (ignore_verb && stack != "");
-    }
+    else if (c == DATA_END) block_done= close_block ();
     else buf << c;
     break;
   case STATUS_ESCAPE:
@@ -151,6 +152,98 @@ texmacs_input_rep::put (char c) { // returns true when expecting input
   return block_done;
 }
 
+bool
+texmacs_input_rep::close_block () {
+  flush (true);
+  end ();
+  ignore_verb= (ignore_verb && stack != "");
+  return stack == "";
+}
+
+/******************************************************************************
+* Framed input
+*******************************************************************************
+* Plugins which are launched with TEXMACS_LINK_FRAMES=1 in their environment
+* may answer with FRAMES_HANDSHAKE as the very first output, after which
+* the output consists of frames (see data_frame in tm_link.cpp).
+* The payload of a FRAME_DATA frame is appended to the buffer of the current
+* block without any scanning for escape characters.  FRAME_BEGIN frames
+* carry "format:" or "channel#" and FRAME_END frames close a block,
+* just like DATA_BEGIN and DATA_END in the escaped protocol.
+* If the output does not start with the handshake, then it is processed
+* as usual, so that old plugins keep working.
+******************************************************************************/
+
+void
+texmacs_input_rep::accept_frames () {
+  framing= FRAMING_PROBE;
+  pending= "";
+}
+
+bool
+texmacs_input_rep::put (string s) { // returns true when expecting input
+  if (framing == FRAMING_PROBE) {
+    string hs= FRAMES_HANDSHAKE;
+    pending << s;
+    if (N(pending) < N(hs) && starts (hs, pending)) return false;
+    s= pending;
+    pending= "";
+    if (starts (s, hs)) {
+      framing= FRAMING_ON;
+      s= s (N(hs), N(s));
+    }
+    else framing= FRAMING_OFF;
+  }
+  if (framing == FRAMING_ON) return put_frames (s);
+  bool block_done= false;
+  int i, n= N(s);
+  for (i=0; i<n; i++)
+    if (put (s[i])) block_done= true;
+  return block_done;
+}
+
+bool
+texmacs_input_rep::put_frames (string s) {
+  if (N(pending) != 0) {
+    pending << s;
+    if (data_frame_length (pending, 0) < 0) return false;
+    s= pending;
+    pending= "";
+  }
+  bool block_done= false;
+  int i= 0, n= N(s), l;
+  while ((l= data_frame_length (s, i)) >= 0) {
+    char type= s[i];
+    i += FRAME_HEADER_SIZE;
+    l -= FRAME_HEADER_SIZE;
+    switch (type) {
+    case FRAME_DATA:
+      if (l == 0) break;
+      if (N(buf) == 0) buf= s (i, i+l);
+      else buf << s (i, i+l);
+      flush ();
+      break;
+    case FRAME_BEGIN:
+      flush (true);
+      if (l > 0 && s[i+l-1] == ':') begin_mode (s (i, i+l-1));
+      else if (l > 0 && s[i+l-1] == '#') begin_channel (s (i, i+l-1));
+      break;
+    case FRAME_END:
+      if (close_block ()) block_done= true;
+      break;
+    case FRAME_ABORT:
+      if (format == "verbatim" && buf == "") ignore_verb= true;
+      break;
+    default:
+      // ignore unknown frames for compatibility with future plugins
+      break;
+    }
+    i += l;
+  }
+  if (i < n) pending= s (i, n);
+  return block_done;
+}
+
 void
 texmacs_input_rep::bof () {
   format = "verbatim";
@@ -160,6 +253,12 @@ texmacs_input_rep::bof () {
 
 void
 texmacs_input_rep::eof () {
+  if (framing == FRAMING_PROBE && N(pending) != 0) {
+    string s= pending;
+    pending= "";
+    framing= FRAMING_OFF;
+    (void) put (s);
+  }
   flush (true);
 }
 
@@ -24,6 +24,8 @@ struct texmacs_input_rep: concrete_struct {
   tree   stack;                 // stack for nested blocks
   bool   ignore_verb;           // hack to enable completion with some plugins
   hashmap<string,tree> docs;    // output for each channel
+  int    framing;               // whether the input consists of frames
+  string pending;               // incomplete frame or handshake
 
   texmacs_input_rep (string type);
   int  get_mode (string s);
@@ -31,6 +33,10 @@ struct texmacs_input_rep: concrete_struct {
   void begin_channel (string s);
   void end ();
   bool put (char c);
+  bool put (string s);
+  bool put_frames (string s);
+  void accept_frames ();
+  bool close_block ();
   void bof ();
   void eof ();
   void write (tree t);
@@ -651,8 +651,12 @@ substitute_latex_previews (tree t, array<tree> a, int &i) {
   if (N(a) <= i);
   else if (is_atomic (t));
   else if (is_tuple (t, "\\latex_preview", 2)) {
-    t[0]= "\\picture-mixed";
-    t[1]= a[i++];
+    // pictures which could not be made are empty
+    if (a[i] != "") {
+      t[0]= "\\picture-mixed";
+      t[1]= a[i];
+    }
+    i++;
   }
   else if (is_tuple (t, "\\def") || is_tuple (t, "\\def*")
       || is_tuple (t, "\\def**") || is_tuple (t, "\\newenvironment**") ||
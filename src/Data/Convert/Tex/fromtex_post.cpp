@@ -17,6 +17,7 @@
 #include "vars.hpp"
 #include "tree_correct.hpp"
 #include "url.hpp"
+#include "tm_timer.hpp"
 
 tree upgrade_tex (tree t);
 extern bool textm_class_flag;
@@ -2407,12 +2408,16 @@ latex_to_tree (tree t0) {
 tree
 latex_document_to_tree (string s, bool as_pic) {
   tree r;
+  bench_start ("latex import");
   command_type ->extend ();
   command_arity->extend ();
   command_def  ->extend ();
   tree t= parse_latex_document (s, true, as_pic);
   if (as_pic) t= latex_fallback_on_pictures (s, t);
+  bench_memory ("latex import");
   r= latex_to_tree (t);
+  bench_memory ("latex import");
+  bench_end ("latex import");
   command_type ->shorten ();
   command_arity->shorten ();
   command_def  ->shorten ();
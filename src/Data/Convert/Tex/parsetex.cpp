@@ -12,6 +12,7 @@
 #include "Tex/convert_tex.hpp"
 #include "converter.hpp"
 #include "wencoding.hpp"
+#include "tm_timer.hpp"
 
 extern bool textm_class_flag;
 
@@ -73,6 +74,8 @@ struct latex_parser {
                           tree opt= tree (CONCAT));
   tree parse_char_code   (string s, int& i);
 
+  void parse_block       (string s, tree& t);
+  void parse_blocks      (string s, tree& t);
   tree parse             (string s, int change);
 };
 
@@ -1630,59 +1633,57 @@ accented_to_Cork (tree t) {
 * Interface
 ******************************************************************************/
 
-tree
-latex_parser::parse (string s, int change) {
-  command_type ->extend ();
-  command_arity->extend ();
-  command_def  ->extend ();
+void
+latex_parser::parse_block (string s, tree& t) {
+  // parse a top-level block and append the result to t
+  int j=0;
+  while (j<N(s)) {
+    int start= j;
+    command_type ("!mode") = "text";
+    command_type ("!em") = "false";
+    tree u= parse (s, j, "", 2);
+    if ((N(t)>0) && (t[N(t)-1]!='\n') && (start==0)) t << "\n";
+    if (is_concat (u)) t << A(u);
+    else t << u;
+    if (j == start) j++;
+  }
+  bench_memory ("latex import");
+}
 
-  // We first cut the string into pieces at strategic places
-  // This reduces the risk that the parser gets confused
-  array<string> a;
-  int i, start=0, cut=0, n= N(s), count= 0;
+static void
+expand_includes (string s, string& out) {
+  // Append s to out, with the bodies of included files spliced in.
+  // Included files are recognized at the same places where parse_blocks
+  // cuts blocks, i.e. at the start of lines, and expanded recursively.
+  // The source is scanned once and the output is only appended to.
+  int i, start= 0, n= N(s);
+  bool line= false;
   for (i=0; i<n; i++)
-    if (s[i]=='\n' || (s[i] == '\\' && test (s, i, "\\nextbib"))) {
+    if (line || s[i]=='\n' || (s[i] == '\\' && test (s, i, "\\nextbib"))) {
+      // the text after an included file starts a new line
+      line= false;
       while ((i<n) && is_space (s[i])) i++;
       if (test (s, i, "%%%%%%%%%% Start TeXmacs macros\n")) {
-        a << s (start, i);
         while ((i<n) && (!test (s, i, "%%%%%%%%%% End TeXmacs macros\n")))
           i++;
         i += 30;
-        start= i;
       }
-      else if (test_macro (s, i, "\\nextbib") || (count == 0 &&
-                (test_env   (s, i, "document")        ||
-                 test_env   (s, i, "abstract")        ||
-                 test_macro (s, i, "\\part")          ||
-                 test_macro (s, i, "\\chapter")       ||
-                 test_macro (s, i, "\\section")       ||
-                 test_macro (s, i, "\\subsection")    ||
-                 test_macro (s, i, "\\subsubsection") ||
-                 test_macro (s, i, "\\paragraph")     ||
-                 test_macro (s, i, "\\subparagraph")  ||
-                 test_macro (s, i, "\\nextbib")       ||
-                 test_macro (s, i, "\\newcommand")    ||
-                 test_macro (s, i, "\\def")))) {
-        a << s (start, i);
-        start= i;
-        while (i < n && test_macro (s, i, "\\nextbib")) {
-          i += 10;
-          a << s (start, i);
-          start= i;
-        }
+      else if (test_macro (s, i, "\\nextbib")) {
+        while (i < n && test_macro (s, i, "\\nextbib")) i += 10;
       }
       else if (test_macro (s, i, "\\input")       ||
                test_macro (s, i, "\\include")     ||
                test_macro (s, i, "\\includeonly") ||
                test_macro (s, i, "\\usepackage")) {
-        cut= i;
+        int cut= i;
         string suffix= ".tex";
         if (test_macro (s, i, "\\usepackage")) suffix= ".sty";
-        while (i<N(s) && s[i] != '{') i++;
+        while (i<n && s[i] != '{') i++;
         int start_name= i+1;
-        while (i<N(s) && s[i] != '}') i++;
+        while (i<n && s[i] != '}') i++;
         array<string> names=
           trim_spaces (tokenize (s (start_name, i), ","));
+        string ins;
         for (int j= 0; j < N(names); j++) {
           string name= names[j];
           if (!ends (name, suffix)) name= name * suffix;
@@ -1691,10 +1692,63 @@ latex_parser::parse (string s, int change) {
           if (!exists (incl) || load_string (incl, body, false));
           else {
             //cout << "Include " << name << " -> " << incl << "\n";
-            s= s (0, cut) * "\n" * body * "\n" * s (i+1, N(s));
-            n= N(s);
+            ins << "\n" << body << "\n";
           }
-          i= cut + 1;
+        }
+        if (N(ins) != 0) {
+          out << s (start, cut);
+          expand_includes (ins, out);
+          start= i+1;
+          line= true;
+        }
+      }
+      else if (s[i] != '\n' && !(s[i] == '\\' && test (s, i, "\\nextbib")))
+        i--;
+    }
+  if (start < n) out << s (start, n);
+}
+
+void
+latex_parser::parse_blocks (string s, tree& t) {
+  // We cut the string into blocks at strategic places and parse each block
+  // as soon as it is complete.  This reduces the risk that the parser gets
+  // confused.  Definitions are shared by all blocks through command_type,
+  // command_arity and command_def.
+  string cur;
+  int i, start=0, n= N(s), count= 0;
+  for (i=0; i<n; i++)
+    if (s[i]=='\n' || (s[i] == '\\' && test (s, i, "\\nextbib"))) {
+      while ((i<n) && is_space (s[i])) i++;
+      if (test (s, i, "%%%%%%%%%% Start TeXmacs macros\n")) {
+        cur << s (start, i);
+        parse_block (cur, t);
+        cur= "";
+        while ((i<n) && (!test (s, i, "%%%%%%%%%% End TeXmacs macros\n")))
+          i++;
+        i += 30;
+        start= i;
+      }
+      else if (test_macro (s, i, "\\nextbib") || (count == 0 &&
+                (test_env   (s, i, "document")        ||
+                 test_env   (s, i, "abstract")        ||
+                 test_macro (s, i, "\\part")          ||
+                 test_macro (s, i, "\\chapter")       ||
+                 test_macro (s, i, "\\section")       ||
+                 test_macro (s, i, "\\subsection")    ||
+                 test_macro (s, i, "\\subsubsection") ||
+                 test_macro (s, i, "\\paragraph")     ||
+                 test_macro (s, i, "\\subparagraph")  ||
+                 test_macro (s, i, "\\nextbib")       ||
+                 test_macro (s, i, "\\newcommand")    ||
+                 test_macro (s, i, "\\def")))) {
+        cur << s (start, i);
+        parse_block (cur, t);
+        cur= "";
+        start= i;
+        while (i < n && test_macro (s, i, "\\nextbib")) {
+          i += 10;
+          parse_block (s (start, i), t);
+          start= i;
         }
       }
       else if (s[i] != '\n' && !(s[i] == '\\' && test (s, i, "\\nextbib")))
@@ -1704,23 +1758,20 @@ latex_parser::parse (string s, int change) {
       count++;
     else if ((i == 0 || s[i-1] != '\\') && s[i] == '}')
       count--;
-  a << s (start, i);
+  if (start < n) cur << s (start, n);
+  parse_block (cur, t);
+}
+
+tree
+latex_parser::parse (string s, int change) {
+  command_type ->extend ();
+  command_arity->extend ();
+  command_def  ->extend ();
 
-  // We now parse each of the pieces
   tree t (CONCAT);
-  for (i=0; i<N(a); i++) {
-    int j=0;
-    while (j<N(a[i])) {
-      int start= j;
-      command_type ("!mode") = "text";
-      command_type ("!em") = "false";
-      tree u= parse (a[i], j, "", 2);
-      if ((N(t)>0) && (t[N(t)-1]!='\n') && (start==0)) t << "\n";
-      if (is_concat (u)) t << A(u);
-      else t << u;
-      if (j == start) j++;
-    }
-  }
+  string src;
+  expand_includes (s, src);
+  parse_blocks (src, t);
 
   if (change > 0) {
     command_type ->merge ();
@@ -0,0 +1,216 @@
+
+/******************************************************************************
+* MODULE     : binarytm.cpp
+* DESCRIPTION: compact binary serialization of TeXmacs trees
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "convert.hpp"
+#include "file.hpp"
+#include "Texmacs/binarytm.hpp"
+
+#define BIN_FLUSH_SIZE 65536
+
+/******************************************************************************
+* Streaming writer
+******************************************************************************/
+
+tm_binary_writer::tm_binary_writer ():
+  buf (BIN_MAGIC), sink (url_none ()), error (false),
+  atoms (-1), labels (-1), nr_atoms (0), nr_labels (0) {}
+
+tm_binary_writer::tm_binary_writer (url sink2):
+  buf (BIN_MAGIC), sink (sink2), error (false),
+  atoms (-1), labels (-1), nr_atoms (0), nr_labels (0)
+{
+  if (save_string (sink, "", false)) error= true;
+}
+
+void
+tm_binary_writer::write_int (unsigned int i) {
+  while (i >= 128) {
+    buf << ((char) ((i & 127) | 128));
+    i >>= 7;
+  }
+  buf << ((char) i);
+}
+
+void
+tm_binary_writer::write_raw (string s) {
+  write_int (N(s));
+  buf << s;
+}
+
+void
+tm_binary_writer::write (tree t) {
+  if (is_atomic (t)) {
+    string s= t->label;
+    int i= atoms[s];
+    if (i >= 0) {
+      buf << ((char) BIN_ATOM);
+      write_int (i);
+    }
+    else {
+      buf << ((char) BIN_NEW_ATOM);
+      write_raw (s);
+      atoms (s)= nr_atoms++;
+    }
+  }
+  else {
+    // generic trees (blackboxes) cannot be serialized
+    tree_label l= is_generic (t)? ERROR: L(t);
+    int i= labels[(int) l], n= is_generic (t)? 0: N(t);
+    if (i >= 0) {
+      buf << ((char) BIN_LABEL);
+      write_int (i);
+    }
+    else {
+      buf << ((char) BIN_NEW_LABEL);
+      write_raw (as_string (l));
+      labels ((int) l)= nr_labels++;
+    }
+    write_int (n);
+    for (int j=0; j<n; j++) write (t[j]);
+  }
+  if (!is_none (sink) && N(buf) >= BIN_FLUSH_SIZE) flush ();
+}
+
+void
+tm_binary_writer::flush () {
+  if (!is_none (sink) && N(buf) > 0) {
+    if (append_string (sink, buf, false)) error= true;
+    buf= "";
+  }
+}
+
+string
+tm_binary_writer::contents () {
+  return buf;
+}
+
+/******************************************************************************
+* Reader
+******************************************************************************/
+
+tm_binary_reader::tm_binary_reader (string buf2):
+  buf (buf2), pos (4), error (!starts (buf2, BIN_MAGIC)) {}
+
+bool
+tm_binary_reader::busy () {
+  return !error && pos < N(buf);
+}
+
+unsigned int
+tm_binary_reader::read_int () {
+  unsigned int r= 0;
+  int shift= 0;
+  while (pos < N(buf) && shift < 32) {
+    unsigned char c= (unsigned char) buf[pos++];
+    r |= ((unsigned int) (c & 127)) << shift;
+    if (c < 128) return r;
+    shift += 7;
+  }
+  error= true;
+  return 0;
+}
+
+string
+tm_binary_reader::read_raw () {
+  unsigned int n= read_int ();
+  if (error || n > (unsigned int) (N(buf) - pos)) {
+    error= true;
+    return "";
+  }
+  pos += n;
+  return buf (pos - n, pos);
+}
+
+tree
+tm_binary_reader::read () {
+  if (pos >= N(buf)) error= true;
+  if (error) return "";
+  char kind= buf[pos++];
+  switch (kind) {
+  case BIN_NEW_ATOM:
+    {
+      string s= read_raw ();
+      atoms << s;
+      return s;
+    }
+  case BIN_ATOM:
+    {
+      unsigned int i= read_int ();
+      if (i >= (unsigned int) N(atoms)) break;
+      return atoms[i];
+    }
+  case BIN_NEW_LABEL:
+  case BIN_LABEL:
+    {
+      tree_label l;
+      if (kind == BIN_NEW_LABEL) {
+        string s= read_raw ();
+        if (error) break;
+        l= make_tree_label (s);
+        labels << l;
+      }
+      else {
+        unsigned int i= read_int ();
+        if (i >= (unsigned int) N(labels)) break;
+        l= labels[i];
+      }
+      unsigned int n= read_int ();
+      // each child takes at least one byte
+      if (error || n > (unsigned int) (N(buf) - pos)) break;
+      tree t (l, (int) n);
+      for (int i=0; i<((int) n); i++) t[i]= read ();
+      return t;
+    }
+  }
+  error= true;
+  return "";
+}
+
+/******************************************************************************
+* Interface
+******************************************************************************/
+
+bool
+is_binary_tree (string s) {
+  return starts (s, BIN_MAGIC);
+}
+
+string
+tree_to_binary (tree t) {
+  tm_binary_writer w;
+  w.write (t);
+  return w.contents ();
+}
+
+tree
+binary_to_tree (string s) {
+  tm_binary_reader r (s);
+  tree t= r.read ();
+  if (r.error) return tree (ERROR, "bad binary tree");
+  return t;
+}
+
+bool
+save_binary_tree (url u, tree t) {
+  tm_binary_writer w (u);
+  w.write (t);
+  w.flush ();
+  return w.error;
+}
+
+bool
+load_binary_tree (url u, tree& t) {
+  string s;
+  if (load_string (u, s, false)) return true;
+  tm_binary_reader r (s);
+  t= r.read ();
+  return r.error;
+}
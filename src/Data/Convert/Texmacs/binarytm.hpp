@@ -0,0 +1,74 @@
+
+/******************************************************************************
+* MODULE     : binarytm.hpp
+* DESCRIPTION: compact binary serialization of TeXmacs trees
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#ifndef BINARYTM_H
+#define BINARYTM_H
+#include "tree.hpp"
+#include "hashmap.hpp"
+#include "url.hpp"
+
+/******************************************************************************
+* The binary format
+*******************************************************************************
+* A stream starts with the magic header "TMB1" and is followed by a sequence
+* of trees, each encoded in prefix order.  Every node starts with one byte:
+*   BIN_NEW_ATOM  <len> <bytes>            atom, appended to the atom table
+*   BIN_ATOM      <index>                  atom from the atom table
+*   BIN_NEW_LABEL <len> <bytes> <arity>    compound, label added to dictionary
+*   BIN_LABEL     <index> <arity>          compound, label from dictionary
+* followed by the arity children for compound nodes.  All integers are
+* unsigned LEB128 varints.  Labels are stored by name, so that binary files
+* remain valid when new primitives are added to the tree_label enumeration.
+* The atom and label tables are shared by all trees in the same stream.
+******************************************************************************/
+
+#define BIN_NEW_ATOM  0
+#define BIN_ATOM      1
+#define BIN_NEW_LABEL 2
+#define BIN_LABEL     3
+
+#define BIN_MAGIC "TMB1"
+
+struct tm_binary_writer {
+  string  buf;                  // not yet flushed bytes
+  url     sink;                 // file to which we stream, or url_none ()
+  bool    error;                // true if streaming to the sink failed
+  hashmap<string,int> atoms;    // indices of already written atoms
+  hashmap<int,int>    labels;   // indices of already written labels
+  int     nr_atoms;             // size of the atom table
+  int     nr_labels;            // size of the label dictionary
+
+  tm_binary_writer ();
+  tm_binary_writer (url sink);
+
+  void write_int (unsigned int i);
+  void write_raw (string s);
+  void write (tree t);
+  void flush ();
+  string contents ();
+};
+
+struct tm_binary_reader {
+  string  buf;                  // the string being read from
+  int     pos;                  // the current position of the reader
+  bool    error;                // true if the input was malformed
+  array<string>     atoms;      // the atom table
+  array<tree_label> labels;     // the label dictionary
+
+  tm_binary_reader (string buf);
+
+  bool busy ();
+  unsigned int read_int ();
+  string read_raw ();
+  tree read ();
+};
+
+#endif // BINARYTM_H
@@ -51,6 +51,13 @@ tree   nonumber_to_eqnumber (tree t);
 tree   eqnumber_to_nonumber (tree t);
 string search_metadata (tree doc, string kind);
 
+/*** Binary ***/
+bool   is_binary_tree (string s);
+string tree_to_binary (tree t);
+tree   binary_to_tree (string s);
+bool   save_binary_tree (url u, tree t);
+bool   load_binary_tree (url u, tree& t);
+
 /*** Scheme ***/
 string scheme_tree_to_string (scheme_tree t);
 string scheme_tree_to_block (scheme_tree t);
@@ -95,6 +95,7 @@ style_invalidate_cache () {
     sd= NULL;
   }
   init_style_data ();
+  drd_heuristic_cache (true);
   remove ("$TEXMACS_HOME_PATH/system/cache" * url_wildcard ("__*"));
 }
 
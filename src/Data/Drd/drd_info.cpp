@@ -15,15 +15,21 @@
 #include "drd_mode.hpp"
 #include "iterator.hpp"
 #include "analyze.hpp"
+#include "convert.hpp"
+#include "file.hpp"
 
 /******************************************************************************
 * Constructors and basic operations
 ******************************************************************************/
 
+int drd_stamp= 0;
+
 drd_info_rep::drd_info_rep (string name2):
-  name (name2), info (tag_info ()), env (UNINIT) {}
+  name (name2), info (tag_info ()), env (UNINIT),
+  table_stamp (-1), miss_stamp (-1), table_misses (0) {}
 drd_info_rep::drd_info_rep (string name2, drd_info base):
-  name (name2), info (tag_info (), base->info), env (UNINIT) {}
+  name (name2), info (tag_info (), base->info), env (UNINIT),
+  table_stamp (-1), miss_stamp (-1), table_misses (0) {}
 drd_info::drd_info (string name):
   rep (tm_new<drd_info_rep> (name)) {}
 drd_info::drd_info (string name, drd_info base):
@@ -49,6 +55,7 @@ drd_info_rep::set_locals (tree t) {
   for (i=0; i<n; i++)
     if (is_func (t[i], ASSOCIATE, 2) && is_atomic (t[i][0]))
       info (make_tree_label (t[i][0]->label))= tag_info (t[i][1]);
+  drd_stamp++;
   return true;
 }
 
@@ -62,33 +69,80 @@ operator << (tm_ostream& out, drd_info drd) {
   return out << "drd [" << drd->name << "]";
 }
 
+/******************************************************************************
+* Flattened tables
+******************************************************************************/
+
+void
+drd_info_rep::freeze_table () {
+  // make a dense copy of the tag information of all levels
+  int i, n= START_EXTENSIONS;
+  rel_hashmap<tree_label,tag_info> h= info;
+  while (!is_nil (h)) {
+    iterator<tree_label> it= iterate (h->item);
+    while (it->busy ()) n= max (n, ((int) it->next ()) + 1);
+    h= h->next;
+  }
+  table= array<tag_info> (n);
+  for (i=0; i<n; i++) table[i]= info[(tree_label) i];
+  table_stamp = drd_stamp;
+  table_misses= 0;
+}
+
+tag_info
+drd_info_rep::lookup_info (tree_label l) {
+  if (table_stamp == drd_stamp) {
+    // labels which were created after building the table
+    int i, n= N(table);
+    table->resize (((int) l) + 1);
+    for (i=n; i<=(int) l; i++) table[i]= info[(tree_label) i];
+    return table[l];
+  }
+  // rebuild the table once the modifications seem to be over
+  if (miss_stamp != drd_stamp) {
+    miss_stamp  = drd_stamp;
+    table_misses= 0;
+  }
+  if ((++table_misses) >= 64) {
+    freeze_table ();
+    return get_info (l);
+  }
+  return info[l];
+}
+
+tag_info&
+drd_info_rep::local_info (tree_label l) {
+  // tag information which can be modified at the current level
+  if (!info->item->contains (l)) drd_stamp++;
+  if (!info->contains (l)) info(l)= copy (info[l]);
+  return info(l);
+}
+
 /******************************************************************************
 * Tag types
 ******************************************************************************/
 
 void
 drd_info_rep::set_type (tree_label l, int tp) {
-  if (info[l]->pi.freeze_type) return;
-  if (!info->contains (l)) info(l)= copy (info[l]);
-  tag_info& ti= info(l);
+  if (get_info (l)->pi.freeze_type) return;
+  tag_info& ti= local_info (l);
   ti->pi.type= tp;
 }
 
 int
 drd_info_rep::get_type (tree_label l) {
-  return info[l]->pi.type;
+  return get_info (l)->pi.type;
 }
 
 void
 drd_info_rep::freeze_type (tree_label l) {
-  if (!info->contains (l)) info(l)= copy (info[l]);
-  tag_info& ti= info(l);
+  tag_info& ti= local_info (l);
   ti->pi.freeze_type= true;
 }
 
 int
 drd_info_rep::get_type (tree t) {
-  return info[L(t)]->pi.type;
+  return get_info (L(t))->pi.type;
 }
 
 /******************************************************************************
@@ -97,9 +151,8 @@ drd_info_rep::get_type (tree t) {
 
 void
 drd_info_rep::set_arity (tree_label l, int arity, int extra, int am, int cm) {
-  if (info[l]->pi.freeze_arity) return;
-  if (!info->contains (l)) info(l)= copy (info[l]);
-  tag_info& ti= info(l);
+  if (get_info (l)->pi.freeze_arity) return;
+  tag_info& ti= local_info (l);
   ti->pi.arity_mode= am;
   ti->pi.child_mode= cm;
   if (am != ARITY_VAR_REPEAT) {
@@ -120,46 +173,45 @@ drd_info_rep::set_arity (tree_label l, int arity, int extra, int am, int cm) {
 
 int
 drd_info_rep::get_arity_mode (tree_label l) {
-  return info[l]->pi.arity_mode;
+  return get_info (l)->pi.arity_mode;
 }
 
 int
 drd_info_rep::get_child_mode (tree_label l) {
-  return info[l]->pi.child_mode;
+  return get_info (l)->pi.child_mode;
 }
 
 int
 drd_info_rep::get_arity_base (tree_label l) {
-  return info[l]->pi.arity_base;
+  return get_info (l)->pi.arity_base;
 }
 
 int
 drd_info_rep::get_arity_extra (tree_label l) {
-  return info[l]->pi.arity_extra;
+  return get_info (l)->pi.arity_extra;
 }
 
 int
 drd_info_rep::get_nr_indices (tree_label l) {
-  return N(info[l]->ci);
+  return N(get_info (l)->ci);
 }
 
 void
 drd_info_rep::freeze_arity (tree_label l) {
-  if (!info->contains (l)) info(l)= copy (info[l]);
-  tag_info& ti= info(l);
+  tag_info& ti= local_info (l);
   ti->pi.freeze_arity= true;
 }
 
 int
 drd_info_rep::get_old_arity (tree_label l) {
-  tag_info ti= info[l];
+  tag_info ti= get_info (l);
   if (ti->pi.arity_mode != ARITY_NORMAL) return -1;
   else return ((int) ti->pi.arity_base) + ((int) ti->pi.arity_extra);
 }
 
 int
 drd_info_rep::get_minimal_arity (tree_label l) {
-  parent_info pi= info[l]->pi;
+  parent_info pi= get_info (l)->pi;
   switch (pi.arity_mode) {
   case ARITY_NORMAL:
     return ((int) pi.arity_base) + ((int) pi.arity_extra);
@@ -173,7 +225,7 @@ drd_info_rep::get_minimal_arity (tree_label l) {
 
 int
 drd_info_rep::get_maximal_arity (tree_label l) {
-  parent_info pi= info[l]->pi;
+  parent_info pi= get_info (l)->pi;
   switch (pi.arity_mode) {
   case ARITY_NORMAL:
   case ARITY_OPTIONS:
@@ -187,7 +239,7 @@ drd_info_rep::get_maximal_arity (tree_label l) {
 
 bool
 drd_info_rep::correct_arity (tree_label l, int i) {
-  parent_info pi= info[l]->pi;
+  parent_info pi= get_info (l)->pi;
   switch (pi.arity_mode) {
   case ARITY_NORMAL:
     return i == ((int) pi.arity_base) + ((int) pi.arity_extra);
@@ -204,7 +256,7 @@ drd_info_rep::correct_arity (tree_label l, int i) {
 
 bool
 drd_info_rep::insert_point (tree_label l, int i, int n) {
-  parent_info pi= info[l]->pi;
+  parent_info pi= get_info (l)->pi;
   switch (pi.arity_mode) {
   case ARITY_NORMAL:
     return false;
@@ -229,7 +281,7 @@ drd_info_rep::is_dynamic (tree t, bool hack) {
   if (is_atomic (t)) return false;
   if (is_func (t, DOCUMENT) || is_func (t, PARA) || is_func (t, CONCAT) ||
       is_func (t, TABLE) || is_func (t, ROW)) return false;
-  return info[L(t)]->pi.arity_mode != ARITY_NORMAL;
+  return get_info (L(t))->pi.arity_mode != ARITY_NORMAL;
 }
 
 /******************************************************************************
@@ -238,39 +290,37 @@ drd_info_rep::is_dynamic (tree t, bool hack) {
 
 void
 drd_info_rep::set_border (tree_label l, int mode) {
-  if (info[l]->pi.freeze_border) return;
-  if (!info->contains (l)) info(l)= copy (info[l]);
-  tag_info& ti= info(l);
+  if (get_info (l)->pi.freeze_border) return;
+  tag_info& ti= local_info (l);
   ti->pi.border_mode= mode;
 }
 
 int
 drd_info_rep::get_border (tree_label l) {
-  return info[l]->pi.border_mode;
+  return get_info (l)->pi.border_mode;
 }
 
 void
 drd_info_rep::freeze_border (tree_label l) {
-  if (!info->contains (l)) info(l)= copy (info[l]);
-  tag_info& ti= info(l);
+  tag_info& ti= local_info (l);
   ti->pi.freeze_border= true;
 }
 
 bool
 drd_info_rep::is_child_enforcing (tree t) {
-  return ((info[L(t)]->pi.border_mode & BORDER_INNER) != 0) &&
+  return ((get_info (L(t))->pi.border_mode & BORDER_INNER) != 0) &&
          (N(t) != 0);
 }
 
 bool
 drd_info_rep::is_parent_enforcing (tree t) {
-  return ((info[L(t)]->pi.border_mode & BORDER_OUTER) != 0) &&
+  return ((get_info (L(t))->pi.border_mode & BORDER_OUTER) != 0) &&
          (N(t) != 0);
 }
 
 bool
 drd_info_rep::var_without_border (tree_label l) {
-  return ((info[l]->pi.border_mode & BORDER_INNER) != 0) &&
+  return ((get_info (l)->pi.border_mode & BORDER_INNER) != 0) &&
          (!std_contains (as_string (l)));
 }
 
@@ -281,27 +331,25 @@ drd_info_rep::var_without_border (tree_label l) {
 
 void
 drd_info_rep::set_with_like (tree_label l, bool is_with_like) {
-  if (info[l]->pi.freeze_with) return;
-  if (!info->contains (l)) info(l)= copy (info[l]);
-  tag_info& ti= info(l);
+  if (get_info (l)->pi.freeze_with) return;
+  tag_info& ti= local_info (l);
   ti->pi.with_like= is_with_like;
 }
 
 bool
 drd_info_rep::get_with_like (tree_label l) {
-  return info[l]->pi.with_like;
+  return get_info (l)->pi.with_like;
 }
 
 void
 drd_info_rep::freeze_with_like (tree_label l) {
-  if (!info->contains (l)) info(l)= copy (info[l]);
-  tag_info& ti= info(l);
+  tag_info& ti= local_info (l);
   ti->pi.freeze_with= true;
 }
 
 bool
 drd_info_rep::is_with_like (tree t) {
-  return info[L(t)]->pi.with_like && N(t) > 0;
+  return get_info (L(t))->pi.with_like && N(t) > 0;
 }
 
 /******************************************************************************
@@ -311,21 +359,19 @@ drd_info_rep::is_with_like (tree t) {
 
 void
 drd_info_rep::set_var_type (tree_label l, int vt) {
-  if (info[l]->pi.freeze_with) return;
-  if (!info->contains (l)) info(l)= copy (info[l]);
-  tag_info& ti= info(l);
+  if (get_info (l)->pi.freeze_with) return;
+  tag_info& ti= local_info (l);
   ti->pi.var_type= vt;
 }
 
 int
 drd_info_rep::get_var_type (tree_label l) {
-  return info[l]->pi.var_type;
+  return get_info (l)->pi.var_type;
 }
 
 void
 drd_info_rep::freeze_var_type (tree_label l) {
-  if (!info->contains (l)) info(l)= copy (info[l]);
-  tag_info& ti= info(l);
+  tag_info& ti= local_info (l);
   ti->pi.freeze_with= true;
 }
 
@@ -335,14 +381,13 @@ drd_info_rep::freeze_var_type (tree_label l) {
 
 void
 drd_info_rep::set_attribute (tree_label l, string which, tree val) {
-  if (!info->contains (l)) info(l)= copy (info[l]);
-  tag_info& ti= info(l);
+  tag_info& ti= local_info (l);
   ti->set_attribute (which, val);
 }
 
 tree
 drd_info_rep::get_attribute (tree_label l, string which) {
-  tree val= info[l]->get_attribute (which);
+  tree val= get_info (l)->get_attribute (which);
   if ((which == "name") && (val == ""))
     return as_string (l);
   return val;
@@ -444,8 +489,7 @@ drd_info_rep::get_syntax (tree t, path p) {
 
 void
 drd_info_rep::set_type (tree_label l, int nr, int tp) {
-  if (!info->contains (l)) info(l)= copy (info[l]);
-  tag_info  & ti= info(l);
+  tag_info  & ti= local_info (l);
   if (nr >= N(ti->ci)) return;
   child_info& ci= ti->ci[nr];
   if (ci.freeze_type) return;
@@ -454,14 +498,13 @@ drd_info_rep::set_type (tree_label l, int nr, int tp) {
 
 int
 drd_info_rep::get_type (tree_label l, int nr) {
-  if (nr >= N(info[l]->ci)) return TYPE_ADHOC;
-  return info[l]->ci[nr].type;
+  if (nr >= N(get_info (l)->ci)) return TYPE_ADHOC;
+  return get_info (l)->ci[nr].type;
 }
 
 void
 drd_info_rep::freeze_type (tree_label l, int nr) {
-  if (!info->contains (l)) info(l)= copy (info[l]);
-  tag_info  & ti= info(l);
+  tag_info  & ti= local_info (l);
   if (nr >= N(ti->ci)) return;
   child_info& ci= ti->ci[nr];
   ci.freeze_type= true;
@@ -469,11 +512,11 @@ drd_info_rep::freeze_type (tree_label l, int nr) {
 
 int
 drd_info_rep::get_type_child (tree t, int i) {
-  tag_info ti= info[L(t)];
+  tag_info ti= get_info (L(t));
   if (is_func (t, EXTERN) && N(t)>0 && is_atomic (t[0])) {
     tree_label lab= make_tree_label ("extern:" * t[0]->label);
-    if (info->contains(lab)) { ti= info[lab]; }
-    else { ti = info(EXTERN); info(lab)= ti; }
+    if (info->contains(lab)) { ti= get_info (lab); }
+    else { ti = info(EXTERN); info(lab)= ti; drd_stamp++; }
   }
   int index= ti->get_index (i, N(t));
   if ((index<0) || (index>=N(ti->ci))) return TYPE_INVALID;
@@ -489,8 +532,7 @@ drd_info_rep::get_type_child (tree t, int i) {
 
 void
 drd_info_rep::set_accessible (tree_label l, int nr, int is_accessible) {
-  if (!info->contains (l)) info(l)= copy (info[l]);
-  tag_info  & ti= info(l);
+  tag_info  & ti= local_info (l);
   if (nr >= N(ti->ci)) return;
   child_info& ci= ti->ci[nr];
   if (ci.freeze_accessible) return;
@@ -499,14 +541,13 @@ drd_info_rep::set_accessible (tree_label l, int nr, int is_accessible) {
 
 int
 drd_info_rep::get_accessible (tree_label l, int nr) {
-  if (nr >= N(info[l]->ci)) return ACCESSIBLE_NEVER;
-  return info[l]->ci[nr].accessible;
+  if (nr >= N(get_info (l)->ci)) return ACCESSIBLE_NEVER;
+  return get_info (l)->ci[nr].accessible;
 }
 
 void
 drd_info_rep::freeze_accessible (tree_label l, int nr) {
-  if (!info->contains (l)) info(l)= copy (info[l]);
-  tag_info  & ti= info(l);
+  tag_info  & ti= local_info (l);
   if (nr >= N(ti->ci)) return;
   child_info& ci= ti->ci[nr];
   ci.freeze_accessible= true;
@@ -514,18 +555,18 @@ drd_info_rep::freeze_accessible (tree_label l, int nr) {
 
 bool
 drd_info_rep::all_accessible (tree_label l) {
-  int i, n= N(info[l]->ci);
+  int i, n= N(get_info (l)->ci);
   for (i=0; i<n; i++)
-    if (info[l]->ci[i].accessible != ACCESSIBLE_ALWAYS)
+    if (get_info (l)->ci[i].accessible != ACCESSIBLE_ALWAYS)
       return false;
   return n>0;
 }
 
 bool
 drd_info_rep::none_accessible (tree_label l) {
-  int i, n= N(info[l]->ci);
+  int i, n= N(get_info (l)->ci);
   for (i=0; i<n; i++)
-    if (info[l]->ci[i].accessible != ACCESSIBLE_NEVER)
+    if (get_info (l)->ci[i].accessible != ACCESSIBLE_NEVER)
       return false;
   return true;
 }
@@ -533,11 +574,11 @@ drd_info_rep::none_accessible (tree_label l) {
 bool
 drd_info_rep::is_accessible_child (tree t, int i) {
   //cout << "l= " << as_string (L(t)) << "\n";
-  tag_info ti= info[L(t)];
+  tag_info ti= get_info (L(t));
   if (is_func (t, EXTERN) && N(t)>0 && is_atomic (t[0])) {
     tree_label lab= make_tree_label ("extern:" * t[0]->label);
-    if (info->contains(lab)) { ti= info[lab]; }
-    else { ti = info(EXTERN); info(lab)= ti; }
+    if (info->contains(lab)) { ti= get_info (lab); }
+    else { ti = info(EXTERN); info(lab)= ti; drd_stamp++; }
   }
   int index= ti->get_index (i, N(t));
   if ((index<0) || (index>=N(ti->ci))) {
@@ -572,8 +613,7 @@ drd_info_rep::is_accessible_path (tree t, path p) {
 
 void
 drd_info_rep::set_writability (tree_label l, int nr, int writability) {
-  if (!info->contains (l)) info(l)= copy (info[l]);
-  tag_info  & ti= info(l);
+  tag_info  & ti= local_info (l);
   if (nr >= N(ti->ci)) return;
   child_info& ci= ti->ci[nr];
   if (ci.freeze_writability) return;
@@ -582,14 +622,13 @@ drd_info_rep::set_writability (tree_label l, int nr, int writability) {
 
 int
 drd_info_rep::get_writability (tree_label l, int nr) {
-  if (nr >= N(info[l]->ci)) return WRITABILITY_NORMAL;
-  return info[l]->ci[nr].writability;
+  if (nr >= N(get_info (l)->ci)) return WRITABILITY_NORMAL;
+  return get_info (l)->ci[nr].writability;
 }
 
 void
 drd_info_rep::freeze_writability (tree_label l, int nr) {
-  if (!info->contains (l)) info(l)= copy (info[l]);
-  tag_info  & ti= info(l);
+  tag_info  & ti= local_info (l);
   if (nr >= N(ti->ci)) return;
   child_info& ci= ti->ci[nr];
   ci.freeze_writability= true;
@@ -597,11 +636,11 @@ drd_info_rep::freeze_writability (tree_label l, int nr) {
 
 int
 drd_info_rep::get_writability_child (tree t, int i) {
-  tag_info ti= info[L(t)];
+  tag_info ti= get_info (L(t));
   if (is_func (t, EXTERN) && N(t)>0 && is_atomic (t[0])) {
     tree_label lab= make_tree_label ("extern:" * t[0]->label);
-    if (info->contains(lab)) { ti= info[lab]; }
-    else { ti = info(EXTERN); info(lab)= ti; }
+    if (info->contains(lab)) { ti= get_info (lab); }
+    else { ti = info(EXTERN); info(lab)= ti; drd_stamp++; }
   }
   int index= ti->get_index (i, N(t));
   if ((index<0) || (index>=N(ti->ci))) return WRITABILITY_DISABLE;
@@ -634,11 +673,11 @@ drd_info_rep::get_child_long_name (tree_label l, int nr) {
 
 string
 drd_info_rep::get_child_name (tree t, int i) {
-  tag_info ti= info[L(t)];
+  tag_info ti= get_info (L(t));
   if (is_func (t, EXTERN) && N(t)>0 && is_atomic (t[0])) {
     tree_label lab= make_tree_label ("extern:" * t[0]->label);
-    if (info->contains(lab)) { ti= info[lab]; }
-    else { ti = info(EXTERN); info(lab)= ti; }
+    if (info->contains(lab)) { ti= get_info (lab); }
+    else { ti = info(EXTERN); info(lab)= ti; drd_stamp++; }
   }
   int index= ti->get_index (i, N(t));
   if ((index<0) || (index>=N(ti->ci))) return "";
@@ -647,11 +686,11 @@ drd_info_rep::get_child_name (tree t, int i) {
 
 string
 drd_info_rep::get_child_long_name (tree t, int i) {
-  tag_info ti= info[L(t)];
+  tag_info ti= get_info (L(t));
   if (is_func (t, EXTERN) && N(t)>0 && is_atomic (t[0])) {
     tree_label lab= make_tree_label ("extern:" * t[0]->label);
-    if (info->contains(lab)) { ti= info[lab]; }
-    else { ti = info(EXTERN); info(lab)= ti; }
+    if (info->contains(lab)) { ti= get_info (lab); }
+    else { ti = info(EXTERN); info(lab)= ti; drd_stamp++; }
   }
   int index= ti->get_index (i, N(t));
   if ((index<0) || (index>=N(ti->ci))) return "";
@@ -701,8 +740,7 @@ drd_info_rep::set_env (tree_label l, int nr, tree env) {
   //cout << as_string (l) << ", " << nr << " -> " << env << "\n";
   //if (as_string (l) == "session")
   //cout << as_string (l) << ", " << nr << " -> " << env << "\n";
-  if (!info->contains (l)) info(l)= copy (info[l]);
-  tag_info  & ti= info(l);
+  tag_info  & ti= local_info (l);
   if (nr >= N(ti->ci)) return;
   child_info& ci= ti->ci[nr];
   if (ci.freeze_env) return;
@@ -711,14 +749,13 @@ drd_info_rep::set_env (tree_label l, int nr, tree env) {
 
 tree
 drd_info_rep::get_env (tree_label l, int nr) {
-  if (nr >= N(info[l]->ci)) return tree (ATTR);
-  return drd_decode (info[l]->ci[nr].env);
+  if (nr >= N(get_info (l)->ci)) return tree (ATTR);
+  return drd_decode (get_info (l)->ci[nr].env);
 }
 
 void
 drd_info_rep::freeze_env (tree_label l, int nr) {
-  if (!info->contains (l)) info(l)= copy (info[l]);
-  tag_info  & ti= info(l);
+  tag_info  & ti= local_info (l);
   if (nr >= N(ti->ci)) return;
   child_info& ci= ti->ci[nr];
   ci.freeze_env= true;
@@ -744,7 +781,7 @@ drd_info_rep::get_env_child (tree t, int i, tree env) {
       }
     */
 
-    tag_info ti= info[L(t)];
+    tag_info ti= get_info (L(t));
     int index= ti->get_index (i, N(t));
     if ((index<0) || (index>=N(ti->ci))) return "";
     tree cenv= drd_decode (ti->ci[index].env);
@@ -1009,9 +1046,8 @@ drd_info_rep::heuristic_init_parameter (string var, tree val) {
 }
 
 void
-drd_info_rep::heuristic_init (hashmap<string,tree> env2) {
+drd_info_rep::heuristic_fixed_point () {
   // time_t tt= texmacs_time ();
-  set_environment (env2);
   bool flag= true;
   int round= 0;
   while (flag) {
@@ -1037,3 +1073,100 @@ drd_info_rep::heuristic_init (hashmap<string,tree> env2) {
   }
   // cout << "--> " << (texmacs_time ()-tt) << "ms\n";
 }
+
+/******************************************************************************
+* Caching the results of the heuristic initialization
+******************************************************************************/
+
+static hashmap<string,tree> heuristic_cache (UNINIT);
+static bool heuristic_on_disk= true;
+static int heuristic_limit= DRD_HEURISTIC_CACHE_SIZE;
+static int heuristic_size= 0;
+
+void
+drd_heuristic_cache (bool on_disk, int limit) {
+  heuristic_cache= hashmap<string,tree> (UNINIT);
+  heuristic_on_disk= on_disk;
+  heuristic_limit= limit;
+  heuristic_size= 0;
+}
+
+int
+drd_heuristic_cache_size () {
+  return heuristic_size;
+}
+
+static void
+heuristic_remember (string key, tree t, int size) {
+  // the size is the one of the serialized drd; as for the other caches,
+  // we start afresh once the limit would be exceeded
+  if (heuristic_size + size > heuristic_limit) {
+    heuristic_cache= hashmap<string,tree> (UNINIT);
+    heuristic_size= 0;
+  }
+  heuristic_cache (key)= t;
+  heuristic_size += size;
+}
+
+static inline unsigned int
+mix (unsigned int h) {
+  h ^= h >> 16; h *= 0x85ebca6b;
+  h ^= h >> 13; h *= 0xc2b2ae35;
+  h ^= h >> 16;
+  return h;
+}
+
+static string
+heuristic_key (rel_hashmap<tree_label,tag_info> info,
+               hashmap<string,tree> env) {
+  // the result depends on the environment and on all levels of the drd;
+  // entries are combined commutatively, since iteration orders vary
+  unsigned int h1= N(env), h2= 0;
+  iterator<string> it= iterate (env);
+  while (it->busy ()) {
+    string var= it->next ();
+    unsigned int h= 31 * ((unsigned int) hash (var)) + stable_hash (env[var]);
+    h1 += h; h2 += mix (h);
+  }
+  for (int level= 1; !is_nil (info); info= info->next, level++) {
+    iterator<tree_label> jt= iterate (info->item);
+    while (jt->busy ()) {
+      tree_label l= jt->next ();
+      unsigned int h= ((unsigned int) hash (as_string (l))) * level +
+                      stable_hash ((tree) info->item[l]);
+      h1 += mix (h); h2 += h;
+    }
+  }
+  return as_hexadecimal ((int) h1, 8) * "-" * as_hexadecimal ((int) h2, 8);
+}
+
+static url
+heuristic_file (string key) {
+  return url ("$TEXMACS_HOME_PATH/system/cache", "__drd-" * key);
+}
+
+void
+drd_info_rep::heuristic_init (hashmap<string,tree> env2) {
+  set_environment (env2);
+  string key= heuristic_key (info, env);
+  tree t= heuristic_cache[key];
+  if (t == UNINIT && heuristic_on_disk) {
+    string s;
+    url name= heuristic_file (key);
+    if (exists (name) && !load_string (name, s, false)) {
+      t= scheme_to_tree (s);
+      heuristic_remember (key, t, N(s));
+    }
+  }
+  if (t == UNINIT || !set_locals (t)) {
+    heuristic_fixed_point ();
+    t= get_locals ();
+    string s= tree_to_scheme (t);
+    heuristic_remember (key, t, N(s));
+    if (heuristic_on_disk) {
+      url name= heuristic_file (key);
+      if (!exists (name)) save_string (name, s);
+    }
+  }
+  freeze_table ();
+}
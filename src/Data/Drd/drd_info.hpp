@@ -15,12 +15,18 @@
 #include "rel_hashmap.hpp"
 #include "tag_info.hpp"
 
+extern int drd_stamp;
+
 class drd_info;
 class drd_info_rep: concrete_struct {
 public:
   string name;
   rel_hashmap<tree_label,tag_info> info;
   hashmap<string,tree> env;
+  array<tag_info> table;   // flattened info, indexed by tree_label
+  int table_stamp;         // value of drd_stamp when the table was built
+  int miss_stamp;          // value of drd_stamp during the last miss
+  int table_misses;        // misses since drd_stamp last changed
 
 public:
   drd_info_rep (string name);
@@ -29,6 +35,12 @@ public:
   bool set_locals (tree t);
   bool contains (string l);
 
+  /* Flattened tables for fast lookups */
+  void freeze_table ();
+  inline tag_info get_info (tree_label l);
+  tag_info lookup_info (tree_label l);
+  tag_info& local_info (tree_label l);
+
   /* Properties of the tag itself */
   void set_type (tree_label tag, int tp);
   int  get_type (tree_label tag);
@@ -126,6 +138,7 @@ public:
   bool heuristic_init_parameter (string var, string val);
   bool heuristic_init_parameter (string var, tree val);
   void heuristic_init (hashmap<string,tree> env);
+  void heuristic_fixed_point ();
 
   friend class drd_info;
   friend tm_ostream& operator << (tm_ostream& out, drd_info drd);
@@ -139,6 +152,18 @@ class drd_info {
 };
 CONCRETE_CODE(drd_info);
 
+inline tag_info
+drd_info_rep::get_info (tree_label l) {
+  if (table_stamp == drd_stamp && ((int) l) < N(table)) return table[l];
+  return lookup_info (l);
+}
+
+#define DRD_HEURISTIC_CACHE_SIZE (4 << 20) // maximal size of cached drds
+
+void drd_heuristic_cache (bool on_disk,
+                          int limit= DRD_HEURISTIC_CACHE_SIZE);
+int  drd_heuristic_cache_size ();
+
 tree drd_env_write (tree env, string var, tree val);
 tree drd_env_merge (tree env, tree t);
 tree drd_env_read (tree env, string var, tree val= tree (UNINIT));
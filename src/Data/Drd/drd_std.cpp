@@ -1258,4 +1258,6 @@ init_std_drd () {
   init_var (ORNAMENT_EXTRA_COLOR, TYPE_COLOR);
   init_var (ORNAMENT_SUNNY_COLOR, TYPE_COLOR);
   init_var (ORNAMENT_SHADOW_COLOR, TYPE_COLOR);
+
+  drd_stamp++;
 }
@@ -20,6 +20,8 @@ static patch make_branches (array<patch> a);
 static hashset<double> genuine_authors;
 static hashset<pointer> archs;
 static hashset<pointer> pending_archs;
+static int history_max_steps= -1;
+static int history_max_bytes= 1 << 26;
 
 /******************************************************************************
 * Constructors, destructors, printing and announcements
@@ -31,11 +33,20 @@ archiver_rep::archiver_rep (double author, path rp2):
   depth (0),
   last_save (0),
   last_autosave (0),
+  pending_autosave (-1),
   the_author (author),
   the_owner (0),
   rp (rp2),
   undo_obs (undo_observer (this)),
-  versioning (false)
+  versioning (false),
+  max_steps (history_max_steps),
+  max_bytes (history_max_bytes),
+  evicted (0),
+  live_nr (0),
+  live_bytes (0),
+  frozen_steps (0),
+  frozen_bytes (0),
+  marks (0)
 {
   archs->insert ((pointer) this);
   attach_observer (subtree (the_et, rp), undo_obs);
@@ -59,12 +70,20 @@ archiver_rep::clear () {
   the_owner= 0;
   depth= 0;
   last_save= -1;
-  last_autosave= -1;
+  last_autosave= pending_autosave= -1;
+  frozen= array<string> ();
+  frozen_nr= array<int> ();
+  live_nr= live_bytes= 0;
+  frozen_steps= frozen_bytes= 0;
+  marks= 0;
 }
 
 void
 archiver_rep::show_all () {
   cout << HRULE << archive << LF << HRULE << LF;
+  cout << history_steps () << " undo steps of " << history_memory ()
+       << " bytes, " << N(frozen) << " encoded parts, "
+       << evicted << " steps discarded" << LF << HRULE << LF;
 }
 
 ////extern tree the_et;
@@ -112,6 +131,17 @@ global_cancel () {
   pending_archs= hashset<pointer> ();
 }
 
+void
+global_history_limits (int max_steps, int max_bytes) {
+  history_max_steps= max_steps;
+  history_max_bytes= max_bytes;
+  iterator<pointer> it = iterate (archs);
+  while (it->busy()) {
+    archiver_rep* arch= (archiver_rep*) it->next();
+    arch->set_limits (max_steps, max_bytes);
+  }
+}
+
 /******************************************************************************
 * Useful subroutines
 ******************************************************************************/
@@ -175,6 +205,34 @@ cdr (patch p) {
   return child (p, 1);
 }
 
+static patch
+cut_history (patch archive, int k, patch& tail) {
+  // keep the k most recent undo steps and return the older ones in tail
+  if (k == 0) {
+    tail= archive;
+    return make_branches (0);
+  }
+  patch un= get_undo (archive);
+  patch nx= cut_history (cdr (un), k-1, tail);
+  return make_history (patch (car (un), nx), get_redo (archive));
+}
+
+static patch
+attach_history (patch bottom, patch tail) {
+  // continue the oldest end of an archive by an older history
+  if (nr_branches (bottom) == 0) return tail;
+  return make_history (get_undo (tail),
+                       append_branches (get_redo (tail), get_redo (bottom)));
+}
+
+static patch
+graft_history (patch archive, patch tail) {
+  if (nr_undo (archive) == 0) return attach_history (archive, tail);
+  patch un= get_undo (archive);
+  patch nx= graft_history (cdr (un), tail);
+  return make_history (patch (car (un), nx), get_redo (archive));
+}
+
 /******************************************************************************
 * Internal subroutines
 ******************************************************************************/
@@ -241,7 +299,8 @@ archiver_rep::expose (patch archive) {
       patch nx= make_history (patch (un2, nx2), make_branches (0));
       patch un= patch (un1, nx);
       patch re= append_branches (re1, fut);
-      last_save= last_autosave= -1;
+      last_save= last_autosave= pending_autosave= -1;
+      live_nr= -1;
       return make_history (un, re);
     }
   else return archive;
@@ -249,6 +308,18 @@ archiver_rep::expose (patch archive) {
 
 void
 archiver_rep::expose () {
+  // decode the older history if it contains steps to be exposed
+  while (true) {
+    int nr= 0;
+    patch p= archive;
+    while (nr_undo (p) != 0 &&
+           get_author (car (get_undo (p))) != the_author) {
+      p= cdr (get_undo (p));
+      nr++;
+    }
+    if (N(frozen) == 0 || live_steps (nr + 3) >= nr + 3) break;
+    thaw (nr + 3);
+  }
   archive= expose (archive);
 }
 
@@ -266,7 +337,8 @@ archiver_rep::normalize () {
     split (p1, re2, Re1, Re2);
     patch ar2= make_history (un2, Re1);
     archive= make_history (patch (p1, ar2), append_branches (re1, Re2));
-    last_save= last_autosave= -1;
+    last_save= last_autosave= pending_autosave= -1;
+    live_nr= -1;
   }
 }
 
@@ -329,12 +401,20 @@ archiver_rep::confirm () {
     if (active ()) {
       //cout << "Confirm " << current << "\n";
       archive= patch (current, archive);
+      if (live_nr >= 0) {
+        live_nr++;
+        live_bytes += patch_memory (current) +
+                      patch_memory (get_redo (archive));
+      }
       current= make_compound (0);
       the_owner= 0;
       depth++;
       if (depth <= last_save) last_save= -1;
       if (depth <= last_autosave) last_autosave= -1;
+      if (depth <= pending_autosave) pending_autosave= -1;
+      thaw ();
       normalize ();
+      freeze ();
       //show_all ();
     }
   }
@@ -342,6 +422,7 @@ archiver_rep::confirm () {
 
 bool
 archiver_rep::retract () {
+  thaw ();
   if (!has_history ()) return false;
   if (the_owner != 0 && the_owner != the_author) return false;
   expose ();
@@ -359,6 +440,7 @@ archiver_rep::retract () {
   }
   if (nr_branches (nx) != 0) nx= get_undo (nx);
   archive= make_history (nx, append_branches (re, get_redo (nx)));
+  live_nr= -1;
   depth--;
   //show_all ();
   return true;
@@ -383,6 +465,7 @@ archiver_rep::forget_cursor () {
 
 void
 archiver_rep::simplify () {
+  thaw ();
   if (has_history () &&
       nr_undo (cdr (get_undo (archive))) == 1 &&
       nr_redo (cdr (get_undo (archive))) == 0 &&
@@ -402,9 +485,11 @@ archiver_rep::simplify () {
         patch un= patch (p1, cdr (get_undo (cdr (get_undo (archive)))));
         patch re= get_redo (archive);
         archive= make_history (un, re);
+        live_nr= -1;
         //show_all ();
         //cout << "\n";
         if (depth == last_autosave + 1) last_autosave= -1;
+        if (depth == pending_autosave + 1) pending_autosave= -1;
         depth--;
         simplify ();
       }
@@ -428,6 +513,7 @@ archiver_rep::redo_possibilities () {
 path
 archiver_rep::undo_one (int i) {
   if (active ()) return path ();
+  thaw ();
   if (undo_possibilities () != 0) {
     ASSERT (i == 0, "index out of range");
     patch p= car (get_undo (archive));
@@ -440,6 +526,7 @@ archiver_rep::undo_one (int i) {
     patch re = append_branches (re1, re2);
     patch un = (nr_branches (nx) == 0? nx: get_undo (nx));
     archive= make_history (un, re);
+    live_nr= -1;
     depth--;
     //show_all ();
     return cursor_hint (q, the_et);
@@ -450,6 +537,7 @@ archiver_rep::undo_one (int i) {
 path
 archiver_rep::redo_one (int i) {
   if (active ()) return path ();
+  thaw ();
   int n= redo_possibilities ();
   if (n != 0) {
     ASSERT (i >= 0 && i < n, "index out of range");
@@ -466,8 +554,10 @@ archiver_rep::redo_one (int i) {
     //cout << "other= " << other << "\n";
     patch nx= make_history (un, other);
     archive= make_history (patch (q, nx), cdr (branch (re, i)));
+    live_nr= -1;
     if (depth <= last_save && i != 0) last_save= -1;
     if (depth <= last_autosave && i != 0) last_autosave= -1;
+    if (depth <= pending_autosave && i != 0) pending_autosave= -1;
     depth++;
     normalize ();
     //show_all ();
@@ -514,6 +604,179 @@ archiver_rep::redo (int i) {
   return r;
 }
 
+/******************************************************************************
+* Compact storage and limits for long histories
+******************************************************************************/
+
+int
+archiver_rep::live_steps (int max) {
+  // number of undo steps which are not encoded, up to max
+  int n= 0;
+  patch p= archive;
+  while (n < max && nr_undo (p) != 0) {
+    p= cdr (get_undo (p));
+    n++;
+  }
+  return n;
+}
+
+static bool
+is_open_marker (patch p) {
+  if (get_type (p) == PATCH_AUTHOR) return is_open_marker (p[0]);
+  return get_type (p) == PATCH_BIRTH && get_birth (p) == false;
+}
+
+int
+archiver_rep::marked_steps () {
+  // number of recent undo steps up to the oldest open marker,
+  // or -1 if some open marker is not part of the live history
+  if (marks == 0) return 0;
+  int n= 0, found= 0;
+  for (patch p= archive; nr_undo (p) != 0; p= cdr (get_undo (p))) {
+    n++;
+    if (is_open_marker (car (get_undo (p))) && ++found == marks) return n;
+  }
+  return -1;
+}
+
+void
+archiver_rep::freeze () {
+  // encode the older part of the history once there are enough steps
+  count_live ();
+  if (live_nr <= 2*HISTORY_LIVE_STEPS) {
+    limit ();
+    return;
+  }
+  // cut just below one of our own modifications, so that expose
+  // never has to look at the encoded part, and never encode open markers
+  int marked= marked_steps ();
+  if (marked < 0) return;
+  int k= 1;
+  patch p= archive;
+  while (k < max (HISTORY_LIVE_STEPS, marked) ||
+         get_author (car (get_undo (p))) != the_author) {
+    p= cdr (get_undo (p));
+    k++;
+    if (nr_undo (p) == 0) return;
+  }
+  if (nr_undo (cdr (get_undo (p))) == 0) return;
+  patch tail;
+  archive= cut_history (archive, k, tail);
+  int nr= 0;
+  for (patch q= tail; nr_undo (q) != 0; q= cdr (get_undo (q))) {
+    live_bytes -= patch_memory (car (get_undo (q))) +
+                  patch_memory (get_redo (q));
+    nr++;
+  }
+  live_nr -= nr;
+  frozen << encode_patch (tail);
+  frozen_nr << nr;
+  frozen_steps += nr;
+  frozen_bytes += N(frozen[N(frozen) - 1]);
+  limit ();
+}
+
+void
+archiver_rep::thaw (int nr) {
+  // decode older history until nr undo steps are directly available
+  while (N(frozen) != 0 && live_steps (nr) < nr) {
+    patch tail= decode_patch (frozen[N(frozen) - 1]);
+    frozen_steps -= frozen_nr[N(frozen_nr) - 1];
+    frozen_bytes -= N(frozen[N(frozen) - 1]);
+    frozen   ->resize (N(frozen) - 1);
+    frozen_nr->resize (N(frozen_nr) - 1);
+    archive= graft_history (archive, tail);
+    live_nr= -1;
+  }
+}
+
+array<int>
+archiver_rep::live_memory () {
+  // approximate memory occupied by each live undo step, most recent first,
+  // including the redo branches which start at that step
+  array<int> r;
+  patch p= archive;
+  while (nr_undo (p) != 0) {
+    r << (patch_memory (car (get_undo (p))) + patch_memory (get_redo (p)));
+    p= cdr (get_undo (p));
+  }
+  return r;
+}
+
+void
+archiver_rep::count_live () {
+  // recount the live history after it has been restructured
+  if (live_nr >= 0) return;
+  array<int> a= live_memory ();
+  live_nr= N(a);
+  live_bytes= 0;
+  for (int i=0; i<N(a); i++) live_bytes += a[i];
+}
+
+void
+archiver_rep::limit () {
+  // discard the oldest history when exceeding the limits,
+  // but never an open marker or anything below it
+  count_live ();
+  int steps= live_nr + frozen_steps;
+  int bytes= live_bytes + frozen_bytes;
+  if ((max_steps < 0 || steps <= max_steps) && bytes <= max_bytes) return;
+  int marked= marked_steps ();
+  if (marked < 0) return;
+  while (N(frozen) != 0 &&
+         ((max_steps >= 0 && steps > max_steps) || bytes > max_bytes)) {
+    steps -= frozen_nr[0];
+    bytes -= N(frozen[0]);
+    evicted += frozen_nr[0];
+    frozen_steps -= frozen_nr[0];
+    frozen_bytes -= N(frozen[0]);
+    frozen   = range (frozen, 1, N(frozen));
+    frozen_nr= range (frozen_nr, 1, N(frozen_nr));
+  }
+  if (N(frozen) != 0) return;
+  if ((max_steps < 0 || steps <= max_steps) && bytes <= max_bytes) return;
+  // the most recent undo step is always kept
+  array<int> live= live_memory ();
+  int keep= 0;
+  bytes= 0;
+  while (keep < live_nr &&
+         (keep < marked ||
+          ((max_steps < 0 || keep < max_steps) &&
+           (keep == 0 || bytes + live[keep] <= max_bytes))))
+    bytes += live[keep++];
+  if (keep < live_nr) {
+    patch tail;
+    archive= cut_history (archive, keep, tail);
+    evicted += live_nr - keep;
+    live_nr= keep;
+    live_bytes= bytes;
+  }
+}
+
+void
+archiver_rep::set_limits (int max_steps2, int max_bytes2) {
+  max_steps= (max_steps2 < 0? -1: max (max_steps2, 1));
+  max_bytes= max_bytes2;
+  limit ();
+}
+
+int
+archiver_rep::history_steps () {
+  count_live ();
+  return live_nr + frozen_steps;
+}
+
+int
+archiver_rep::history_memory () {
+  count_live ();
+  return live_bytes + frozen_bytes;
+}
+
+int
+archiver_rep::evicted_steps () {
+  return evicted;
+}
+
 /******************************************************************************
 * Marking blocks for grouped modifications or canceling
 ******************************************************************************/
@@ -571,11 +834,20 @@ remove_marker (patch archive, double m) {
   return remove_marker_bis (compress (archive), m);
 }
 
+void
+archiver_rep::thaw_marker (double m) {
+  // decode older history if the marker was encoded
+  for (patch p= archive; nr_undo (p) != 0; p= cdr (get_undo (p)))
+    if (is_marker (car (get_undo (p)), m, false)) return;
+  thaw (MAX_SI);
+}
+
 void
 archiver_rep::mark_start (double m) {
   //cout << "Mark start " << m << "\n";
   confirm ();
   start_slave (m);
+  marks++;
   confirm ();
   //show_all ();
 }
@@ -588,7 +860,10 @@ archiver_rep::mark_end (double m) {
     //  cout << "CONFIRM: " << current << "\n";
     confirm ();
   }
+  thaw_marker (m);
   archive= remove_marker (archive, m);
+  live_nr= -1;
+  marks--;
   depth--;
   simplify ();
   //show_all ();
@@ -601,13 +876,19 @@ archiver_rep::mark_cancel (double m) {
   while (nr_undo (archive) != 0) {
     expose ();
     if (is_marker (car (get_undo (archive)), m, false)) {
+      thaw_marker (m);
       archive= remove_marker (archive, m);
+      live_nr= -1;
+      marks--;
       depth--;
       simplify ();
       return true;
     }
     if (get_author (car (get_undo (archive))) != the_author) {
+      thaw_marker (m);
       archive= remove_marker (archive, m);
+      live_nr= -1;
+      marks--;
       depth--;
       return false;
     }
@@ -657,6 +938,17 @@ archiver_rep::notify_autosave () {
   last_autosave= depth;
 }
 
+void
+archiver_rep::prepare_autosave () {
+  pending_autosave= depth;
+}
+
+void
+archiver_rep::confirm_autosave () {
+  last_autosave= pending_autosave;
+  pending_autosave= -1;
+}
+
 bool
 archiver_rep::conform_autosave () {
   return last_autosave == depth;
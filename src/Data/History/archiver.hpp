@@ -13,9 +13,12 @@
 #define ARCHIVER_H
 #include "patch.hpp"
 
+#define HISTORY_LIVE_STEPS 32
+
 void global_clear_history ();
 void global_confirm ();
 void global_cancel ();
+void global_history_limits (int max_steps, int max_bytes);
 
 class archiver_rep: public concrete_struct {
   patch    archive;        // undo and redo archive
@@ -23,11 +26,22 @@ class archiver_rep: public concrete_struct {
   int      depth;          // archive depth
   int      last_save;      // archive depth at last save
   int      last_autosave;  // archive depth at last autosave
+  int      pending_autosave; // archive depth of a running autosave
   double   the_author;     // the author corresponding to the archiver
   double   the_owner;      // author of current modifications
   path     rp;             // root path for document
   observer undo_obs;       // observer for undoing changes
   bool     versioning;     // true during undo and redo operations
+  array<string> frozen;    // encoded older parts of the history
+  array<int> frozen_nr;    // number of undo steps in each encoded part
+  int      max_steps;      // maximal number of undo steps (-1 for no limit)
+  int      max_bytes;      // maximal memory occupied by the history
+  int      evicted;        // number of discarded undo steps
+  int      live_nr;        // number of live undo steps (-1 if unknown)
+  int      live_bytes;     // memory occupied by the live undo steps
+  int      frozen_steps;   // number of undo steps in the encoded parts
+  int      frozen_bytes;   // memory occupied by the encoded parts
+  int      marks;          // number of open markers
 
 protected:
   void apply (patch p);
@@ -37,6 +51,14 @@ protected:
   void expose ();
   void normalize ();
   int corrected_depth ();
+  int live_steps (int max);
+  array<int> live_memory ();
+  void count_live ();
+  int marked_steps ();
+  void freeze ();
+  void thaw (int nr= 3);
+  void thaw_marker (double m);
+  void limit ();
 
 public:
   archiver_rep (double author, path rp);
@@ -69,9 +91,16 @@ public:
   void require_autosave ();
   void notify_save ();
   void notify_autosave ();
+  void prepare_autosave ();
+  void confirm_autosave ();
   bool conform_save ();
   bool conform_autosave ();
 
+  void set_limits (int max_steps, int max_bytes);
+  int  history_steps ();
+  int  history_memory ();
+  int  evicted_steps ();
+
   friend void archive_announce (archiver_rep* arch, modification mod);
   friend void global_clear_history ();
   friend void global_confirm ();
@@ -129,5 +129,8 @@ patch co_pull (patch p1, patch p2);
 bool join (patch& p1, patch p2, tree t);
 patch remove_set_cursor (patch p);
 bool does_modify (patch p);
+string encode_patch (patch p);
+patch decode_patch (string s);
+int patch_memory (patch p);
 
 #endif // defined PATCH_H
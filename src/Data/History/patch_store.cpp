@@ -0,0 +1,289 @@
+
+/******************************************************************************
+* MODULE     : patch_store.cpp
+* DESCRIPTION: Compact encodings of patches for storing the history
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "patch.hpp"
+#include "hashmap.hpp"
+#include <string.h>
+
+/******************************************************************************
+* The encoding consists of a table with all trees which occur in the
+* modifications, followed by the patch itself.  Identical subtrees are
+* stored only once in the table, so that the contents of removals and
+* their inverse insertions are shared.  Decoding builds fresh trees for
+* every occurrence, since trees in the history may not be shared with
+* each other once they are inserted into the document.
+******************************************************************************/
+
+static void
+encode_int (string& s, int i) {
+  unsigned int u= (i >= 0? ((unsigned int) i) << 1:
+                           (((unsigned int) (-(i+1))) << 1) | 1);
+  while (u >= 128) {
+    s << ((char) ((u & 127) | 128));
+    u >>= 7;
+  }
+  s << ((char) u);
+}
+
+static int
+decode_int (string s, int& i) {
+  unsigned int u= 0;
+  int shift= 0;
+  while (i < N(s)) {
+    unsigned char c= (unsigned char) s[i++];
+    u |= ((unsigned int) (c & 127)) << shift;
+    if (c < 128) break;
+    shift += 7;
+  }
+  return (u & 1) == 0? (int) (u >> 1): -((int) (u >> 1)) - 1;
+}
+
+static void
+encode_double (string& s, double x) {
+  char buf[sizeof (double)];
+  memcpy (buf, &x, sizeof (double));
+  for (int k=0; k<(int) sizeof (double); k++) s << buf[k];
+}
+
+static double
+decode_double (string s, int& i) {
+  double x;
+  memcpy (&x, &s[i], sizeof (double));
+  i += sizeof (double);
+  return x;
+}
+
+/******************************************************************************
+* Encoding
+******************************************************************************/
+
+struct patch_encoder {
+  hashmap<string,int> index;   // table entries and their numbers
+  string table;                // the encoded table
+  int nr;                      // number of entries in the table
+  patch_encoder (): index (-1), nr (0) {}
+  int  encode (tree t);
+  void encode (string& s, modification m);
+  void encode (string& s, patch p);
+};
+
+int
+patch_encoder::encode (tree t) {
+  string e;
+  if (is_atomic (t)) {
+    e << 'a';
+    encode_int (e, N(t->label));
+    e << t->label;
+  }
+  else {
+    int i, n= N(t);
+    e << 'c';
+    encode_int (e, (int) L(t));
+    encode_int (e, n);
+    for (i=0; i<n; i++) encode_int (e, encode (t[i]));
+  }
+  int k= index[e];
+  if (k < 0) {
+    k= nr++;
+    index (e)= k;
+    table << e;
+  }
+  return k;
+}
+
+void
+patch_encoder::encode (string& s, modification m) {
+  encode_int (s, m->k);
+  encode_int (s, N(m->p));
+  for (path p= m->p; !is_nil (p); p= p->next)
+    encode_int (s, p->item);
+  encode_int (s, encode (m->t));
+}
+
+void
+patch_encoder::encode (string& s, patch p) {
+  int i, n;
+  s << ((char) get_type (p));
+  switch (get_type (p)) {
+  case PATCH_MODIFICATION:
+    encode (s, get_modification (p));
+    encode (s, get_inverse (p));
+    break;
+  case PATCH_COMPOUND:
+  case PATCH_BRANCH:
+    n= N(p);
+    encode_int (s, n);
+    for (i=0; i<n; i++) encode (s, p[i]);
+    break;
+  case PATCH_BIRTH:
+    encode_double (s, get_author (p));
+    s << (get_birth (p)? '1': '0');
+    break;
+  case PATCH_AUTHOR:
+    encode_double (s, get_author (p));
+    encode (s, p[0]);
+    break;
+  default:
+    FAILED ("unsupported patch type");
+  }
+}
+
+string
+encode_patch (patch p) {
+  patch_encoder enc;
+  string body;
+  enc.encode (body, p);
+  string r;
+  encode_int (r, enc.nr);
+  r << enc.table << body;
+  return r;
+}
+
+/******************************************************************************
+* Decoding
+******************************************************************************/
+
+struct patch_decoder {
+  string s;                    // the encoding
+  array<int> entries;          // positions of the table entries
+  patch_decoder (string s2): s (s2) {}
+  void skip_table (int& i);
+  tree decode_tree (int k);
+  modification decode_modification (int& i);
+  patch decode (int& i);
+};
+
+void
+patch_decoder::skip_table (int& i) {
+  int k, nr= decode_int (s, i);
+  for (k=0; k<nr; k++) {
+    entries << i;
+    if (s[i++] == 'a') {
+      int len= decode_int (s, i);
+      i += len;
+    }
+    else {
+      (void) decode_int (s, i);
+      int j, n= decode_int (s, i);
+      for (j=0; j<n; j++) (void) decode_int (s, i);
+    }
+  }
+}
+
+tree
+patch_decoder::decode_tree (int k) {
+  int i= entries[k];
+  if (s[i++] == 'a') {
+    int len= decode_int (s, i);
+    return tree (s (i, i + len));
+  }
+  else {
+    tree_label l= (tree_label) decode_int (s, i);
+    int j, n= decode_int (s, i);
+    tree t (l, n);
+    for (j=0; j<n; j++) t[j]= decode_tree (decode_int (s, i));
+    return t;
+  }
+}
+
+modification
+patch_decoder::decode_modification (int& i) {
+  int k= decode_int (s, i);
+  int j, n= decode_int (s, i);
+  array<int> a (n);
+  for (j=0; j<n; j++) a[j]= decode_int (s, i);
+  path p;
+  for (j=n-1; j>=0; j--) p= path (a[j], p);
+  tree t= decode_tree (decode_int (s, i));
+  return modification (k, p, t);
+}
+
+patch
+patch_decoder::decode (int& i) {
+  int type= (int) s[i++];
+  switch (type) {
+  case PATCH_MODIFICATION:
+    {
+      modification m  = decode_modification (i);
+      modification inv= decode_modification (i);
+      return patch (m, inv);
+    }
+  case PATCH_COMPOUND:
+  case PATCH_BRANCH:
+    {
+      int j, n= decode_int (s, i);
+      array<patch> a (n);
+      for (j=0; j<n; j++) a[j]= decode (i);
+      return patch (type == PATCH_BRANCH, a);
+    }
+  case PATCH_BIRTH:
+    {
+      double author= decode_double (s, i);
+      bool birth= (s[i++] == '1');
+      return patch (author, birth);
+    }
+  case PATCH_AUTHOR:
+    {
+      double author= decode_double (s, i);
+      return patch (author, decode (i));
+    }
+  default:
+    FAILED ("invalid patch encoding");
+  }
+  return patch ();
+}
+
+patch
+decode_patch (string s) {
+  patch_decoder dec (s);
+  int i= 0;
+  dec.skip_table (i);
+  return dec.decode (i);
+}
+
+/******************************************************************************
+* Estimating the memory occupied by patches
+******************************************************************************/
+
+static int
+tree_memory (tree t) {
+  if (is_atomic (t)) return sizeof (atomic_rep) + N(t->label);
+  int i, n= N(t), r= sizeof (compound_rep) + n * sizeof (tree);
+  for (i=0; i<n; i++) r += tree_memory (t[i]);
+  return r;
+}
+
+static int
+modification_memory (modification m) {
+  return sizeof (modification_rep) + N(m->p) * sizeof (list_rep<int>) +
+         tree_memory (m->t);
+}
+
+int
+patch_memory (patch p) {
+  // shared subtrees are counted once for each occurrence
+  int i, n, r= sizeof (patch_rep);
+  switch (get_type (p)) {
+  case PATCH_MODIFICATION:
+    r += modification_memory (get_modification (p));
+    r += modification_memory (get_inverse (p));
+    break;
+  case PATCH_COMPOUND:
+  case PATCH_BRANCH:
+  case PATCH_AUTHOR:
+    n= N(p);
+    for (i=0; i<n; i++) r += patch_memory (p[i]);
+    break;
+  default:
+    break;
+  }
+  return r;
+}
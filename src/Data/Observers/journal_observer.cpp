@@ -0,0 +1,137 @@
+
+/******************************************************************************
+* MODULE     : journal_observer.cpp
+* DESCRIPTION: Journals of the modifications of a tree
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* A journal observer is attached to the root of a buffer and records
+* the modifications of the buffer, with paths relative to the root,
+* since the journal was last taken.  This allows the autosave routines
+* to append the recent changes to a file instead of rewriting the whole
+* document.  If the root gets detached, some modifications may have been
+* missed and the journal is no longer valid until it is taken again.
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "modification.hpp"
+
+/******************************************************************************
+* Definition of the journal_observer_rep class
+******************************************************************************/
+
+class journal_observer_rep: public observer_rep {
+  list<modification> mods;   // modifications since the journal was taken,
+                             // the most recent one first
+  bool valid;                // no modifications were missed
+public:
+  journal_observer_rep (): valid (true) {}
+  int get_type () { return OBSERVER_JOURNAL; }
+  tm_ostream& print (tm_ostream& out) { return out << " journal"; }
+
+  void announce (tree& ref, modification mod);
+  bool take_journal (list<modification>& l);
+
+  void reattach           (tree& ref, tree t);
+  void notify_assign      (tree& ref, tree t);
+  void notify_var_split   (tree& ref, tree t1, tree t2);
+  void notify_var_join    (tree& ref, tree t, int offset);
+  void notify_remove_node (tree& ref, int pos);
+  void notify_detach      (tree& ref, tree closest, bool right);
+};
+
+void
+journal_observer_rep::announce (tree& ref, modification mod) {
+  (void) ref;
+  if (!valid || mod->k == MOD_SET_CURSOR) return;
+  // the inserted trees may be modified later on
+  mods= list<modification> (copy (mod), mods);
+}
+
+bool
+journal_observer_rep::take_journal (list<modification>& l) {
+  bool ok= valid;
+  l= reverse (mods);
+  mods= list<modification> ();
+  valid= true;
+  return ok;
+}
+
+/******************************************************************************
+* Reattach when necessary
+******************************************************************************/
+
+void
+journal_observer_rep::reattach (tree& ref, tree t) {
+  if (ref.rep != t.rep) {
+    observer me (this); // the tree holds the only other reference to us
+    remove_observer (ref->obs, me);
+    insert_observer (t->obs, me);
+  }
+}
+
+void
+journal_observer_rep::notify_assign (tree& ref, tree t) {
+  reattach (ref, t);
+}
+
+void
+journal_observer_rep::notify_var_split (tree& ref, tree t1, tree t2) {
+  (void) t2;
+  reattach (ref, t1); // always at the left
+}
+
+void
+journal_observer_rep::notify_var_join (tree& ref, tree t, int offset) {
+  (void) offset;
+  reattach (ref, t);
+}
+
+void
+journal_observer_rep::notify_remove_node (tree& ref, int pos) {
+  reattach (ref, ref[pos]);
+}
+
+void
+journal_observer_rep::notify_detach (tree& ref, tree closest, bool right) {
+  (void) right;
+  reattach (ref, closest);
+  mods= list<modification> ();
+  valid= false;
+}
+
+/******************************************************************************
+* Attaching and detaching journals
+******************************************************************************/
+
+observer
+journal_observer () {
+  return tm_new<journal_observer_rep> ();
+}
+
+bool
+has_journal (tree& ref) {
+  return !is_nil (search_observer (ref, OBSERVER_JOURNAL));
+}
+
+void
+attach_journal (tree& ref) {
+  if (!has_journal (ref))
+    attach_observer (ref, journal_observer ());
+}
+
+void
+detach_journal (tree& ref) {
+  observer obs= search_observer (ref, OBSERVER_JOURNAL);
+  if (!is_nil (obs)) detach_observer (ref, obs);
+}
+
+bool
+journal_take (tree& ref, list<modification>& l) {
+  observer obs= search_observer (ref, OBSERVER_JOURNAL);
+  l= list<modification> ();
+  if (is_nil (obs)) return false;
+  return obs->take_journal (l);
+}
@@ -15,52 +15,157 @@
 #include "vars.hpp"
 #include "boot.hpp"
 
-hashmap<string,list<observer> > id_resolve;
-hashmap<observer,list<string> > pointer_resolve;
-hashmap<tree,list<soft_link> > vertex_occurrences;
-hashmap<string,int> type_count (0);
+/******************************************************************************
+* Sets of occurrences with constant time removals
+******************************************************************************/
 
-static hashset<string> visited_table;
+template<class T> class occurrences;
+template<class T> bool is_nil (occurrences<T> s);
+template<class T> class occurrences_rep: concrete_struct {
+  array<T>   items;  // in the order of insertion, possibly with holes
+  array<int> mult;   // the multiplicities, or zero for the holes
+  hashmap<T,int> pos;// the positions of the items, for larger sets
+  int holes;         // the number of holes
+
+public:
+  inline occurrences_rep (): pos (-1), holes (0) {}
+  int  find (T x);
+  void insert (T x);
+  void remove (T x);
+  bool is_empty ();
+  list<T> as_list ();
+
+  friend class occurrences<T>;
+};
+
+template<class T> class occurrences {
+  CONCRETE_NULL_TEMPLATE(occurrences,T);
+  inline occurrences (T x): rep (tm_new<occurrences_rep<T> > ()) {
+    rep->insert (x); }
+};
+CONCRETE_NULL_TEMPLATE_CODE(occurrences,class,T);
+
+#define OCCURRENCES_SMALL 8
+
+template<class T> int
+occurrences_rep<T>::find (T x) {
+  if (N(items) > OCCURRENCES_SMALL) return pos[x];
+  for (int i=0; i<N(items); i++)
+    if (mult[i] != 0 && items[i] == x) return i;
+  return -1;
+}
 
-extern tree the_et;
+template<class T> void
+occurrences_rep<T>::insert (T x) {
+  int i= find (x);
+  if (i >= 0) { mult[i]++; return; }
+  items << x;
+  mult << 1;
+  if (N(items) == OCCURRENCES_SMALL + 1) {
+    for (int j=0; j<N(items); j++)
+      if (mult[j] != 0) pos (items[j])= j;
+  }
+  else if (N(items) > OCCURRENCES_SMALL) pos (x)= N(items) - 1;
+}
+
+template<class T> void
+occurrences_rep<T>::remove (T x) {
+  // like for the lists which were used before, all occurrences are removed
+  int i= find (x);
+  if (i < 0) return;
+  mult[i]= 0;
+  holes++;
+  if (N(items) > OCCURRENCES_SMALL) pos->reset (x);
+  if (2 * holes <= N(items)) return;
+  // compact once half of the entries are holes, in amortized constant time
+  int j= 0, n= N(items);
+  for (i=0; i<n; i++)
+    if (mult[i] != 0) {
+      items[j]= items[i];
+      mult[j]= mult[i];
+      j++;
+    }
+  items->resize (j);
+  mult->resize (j);
+  holes= 0;
+  pos= hashmap<T,int> (-1);
+  if (j > OCCURRENCES_SMALL)
+    for (i=0; i<j; i++) pos (items[i])= i;
+}
+
+template<class T> bool
+occurrences_rep<T>::is_empty () {
+  return holes == N(items);
+}
+
+template<class T> list<T>
+occurrences_rep<T>::as_list () {
+  // most recent occurrences first
+  list<T> l;
+  for (int i=0; i<N(items); i++)
+    for (int k=0; k<mult[i]; k++)
+      l= list<T> (items[i], l);
+  return l;
+}
+
+template<class K, class T> static void
+insert_occurrence (hashmap<K,occurrences<T> >& h, K key, T x) {
+  occurrences<T>& s= h (key);
+  if (is_nil (s)) s= occurrences<T> (x);
+  else s->insert (x);
+}
+
+template<class K, class T> static void
+remove_occurrence (hashmap<K,occurrences<T> >& h, K key, T x) {
+  if (!h->contains (key)) return;
+  occurrences<T>& s= h (key);
+  s->remove (x);
+  if (s->is_empty ()) h->reset (key);
+}
+
+template<class K, class T> static list<T>
+get_occurrences (hashmap<K,occurrences<T> >& h, K key) {
+  if (!h->contains (key)) return list<T> ();
+  return h[key]->as_list ();
+}
 
 /******************************************************************************
 * Soft links
 ******************************************************************************/
 
+hashmap<string,occurrences<observer> > id_resolve;
+hashmap<observer,occurrences<string> > pointer_resolve;
+hashmap<tree,occurrences<soft_link> > vertex_occurrences;
+hashmap<string,int> type_count (0);
+
+static hashset<string> visited_table;
+
+extern tree the_et;
+
 void
 register_pointer (string id, observer which) {
   // cout << "Register: " << id << " -> " << which << "\n";
   // cout << "Register: " << id << " -> " << obtain_tree (which) << "\n";
-  list<observer>& l1= id_resolve (id);
-  l1= list<observer> (which, l1);
-  list<string>& l2= pointer_resolve (which);
-  l2= list<string> (id, l2);
+  insert_occurrence (id_resolve, id, which);
+  insert_occurrence (pointer_resolve, which, id);
 }
 
 void
 unregister_pointer (string id, observer which) {
   // cout << "Unregister: " << id << " -> " << which << "\n";
   // cout << "Unregister: " << id << " -> " << obtain_tree (which) << "\n";
-  list<observer>& l1= id_resolve (id);
-  l1= remove (l1, which);
-  if (is_nil (l1)) id_resolve->reset (id);
-  list<string>& l2= pointer_resolve (which);
-  l2= remove (l2, id);
-  if (is_nil (l2)) pointer_resolve->reset (which);
+  remove_occurrence (id_resolve, id, which);
+  remove_occurrence (pointer_resolve, which, id);
 }
 
 void
 register_vertex (tree v, soft_link ln) {
-  list<soft_link>& l= vertex_occurrences (v);
-  l= list<soft_link> (ln, l);
+  insert_occurrence (vertex_occurrences, v, ln);
 }
 
 void
 unregister_vertex (tree v, soft_link ln) {
-  list<soft_link>& l= vertex_occurrences (v);
-  l= remove (l, ln);
-  if (is_nil (l)) vertex_occurrences->reset (v);
+  remove_occurrence (vertex_occurrences, v, ln);
 }
 
 void
@@ -137,7 +242,7 @@ link_repository_rep::insert_link (soft_link ln) {
 list<string>
 get_ids (list<observer> l) {
   if (is_nil (l)) return list<string> ();
-  return pointer_resolve [l->item] * get_ids (l->next);
+  return get_occurrences (pointer_resolve, l->item) * get_ids (l->next);
 }
 
 list<string>
@@ -155,7 +260,7 @@ as_trees (list<observer> l) {
 
 list<tree>
 get_trees (string id) {
-  return reverse (as_trees (id_resolve [id]));
+  return reverse (as_trees (get_occurrences (id_resolve, id)));
 }
 
 list<tree>
@@ -166,7 +271,7 @@ as_tree_list (list<soft_link> l) {
 
 list<tree>
 get_links (tree v) {
-  return reverse (as_tree_list (vertex_occurrences [v]));
+  return reverse (as_tree_list (get_occurrences (vertex_occurrences, v)));
 }
 
 list<string>
@@ -254,7 +359,7 @@ link_announce (tree ln, string id, modification mod) {
 void
 link_announce (observer obs, modification mod) {
   //cout << "Link event " << mod << "\n";
-  for (list<string> ids= pointer_resolve [obs];
+  for (list<string> ids= get_occurrences (pointer_resolve, obs);
        !is_nil (ids); ids= ids->next)
     for (list<tree> lns= get_links (compound ("id", ids->item));
          !is_nil (lns); lns= lns->next)
@@ -33,7 +33,7 @@ public:
 
 class soft_link {
 public:
-CONCRETE(soft_link);
+CONCRETE_NULL(soft_link);
 public:
   inline soft_link (tree t):
     rep (tm_new<soft_link_rep> (t)) {}
@@ -41,10 +41,12 @@ public:
     return ln1.rep == ln2.rep; }
   inline friend bool operator != (soft_link ln1, soft_link ln2) {
     return ln1.rep != ln2.rep; }
+  inline friend int hash (soft_link ln) {
+    return hash ((pointer) ln.rep); }
   inline friend tm_ostream& operator << (tm_ostream& out, soft_link ln) {
     return out << "soft_link (" << ln.rep << ")"; }
 };
-CONCRETE_CODE(soft_link);
+CONCRETE_NULL_CODE(soft_link);
 
 /******************************************************************************
 * Link repositories
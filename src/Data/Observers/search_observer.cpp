@@ -0,0 +1,319 @@
+
+/******************************************************************************
+* MODULE     : search_observer.cpp
+* DESCRIPTION: Incrementally maintained text indices for searching
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* A search observer is attached to the root of a buffer and maintains
+* a mirror of the tree, in which each node records how many times each
+* trigram of (lowercase) characters occurs inside the corresponding subtree.
+* Plain string queries only need to descend into the subtrees which
+* contain all trigrams of the query.  Modifications are announced to
+* the observer with a path relative to the root; the mirror is updated
+* by removing the old contribution of the touched children when
+* the modification is announced and adding the new one when it is done.
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "modification.hpp"
+#include "analyze.hpp"
+#include "iterator.hpp"
+
+/******************************************************************************
+* Index nodes
+******************************************************************************/
+
+class search_node;
+class search_node_rep: concrete_struct {
+public:
+  bool leaf;                 // true for atomic trees
+  hashmap<int,int> grams;    // trigram -> number of occurrences in subtree
+  array<search_node> a;      // index nodes for the children
+  search_node_rep (): leaf (true), grams (0) {}
+  friend class search_node;
+};
+
+class search_node {
+  CONCRETE_NULL(search_node);
+  search_node (tree t);
+};
+CONCRETE_NULL_CODE(search_node);
+
+static inline int
+trigram (string s, int i) {
+  return (((int) (unsigned char) s[i]) << 16) +
+         (((int) (unsigned char) s[i+1]) << 8) +
+         ((int) (unsigned char) s[i+2]);
+}
+
+static void
+add_grams (hashmap<int,int>& h, hashmap<int,int> d, int sign) {
+  iterator<int> it= iterate (d);
+  while (it->busy ()) {
+    int g= it->next ();
+    int c= h[g] + sign * d[g];
+    if (c == 0) h->reset (g);
+    else h(g)= c;
+  }
+}
+
+search_node::search_node (tree t): rep (tm_new<search_node_rep> ()) {
+  if (is_atomic (t)) {
+    string s= locase_all (t->label);
+    for (int i=0; i+2<N(s); i++) {
+      int g= trigram (s, i);
+      rep->grams(g)= rep->grams[g] + 1;
+    }
+  }
+  else {
+    rep->leaf= false;
+    int i, n= N(t);
+    rep->a= array<search_node> (n);
+    for (i=0; i<n; i++) {
+      rep->a[i]= search_node (t[i]);
+      add_grams (rep->grams, rep->a[i]->grams, 1);
+    }
+  }
+}
+
+/******************************************************************************
+* Definition of the search_observer_rep class
+******************************************************************************/
+
+class search_observer_rep: public observer_rep {
+  search_node idx;           // the index
+  bool   dirty;              // index needs to be rebuilt from scratch
+  bool   pending;            // a modification has been announced
+  path   r;                  // path to the node whose children changed
+  int    i;                  // first changed child
+  int    old_nr;             // number of children before the modification
+  int    new_nr;             // number of children after the modification
+public:
+  search_observer_rep (tree t):
+    idx (t), dirty (false), pending (false), i (0), old_nr (0), new_nr (0) {}
+  int get_type () { return OBSERVER_SEARCH; }
+  tm_ostream& print (tm_ostream& out) { return out << " search_index"; }
+
+  void announce (tree& ref, modification mod);
+  void done     (tree& ref, modification mod);
+  bool get_search_candidates (tree& ref, string what, array<path>& a);
+
+  void reattach           (tree& ref, tree t);
+  void notify_assign      (tree& ref, tree t);
+  void notify_var_split   (tree& ref, tree t1, tree t2);
+  void notify_var_join    (tree& ref, tree t, int offset);
+  void notify_remove_node (tree& ref, int pos);
+  void notify_detach      (tree& ref, tree closest, bool right);
+
+private:
+  bool changed_range (tree& ref, modification mod);
+  void update (path p, search_node n, int sign);
+};
+
+/******************************************************************************
+* Updating the index
+******************************************************************************/
+
+bool
+search_observer_rep::changed_range (tree& ref, modification mod) {
+  // Determine the range of children [i, i+old_nr) of the node at r which
+  // is replaced by [i, i+new_nr) after the modification.
+  // Returns false if the modification does not affect the text.
+  path p= root (mod);
+  switch (mod->k) {
+  case MOD_ASSIGN:
+    r= p; i= -1; old_nr= new_nr= 1;
+    break;
+  case MOD_INSERT:
+  case MOD_REMOVE:
+    if (is_atomic (subtree (ref, p))) {
+      r= p; i= -1; old_nr= new_nr= 1;
+    }
+    else {
+      int nr= (mod->k == MOD_INSERT? N(mod->t): argument (mod));
+      r= p; i= index (mod);
+      old_nr= (mod->k == MOD_INSERT? 0: nr);
+      new_nr= (mod->k == MOD_INSERT? nr: 0);
+    }
+    break;
+  case MOD_SPLIT:
+    r= p; i= index (mod); old_nr= 1; new_nr= 2;
+    break;
+  case MOD_JOIN:
+    r= p; i= index (mod); old_nr= 2; new_nr= 1;
+    break;
+  case MOD_INSERT_NODE:
+  case MOD_REMOVE_NODE:
+    r= p; i= -1; old_nr= new_nr= 1;
+    break;
+  default:
+    return false;
+  }
+  if (i < 0 && !is_nil (r)) {
+    // the node at r itself is replaced
+    i= last_item (r);
+    r= path_up (r);
+  }
+  // i < 0 at this point means that the whole tree is replaced
+  return true;
+}
+
+void
+search_observer_rep::update (path p, search_node n, int sign) {
+  // add or remove the trigrams of n to the nodes along p
+  search_node cur= idx;
+  add_grams (cur->grams, n->grams, sign);
+  for (path q= p; !is_nil (q); q= q->next) {
+    cur= cur->a[q->item];
+    add_grams (cur->grams, n->grams, sign);
+  }
+}
+
+void
+search_observer_rep::announce (tree& ref, modification mod) {
+  if (dirty) return;
+  if (pending || !changed_range (ref, mod)) {
+    if (pending) dirty= true;
+    return;
+  }
+  pending= true;
+  if (i < 0) return;
+  search_node n= idx;
+  for (path q= r; !is_nil (q); q= q->next) n= n->a[q->item];
+  for (int k=i; k<i+old_nr; k++) update (r, n->a[k], -1);
+}
+
+void
+search_observer_rep::done (tree& ref, modification mod) {
+  (void) mod;
+  if (!pending || dirty) return;
+  pending= false;
+  if (i < 0) {
+    idx= search_node (ref);
+    return;
+  }
+  search_node n= idx;
+  for (path q= r; !is_nil (q); q= q->next) n= n->a[q->item];
+  tree& t= subtree (ref, r);
+  array<search_node> a= n->a;
+  array<search_node> b (N(a) - old_nr + new_nr);
+  int k;
+  for (k=0; k<i; k++) b[k]= a[k];
+  for (k=0; k<new_nr; k++) b[i+k]= search_node (t[i+k]);
+  for (k=i+old_nr; k<N(a); k++) b[k-old_nr+new_nr]= a[k];
+  n->a= b;
+  for (k=i; k<i+new_nr; k++) update (r, b[k], 1);
+}
+
+/******************************************************************************
+* Queries
+******************************************************************************/
+
+static void
+get_candidates (search_node n, array<int> q, path p, array<path>& a) {
+  for (int k=0; k<N(q); k++)
+    if (!n->grams->contains (q[k])) return;
+  if (n->leaf) a << reverse (p);
+  else
+    for (int k=0; k<N(n->a); k++)
+      get_candidates (n->a[k], q, path (k, p), a);
+}
+
+bool
+search_observer_rep::get_search_candidates (tree& ref, string what,
+                                            array<path>& a)
+{
+  string s= locase_all (what);
+  if (N(s) < 3) return false;
+  if (dirty || pending) {
+    idx= search_node (ref);
+    dirty= pending= false;
+  }
+  hashmap<int,int> h (0);
+  array<int> q;
+  for (int k=0; k+2<N(s); k++)
+    if (!h->contains (trigram (s, k))) {
+      h (trigram (s, k))= 1;
+      q << trigram (s, k);
+    }
+  get_candidates (idx, q, path (), a);
+  return true;
+}
+
+/******************************************************************************
+* Reattach when necessary
+******************************************************************************/
+
+void
+search_observer_rep::reattach (tree& ref, tree t) {
+  if (ref.rep != t.rep) {
+    observer me (this); // the tree holds the only other reference to us
+    remove_observer (ref->obs, me);
+    insert_observer (t->obs, me);
+  }
+}
+
+void
+search_observer_rep::notify_assign (tree& ref, tree t) {
+  reattach (ref, t);
+}
+
+void
+search_observer_rep::notify_var_split (tree& ref, tree t1, tree t2) {
+  (void) t2;
+  reattach (ref, t1); // always at the left
+}
+
+void
+search_observer_rep::notify_var_join (tree& ref, tree t, int offset) {
+  (void) ref; (void) offset;
+  reattach (ref, t);
+}
+
+void
+search_observer_rep::notify_remove_node (tree& ref, int pos) {
+  reattach (ref, ref[pos]);
+}
+
+void
+search_observer_rep::notify_detach (tree& ref, tree closest, bool right) {
+  (void) right;
+  reattach (ref, closest);
+  dirty= true;
+}
+
+/******************************************************************************
+* Attaching and detaching search indices
+******************************************************************************/
+
+observer
+search_index_observer (tree t) {
+  return tm_new<search_observer_rep> (t);
+}
+
+bool
+has_search_index (tree& ref) {
+  return !is_nil (search_observer (ref, OBSERVER_SEARCH));
+}
+
+void
+attach_search_index (tree& ref) {
+  if (!has_search_index (ref))
+    attach_observer (ref, search_index_observer (ref));
+}
+
+void
+detach_search_index (tree& ref) {
+  observer obs= search_observer (ref, OBSERVER_SEARCH);
+  if (!is_nil (obs)) detach_observer (ref, obs);
+}
+
+bool
+search_index_candidates (tree& ref, string what, array<path>& a) {
+  observer obs= search_observer (ref, OBSERVER_SEARCH);
+  if (is_nil (obs)) return false;
+  return obs->get_search_candidates (ref, what, a);
+}
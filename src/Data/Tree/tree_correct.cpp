@@ -14,6 +14,26 @@
 #include "scheme.hpp"
 #include "packrat.hpp"
 
+/******************************************************************************
+* Reuse unchanged subtrees
+******************************************************************************/
+
+static tree
+reuse (tree t, tree r) {
+  // return t instead of its correction r when r is the same as t,
+  // up to the identity of its atomic children
+  if (strong_equal (t, r)) return t;
+  if (is_atomic (t) || is_atomic (r))
+    return (is_atomic (t) && is_atomic (r) && t->label == r->label)? t: r;
+  int i, n= N(t);
+  if (L(t) != L(r) || N(r) != n) return r;
+  for (i=0; i<n; i++)
+    if (!strong_equal (t[i], r[i]) &&
+        (is_compound (t[i]) || is_compound (r[i]) ||
+         t[i]->label != r[i]->label)) return r;
+  return t;
+}
+
 /******************************************************************************
 * DRD based correction
 ******************************************************************************/
@@ -184,6 +204,7 @@ with_correct (tree t) {
     tree u (t, N(t));
     for (int k=0; k<N(t); k++)
       u[k]= with_correct (t[k]);
+    u= reuse (t, u);
     array<tree> a= concat_decompose (u);
     int i, n= N(a);
     array<tree> r;
@@ -202,6 +223,7 @@ with_correct (tree t) {
         if (k1 < k2) x << with_recompose (a[i], range (b, k1, k2));
         if (k2 < p ) x << range (b, k2, p);
         if (N(x) == 0) continue;
+        if (N(x) == 1) x[0]= reuse (a[i], x[0]);
         if (N(r) != 0 &&
             is_with_like (r[N(r)-1]) &&
             with_same_type (r[N(r)-1], x[0]))
@@ -217,7 +239,7 @@ with_correct (tree t) {
     }
     //cout << UNINDENT << "Corrected " << t << " -> "
     //<< concat_recompose (r) << LF;
-    return concat_recompose (r);
+    return reuse (t, concat_recompose (r));
   }
 }
 
@@ -227,13 +249,16 @@ superfluous_with_correct (tree t, tree env) {
   else {
     //cout << "Superfluous correcting " << t << ", " << env << LF;
     if (is_compound (t, "body", 1))
-      return compound ("body", superfluous_with_correct (t[0], env));
+      return reuse (t, compound ("body",
+                                 superfluous_with_correct (t[0], env)));
+    tree u= t;
     if (is_func (t, WITH) && ((N(t) & 1) == 0))
       t= t * tree (WITH, "");
     tree r (t, N(t));
     for (int i=0; i<N(t); i++)
       r[i]= superfluous_with_correct
               (t[i], the_drd->get_env_child (t, i, env));
+    r= reuse (u, r);
     if (is_compound (r, "math", 1) && r[0] == "") return "";
     else if (is_compound (r, "text", 1) && r[0] == "") return "";
     else if (is_compound (r, "math", 1) && drd_env_read (env, MODE) == "math")
@@ -248,7 +273,7 @@ superfluous_with_correct (tree t, tree env) {
     }
     else if (is_func (r, CONCAT)) {
       array<tree> a= concat_decompose (r);
-      return concat_recompose (a);
+      return reuse (r, concat_recompose (a));
     }
     return r;
   }
@@ -365,9 +390,9 @@ homoglyph_correct (tree t, string mode) {
     tree ret= concat_recompose (a);
     //if (ret != r) cout << "< " << r << " >" << LF
     //<< "> " << ret << " <" << LF;
-    return ret;
+    return reuse (t, ret);
   }
-  else return r;
+  else return reuse (t, r);
 }
 
 tree
@@ -419,24 +444,8 @@ superfluous_invisible_correct (array<tree> a) {
 }
 
 static tree
-superfluous_invisible_correct (tree t, string mode) {
-  //cout << "Correct " << t << ", " << mode << "\n";
-  tree r= t;
-  if (is_compound (t)) {
-    int i, n= N(t);
-    r= tree (t, n);
-    for (i=0; i<n; i++) {
-      string smode= get_submode (t, i, mode);
-      //cout << "  " << i << ": " << is_correctable_child (t, i)
-      //<< ", " << smode << "\n";
-      if (is_func (t, WITH) && i != N(t)-1)
-        r[i]= t[i];
-      else if (is_correctable_child (t, i))
-        r[i]= superfluous_invisible_correct (t[i], smode);
-      else r[i]= t[i];
-    }
-  }
-  
+superfluous_preamble_correct (tree r) {
+  // a preamble surrounded by spaces
   if (is_func (r, CONCAT)) {
     bool ok= true;
     int i, found= -1;
@@ -453,8 +462,30 @@ superfluous_invisible_correct (tree t, string mode) {
         for (int j=0; j<N(s); j++)
           if (s[j] != ' ') ok= false;
       }
-    if (ok) r= r[found];
+    if (ok && found != -1) return r[found];
   }
+  return r;
+}
+
+static tree
+superfluous_invisible_correct (tree t, string mode) {
+  //cout << "Correct " << t << ", " << mode << "\n";
+  tree r= t;
+  if (is_compound (t)) {
+    int i, n= N(t);
+    r= tree (t, n);
+    for (i=0; i<n; i++) {
+      string smode= get_submode (t, i, mode);
+      //cout << "  " << i << ": " << is_correctable_child (t, i)
+      //<< ", " << smode << "\n";
+      if (is_func (t, WITH) && i != N(t)-1)
+        r[i]= t[i];
+      else if (is_correctable_child (t, i))
+        r[i]= superfluous_invisible_correct (t[i], smode);
+      else r[i]= t[i];
+    }
+  }
+  r= superfluous_preamble_correct (r);
 
   if (is_func (r, INACTIVE, 1) && is_func (r[0], RIGID))
     return r[0];
@@ -464,9 +495,9 @@ superfluous_invisible_correct (tree t, string mode) {
     tree ret= concat_recompose (a);
     //if (ret != r) cout << "< " << r << " >" << LF
     //<< "> " << ret << " <" << LF;
-    return ret;
+    return reuse (t, ret);
   }
-  else return r;
+  else return reuse (t, r);
 }
 
 tree
@@ -500,16 +531,20 @@ protected:
   bool contains_plus_like (tree t);
   bool contains_separator (tree t);
   void count_invisible (array<tree> a);
-  void count_invisible (tree t, string mode);
   int  get_status (tree t, bool left, bool script_flag);
   array<tree> correct (array<tree> a);
 
 public:
+  inline invisible_corrector (int force2):
+    force (force2), times_before (0), times_after (0), space_after (0) {
+      space_after ("o")= 1000000;
+      space_after ("O")= 1000000; }
   inline invisible_corrector (tree t, int force2):
     force (force2), times_before (0), times_after (0), space_after (0) {
       space_after ("o")= 1000000;
       space_after ("O")= 1000000;
       count_invisible (t, "text"); }
+  void count_invisible (tree t, string mode);
   tree correct (tree t, string mode);
 };
 
@@ -772,9 +807,9 @@ invisible_corrector::correct (tree t, string mode) {
     //if (ret != r)
     //  cout << "<< " << r << " >>" << LF
     //       << ">> " << ret << " <<" << LF;
-    return ret;
+    return reuse (t, ret);
   }
-  else return r;
+  else return reuse (t, r);
 }
 
 tree
@@ -792,12 +827,142 @@ missing_invisible_correct (tree t, int force) {
 }
 
 tree
-missing_invisible_correct_twice (tree t, int force= -1) {
+missing_invisible_correct_twice (tree t, int force) {
   tree u= missing_invisible_correct (t, force);
   if (u == t) return t;
   return missing_invisible_correct (u, force);
 }
 
+/******************************************************************************
+* Fused corrections of invisible symbols and homoglyphs
+*******************************************************************************
+* The corrections below yield the same result as the sequence
+*   superfluous_invisible_correct, homoglyph_correct,
+*   superfluous_invisible_correct, missing_invisible_correct_twice,
+*   missing_invisible_correct (force= 1),
+* restricted to the enabled corrections.  Outside mathematics, the first
+* three corrections only remove superfluous spaces around preambles, so they
+* are applied in a single traversal, which applies the sequence to the
+* maximal mathematical subtrees.  The insertion of missing invisible symbols
+* relies on statistics for the whole document, which are gathered during
+* the previous traversal.  Identical formulas are only corrected once
+* and subtrees which need no correction are reused.
+******************************************************************************/
+
+static tree
+math_correct_sequence (tree t, string mode, int flags) {
+  if ((flags & MATH_CORRECT_SUPERFLUOUS) != 0)
+    t= superfluous_invisible_correct (t, mode);
+  if ((flags & MATH_CORRECT_HOMOGLYPH) != 0)
+    t= homoglyph_correct (t, mode);
+  if ((flags & MATH_CORRECT_SUPERFLUOUS) != 0)
+    t= superfluous_invisible_correct (t, mode);
+  return t;
+}
+
+static tree
+math_correct (tree t, string mode, int flags,
+              invisible_corrector* counter, hashmap<tree,tree>& done) {
+  if (mode == "math" || is_func (t, INACTIVE, 1)) {
+    // NOTE: inactive rigid markup is removed after correcting its body
+    tree r;
+    if (mode == "math" && done->contains (t)) {
+      r= done[t];
+      if (r == t) r= t;
+    }
+    else {
+      r= math_correct_sequence (t, mode, flags);
+      if (mode == "math") done (t)= r;
+    }
+    if (counter != NULL) counter->count_invisible (r, mode);
+    return r;
+  }
+  if (is_atomic (t)) return t;
+  int i, n= N(t);
+  tree r (t, n);
+  for (i=0; i<n; i++) {
+    string smode= get_submode (t, i, mode);
+    if (!is_correctable_child (t, i))
+      r[i]= t[i];
+    else if (!is_func (t, WITH) || i == n-1)
+      r[i]= math_correct (t[i], smode, flags, counter, done);
+    else if ((flags & MATH_CORRECT_HOMOGLYPH) != 0)
+      r[i]= homoglyph_correct (t[i], smode);
+    else r[i]= t[i];
+  }
+  if ((flags & MATH_CORRECT_SUPERFLUOUS) != 0)
+    r= superfluous_preamble_correct (r);
+  return reuse (t, r);
+}
+
+static tree
+missing_invisible_correct (invisible_corrector& corrector, tree t, string mode,
+                           invisible_corrector* counter,
+                           hashmap<tree,tree>& done) {
+  if (mode == "math") {
+    tree r;
+    if (done->contains (t)) {
+      r= done[t];
+      if (r == t) r= t;
+    }
+    else {
+      r= corrector.correct (t, mode);
+      done (t)= r;
+    }
+    if (counter != NULL) counter->count_invisible (r, mode);
+    return r;
+  }
+  if (is_atomic (t)) return t;
+  int i, n= N(t);
+  tree r (t, n);
+  for (i=0; i<n; i++) {
+    string smode= get_submode (t, i, mode);
+    if ((is_func (t, WITH) && i != n-1) || !is_correctable_child (t, i))
+      r[i]= t[i];
+    else r[i]= missing_invisible_correct (corrector, t[i], smode,
+                                          counter, done);
+  }
+  return reuse (t, r);
+}
+
+static tree
+missing_invisible_correct (invisible_corrector& corrector, tree t,
+                           invisible_corrector* counter) {
+  hashmap<tree,tree> done (UNINIT);
+  return missing_invisible_correct (corrector, t, "text", counter, done);
+}
+
+tree
+math_correct (tree t, int flags) {
+  with_drd drd (get_document_drd (t));
+  bool missing= (flags & MATH_CORRECT_MISSING) != 0;
+  bool zealous= (flags & MATH_CORRECT_ZEALOUS) != 0;
+  invisible_corrector first (-1);
+  invisible_corrector* counter= (missing || zealous? &first: NULL);
+  if ((flags & (MATH_CORRECT_SUPERFLUOUS | MATH_CORRECT_HOMOGLYPH)) != 0) {
+    hashmap<tree,tree> done (UNINIT);
+    t= math_correct (t, "text", flags, counter, done);
+  }
+  else if (counter != NULL) first.count_invisible (t, "text");
+  if (!missing) {
+    if (!zealous) return t;
+    first.force= 1;
+    return missing_invisible_correct (first, t, NULL);
+  }
+
+  invisible_corrector second (-1);
+  tree u= missing_invisible_correct (first, t, &second);
+  if (u != t) {
+    invisible_corrector third (1);
+    t= missing_invisible_correct (second, u, zealous? &third: NULL);
+    if (!zealous) return t;
+    return missing_invisible_correct (third, t, NULL);
+  }
+  if (!zealous) return t;
+  second.force= 1;
+  return missing_invisible_correct (second, t, NULL);
+}
+
 /******************************************************************************
 * Miscellaneous corrections
 ******************************************************************************/
@@ -897,6 +1062,17 @@ count_math_table_errors (tree t, int mode) {
   }
 }
 
+static int
+count_math_child_errors (tree t, tree cmode, int mode) {
+  if (cmode != "math") return count_math_errors (t, mode);
+  while (is_func (t, DOCUMENT, 1) ||
+         is_func (t, TFORMAT) ||
+         is_func (t, WITH))
+    t= t[N(t)-1];
+  if (is_func (t, TABLE)) return count_math_table_errors (t, mode);
+  else return count_math_formula_errors (t, mode);
+}
+
 int
 count_math_errors (tree t, int mode) {
   if (is_atomic (t)) return 0;
@@ -904,21 +1080,32 @@ count_math_errors (tree t, int mode) {
     int sum= 0;
     for (int i=0; i<N(t); i++) {
       tree cmode= the_drd->get_env_child (t, i, MODE, "text");
-      if (cmode != "math") sum += count_math_errors (t[i], mode);
-      else {
-        tree u= t[i];
-        while (is_func (u, DOCUMENT, 1) ||
-               is_func (u, TFORMAT) ||
-               is_func (u, WITH))
-          u= u[N(u)-1];
-        if (is_func (u, TABLE)) sum += count_math_table_errors (u, mode);
-        else sum += count_math_formula_errors (u, mode);
-      }
+      sum += count_math_child_errors (t[i], cmode, mode);
     }
     return sum;
   }
 }
 
+static int
+count_new_math_errors (tree t, tree u) {
+  // count_math_errors (u) - count_math_errors (t), where u is a correction
+  // of t, which shares the subtrees which were not modified
+  if (strong_equal (t, u)) return 0;
+  if (is_atomic (t) || is_atomic (u) || L(t) != L(u) || N(t) != N(u))
+    return count_math_errors (u) - count_math_errors (t);
+  int sum= 0;
+  for (int i=0; i<N(t); i++) {
+    tree tmode= the_drd->get_env_child (t, i, MODE, "text");
+    tree umode= the_drd->get_env_child (u, i, MODE, "text");
+    if (tmode != "math" && umode != "math")
+      sum += count_new_math_errors (t[i], u[i]);
+    else if (tmode != umode || t[i] != u[i])
+      sum += count_math_child_errors (u[i], umode, 0) -
+             count_math_child_errors (t[i], tmode, 0);
+  }
+  return sum;
+}
+
 /******************************************************************************
 * Print mathematical status
 ******************************************************************************/
@@ -937,9 +1124,9 @@ static int corrected_homoglyph= 0;
 static int corrected_missing_invisible= 0;
 static int corrected_zealous_invisible= 0;
 
-void
-math_status_cumul_sub (tree t, int& cumul, int& errors) {
-  int new_errors= count_math_errors (t);
+static void
+math_status_cumul_sub (tree old_t, tree t, int& cumul, int& errors) {
+  int new_errors= errors + count_new_math_errors (old_t, t);
   cumul += (errors - new_errors);
   errors= new_errors;
 }
@@ -957,29 +1144,29 @@ math_status_cumul (tree t) {
   int errors= count_math_errors (t);
   count_formula += count_math_errors (t, 1);
   count_initial_errors += errors;
-  t= with_correct (t);
-  math_status_cumul_sub (t, corrected_with, errors);
-  t= superfluous_with_correct (t);
-  math_status_cumul_sub (t, corrected_superfluous_with, errors);
-  t= upgrade_brackets (t);
-  math_status_cumul_sub (t, corrected_brackets, errors);
-  t= move_brackets (t);
-  math_status_cumul_sub (t, corrected_move_brackets, errors);
-  t= misc_math_correct (t);
-  math_status_cumul_sub (t, corrected_misc, errors);
-  t= superfluous_invisible_correct (t);
-  math_status_cumul_sub (t, corrected_superfluous_invisible, errors);
-  t= homoglyph_correct (t);
-  math_status_cumul_sub (t, corrected_homoglyph, errors);
-  t= superfluous_invisible_correct (t);
-  math_status_cumul_sub (t, corrected_superfluous_invisible, errors);
-  t= missing_invisible_correct (t);
-  math_status_cumul_sub (t, corrected_missing_invisible, errors);
+  tree u= with_correct (t);
+  math_status_cumul_sub (t, u, corrected_with, errors);
+  t= superfluous_with_correct (u);
+  math_status_cumul_sub (u, t, corrected_superfluous_with, errors);
+  u= upgrade_brackets (t);
+  math_status_cumul_sub (t, u, corrected_brackets, errors);
+  t= move_brackets (u);
+  math_status_cumul_sub (u, t, corrected_move_brackets, errors);
+  u= misc_math_correct (t);
+  math_status_cumul_sub (t, u, corrected_misc, errors);
+  t= superfluous_invisible_correct (u);
+  math_status_cumul_sub (u, t, corrected_superfluous_invisible, errors);
+  u= homoglyph_correct (t);
+  math_status_cumul_sub (t, u, corrected_homoglyph, errors);
+  t= superfluous_invisible_correct (u);
+  math_status_cumul_sub (u, t, corrected_superfluous_invisible, errors);
+  u= missing_invisible_correct (t);
+  math_status_cumul_sub (t, u, corrected_missing_invisible, errors);
   count_final_errors += errors;
   //cout << "Errors= " << errors << "\n";
-  //(void) count_math_errors (t, 2);
-  t= missing_invisible_correct (t, 1);
-  math_status_cumul_sub (t, corrected_zealous_invisible, errors);
+  //(void) count_math_errors (u, 2);
+  t= missing_invisible_correct (u, 1);
+  math_status_cumul_sub (u, t, corrected_zealous_invisible, errors);
 }
 
 void
@@ -1037,36 +1224,32 @@ tree
 latex_correct (tree t) {
   // NOTE: matching brackets corrected in upgrade_tex
   t= misc_math_correct (t);
-  //if (enabled_preference ("remove superfluous invisible"))
-  t= superfluous_invisible_correct (t);
-  //if (enabled_preference ("homoglyph correct"))
-  t= homoglyph_correct (t);
-  //if (enabled_preference ("remove superfluous invisible"))
-  t= superfluous_invisible_correct (t);
-  //if (enabled_preference ("insert missing invisible"))
-  t= missing_invisible_correct_twice (t);
-  //if (enabled_preference ("insert missing invisible"))
-  t= missing_invisible_correct (t, 1);
+  t= math_correct (t, MATH_CORRECT_ALL);
   t= downgrade_big (t);
   t= correct_missing_block (t);
   t= correct_concat_block (t);
   return t;
 }
 
+static int
+math_correct_flags (string prefix) {
+  int flags= 0;
+  if (enabled_preference (prefix * "remove superfluous invisible"))
+    flags += MATH_CORRECT_SUPERFLUOUS;
+  if (enabled_preference (prefix * "homoglyph correct"))
+    flags += MATH_CORRECT_HOMOGLYPH;
+  if (enabled_preference (prefix * "insert missing invisible"))
+    flags += MATH_CORRECT_MISSING;
+  if (enabled_preference (prefix * "zealous invisible correct"))
+    flags += MATH_CORRECT_ZEALOUS;
+  return flags;
+}
+
 tree
 automatic_correct (tree t, string version) {
   if (version_inf_eq (version, "1.0.7.9")) {
     t= misc_math_correct (t);
-    if (enabled_preference ("remove superfluous invisible"))
-      t= superfluous_invisible_correct (t);
-    if (enabled_preference ("homoglyph correct"))
-      t= homoglyph_correct (t);
-    if (enabled_preference ("remove superfluous invisible"))
-      t= superfluous_invisible_correct (t);
-    if (enabled_preference ("insert missing invisible"))
-      t= missing_invisible_correct_twice (t);
-    if (enabled_preference ("zealous invisible correct"))
-      t= missing_invisible_correct (t, 1);
+    t= math_correct (t, math_correct_flags (""));
   }
   t= downgrade_big (t);
   return t;
@@ -1078,16 +1261,7 @@ manual_correct (tree t) {
   t= superfluous_with_correct (t);
   t= upgrade_brackets (t);
   t= misc_math_correct (t);
-  if (enabled_preference ("manual remove superfluous invisible"))
-    t= superfluous_invisible_correct (t);
-  if (enabled_preference ("manual homoglyph correct"))
-    t= homoglyph_correct (t);
-  if (enabled_preference ("manual remove superfluous invisible"))
-    t= superfluous_invisible_correct (t);
-  if (enabled_preference ("manual insert missing invisible"))
-    t= missing_invisible_correct_twice (t);
-  if (enabled_preference ("manual zealous invisible correct"))
-    t= missing_invisible_correct (t, 1);
+  t= math_correct (t, math_correct_flags ("manual "));
   t= downgrade_big (t);
   return t;
 }
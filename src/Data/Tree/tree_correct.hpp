@@ -18,13 +18,22 @@ tree correct_concat_block (tree t);
 tree with_correct (tree t);
 tree superfluous_with_correct (tree t);
 tree superfluous_invisible_correct (tree t);
+tree homoglyph_correct (tree t);
 tree missing_invisible_correct (tree t, int force= -1);
+tree missing_invisible_correct_twice (tree t, int force= -1);
 tree upgrade_brackets (tree t, string mode= "text");
 tree upgrade_big (tree t);
 tree downgrade_brackets (tree t, bool del_miss= false, bool big_dot= true);
 tree downgrade_big (tree t);
 tree move_brackets (tree t);
 
+#define MATH_CORRECT_SUPERFLUOUS  1
+#define MATH_CORRECT_HOMOGLYPH    2
+#define MATH_CORRECT_MISSING      4
+#define MATH_CORRECT_ZEALOUS      8
+#define MATH_CORRECT_ALL          15
+tree math_correct (tree t, int flags= MATH_CORRECT_ALL);
+
 int  count_math_errors (tree t, int mode= 0);
 void math_status_cumul (tree t);
 void math_status_print ();
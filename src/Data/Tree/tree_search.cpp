@@ -454,6 +454,47 @@ select (range_set& sel, tree t, tree what, path p) {
   }
 }
 
+/******************************************************************************
+* Searching plain strings using the search index of a buffer
+******************************************************************************/
+
+static bool
+is_accessible_for_search (tree t, path q) {
+  for (; !is_nil (q); q= q->next) {
+    if (!is_accessible_for_search (t, q->item)) return false;
+    t= t[q->item];
+  }
+  return true;
+}
+
+static bool
+search_indexed (range_set& sel, tree t, tree what, path p, path pos,
+                bool attach) {
+  // Only the leaves which contain all trigrams of 'what' are examined,
+  // starting with those closest to 'pos'.  The index of a buffer is
+  // created by the first interactive search and dropped by search_done
+  if (!is_atomic (what) || !admits_edit_observer (t)) return false;
+  if (attach) attach_search_index (t);
+  array<path> a;
+  if (!search_index_candidates (t, what->label, a)) return false;
+  int n= N(a), lo, hi, hits= 0;
+  for (hi=0; hi<n && !is_nil (pos) && path_less (a[hi], pos); hi++) {}
+  lo= hi-1;
+  array<range_set> sub (n);
+  bool right= true;
+  while ((lo >= 0 || hi < n) && hits <= search_max_hits) {
+    int k= (hi < n && (right || lo < 0))? hi++: lo--;
+    right= !right;
+    if (is_accessible_for_search (t, a[k])) {
+      tree leaf= subtree (t, a[k]);
+      search_string (sub[k], leaf->label, what, p * a[k]);
+      hits += N(sub[k]);
+    }
+  }
+  for (int k=0; k<n; k++) sel << sub[k];
+  return true;
+}
+
 /******************************************************************************
 * Front end
 ******************************************************************************/
@@ -465,6 +506,7 @@ search (tree t, tree what, path p, int limit) {
   range_set sel;
   //cout << "Search " << what << ", " << contains_select_region (what) << "\n";
   if (contains_select_region (what)) select (sel, t, what, p);
+  else if (search_indexed (sel, t, what, p, path (), false));
   else search (sel, t, what, p);
   //cout << "Selected " << sel << "\n";
   search_max_hits= 1000000;
@@ -478,12 +520,18 @@ search (tree t, tree what, path p, path pos, int limit) {
   range_set sel;
   //cout << "Search " << what << ", " << contains_select_region (what) << "\n";
   if (contains_select_region (what)) select (sel, t, what, p);
+  else if (search_indexed (sel, t, what, p, pos, true));
   else search (sel, t, what, p, pos);
   //cout << "Selected " << sel << "\n";
   search_max_hits= 1000000;
   return sel;
 }
 
+void
+search_done (tree t) {
+  detach_search_index (t);
+}
+
 range_set
 previous_search_hit (range_set sels, path cur, bool strict) {
   int i= (N(sels) >> 1) << 1;
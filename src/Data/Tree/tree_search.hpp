@@ -15,6 +15,7 @@
 
 range_set search (tree t, tree what, path p, int limit= 1000000);
 range_set search (tree t, tree what, path p, path pos, int limit);
+void search_done (tree t);
 range_set previous_search_hit (range_set sel, path cur, bool strict);
 range_set next_search_hit (range_set sel, path cur, bool strict);
 range_set navigate_search_hit (path cur, bool fw, bool extreme, bool strict);
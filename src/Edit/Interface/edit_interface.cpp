@@ -66,7 +66,7 @@ edit_interface_rep::edit_interface_rep ():
   last_x (0), last_y (0), last_t (0),
   table_selection (false), mouse_adjusting (false),
   oc (0, 0), temp_invalid_cursor (false),
-  shadow (NULL), stored (NULL),
+  shadow (NULL), stored (NULL), tiles (), tiles_frame (0, 0, 0, 0),
   cur_sb (2), cur_wb (2)
 {
   input_mode= INPUT_NORMAL;
@@ -96,6 +96,7 @@ edit_interface_rep::suspend () {
   if (stored != NULL) tm_delete (stored);
   shadow = NULL;
   stored = NULL;
+  tiles->invalidate_all ();
 }
 
 void
@@ -165,6 +166,7 @@ edit_interface_rep::invalidate (rectangles rs) {
 
 void
 edit_interface_rep::invalidate_all () {
+  tiles->invalidate_all ();
   send_invalidate_all (this);
 }
 
@@ -696,8 +698,10 @@ edit_interface_rep::apply_changes () {
   }
   
   // cout << "Handling environment\n";
-  if (env_change & THE_ENVIRONMENT)
+  if (env_change & THE_ENVIRONMENT) {
     typeset_invalidate_all ();
+    tiles->invalidate_all ();
+  }
 
   // cout << "Handling tree\n";
   if (env_change & (THE_TREE+THE_ENVIRONMENT)) {
@@ -705,6 +709,8 @@ edit_interface_rep::apply_changes () {
     SI x1, y1, x2, y2;
     typeset (x1, y1, x2, y2);
     invalidate (x1- 2*pixel, y1- 2*pixel, x2+ 2*pixel, y2+ 2*pixel);
+    tiles->invalidate (rectangle (x1- 2*pixel, y1- 2*pixel,
+                                  x2+ 2*pixel, y2+ 2*pixel));
     // check_data_integrety ();
     the_ghost_cursor()= eb->find_check_cursor (tp);
   }
@@ -952,6 +958,7 @@ edit_interface_rep::animate () {
     rectangles rs= eb->anim_invalid ();
     invalidate (rs);
     stored_rects= rectangles ();
+    tiles->invalidate (rs);
   }
 }
 
@@ -962,6 +969,7 @@ edit_interface_rep::animate () {
 void
 edit_interface_rep::full_screen_mode (bool flag) {
   full_screen= flag;
+  tiles->invalidate_all ();
   send_invalidate_all (this);
 }
 
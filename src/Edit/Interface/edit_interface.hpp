@@ -14,6 +14,7 @@
 #include "editor.hpp"
 #include "tm_timer.hpp"
 #include "widget.hpp"
+#include "tile_cache.hpp"
 
 #define INPUT_NORMAL      0
 #define INPUT_SEARCH      1
@@ -70,6 +71,8 @@ protected:
   SI            vx1, vy1, vx2, vy2;
   rectangles    stored_rects;
   renderer      stored;
+  tile_cache    tiles;         // rendered tiles of the document
+  rectangle     tiles_frame;   // extents of the document for these tiles
   rectangles    locus_new_rects;
   rectangles    locus_rects;
   list<string>  mouse_ids;
@@ -115,6 +118,8 @@ public:
   void draw_post (renderer win, renderer ren, rectangle r);
   void draw_with_shadow (renderer win, rectangle r);
   void draw_with_stored (renderer win, rectangle r);
+  bool render_tile (renderer win, rectangle tr, picture& pic);
+  bool draw_with_tiles (renderer win, rectangle r);
 
   /* handle changes */
   void notify_change (int changed);
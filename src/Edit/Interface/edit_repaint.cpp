@@ -307,10 +307,58 @@ edit_interface_rep::draw_with_shadow (renderer win, rectangle r) {
   }
 }
 
+bool
+edit_interface_rep::render_tile (renderer win, rectangle tr, picture& pic) {
+  rectangle sr= tr * magf;
+  renderer ren= win->shadow (pic, sr->x1, sr->y1, sr->x2, sr->y2);
+  ren->set_clipping (sr->x1, sr->y1, sr->x2, sr->y2);
+
+  rectangles l;
+  ren->set_zoom_factor (zoomf);
+  draw_background (ren, tr->x1, tr->y1, tr->x2, tr->y2);
+  draw_surround (ren, tr);
+  draw_text (ren, l);
+  ren->reset_zoom_factor ();
+  delete_renderer (ren);
+
+  // incomplete and animated tiles cannot be reused
+  return !gui_interrupted () && anim_next >= 1.0e12;
+}
+
+static bool
+render_tile_callback (void* obj, renderer win, rectangle tr, picture& pic) {
+  return ((edit_interface_rep*) obj)->render_tile (win, tr, pic);
+}
+
+bool
+edit_interface_rep::draw_with_tiles (renderer win, rectangle r) {
+  if (!win->is_screen || inside_active_graphics () || anim_next < 1.0e12)
+    return false;
+  rectangle frame (eb->x1, eb->y1, eb->x2, eb->y2);
+  if (frame != tiles_frame) {
+    tiles->invalidate_all ();
+    tiles_frame= frame;
+  }
+
+  /* Put the tiles on the screen and draw the cursor and selections */
+  int z= tiles->zoom_index (magf, TILE_PIXELS * pixel);
+  rectangle sr= r * magf;
+  win->new_shadow (shadow);
+  win->get_shadow (shadow, sr->x1, sr->y1, sr->x2, sr->y2);
+  if (!tiles->draw (win, shadow, z, r, render_tile_callback, (void*) this))
+    return false;
+  draw_post (win, shadow, r);
+  win->put_shadow (shadow, sr->x1, sr->y1, sr->x2, sr->y2);
+  return true;
+}
+
 void
 edit_interface_rep::draw_with_stored (renderer win, rectangle r) {
   //cout << "Redraw " << (r*magf/PIXEL) << "\n";
 
+  /* Repaint from the tile cache whenever possible */
+  if (draw_with_tiles (win, r)) return;
+
   /* Verify whether the backing store is still valid */
   if (!is_nil (stored_rects)) {
     SI w1, h1, w2, h2;
@@ -416,6 +416,17 @@ edit_modify_rep::need_save (bool real_save) {
   return !arch->conform_autosave ();
 }
 
+void
+edit_modify_rep::prepare_autosave () {
+  arch->confirm ();
+  arch->prepare_autosave ();
+}
+
+void
+edit_modify_rep::confirm_autosave () {
+  arch->confirm_autosave ();
+}
+
 void
 edit_modify_rep::show_history () {
   arch->show_all ();
@@ -58,6 +58,8 @@ public:
   void require_save ();
   void notify_save (bool real_save= true);
   bool need_save (bool real_save= true);
+  void prepare_autosave ();
+  void confirm_autosave ();
   void show_history ();
 
   observer position_new (path p);
@@ -41,7 +41,9 @@ struct glyph_rep: concrete_struct {
   short lwidth;              // logical width of character
   short status;              // status for extensible characters
   short artistic;            // result of applying an artistic effect
-  QN*   raster;              // character definition
+  QN*   raster;              // character definition if depth > 1
+  DN*   bits;                // character definition if depth == 1
+  int   stride;              // number of words for each row of bits
 
   glyph_rep (int w, int h, int xoff, int yoff, int depth, int status=0);
   ~glyph_rep ();
@@ -63,15 +65,14 @@ CONCRETE_NULL_CODE(glyph);
 
 inline int
 glyph_rep::get_1 (int i, int j) {
-  int bit= j*width+i;
-  return (raster[bit>>3] >> (bit&7)) & 1;
+  return (int) ((bits[j*stride + (i>>6)] >> (i&63)) & 1);
 }
 
 inline void
 glyph_rep::set_1 (int i, int j, int with) {
-  int bit= j*width+i;
-  if (with==0) raster[bit>>3] &= ~(1 << (bit&7));
-  else raster[bit>>3] |= (1 << (bit&7));
+  DN mask= ((DN) 1) << (i&63);
+  if (with==0) bits[j*stride + (i>>6)] &= ~mask;
+  else bits[j*stride + (i>>6)] |= mask;
 }
 
 tm_ostream& operator << (tm_ostream& out, glyph gl);
@@ -130,6 +131,29 @@ glyph unserif     (glyph gl, int code, SI penw);
 
 glyph circle_glyph (SI rad, SI penw);
 
+/******************************************************************************
+* Word-parallel routines on the rows of glyphs of depth one.
+* Bits beyond the width of a row are always zero.
+******************************************************************************/
+
+inline int
+bit_count (DN w) {
+#ifdef __GNUC__
+  return __builtin_popcountll (w);
+#else
+  w= w - ((w >> 1) & 0x5555555555555555ULL);
+  w= (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+  w= (w + (w >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+  return (int) ((w * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+DN   row_field (glyph gl, int j, int i, int n);
+void or_row (glyph dest, int dj, glyph src, int j, int offset);
+bool empty_block (glyph gl, int i1, int i2, int j1, int j2);
+int  row_pixels (glyph gl, int j);
+int  row_changes (glyph gl, int j);
+
 int pixel_count (glyph g);
 double left_protrusion (glyph g, glyph o);
 double right_protrusion (glyph g, glyph o);
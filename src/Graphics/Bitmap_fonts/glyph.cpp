@@ -28,13 +28,27 @@ glyph_rep::glyph_rep (int w2, int h2, int xoff2, int yoff2,
   status   = status2;
   artistic = 0;
 
-  int i, n= (depth==1? (width*height+7)/8: width*height);
-  raster= tm_new_array<QN> (n);
-  for (i=0; i<n; i++) raster[i]=0;
+  int i, n;
+  if (depth==1) {
+    // rows are aligned on words for the word-parallel routines
+    stride= (width+63) >> 6;
+    n     = stride*height;
+    raster= NULL;
+    bits  = tm_new_array<DN> (n);
+    for (i=0; i<n; i++) bits[i]=0;
+  }
+  else {
+    stride= 0;
+    n     = width*height;
+    bits  = NULL;
+    raster= tm_new_array<QN> (n);
+    for (i=0; i<n; i++) raster[i]=0;
+  }
 }
 
 glyph_rep::~glyph_rep () {
-  tm_delete_array (raster);
+  if (raster != NULL) tm_delete_array (raster);
+  if (bits != NULL) tm_delete_array (bits);
 }
 
 glyph::glyph (int w2, int h2, int xoff2, int yoff2, int depth2, int status2) {
@@ -49,10 +63,7 @@ int
 glyph_rep::get_x (int i, int j) {
   if (i<0 ||  (i-width)>=0) return 0;
   if (j<0 || (j-height)>=0) return 0;
-  if (depth==1) {
-    int bit= j*width+i;
-    return (raster[bit>>3] >> (bit&7)) & 1;
-  }
+  if (depth==1) return get_1 (i, j);
   else return raster[j*width+i];
 }
 
@@ -60,11 +71,7 @@ void
 glyph_rep::set_x (int i, int j, int with) {
   if ((i<0) || (i>=width)) FAILED ("bad x-index");
   if ((j<0) || (j>=height)) FAILED ("bad y-index");
-  if (depth==1) {
-    int bit= j*width+i;
-    if (with==0) raster[bit>>3] &= ~(1 << (bit&7));
-    else raster[bit>>3] |= (1 << (bit&7));
-  }
+  if (depth==1) set_1 (i, j, with);
   else raster [j*width+ i]= with;
 }
 
@@ -28,8 +28,7 @@ next_column (glyph g, int x, int dx) {
 int
 next_row (glyph g, int y, int dy) {
   while (y >= 0 && y < g->height) {
-    for (int x=0; x<g->width; x++)
-      if (g->get_1 (x, y) != 0) return y;
+    if (row_pixels (g, y) != 0) return y;
     y += dy;
   }
   return y;
@@ -55,13 +54,7 @@ search_in_column (glyph g, int x, int what, int y, int dy) {
 
 int
 count_row_changes (glyph g, int y) {
-  int cur= 0, count= 0;
-  for (int x=0; x<g->width; x++)
-    if (g->get_1 (x, y) != cur) {
-      cur= g->get_1 (x, y);
-      if (cur == 1) count++;
-    }
-  return count;
+  return row_changes (g, y);
 }
 
 int
@@ -77,10 +70,7 @@ count_column_changes (glyph g, int x) {
 
 int
 count_row_pixels (glyph g, int y) {
-  int count= 0;
-  for (int x=0; x<g->width; x++)
-    count += g->get_1 (x, y);
-  return count;
+  return row_pixels (g, y);
 }
 
 int
@@ -109,8 +99,7 @@ int
 pixel_count (glyph g) {
   int r= 0;
   for (int y=0; y<g->height; y++)
-    for (int x=0; x<g->width; x++)
-      r += g->get_1 (x, y);
+    r += row_pixels (g, y);
   return r;
 }
 
@@ -176,40 +176,46 @@ shrink (glyph gl, int xfactor, int yfactor,
   SI  off_x = (((-X1) *xfactor+ dx)*PIXEL + ((tx*PIXEL)>>1))/xfactor;
   SI  off_y = (((Y2-1)*yfactor- dy)*PIXEL - ((ty*PIXEL)>>1))/yfactor;
 
-  int i, j, x, y;
-  int index, indey, entry;
+  int i, j, y;
   int ww=(X2-X1)*xfactor, hh=(Y2-Y1)*yfactor;
-  int* bitmap= tm_new_array<int> (ww*hh);
-  //STACK_NEW_ARRAY (bitmap, int, ww*hh);
-  for (i=0; i<ww*hh; i++) bitmap[i]=0;
-  for (y=0, index= ww*frac_y+ frac_x; y<gl->height; y++, index-=ww)
-    for (x=0; x<gl->width; x++)
-      if (gl->get_1(x,y))
-        for (j=0, indey=ww*ty; j<=ty; j++, indey-=ww) {
-	  entry = index+indey+x;
-	  for (i=0; i<=tx; i++, entry++)
-	    bitmap[entry]= 1;
-	}
-
-  int X, Y, sum, nr= xfactor*yfactor;
+  int X, Y, nr= xfactor*yfactor;
   int new_depth= gl->depth+ log2i (nr);
   if (new_depth > 8) new_depth= 8;
   glyph CB (X2-X1, Y2-Y1, -X1, Y2-1, new_depth, gl->status);
   CB->index = gl->index;
-  for (Y=Y1; Y<Y2; Y++)
-    for (X=X1; X<X2; X++) {
-      sum=0;
-      indey= ((Y-Y1)*ww+ (X-X1))*xfactor;
-      for (j=0, index= indey; j<yfactor; j++, index+=ww)
-	for (i=0; i<xfactor; i++)
-	  sum += bitmap[index+ i];
-      if (nr >= 64) sum= (64 * sum) / nr;
-      CB->set (X, Y, sum);
+
+  // thicken the pixels and put them at their place in a larger bitmap
+  glyph bitmap (ww, hh, 0, 0);
+  glyph thick (gl->width+ tx, 1, 0, 0);
+  for (y=0; y<gl->height; y++) {
+    if (row_pixels (gl, y) == 0) continue;
+    for (i=0; i<thick->stride; i++) thick->bits[i]= 0;
+    for (i=0; i<=tx; i++) or_row (thick, 0, gl, y, i);
+    for (j=0; j<=ty; j++) or_row (bitmap, frac_y- y+ j, thick, 0, frac_x);
+  }
+
+  // count the pixels in each block of the bitmap, by counting the bits
+  // in the fields of xfactor pixels which correspond to the columns of CB
+  int nx= X2-X1, row, k;
+  STACK_NEW_ARRAY (sum, int, nx);
+  for (Y=Y1; Y<Y2; Y++) {
+    for (k=0; k<nx; k++) sum[k]= 0;
+    row= (Y-Y1)*xfactor;
+    for (j=0; j<yfactor && row+j < hh; j++)
+      if (row_pixels (bitmap, row+j) != 0)
+        for (k=0, i=0; k<nx; k++, i+=xfactor) {
+          int n= xfactor;
+          for (int c=i; n > 0; c+=64, n-=64)
+            sum[k] += bit_count (row_field (bitmap, row+j, c, min (n, 64)));
+        }
+    for (X=X1, k=0; X<X2; X++, k++) {
+      if (nr >= 64) sum[k]= (64 * sum[k]) / nr;
+      CB->set (X, Y, sum[k]);
     }
+  }
+  STACK_DELETE_ARRAY (sum);
   xo= off_x;
   yo= off_y;
-  tm_delete_array (bitmap);
-  //STACK_DELETE_ARRAY (bitmap);
 
   // cout << CB << "\n";
   return CB;
@@ -223,6 +229,18 @@ shrink (glyph gl, int xfactor, int yfactor, SI& xo, SI& yo) {
     return glyph (0, 0, 0, 0, new_depth);
   }
 
+  if (gl->depth != 1) {
+    // the shrinking routines operate on the rows of 1-bit glyphs
+    glyph bw (gl->width, gl->height, gl->xoff, gl->yoff, 1, gl->status);
+    bw->index   = gl->index;
+    bw->lwidth  = gl->lwidth;
+    bw->artistic= gl->artistic;
+    for (int y=0; y<gl->height; y++)
+      for (int x=0; x<gl->width; x++)
+        bw->set_1 (x, y, gl->get_x (x, y) != 0);
+    gl= bw;
+  }
+
   int tx= ((xfactor/3) * (retina_factor+1)) / 2;
   int ty= ((yfactor/3) * (retina_factor+1)) / 2;
   int dx=0, dy=0;
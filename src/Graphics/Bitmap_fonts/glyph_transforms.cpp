@@ -79,10 +79,12 @@ slanted (glyph gl, double slant) {
   glyph bmr (nw, hh, gl->xoff + l, gl->yoff, gl->depth);
   for (j=0; j<hh; j++) {
     int dx= (int) (floor (slant * (gl->yoff - j) + 0.5));
-    for (i=0; i<nw; i++)
-      bmr->set_x (i, j, 0);
-    for (i=0; i<ww; i++)
-      bmr->set_x (i+l+dx, j, gl->get_x (i, j));
+    if (gl->depth == 1 && l+dx >= 0 && ww+l+dx <= nw)
+      // shear the row by shifting its words
+      or_row (bmr, j, gl, j, l+dx);
+    else
+      for (i=0; i<ww; i++)
+        bmr->set_x (i+l+dx, j, gl->get_x (i, j));
   }
   bmr->lwidth= gl->lwidth;
   return simplify (bmr);
@@ -174,6 +176,7 @@ stretched (glyph gl, double xf, double yf) {
       int j2= ((int) ceil  ((Y + 1) / yf)) - y1;
       j1= max (min (j1, hh-1), 0);
       j2= max (min (j2, hh-1), 0);
+      if (gl->depth == 1 && empty_block (gl, i1, i2, j1, j2)) continue;
       double sum= 0.0;
       for (i= i1; i<i2; i++)
         for (j= j1; j<j2; j++)
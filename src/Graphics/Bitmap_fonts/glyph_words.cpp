@@ -0,0 +1,81 @@
+
+/******************************************************************************
+* MODULE     : glyph_words.cpp
+* DESCRIPTION: word-parallel operations on the rows of 1-bit glyphs
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "bitmap_font.hpp"
+
+/******************************************************************************
+* Pixel i of row j is bit (i&63) of the word gl->bits[j*gl->stride + (i>>6)]
+******************************************************************************/
+
+DN
+row_field (glyph gl, int j, int i, int n) {
+  // the n <= 64 pixels starting at column i >= 0 of row j
+  int k= i >> 6, s= i & 63;
+  if (k >= gl->stride) return 0;
+  DN* row= gl->bits + j*gl->stride;
+  DN  w  = row[k] >> s;
+  if (s != 0 && s + n > 64 && k + 1 < gl->stride) w |= row[k+1] << (64 - s);
+  if (n < 64) w &= (((DN) 1) << n) - 1;
+  return w;
+}
+
+void
+or_row (glyph dest, int dj, glyph src, int j, int offset) {
+  // add row j of src to row dj of dest, shifted to the right by offset >= 0;
+  // the shifted pixels should fit into the width of dest
+  DN* from= src->bits + j*src->stride;
+  DN* to  = dest->bits + dj*dest->stride;
+  int k= offset >> 6, s= offset & 63;
+  for (int l=0; l<src->stride; l++) {
+    DN w= from[l];
+    if (w == 0) continue;
+    DN lo= w << s;
+    if (lo != 0) to[k+l] |= lo;
+    if (s != 0) {
+      DN hi= w >> (64 - s);
+      if (hi != 0) to[k+l+1] |= hi;
+    }
+  }
+}
+
+bool
+empty_block (glyph gl, int i1, int i2, int j1, int j2) {
+  // test whether there are no pixels with i1 <= i < i2 and j1 <= j < j2
+  i1= max (i1, 0); i2= min (i2, (int) gl->width);
+  j1= max (j1, 0); j2= min (j2, (int) gl->height);
+  for (int j=j1; j<j2; j++)
+    for (int i=i1; i<i2; i+=64)
+      if (row_field (gl, j, i, min (64, i2-i)) != 0) return false;
+  return true;
+}
+
+int
+row_pixels (glyph gl, int j) {
+  DN* row= gl->bits + j*gl->stride;
+  int count= 0;
+  for (int k=0; k<gl->stride; k++)
+    count += bit_count (row[k]);
+  return count;
+}
+
+int
+row_changes (glyph gl, int j) {
+  // number of changes from unset to set pixels, starting with unset
+  DN* row= gl->bits + j*gl->stride;
+  DN  carry= 0;
+  int count= 0;
+  for (int k=0; k<gl->stride; k++) {
+    DN w= row[k];
+    count += bit_count (w & ~((w << 1) | carry));
+    carry= w >> 63;
+  }
+  return count;
+}
@@ -53,6 +53,7 @@ printer_rep::printer_rep (
     nr_pages (nr_pages2), page_type (page_type2),
     landscape (landscape2), paper_w (paper_w2), paper_h (paper_h2),
     use_alpha (get_preference ("experimental alpha") == "on"),
+    spool_name (url_none ()), spool (NULL),
     linelen (0), fg ((color) (-1)), bg ((color) (-1)), opacity (255),
     pen (black), bgb (white),
     ncols (0), lw (-1), nwidths (0), cfn (""), nfonts (0),
@@ -155,8 +156,29 @@ printer_rep::~printer_rep () {
     prologue << "@landscape\n";
   prologue << "%%EndSetup\n";
 
-  string ps_text= prologue * "\n" * body;
-  save_string (ps_file_name, ps_text);
+  if (spool == NULL) {
+    string ps_text= prologue * "\n" * body;
+    save_string (ps_file_name, ps_text);
+    return;
+  }
+
+  // splice the prologue in front of the spooled pages
+  flush_body ();
+  fclose (spool);
+  spool= NULL;
+  if (!save_string (ps_file_name, prologue * "\n")) {
+    c_string _name (concretize (spool_name));
+    FILE* fin= fopen (_name, "rb");
+    if (fin != NULL) {
+      string block (1 << 20);
+      while (true) {
+        int r= (int) fread (&block[0], 1, N(block), fin);
+        if (r <= 0 || append_string (ps_file_name, block (0, r))) break;
+      }
+      fclose (fin);
+    }
+  }
+  remove (spool_name);
 }
 
 bool
@@ -166,7 +188,10 @@ printer_rep::is_printer () {
 
 void
 printer_rep::next_page () {
-  if (cur_page > 0) print ("eop\n");
+  if (cur_page > 0) {
+    print ("eop\n");
+    flush_body ();
+  }
   if (cur_page >= nr_pages) return;
   cur_page++;
   body << "\n%%Page: " << as_string (cur_page) << " "
@@ -189,6 +214,33 @@ printer_rep::next_page () {
 * subroutines for printing
 ******************************************************************************/
 
+void
+printer_rep::flush_body () {
+  // only called at page boundaries, where print never backtracks;
+  // the pages are written to a temporary file once they become large
+  if (spool == NULL) {
+    if (N(body) < PRINTER_SPOOL_SIZE || !is_none (spool_name)) return;
+    spool_name= url_temp (".ps");
+    // without a temporary directory, concretize yields a bogus name
+    // relative to the current directory
+    if (!is_directory (url_temp_dir ())) {
+      io_warning << "No temporary directory, keeping the pages in memory\n";
+      return;
+    }
+    c_string _name (concretize (spool_name));
+    spool= fopen (_name, "wb");
+    if (spool == NULL) {
+      io_warning << "Could not open " << spool_name
+                 << ", keeping the pages in memory\n";
+      return;
+    }
+  }
+  if (N(body) == 0) return;
+  if (fwrite (&body[0], 1, N(body), spool) != (size_t) N(body))
+    io_warning << "Write error for " << spool_name << "\n";
+  body= string ();
+}
+
 void
 printer_rep::define (string s, string defn) {
   if (defs->contains (s)) return;
@@ -340,18 +392,8 @@ printer_rep::select_tex_font (string name) {
 
 static const char* hex_string= "0123456789ABCDEF";
 
-void
-printer_rep::make_tex_char (string name, unsigned char c, glyph gl) {
-  // cout << "Make char " << (int) c << " of " << name << "\n";
-  string char_name (name * "-" * as_string ((int) c));
-  if (tex_chars->contains (char_name)) return;
-  if (!tex_fonts->contains (name)) {
-    tex_fonts (name)= "F" * as_string (nfonts);
-    tex_font_chars (name)= array<int> (0);
-    nfonts++;
-  }
-  tex_font_chars (name) << ((int) c);
-
+static string
+encode_tex_char (glyph gl) {
   string hex_code;
   int i, j, count=0, cur= 0;
   for (j=0; j < gl->height; j++)
@@ -383,9 +425,40 @@ printer_rep::make_tex_char (string name, unsigned char c, glyph gl) {
              << as_string (d3) << " " << as_string (d4) << " "
              << as_string (d5) << " ";
   }
+  return hex_code;
+}
+
+static hashmap<string,string> tex_char_cache ("");
+static int tex_char_cache_size= 0;
 
-  tex_chars (char_name)= hex_code;
-  tex_width (char_name)= as_string (d5);
+void
+printer_rep::make_tex_char (string name, unsigned char c, glyph gl) {
+  // cout << "Make char " << (int) c << " of " << name << "\n";
+  string char_name (name * "-" * as_string ((int) c));
+  if (tex_chars->contains (char_name)) return;
+  if (!tex_fonts->contains (name)) {
+    tex_fonts (name)= "F" * as_string (nfonts);
+    tex_font_chars (name)= array<int> (0);
+    nfonts++;
+  }
+  tex_font_chars (name) << ((int) c);
+
+  // the definitions are shared between all printed documents
+  string key= char_name * ":" * as_string (gl->width) *
+              ":" * as_string (gl->height) *
+              ":" * as_string (gl->xoff) * ":" * as_string (gl->yoff) *
+              ":" * as_string (gl->lwidth);
+  if (!tex_char_cache->contains (key)) {
+    string code= encode_tex_char (gl);
+    if (tex_char_cache_size + N(code) > TEX_CHAR_CACHE_SIZE) {
+      tex_char_cache= hashmap<string,string> ("");
+      tex_char_cache_size= 0;
+    }
+    tex_char_cache (key)= code;
+    tex_char_cache_size += N(code);
+  }
+  tex_chars (char_name)= tex_char_cache [key];
+  tex_width (char_name)= as_string (gl->lwidth);
 }
 
 static string
@@ -414,12 +487,19 @@ static SI parse_length (string pfb, int& pos) {
   return (((((((SI) c1)<<8)+ ((SI) c2))<<8)+ ((SI) c3))<<8)+ c4;
 }
 
+static hashmap<string,string> pfa_cache ("");
+static int pfa_cache_size= 0;
+
 static string pfb_to_pfa (url file) {
   //cout << "pfb_to_pfa :" << file << LF;
   string pfb, pfa;
   QN magic, type = 0;
   SI length;
   
+  // converted fonts are cached by their location and modification time
+  int mtime= last_modified (file, false);
+  string key= as_string (file) * ":" * as_string (mtime);
+  if (mtime >= 0 && pfa_cache->contains (key)) return pfa_cache [key];
   (void) load_string (file, pfb, true);
   int pos = 0, size = N(pfb);
   while ((pos < size) && (type != 3)) {
@@ -451,9 +531,9 @@ static string pfb_to_pfa (url file) {
         //        parse (pfb, pos, length);
         //cout << "binary data of size " << length << LF;
         for (int i=0; i <length; i++) {
-          QI ch;
-          parse(pfb, pos, ch);
-          pfa << as_hexadecimal (ch, 2);
+          QN ch;
+          parse (pfb, pos, ch);
+          pfa << hex_string[ch >> 4] << hex_string[ch & 15];
           if ((i+1) % HEX_PER_LINE == 0) pfa << "\n"; 
         }
         break;
@@ -469,6 +549,13 @@ static string pfb_to_pfa (url file) {
         
     }
   }
+  if (mtime < 0) return pfa;
+  if (pfa_cache_size + N(pfa) > PFA_CACHE_SIZE) {
+    pfa_cache= hashmap<string,string> ("");
+    pfa_cache_size= 0;
+  }
+  pfa_cache (key)= pfa;
+  pfa_cache_size += N(pfa);
   return pfa;
 }
 
@@ -15,6 +15,11 @@
 #include "gui.hpp"
 #include "hashmap.hpp"
 #include "url.hpp"
+#include <stdio.h>
+
+#define PRINTER_SPOOL_SIZE   (1 << 18)  // size from which pages are spooled
+#define TEX_CHAR_CACHE_SIZE  (8 << 20)  // maximal size of cached characters
+#define PFA_CACHE_SIZE       (32 << 20) // maximal size of cached fonts
 
 class printer_rep: public renderer_rep {
   url      ps_file_name;
@@ -29,6 +34,8 @@ class printer_rep: public renderer_rep {
   bool     use_alpha;
   string   prologue;
   string   body;
+  url      spool_name;
+  FILE*    spool;
   int      cur_page;
   int      linelen;
 
@@ -61,6 +68,7 @@ public:
 
   /*********************** subroutines for printing **************************/
 
+  void flush_body ();
   void define (string comm, string defn);
   void sep ();
   void cr ();
@@ -0,0 +1,230 @@
+
+/******************************************************************************
+* MODULE     : tile_cache.cpp
+* DESCRIPTION: Cache of rendered tiles for repainting the screen
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "tile_cache.hpp"
+
+/******************************************************************************
+* Constructors and geometry
+******************************************************************************/
+
+tile_cache_rep::tile_cache_rep (int budget2):
+  budget (budget2), used (0), hits (0), misses (0),
+  evictions (0), invalidations (0), slot (-1), first (-1), last (-1) {}
+
+tile_cache::tile_cache (int budget):
+  rep (tm_new<tile_cache_rep> (budget)) {}
+
+int
+tile_cache_rep::zoom_index (double zoom, SI sz) {
+  for (int z=0; z<N(zooms); z++)
+    if (zooms[z] == zoom && sizes[z] == sz) return z;
+  zooms << zoom;
+  sizes << sz;
+  return N(zooms) - 1;
+}
+
+DI
+tile_cache_rep::key (int z, int tx, int ty) {
+  return (((DI) z) << 48) |
+         (((DI) (tx & 0xffffff)) << 24) |
+          ((DI) (ty & 0xffffff));
+}
+
+static inline int
+floor_div (SI x, SI d) {
+  return (int) (x >= 0? x / d: -((-x + d - 1) / d));
+}
+
+void
+tile_cache_rep::range (int z, rectangle r,
+                       int& tx1, int& ty1, int& tx2, int& ty2) {
+  // the tiles tx1..tx2 and ty1..ty2 cover the half open rectangle r
+  tx1= floor_div (r->x1, sizes[z]);
+  ty1= floor_div (r->y1, sizes[z]);
+  tx2= floor_div (r->x2 - 1, sizes[z]);
+  ty2= floor_div (r->y2 - 1, sizes[z]);
+}
+
+rectangle
+tile_cache_rep::extents (int z, int tx, int ty) {
+  SI sz= sizes[z];
+  return rectangle (tx * sz, ty * sz, (tx + 1) * sz, (ty + 1) * sz);
+}
+
+int
+tile_cache_rep::size () {
+  return N(tiles) - N(unused);
+}
+
+/******************************************************************************
+* Maintaining the least recently used order
+******************************************************************************/
+
+void
+tile_cache_rep::unlink (int i) {
+  tile_entry& t= tiles[i];
+  if (t.prev >= 0) tiles[t.prev].next= t.next; else first= t.next;
+  if (t.next >= 0) tiles[t.next].prev= t.prev; else last= t.prev;
+  t.prev= t.next= -1;
+}
+
+void
+tile_cache_rep::touch (int i) {
+  if (first == i) return;
+  if (tiles[i].prev >= 0) unlink (i);
+  tiles[i].next= first;
+  if (first >= 0) tiles[first].prev= i;
+  first= i;
+  if (last < 0) last= i;
+}
+
+void
+tile_cache_rep::remove (int i) {
+  tile_entry& t= tiles[i];
+  unlink (i);
+  slot->reset (t.key);
+  used -= t.bytes;
+  t.pic= picture ();
+  t.bytes= 0;
+  unused << i;
+}
+
+/******************************************************************************
+* Lookup and storage
+******************************************************************************/
+
+bool
+tile_cache_rep::lookup (int z, int tx, int ty,
+                        picture& pic, SI& ox, SI& oy) {
+  int i= slot[key (z, tx, ty)];
+  if (i < 0) { misses++; return false; }
+  hits++;
+  touch (i);
+  pic= tiles[i].pic;
+  ox = tiles[i].ox;
+  oy = tiles[i].oy;
+  return true;
+}
+
+void
+tile_cache_rep::store (int z, int tx, int ty, picture pic, SI ox, SI oy) {
+  DI k= key (z, tx, ty);
+  if (slot[k] >= 0) remove (slot[k]);
+  int bytes= 4 * pic->get_width () * pic->get_height ();
+  if (bytes > budget) return;
+  while (used + bytes > budget && last >= 0) {
+    remove (last);
+    evictions++;
+  }
+  int i;
+  if (N(unused) > 0) {
+    i= unused[N(unused) - 1];
+    unused->resize (N(unused) - 1);
+  }
+  else {
+    i= N(tiles);
+    tiles << tile_entry ();
+  }
+  tile_entry& t= tiles[i];
+  t.key= k; t.pic= pic; t.ox= ox; t.oy= oy; t.bytes= bytes;
+  t.prev= t.next= -1;
+  slot (k)= i;
+  used += bytes;
+  touch (i);
+}
+
+/******************************************************************************
+* Drawing the tiles which cover a region
+******************************************************************************/
+
+bool
+tile_cache_rep::draw (renderer win, renderer ren, int z, rectangle r,
+                      tile_renderer render, void* obj) {
+  // tiles are rendered on win, but drawn on ren, which may be a shadow
+  // of win; tiles which were rendered with a different subpixel offset
+  // of the origin are rendered again
+  int tx1, ty1, tx2, ty2;
+  range (z, r, tx1, ty1, tx2, ty2);
+  array<picture> pics;
+  for (int ty=ty2; ty>=ty1; ty--)
+    for (int tx=tx1; tx<=tx2; tx++) {
+      picture pic;
+      SI ox, oy;
+      if (!lookup (z, tx, ty, pic, ox, oy) ||
+          (ox - win->ox) % win->pixel != 0 ||
+          (oy - win->oy) % win->pixel != 0) {
+        if (!render (obj, win, extents (z, tx, ty), pic)) return false;
+        store (z, tx, ty, pic, win->ox, win->oy);
+      }
+      pics << pic;
+    }
+  for (int i=0; i<N(pics); i++)
+    ren->draw_picture (pics[i], 0, 0);
+  return true;
+}
+
+/******************************************************************************
+* Invalidation after changes in the document
+******************************************************************************/
+
+void
+tile_cache_rep::invalidate (rectangle r) {
+  for (int z=0; z<N(zooms); z++) {
+    int tx1, ty1, tx2, ty2;
+    range (z, r, tx1, ty1, tx2, ty2);
+    double nr= ((double) (tx2 - tx1 + 1)) * ((double) (ty2 - ty1 + 1));
+    if (nr <= (double) size ()) {
+      for (int tx=tx1; tx<=tx2; tx++)
+        for (int ty=ty1; ty<=ty2; ty++) {
+          int i= slot[key (z, tx, ty)];
+          if (i >= 0) { remove (i); invalidations++; }
+        }
+    }
+    else {
+      // large regions: only visit the tiles which are present
+      for (int i=0; i<N(tiles); i++)
+        if (!is_nil (tiles[i].pic) && (int) (tiles[i].key >> 48) == z) {
+          DI k = tiles[i].key;
+          int tx= (int) (((k >> 24) & 0xffffff) << 8) >> 8;
+          int ty= (int) ((k & 0xffffff) << 8) >> 8;
+          if (tx >= tx1 && tx <= tx2 && ty >= ty1 && ty <= ty2) {
+            remove (i);
+            invalidations++;
+          }
+        }
+    }
+  }
+}
+
+void
+tile_cache_rep::invalidate (rectangles rs) {
+  for (; !is_nil (rs); rs= rs->next)
+    invalidate (rs->item);
+}
+
+void
+tile_cache_rep::invalidate_all () {
+  for (int i=0; i<N(tiles); i++)
+    if (!is_nil (tiles[i].pic)) {
+      remove (i);
+      invalidations++;
+    }
+}
+
+tm_ostream&
+operator << (tm_ostream& out, tile_cache tc) {
+  return out << "tile_cache [" << tc->size () << " tiles, "
+             << tc->used << " bytes, "
+             << tc->hits << " hits, "
+             << tc->misses << " misses, "
+             << tc->evictions << " evictions, "
+             << tc->invalidations << " invalidations]";
+}
@@ -0,0 +1,90 @@
+
+/******************************************************************************
+* MODULE     : tile_cache.hpp
+* DESCRIPTION: Cache of rendered tiles for repainting the screen
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#ifndef TILE_CACHE_H
+#define TILE_CACHE_H
+#include "renderer.hpp"
+#include "rectangles.hpp"
+#include "hashmap.hpp"
+
+#define TILE_PIXELS        256
+#define TILE_CACHE_BUDGET  (64 << 20)
+
+/******************************************************************************
+* Tiles are square pieces of the rendered document, aligned on a grid
+* in document coordinates with one grid for every magnification.
+* The grid of the magnification z consists of the rectangles
+* (tx*size[z], ty*size[z])--((tx+1)*size[z], (ty+1)*size[z]).
+* Each tile also remembers the origin of the renderer on which it was
+* rendered, so that it can be put back after scrolling.
+* Like all shadow pictures, the origin of a tile corresponds to the
+* origin of the document, so that tiles are drawn at (0, 0).
+******************************************************************************/
+
+typedef bool (*tile_renderer) (void* obj, renderer win, rectangle tr,
+                               picture& pic);
+
+struct tile_entry {
+  DI      key;             // magnification and position on the grid
+  picture pic;             // the rendered tile
+  SI      ox, oy;          // origin of the renderer at rendering time
+  int     bytes;           // memory occupied by the picture
+  int     prev, next;      // neighbours in the least recently used order
+};
+
+class tile_cache;
+class tile_cache_rep: concrete_struct {
+public:
+  int  budget;             // maximal memory occupied by the tiles
+  int  used;               // memory which is currently occupied
+  int  hits, misses;       // statistics for lookups
+  int  evictions;          // number of tiles removed for lack of memory
+  int  invalidations;      // number of tiles removed after changes
+
+  array<double>      zooms;   // known magnifications
+  array<SI>          sizes;   // size of the tiles for each magnification
+  array<tile_entry>  tiles;   // slots for the tiles
+  array<int>         unused;  // slots which can be reused
+  hashmap<DI,int>    slot;    // slots of the tiles by key
+  int                first;   // most recently used tile
+  int                last;    // least recently used tile
+
+  tile_cache_rep (int budget);
+
+  int  zoom_index (double zoom, SI size);
+  DI   key (int z, int tx, int ty);
+  void range (int z, rectangle r, int& tx1, int& ty1, int& tx2, int& ty2);
+  rectangle extents (int z, int tx, int ty);
+
+  bool lookup (int z, int tx, int ty, picture& pic, SI& ox, SI& oy);
+  void store (int z, int tx, int ty, picture pic, SI ox, SI oy);
+  bool draw (renderer win, renderer ren, int z, rectangle r,
+             tile_renderer render, void* obj);
+  void remove (int i);
+  void unlink (int i);
+  void touch (int i);
+
+  void invalidate (rectangle r);
+  void invalidate (rectangles rs);
+  void invalidate_all ();
+  int  size ();
+  friend class tile_cache;
+};
+
+class tile_cache {
+  CONCRETE(tile_cache);
+  tile_cache (int budget= TILE_CACHE_BUDGET);
+};
+CONCRETE_CODE(tile_cache);
+
+tm_ostream& operator << (tm_ostream& out, tile_cache tc);
+
+#endif // defined TILE_CACHE_H
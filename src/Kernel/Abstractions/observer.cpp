@@ -746,3 +746,13 @@ bool
 observer_rep::get_highlight (int lan, array<int>& cols) {
   (void) lan; (void) cols; return false;
 }
+
+bool
+observer_rep::get_search_candidates (tree& ref, string s, array<path>& a) {
+  (void) ref; (void) s; (void) a; return false;
+}
+
+bool
+observer_rep::take_journal (list<modification>& l) {
+  (void) l; return false;
+}
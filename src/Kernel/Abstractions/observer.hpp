@@ -33,6 +33,8 @@ typedef list<int> path;
 #define OBSERVER_UNDO       7
 #define OBSERVER_HIGHLIGHT  8
 #define OBSERVER_WIDGET     9
+#define OBSERVER_SEARCH     10
+#define OBSERVER_JOURNAL    11
 
 #define ADDENDUM_PLAYER     1
 
@@ -87,6 +89,8 @@ public:
   virtual bool get_contents (int kind, blackbox& bb);
   virtual bool set_highlight (int lan, int col, int start, int end);
   virtual bool get_highlight (int lan, array<int>& cols);
+  virtual bool get_search_candidates (tree& ref, string s, array<path>& a);
+  virtual bool take_journal (list<modification>& l);
 };
 
 class observer {
@@ -115,6 +119,8 @@ observer tree_position (tree t, int index);
 observer edit_observer (editor_rep* ed);
 observer undo_observer (archiver_rep* arch);
 observer highlight_observer (int lan, array<int> cols);
+observer search_index_observer (tree t);
+observer journal_observer ();
 
 /******************************************************************************
 * Modification routines for trees and other observer-related facilities
@@ -176,6 +182,16 @@ bool has_highlight (tree& ref, int lan);
 array<int> obtain_highlight (tree& ref, int lan);
 void detach_highlight (tree& ref, int lan);
 
+void attach_search_index (tree& ref);
+bool has_search_index (tree& ref);
+void detach_search_index (tree& ref);
+bool search_index_candidates (tree& ref, string what, array<path>& a);
+
+void attach_journal (tree& ref);
+bool has_journal (tree& ref);
+void detach_journal (tree& ref);
+bool journal_take (tree& ref, list<modification>& l);
+
 void stretched_print (tree t, bool ips= false, int indent= 0);
 
 #endif // defined OBSERVER_H
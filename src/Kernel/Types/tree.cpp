@@ -12,6 +12,7 @@
 #include "generic_tree.hpp"
 #include "drd_std.hpp"
 #include "hashset.hpp"
+#include "analyze.hpp"
 
 /******************************************************************************
 * Main routines for trees
@@ -223,6 +224,54 @@ hash (tree t) {
   else return ((int) L(t)) ^ hash (A(t));
 }
 
+unsigned int
+stable_hash (tree t) {
+  // unlike hash (tree), this does not depend on the numbering of
+  // the extensions, which changes from one session to another
+  if (is_atomic (t)) return (unsigned int) hash (t->label);
+  unsigned int h= (L(t) < START_EXTENSIONS?
+                   (unsigned int) L(t):
+                   (unsigned int) hash (as_string (L(t))));
+  int i, n= N(t);
+  for (i=0; i<n; i++) h= 1000003 * h + stable_hash (t[i]);
+  return h;
+}
+
+static inline void
+fnv_hash (string s, unsigned int& h) {
+  for (int i=0; i<N(s); i++)
+    h= (h ^ ((unsigned int) (unsigned char) s[i])) * 16777619u;
+}
+
+static void
+fnv_hash (tree t, unsigned int& h) {
+  if (is_atomic (t)) {
+    fnv_hash (t->label, h);
+    h= (h ^ 0xff) * 16777619u;
+  }
+  else {
+    h= (h ^ (unsigned int) hash (as_string (L(t)))) * 16777619u;
+    for (int i=0; i<N(t); i++) fnv_hash (t[i], h);
+    h= (h ^ (unsigned int) N(t)) * 16777619u;
+  }
+}
+
+string
+cache_key (string s) {
+  // key for data which persist between sessions, such as files in the
+  // cache on disk; two independent hashes make collisions unlikely
+  unsigned int h1= (unsigned int) hash (s), h2= 2166136261u;
+  fnv_hash (s, h2);
+  return as_hexadecimal ((int) h1, 8) * as_hexadecimal ((int) h2, 8);
+}
+
+string
+cache_key (tree t) {
+  unsigned int h1= stable_hash (t), h2= 2166136261u;
+  fnv_hash (t, h2);
+  return as_hexadecimal ((int) h1, 8) * as_hexadecimal ((int) h2, 8);
+}
+
 string
 tree_as_string (tree t) {
   if (is_atomic (t)) return t->label;
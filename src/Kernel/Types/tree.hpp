@@ -91,6 +91,8 @@ public:
   friend class tree_addendum_rep;
   friend class edit_observer_rep;
   friend class undo_observer_rep;
+  friend class search_observer_rep;
+  friend class journal_observer_rep;
   friend class tree_links_rep;
   friend class link_repository_rep;
 #ifdef QTTEXMACS
@@ -374,6 +376,9 @@ inline tree verbatim (tree t1) {
 
 tree   correct (tree t);
 int    hash (tree t);
+unsigned int stable_hash (tree t);
+string cache_key (string s);
+string cache_key (tree t);
 
 template<class T>
 array<T>::operator tree () {
@@ -10,6 +10,7 @@
 ******************************************************************************/
 
 #include "Bibtex/bibtex.hpp"
+#include "Bibtex/bibtex_functions.hpp"
 #include "file.hpp"
 #include "sys_utils.hpp"
 #include "convert.hpp"
@@ -82,33 +83,24 @@ bibtex_update_encoding (string s) {
   return r;
 }
 
-tree
-bibtex_load_bbl (string bib, url bbl_file) {
-  string result;
-  if (load_string (bbl_file, result, false))
-    return "Error: bibtex failed to create bibliography";
+static bool
+is_bbl_item (tree t) {
+  return is_concat (t) &&
+         (is_compound (t[0], "bibitem") ||
+          is_compound (t[0], "bibitem*") ||
+          is_compound (t[0], "bibitem-with-key"));
+}
 
-  result= bibtex_update_encoding (result);
+static tree
+bibtex_bib_list (string bib, tree with, tree largest, array<tree> t) {
   int count=1;
-  tree t= generic_to_tree (result, "latex-snippet");
-  tree with= tree (WITH);
-  with << search_defs (t);
-  t= search_bib (t);
-  if (t == "") return "";
-  tree largest= t[0];
-  t= t[1];
-
   tree u (DOCUMENT);
-  for (int i=0; i<arity(t); i++) {
-    if (is_concat (t[i]) &&
-	(is_compound (t[i][0], "bibitem") ||
-	 is_compound (t[i][0], "bibitem*")||
-	 is_compound (t[i][0], "bibitem-with-key")))
+  for (int i=0; i<N(t); i++) {
+    if (is_bbl_item (t[i]))
       {
 	tree item= t[i][0];
 	if (is_compound (item, "bibitem"))
 	  item= compound ("bibitem*", as_string (count++), item[0]);
-	t[i][0]= item;
 	tree v (CONCAT, compound ("bibitem*", item[0]));
 	if (is_atomic (item[1]))
 	  v << tree (LABEL, bib * "-" * item[1]->label);
@@ -128,6 +120,85 @@ bibtex_load_bbl (string bib, url bbl_file) {
   return compound ("bib-list", largest, u);
 }
 
+static tree
+bibtex_convert_bbl (string bib, string result) {
+  tree t= generic_to_tree (result, "latex-snippet");
+  tree with= tree (WITH);
+  with << search_defs (t);
+  t= search_bib (t);
+  if (t == "") return "";
+  return bibtex_bib_list (bib, with, t[0], A (t[1]));
+}
+
+static bool
+bibtex_split_bbl (string s, string& header, array<string>& items,
+                  string& footer) {
+  int start= search_forwards ("\\bibitem", s);
+  int end  = search_backwards ("\\end{thebibliography}", s);
+  if (start < 0 || end < start) return false;
+  header= s (0, start);
+  footer= s (end, N(s));
+  int pos= start;
+  while (pos < end) {
+    int next= search_forwards ("\\bibitem", pos + 8, s);
+    if (next < 0 || next > end) next= end;
+    items << s (pos, next);
+    pos= next;
+  }
+  return true;
+}
+
+tree
+bibtex_load_bbl (string bib, url bbl_file) {
+  string result;
+  if (load_string (bbl_file, result, false))
+    return "Error: bibtex failed to create bibliography";
+  result= bibtex_update_encoding (result);
+
+  // the conversions of the items are memoized, so that only the new or
+  // modified ones are converted, together, in a single run;
+  // the header contains the widest label and additional definitions
+  string header, footer;
+  array<string> items;
+  if (!bibtex_split_bbl (result, header, items, footer))
+    return bibtex_convert_bbl (bib, result);
+  bib_cache_context ();
+  string hkey= cache_key (header);
+  tree info= bib_cache_get ("bbl", hkey);
+  array<string> keys;
+  array<tree> lines;
+  array<int> todo;
+  string missing;
+  for (int i=0; i<N(items); i++) {
+    keys << cache_key (header * items[i]);
+    lines << bib_cache_get ("bbl", keys[i]);
+    if (lines[i] != UNINIT) lines[i]= copy (lines[i]);
+    else {
+      todo << i;
+      missing << items[i];
+    }
+  }
+  if (info == UNINIT || N(todo) > 0) {
+    tree t= generic_to_tree (header * missing * footer, "latex-snippet");
+    tree with= tree (WITH);
+    with << search_defs (t);
+    t= search_bib (t);
+    if (t == "") return bibtex_convert_bbl (bib, result);
+    array<tree> conv;
+    for (int i=0; i<N(t[1]); i++)
+      if (is_bbl_item (t[1][i])) conv << t[1][i];
+    if (N(conv) != N(todo)) return bibtex_convert_bbl (bib, result);
+    info= tuple (with, t[0]);
+    bib_cache_set ("bbl", hkey, copy (info));
+    for (int k=0; k<N(todo); k++) {
+      lines[todo[k]]= conv[k];
+      bib_cache_set ("bbl", keys[todo[k]], copy (conv[k]));
+    }
+    bib_cache_flush ();
+  }
+  return bibtex_bib_list (bib, copy (info[0]), copy (info[1]), lines);
+}
+
 static bool
 contain_space (string s) {
   for (int i=0; i<N(s); i++)
@@ -177,6 +248,18 @@ bibtex_run (string bib, string style, url bib_file, tree bib_t) {
   bib_s << "\\bibdata{" << bib_name << "}\n";
   save_string ("$TEXMACS_HOME_PATH/system/bib/temp.aux", bib_s);
 
+  // the bibliography only changes with the citations, the database or style
+  string data, bst;
+  (void) load_string (bib_file, data, false);
+  url bst_file= url_system (dir) * (style * ".bst");
+  if (exists (bst_file)) (void) load_string (bst_file, bst, false);
+  string key= cache_key (bibtex_command * "\n" * bib * "\n" * bib_s *
+                             "\n" * data * "\n" * bst);
+  bib_cache_context ();
+  tree cached= bib_cache_get ("run", key);
+  if (cached != UNINIT) return copy (cached);
+  bool ok= true;
+
 #ifdef OS_WIN32_LATER
   c_string directory (dir);
   RunBibtex (directory, "$TEXMACS_HOME_PATH/system/bib", "temp");
@@ -191,8 +274,10 @@ bibtex_run (string bib, string style, url bib_file, tree bib_t) {
       debug_shell << cmdln << "\n";
   }
   string log;
-  if (system (cmdln, log))
+  if (system (cmdln, log)) {
     bibtex_error << log << "\n";
+    ok= false;
+  }
   else {
     int pos=0;
     while (true) {
@@ -206,7 +291,12 @@ bibtex_run (string bib, string style, url bib_file, tree bib_t) {
   }
 #endif
 
-  return bibtex_load_bbl (bib, "$TEXMACS_HOME_PATH/system/bib/temp.bbl");
+  tree r= bibtex_load_bbl (bib, "$TEXMACS_HOME_PATH/system/bib/temp.bbl");
+  if (ok && !(is_atomic (r) && starts (r->label, "Error:"))) {
+    bib_cache_set ("run", key, copy (r));
+    bib_cache_flush ();
+  }
+  return r;
   /*
   string result;
   if (load_string ("$TEXMACS_HOME_PATH/system/bib/temp.bbl", result, false))
@@ -11,6 +11,10 @@
 
 #include "bibtex_functions.hpp"
 #include "converter.hpp"
+#include "file.hpp"
+#include "iterator.hpp"
+#include "scheme.hpp"
+#include "tm_configure.hpp"
 #include "vars.hpp"
 
 /******************************************************************************
@@ -933,8 +937,8 @@ is_hyper_link (string s) {
   return starts (s, "http://") || starts (s, "https://") || starts (s, "ftp://");
 }
 
-void
-bib_parse_fields (tree& t) {
+static bool
+bib_parse_fields_batch (tree& t) {
   string fields;
   int nb= bib_get_fields (t, fields);
   array<tree> latex= bib_latex_array (
@@ -952,7 +956,36 @@ bib_parse_fields (tree& t) {
     if (is_atomic (latex[k]) && is_hyper_link (latex[k]->label))
       latex[k]= compound ("slink", latex[k]);
   int i= 0;
-  if (nb == N(latex)) bib_set_fields (t, latex, i);
+  if (nb != N(latex)) return false;
+  bib_set_fields (t, latex, i);
+  return true;
+}
+
+void
+bib_parse_fields (tree& t) {
+  // the fields of each entry are converted once; the new or modified
+  // entries are converted together, using a single LaTeX parse
+  bib_cache_context ();
+  tree todo (DOCUMENT);
+  array<int> where;
+  array<string> keys;
+  for (int i=0; i<N(t); i++)
+    if (bib_is_entry (t[i]) || bib_is_comment (t[i])) {
+      string key= cache_key (t[i]);
+      tree r= bib_cache_get ("fields", key);
+      if (r != UNINIT) t[i]= copy (r);
+      else {
+        todo << t[i];
+        where << i;
+        keys << key;
+      }
+    }
+  if (N(todo) == 0 || !bib_parse_fields_batch (todo)) return;
+  for (int k=0; k<N(todo); k++) {
+    t[where[k]]= todo[k];
+    bib_cache_set ("fields", keys[k], copy (todo[k]));
+  }
+  bib_cache_flush ();
 }
 
 /******************************************************************************
@@ -997,6 +1030,178 @@ bib_preamble (tree t) {
   return pre;
 }
 
+/******************************************************************************
+* Memoization of conversions, in memory and on disk
+******************************************************************************/
+
+static hashmap<string,tree> bib_cache (UNINIT);
+static hashmap<string,string> bib_cache_raw ("");
+static hashset<string> bib_cache_loaded;
+static hashset<string> bib_cache_damaged;
+static hashmap<string,string> bib_cache_pending ("");
+static bool bib_cache_on_disk= true;
+static int bib_cache_limit= BIB_CACHE_SIZE;
+static string bib_cache_salt;
+static int bib_cache_hits= 0;
+static int bib_cache_misses= 0;
+
+void
+bib_cache_reset (bool on_disk, int limit) {
+  bib_cache= hashmap<string,tree> (UNINIT);
+  bib_cache_raw= hashmap<string,string> ("");
+  bib_cache_loaded= hashset<string> ();
+  bib_cache_damaged= hashset<string> ();
+  bib_cache_pending= hashmap<string,string> ("");
+  bib_cache_on_disk= on_disk;
+  bib_cache_limit= limit;
+  bib_cache_context ();
+}
+
+void
+bib_cache_statistics (int& hits, int& misses) {
+  hits  = bib_cache_hits;
+  misses= bib_cache_misses;
+}
+
+void
+bib_cache_context () {
+  // the conversions also depend on the version of the converters and on
+  // the options of the LaTeX importer, which are part of all the keys
+  string s= TEXMACS_VERSION "\n" BIB_CACHE_FORMAT;
+  s << "\n" << get_preference ("latex->texmacs:fallback-on-pictures", "on")
+    << "\n" << get_preference ("latex->texmacs:source-tracking", "off")
+    << "\n" << get_preference ("latex->texmacs:conservative", "off")
+    << "\n" << get_preference ("latex->texmacs:transparent-source-tracking",
+                               "off");
+  bib_cache_salt= cache_key (s);
+}
+
+static url
+bib_cache_file (string kind) {
+  return url ("$TEXMACS_HOME_PATH/system/cache", "__bib-" * kind);
+}
+
+static bool
+bib_cache_read (string s, int& pos, string& key, string& data, bool& bad) {
+  // each record is a line with its key, length and checksum, followed by
+  // the data; damaged records are skipped up to the next valid one
+  while (pos < N(s)) {
+    int end= search_forwards ("\n", pos, s);
+    if (end < 0) break;
+    array<string> head= tokenize (s (pos, end), " ");
+    int len= (N(head) == 3 && is_int (head[1])? as_int (head[1]): -1);
+    if (len >= 0 && end + 1 + len <= N(s)) {
+      data= s (end + 1, end + 1 + len);
+      if (cache_key (data) == head[2]) {
+        key= head[0];
+        pos= end + 1 + len;
+        return true;
+      }
+    }
+    bad= true;
+    pos= end + 1;
+  }
+  if (pos < N(s)) bad= true;
+  pos= N(s);
+  return false;
+}
+
+static string
+bib_cache_record (string key, string data) {
+  string r;
+  r << key << " " << as_string (N(data)) << " " << cache_key (data)
+    << "\n" << data;
+  return r;
+}
+
+static void
+bib_cache_load (string kind) {
+  // the records are only converted back into trees when they are used
+  if (bib_cache_loaded->contains (kind)) return;
+  bib_cache_loaded->insert (kind);
+  string s;
+  url name= bib_cache_file (kind);
+  if (!bib_cache_on_disk || !exists (name) || load_string (name, s, false))
+    return;
+  int pos= 0;
+  bool bad= false;
+  string key, data;
+  while (bib_cache_read (s, pos, key, data, bad))
+    bib_cache_raw (kind * ":" * key)= data;
+  if (bad) bib_cache_damaged->insert (kind);
+}
+
+static void
+bib_cache_compact (string kind) {
+  // the most recent records are kept, up to half of the size limit;
+  // the new file replaces the old one at once, with a rename
+  string s;
+  url name= bib_cache_file (kind);
+  if (load_string (name, s, false)) return;
+  array<string> keys, datas;
+  int pos= 0;
+  bool bad= false;
+  string key, data;
+  while (bib_cache_read (s, pos, key, data, bad)) {
+    keys << key;
+    datas << data;
+  }
+  hashset<string> done;
+  array<string> kept;
+  int size= 0;
+  for (int i=N(keys)-1; i>=0; i--)
+    if (!done->contains (keys[i])) {
+      string r= bib_cache_record (keys[i], datas[i]);
+      if (size + N(r) > bib_cache_limit / 2) break;
+      done->insert (keys[i]);
+      kept << r;
+      size += N(r);
+    }
+  string r;
+  for (int i=N(kept)-1; i>=0; i--) r << kept[i];
+  url tmp= head (name) * tail (url_temp ("-bib"));
+  if (save_string (tmp, r)) remove (tmp);
+  else move (tmp, name);
+  bib_cache_damaged->remove (kind);
+}
+
+tree
+bib_cache_get (string kind, string key) {
+  bib_cache_load (kind);
+  string k= kind * ":" * bib_cache_salt * key;
+  tree t= bib_cache[k];
+  if (t == UNINIT && bib_cache_raw->contains (k)) {
+    bib_cache (k)= t= binary_to_tree (bib_cache_raw[k]);
+    bib_cache_raw->reset (k);
+  }
+  if (t == UNINIT) bib_cache_misses++;
+  else bib_cache_hits++;
+  return t;
+}
+
+void
+bib_cache_set (string kind, string key, tree t) {
+  bib_cache (kind * ":" * bib_cache_salt * key)= t;
+  if (bib_cache_on_disk)
+    bib_cache_pending (kind) << bib_cache_record (bib_cache_salt * key,
+                                                  tree_to_binary (t));
+}
+
+void
+bib_cache_flush () {
+  iterator<string> it= iterate (bib_cache_pending);
+  while (it->busy ()) {
+    string kind= it->next ();
+    url name= bib_cache_file (kind);
+    // damaged parts are removed first, since new records are appended
+    bib_cache_load (kind);
+    if (bib_cache_damaged->contains (kind)) bib_cache_compact (kind);
+    (void) append_string (name, bib_cache_pending[kind]);
+    if (file_size (name) > bib_cache_limit) bib_cache_compact (kind);
+  }
+  bib_cache_pending= hashmap<string,string> ("");
+}
+
 /******************************************************************************
 * Entries selection
 ******************************************************************************/
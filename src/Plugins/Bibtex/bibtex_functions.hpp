@@ -38,3 +38,13 @@ tree   bib_subst_vars (tree t, hashmap<string,string> dict);
 tree   bib_entries (tree t, tree bib_t);
 scheme_tree bib_abbreviate (scheme_tree st, scheme_tree s1, scheme_tree s2);
 
+#define BIB_CACHE_FORMAT "3"
+#define BIB_CACHE_SIZE (16<<20)
+
+void   bib_cache_reset (bool on_disk, int limit= BIB_CACHE_SIZE);
+void   bib_cache_context ();
+void   bib_cache_statistics (int& hits, int& misses);
+tree   bib_cache_get (string kind, string key);
+void   bib_cache_set (string kind, string key, tree t);
+void   bib_cache_flush ();
+
@@ -15,6 +15,7 @@
 #include "analyze.hpp"
 #include "file.hpp"
 #include "sys_utils.hpp"
+#include "tm_timer.hpp"
 
 static inline void
 dbg (string s) {
@@ -33,20 +34,33 @@ latex_present () {
   return exists_in_path (latex_command);
 }
 
-array<string>
-search_latex_previews (tree t) {
-  array<string> r;
+void
+search_latex_previews (tree t, array<tree>& r) {
+  // the previews in the order in which substitute_latex_previews uses them
   if (is_atomic (t));
   else if (is_tuple (t, "\\def") || is_tuple (t, "\\def*")
       || is_tuple (t, "\\def**") || is_tuple (t, "\\newenvironment**") ||
       is_tuple (t, "\\newenvironment") || is_tuple (t, "\\newenvironment*"));
   else if (is_tuple (t, "\\latex_preview", 2))
-    r << as_string (t[1]);
+    r << t;
   else {
     int i, n= N(t);
     for (i=0; i<n; i++)
-      r << search_latex_previews (t[i]);
+      search_latex_previews (t[i], r);
   }
+}
+
+static string
+latex_preview_code (tree t, bool& math) {
+  // the original LaTeX source of a preview, as stored by the parser
+  if (is_atomic (t)) {
+    string s= replace (t->label, "<less>", "<");
+    return replace (s, "<gtr>", ">");
+  }
+  if (is_compound (t, "text", 1)) math= true;
+  string r;
+  for (int i=0; i<N(t); i++)
+    r << latex_preview_code (t[i], math);
   return r;
 }
 
@@ -83,48 +97,91 @@ latex_remove_fmt (string s) {
   return s;
 }
 
-void
-latex_install_preview (string s, tree t, url wdir, bool dvips) {
+string
+latex_preview_preamble (string s) {
+  // the part of the document before \begin{document}, which is shared
+  // by all previews and which can be precompiled into a format
   s= latex_remove_fmt (s);
-  int i= 0;
-  array<string> macros= search_latex_previews (t);
+  int i= latex_search_forwards ("\\begin{document}", 0, s);
+  if (i < 0) return "\\documentclass{article}\n";
+  return s (0, i);
+}
+
+static string
+latex_preview_body (string s) {
+  s= latex_remove_fmt (s);
+  int i= latex_search_forwards ("\\begin{document}", 0, s);
+  if (i < 0) return "";
+  return s (i, N(s));
+}
+
+static bool
+latex_body_defines (string body) {
+  // definitions after \begin{document} are lost when the snippets are
+  // compiled on their own, so that the whole document is compiled instead
+  static const char* defs[]= {
+    "\\def", "\\gdef", "\\edef", "\\xdef", "\\let",
+    "\\newcommand", "\\renewcommand", "\\providecommand",
+    "\\newenvironment", "\\renewenvironment", "\\DeclareMathOperator",
+    "\\definecolor", "\\input", "\\include", NULL };
+  for (int k=0; defs[k] != NULL; k++) {
+    string def= defs[k];
+    int i= latex_search_forwards (def, 0, body);
+    while (i >= 0) {
+      i += N(def);
+      if (i >= N(body) || !is_alpha (body[i])) return true;
+      i= latex_search_forwards (def, i, body);
+    }
+  }
+  return false;
+}
+
+static string
+latex_preview_macros (array<tree> previews) {
+  // the commands of the document which are turned into pictures
+  string r;
   hashmap<string,bool> done (false);
-  string preview= "%%%%%%%%%%%%%% ADDED BY TEXMACS %%%%%%%%%%%%%%%%%%\n";
-  if (!dvips)
-    preview  << "\\usepackage[active,tightpage,delayed]{preview}\n";
-  else
-    preview  << "\\usepackage[active,tightpage,delayed,psfixbb,dvips]{preview}\n";
-
-  for (i=0; i<N(macros); i++) {
-    if (macros[i] == "") continue;
-    if (done[macros[i]]) continue;
-    if (test (macros[i], 0, "end-")) continue;
-    int arity= latex_arity (macros[i]);
-    bool option= (arity<0);
+  for (int i=0; i<N(previews); i++) {
+    string macro= as_string (previews[i][1]);
+    if (macro == "" || done[macro] || starts (macro, "end-")) continue;
+    int arity= latex_arity (macro);
     string arity_code;
-    if (option) {
+    if (arity < 0) {
       arity_code << "[]";
       arity= -arity;
     }
     while (arity-- > 0) arity_code << "{}";
-    string name= "\\" * macros[i];
+    string name= "\\" * macro;
     string cmd= "\\PreviewMacro";
-    if (test (name, 0, "\\begin-")) {
-      name= name(7, N(name));
+    if (starts (macro, "begin-")) {
+      name= macro (6, N(macro));
       cmd= "\\PreviewEnvironment";
     }
-    preview << cmd << "[{" * arity_code * "}]{" * name * "}\n";
-    done(macros[i])= true;
+    r << cmd << "[{" << arity_code << "}]{" << name << "}\n";
+    done (macro)= true;
   }
+  return r;
+}
+
+string
+latex_install_preview (string pre, bool dvips, string macros= "") {
+  // with macros, the pictures are those of the commands in the document,
+  // otherwise those of the preview environments
+  string options= (macros == ""? string ("active,tightpage"):
+                                 string ("active,tightpage,delayed"));
+  if (dvips) options << ",psfixbb,dvips";
+  string preview= "%%%%%%%%%%%%%% ADDED BY TEXMACS %%%%%%%%%%%%%%%%%%\n";
+  preview << "\\usepackage[" << options << "]{preview}\n" << macros;
   preview << "%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%\n";
 
-  i= latex_search_forwards ("\\documentclass", 0, s);
-  i= latex_search_forwards ("{", i, s);
-  i= latex_search_forwards ("}", i, s);
-  i= latex_search_forwards ("\n", i, s);
+  int i= latex_search_forwards ("\\documentclass", 0, pre);
+  if (i < 0) return pre * preview;
+  i= latex_search_forwards ("{", i, pre);
+  i= latex_search_forwards ("}", i, pre);
+  i= latex_search_forwards ("\n", i, pre);
+  if (i < 0) return pre * "\n" * preview;
   i++;
-  s= s(0, i) * preview * s(i, N(s));
-  save_string (wdir * "temp.tex", s);
+  return pre (0, i) * preview * pre (i, N(pre));
 }
 
 tree
@@ -146,6 +203,7 @@ latex_load_image (url image) {
 
 array<tree>
 latex_load_preview (url wdir, bool dvips= false) {
+  // one picture for each page of the document, empty if the page is empty
   string cmdln= "cd \"" * as_string (wdir) * "\"; ";
   if (dvips) {
     cmdln << "dvips temp.dvi && "
@@ -171,6 +229,7 @@ latex_load_preview (url wdir, bool dvips= false) {
       tree tmp= latex_load_image (u);
       if (N(tmp) == 5 && (tmp[1] != "0pt" || tmp[2] != "0pt"))
         r << tmp;
+      else r << tree ("");
       cnt++;
     }
     else
@@ -179,56 +238,219 @@ latex_load_preview (url wdir, bool dvips= false) {
   return r;
 }
 
-array<tree>
-latex_preview (string s, tree t) {
+/******************************************************************************
+* Cache of the pictures, keyed by a hash of the preamble, code and command
+******************************************************************************/
+
+static hashmap<string,tree> preview_cache (UNINIT);
+static bool preview_on_disk= true;
+static int preview_hits= 0;
+static int preview_misses= 0;
+static time_t preview_compile_time= 0;
+
+void
+latex_preview_cache (bool on_disk) {
+  preview_cache= hashmap<string,tree> (UNINIT);
+  preview_on_disk= on_disk;
+}
+
+void
+latex_preview_statistics (int& hits, int& misses, int& compile_ms) {
+  hits      = preview_hits;
+  misses    = preview_misses;
+  compile_ms= (int) preview_compile_time;
+}
+
+static string
+picture_key (bool dvips, string context, string code) {
+  // pictures are keyed by the compilation which actually made them
+  string cmd= dvips? string ("latex dvips"): latex_command;
+  return cache_key (cmd * "\n" * context * "\n" * code);
+}
+
+static url
+preview_file (string name) {
+  return url ("$TEXMACS_HOME_PATH/system/cache", name);
+}
+
+static tree
+preview_load (string key) {
+  tree t= preview_cache[key];
+  if (t != UNINIT || !preview_on_disk) return t;
+  // the files contain the size of the picture, followed by the eps data
+  string s;
+  url name= preview_file ("__latex-" * key);
+  if (!exists (name) || load_string (name, s, false)) return t;
+  int pos= search_forwards ("\n", s);
+  if (pos < 0) return t;
+  array<string> size= tokenize (s (0, pos), " ");
+  if (N(size) != 2) return t;
+  t= tree (IMAGE, 5);
+  t[0]= tuple (tree (RAW_DATA, s (pos+1, N(s))), "eps");
+  t[1]= size[0];
+  t[2]= size[1];
+  preview_cache (key)= t;
+  return t;
+}
+
+static tree
+preview_lookup (string context, string code) {
+  // pictures made by the dvips fallback are as good as the others
+  tree t= preview_load (picture_key (false, context, code));
+  if (t == UNINIT) t= preview_load (picture_key (true, context, code));
+  return t;
+}
+
+static void
+preview_save (string key, tree t) {
+  preview_cache (key)= t;
+  if (preview_on_disk) {
+    string s= as_string (t[1]) * " " * as_string (t[2]) * "\n";
+    s << as_string (t[0][0][0]);
+    save_string (preview_file ("__latex-" * key), s);
+  }
+}
+
+/******************************************************************************
+* Compiling the missing pictures in one run
+******************************************************************************/
+
+static bool
+latex_run (string cmd, string options, url wdir, string file) {
+  // relative paths in the document are relative to its directory
+  string cmdln;
+  if (!is_none (get_file_focus ()))
+    cmdln << "cd " << as_string (head (get_file_focus ())) << "; ";
+  cmdln << cmd << options
+        << " -interaction nonstopmode -halt-on-error -file-line-error "
+        << " -output-directory \"" << as_string (wdir)
+        << "\" \"" << as_string (wdir * file) << "\"";
+  dbg ("LaTeX command: " * cmdln);
+  return system (cmdln) == 0;
+}
+
+static bool
+latex_compile (string pre, string macros, string body, url wdir, bool dvips) {
+  string cmd= dvips? string ("latex"): latex_command;
+  pre= latex_install_preview (pre, dvips, macros);
+  if (preview_on_disk) {
+    // the preamble is dumped into a format, which is reused by later runs
+    url fmt= preview_file ("__latex-" * cache_key (cmd * "\n" * pre) *
+                           ".fmt");
+    if (!exists (fmt)) {
+      save_string (wdir * "preamble.tex", pre * "\\dump\n");
+      string options= " -ini -jobname=preamble \"&" * cmd * "\"";
+      if (latex_run (cmd, options, wdir, "preamble.tex") &&
+          exists (wdir * "preamble.fmt"))
+        copy (wdir * "preamble.fmt", fmt);
+    }
+    if (exists (fmt)) {
+      string name= concretize (fmt);
+      name= name (0, N(name) - 4);
+      save_string (wdir * "temp.tex", body);
+      if (latex_run (cmd, " -fmt=\"" * name * "\"", wdir, "temp.tex"))
+        return true;
+      dbg ("Could not compile LaTeX document using the precompiled preamble");
+    }
+  }
+  save_string (wdir * "temp.tex", pre * body);
+  return latex_run (cmd, "", wdir, "temp.tex");
+}
+
+static void
+latex_preview_batch (string pre, string macros, string body,
+                     string context, array<string> codes) {
+  // one picture is expected for each code, in this order
   if (!latex_present () && !exists_in_path ("latex")) {
     dbg ("LaTeX preview: " * latex_command * " not found");
-    return array<tree>();
+    return;
   }
   if (!exists_in_path ("gs")) {
     dbg ("LaTeX preview: ghostscript not found");
-    return array<tree>();
+    return;
   }
   // FIXME: ./Texmacs/Window/tm_frame.cpp:191 seems to crash here if we launch
   // system_wait ("LaTeX: compiling document, ", "please wait");
+  time_t start= texmacs_time ();
   url wdir= url_temp ("_latex_preview");
   mkdir (wdir);
   bool dvips= false;
-  latex_install_preview (s, t, wdir, dvips);
-  string document_root= as_string (head (get_file_focus ()));
-  string cmdln= "cd " * document_root;
-  cmdln << "; " << latex_command
-        << " -interaction nonstopmode -halt-on-error -file-line-error "
-        << " -output-directory \"" << as_string (wdir)
-        << "\" \"" << as_string (wdir) << "/temp.tex\"";
-  dbg ("LaTeX command: " * cmdln);
-  if (system (cmdln)) {
+  if (!latex_compile (pre, macros, body, wdir, dvips)) {
     dbg ("Could not compile LaTeX document using " * latex_command);
     dbg ("Try to fallback on LaTeX");
     dvips= true;
-    latex_install_preview (s, t, wdir, dvips);
-    cmdln= "cd " * document_root;
-    cmdln << "; latex"
-          << " -interaction nonstopmode -halt-on-error -file-line-error "
-          << " -output-directory \"" << as_string (wdir)
-          << "\" \"" << as_string (wdir) << "/temp.tex\"";
-    dbg ("LaTeX command: " * cmdln);
-    if (system (cmdln)) {
+    if (!latex_compile (pre, macros, body, wdir, dvips)) {
       dbg ("Could not compile LaTeX document");
       latex_clean_tmp_directory (wdir);
-      return array<tree> ();
+      preview_compile_time += texmacs_time () - start;
+      return;
     }
   }
   array<tree> r= latex_load_preview (wdir, dvips);
-  int exp= N(search_latex_previews (t));
-  if (N(r) != exp) {
+  if (N(r) != N(codes)) {
     string msg;
     msg << "Warning: did not found the expected number of pictures:\n"
       << "         Got " << as_string (N(r)) << " whereas expected "
-      << as_string (exp) << ".\n         LaTeX compilation or picture"
+      << as_string (N(codes)) << ".\n         LaTeX compilation or picture"
       << " importation might have failed";
     dbg (msg);
   }
+  else
+    for (int i=0; i<N(r); i++)
+      if (r[i] != "")
+        preview_save (picture_key (dvips, context, codes[i]), r[i]);
   latex_clean_tmp_directory (wdir);
+  preview_compile_time += texmacs_time () - start;
+}
+
+array<tree>
+latex_preview (string s, tree t) {
+  // The snippets which are not in the cache are compiled in one run, each
+  // in a preview environment, after the preamble of the document.
+  // When the body of the document makes definitions of its own, the whole
+  // document is compiled instead, with its commands turned into pictures
+  // by the preview package, and the body becomes part of the keys.
+  array<tree> previews;
+  search_latex_previews (t, previews);
+  string pre= latex_preview_preamble (s);
+  string body= latex_preview_body (s);
+  bool whole= latex_body_defines (body);
+  string context= whole? pre * body: pre;
+  array<string> all, codes;
+  hashmap<string,bool> todo (false);
+  for (int i=0; i<N(previews); i++) {
+    bool math= false;
+    string code= latex_preview_code (previews[i][2], math);
+    if (math) code= "$" * code * "$";
+    all << code;
+    if (preview_lookup (context, code) != UNINIT) preview_hits++;
+    else {
+      preview_misses++;
+      if (!todo[code]) {
+        codes << code;
+        todo (code)= true;
+      }
+    }
+  }
+  if (N(codes) > 0 && whole)
+    latex_preview_batch (pre, latex_preview_macros (previews), body,
+                         context, all);
+  else if (N(codes) > 0) {
+    // each picture is a page of its own, so that pages and pictures match
+    string batch= "\\begin{document}\n";
+    for (int i=0; i<N(codes); i++)
+      batch << "\\begin{preview}" << codes[i] << "\\end{preview}\n";
+    batch << "\\end{document}\n";
+    latex_preview_batch (pre, "", batch, context, codes);
+  }
+  dbg ("LaTeX preview: " * as_string (preview_hits) * " hits, " *
+       as_string (preview_misses) * " misses, " *
+       as_string ((int) preview_compile_time) * " ms of compilation");
+  // pictures which could not be made are left empty
+  array<tree> r;
+  for (int i=0; i<N(all); i++) {
+    tree img= preview_lookup (context, all[i]);
+    r << (img == UNINIT? tree (""): img);
+  }
   return r;
-} 
+}
@@ -16,5 +16,7 @@
 
 array<tree> latex_preview (string s, tree t);
 void set_latex_command (string cmd);
+void latex_preview_cache (bool on_disk);
+void latex_preview_statistics (int& hits, int& misses, int& compile_ms);
 
 #endif // LATEX_PREVIEW_H
@@ -53,6 +53,9 @@
 #include "PDFWriter/PDFTiledPattern.h"
 #include "PDFWriter/TiledPatternContentContext.h"
 #include "PDFWriter/PDFUsedFont.h"
+#include "PDFWriter/OutputStringBufferStream.h"
+#include "zlib.h"
+#include <pthread.h>
  
 /******************************************************************************
  * pdf_hummus_renderer
@@ -69,6 +72,49 @@ class pdf_raw_image;
 class t3font;
 class pdf_pattern;
 
+/******************************************************************************
+* Page contents compressed by worker threads
+******************************************************************************/
+
+// Number of pages whose contents may be compressed at the same time.
+// It does not depend on the machine, so that the output only depends
+// on the document.
+#define PDF_PAGE_WORKERS 4
+
+struct pdf_page_stream {
+  ObjectIDType id;       // object of the content stream
+  std::string  contents; // operators of the page
+  std::string  deflated; // compressed operators
+  uLongf       length;   // length of the compressed operators
+  bool         ok;       // whether the compression succeeded
+  bool         threaded; // whether a worker is compressing
+  pthread_t    thread;
+};
+
+static void*
+deflate_page (void* arg) {
+  // NOTE: workers only handle plain buffers, allocated beforehand;
+  // fonts, images and patterns are only registered by the renderer
+  pdf_page_stream* job= (pdf_page_stream*) arg;
+  job->ok= compress2 ((Bytef*) &job->deflated[0], &job->length,
+                      (const Bytef*) job->contents.data (),
+                      job->contents.size (), Z_DEFAULT_COMPRESSION) == Z_OK;
+  return NULL;
+}
+
+class pdf_page_context: public PageContentContext {
+  // page content context which collects the operators in memory
+  OutputStringBufferStream buffer;
+public:
+  pdf_page_context (PDFWriter& w, PDFPage* page):
+    PageContentContext (&w.GetDocumentContext (), page,
+                        &w.GetObjectsContext ()) {}
+  std::string contents () { return buffer.ToString (); }
+private:
+  void RenewStreamConnection () {
+    GetPrimitiveWriter ().SetStreamForWriting (&buffer); }
+};
+
 class pdf_hummus_renderer_rep : public renderer_rep {
   
   static const int default_dpi= 72; // PDF initial coordinate system corresponds to 72 dpi
@@ -84,6 +130,8 @@ class pdf_hummus_renderer_rep : public renderer_rep {
   ObjectIDType initial_GState_id; // GSstate with default values
 
   int       page_num;
+  bool      parallel;  // compress page contents in worker threads
+  array<pdf_page_stream*> page_streams; // pending page contents
   bool      inText;
   color     fg, bg;
   SI        lw;
@@ -107,6 +155,10 @@ class pdf_hummus_renderer_rep : public renderer_rep {
   hashmap<string,pdf_raw_image> pdf_glyphs;
   hashmap<tree,pdf_image> image_pool;
   hashmap<tree,pdf_image> pattern_image_pool;
+  hashmap<string,pdf_image> image_contents;         // by content fingerprint
+  hashmap<string,pdf_image> pattern_image_contents; // by content fingerprint
+  array<pdf_image> images;                          // distinct images
+  array<pdf_image> pattern_images;                  // distinct pattern images
   hashmap<tree,pdf_pattern> pattern_pool;
   hashmap<unsigned long long int,url> picture_cache;
   array<url> temp_images;
@@ -154,6 +206,8 @@ class pdf_hummus_renderer_rep : public renderer_rep {
   void select_fill_color (color c);
   void select_alpha (int a);
   
+  pdf_image make_pdf_image (url u, hashmap<string,pdf_image>& contents,
+                            array<pdf_image>& distinct);
   void register_pattern_image (brush br, SI pixel);
   void select_stroke_pattern (brush br);
   void select_fill_pattern (brush br);
@@ -165,6 +219,7 @@ class pdf_hummus_renderer_rep : public renderer_rep {
   
   void begin_page();
   void end_page();
+  void write_page_stream ();
   
   int get_label_id(string label);
 
@@ -289,6 +344,7 @@ pdf_hummus_renderer_rep::pdf_hummus_renderer_rep (
     nr_pages (nr_pages2), page_type (page_type2),
     landscape (landscape2), paper_w (paper_w2), paper_h (paper_h2),
     page_num(0),
+    parallel (get_preference ("texmacs->pdf:parallel pages") == "on"),
     inText (false),
     fg (-1), bg (-1),
     lw (-1),
@@ -360,6 +416,7 @@ pdf_hummus_renderer_rep::pdf_hummus_renderer_rep (
 pdf_hummus_renderer_rep::~pdf_hummus_renderer_rep () {
   if (!started) return; // no cleanup to do
   end_page();
+  while (N(page_streams) != 0) write_page_stream ();
   
   flush_images();
   flush_patterns();
@@ -431,7 +488,8 @@ pdf_hummus_renderer_rep::begin_page() {
 
   page = new PDFPage();
   page->SetMediaBox(PDFRectangle(0,0,width,height));
-  contentContext = pdfWriter.StartPageContentContext(page);
+  if (parallel) contentContext= new pdf_page_context (pdfWriter, page);
+  else contentContext = pdfWriter.StartPageContentContext(page);
   if (NULL == contentContext) {
     //status = PDFHummus::eFailure;
     convert_error << "Failed to create content context for page\n";
@@ -471,9 +529,27 @@ pdf_hummus_renderer_rep::end_page(){
   // outmost restore for the graphics state (see begin_page)
   contentContext->Q();
 
-  status = pdfWriter.EndPageContentContext(contentContext);
-  if (status != PDFHummus::eSuccess) {
-    convert_error << "Failed to end page content context\n";
+  if (parallel) {
+    // hand the operators of the page over to a worker
+    pdf_page_context* ctx= (pdf_page_context*) contentContext;
+    pdf_page_stream* job= new pdf_page_stream ();
+    job->id= pdfWriter.GetObjectsContext ()
+      .GetInDirectObjectsRegistry ().AllocateNewObjectID ();
+    page->AddContentStreamReference (job->id);
+    job->contents= ctx->contents ();
+    delete ctx;
+    job->length= compressBound (job->contents.size ());
+    job->deflated.resize (job->length);
+    job->threaded=
+      pthread_create (&job->thread, NULL, deflate_page, (void*) job) == 0;
+    if (!job->threaded) deflate_page ((void*) job);
+    page_streams << job;
+  }
+  else {
+    status = pdfWriter.EndPageContentContext(contentContext);
+    if (status != PDFHummus::eSuccess) {
+      convert_error << "Failed to end page content context\n";
+    }
   }
   
   EStatusCodeAndObjectIDType res = pdfWriter.GetDocumentContext().WritePageAndRelease(page);
@@ -484,6 +560,37 @@ pdf_hummus_renderer_rep::end_page(){
 
   page_id (page_num) = res.second;
   page_num++;
+
+  // pages are written in order, after a fixed number of further pages,
+  // so that the output does not depend on the speed of the workers
+  while (N(page_streams) > PDF_PAGE_WORKERS) write_page_stream ();
+}
+
+void
+pdf_hummus_renderer_rep::write_page_stream () {
+  pdf_page_stream* job= page_streams[0];
+  page_streams= range (page_streams, 1, N(page_streams));
+  if (job->threaded) pthread_join (job->thread, NULL);
+  if (job->ok) job->deflated.resize (job->length);
+  const std::string& data= (job->ok? job->deflated: job->contents);
+  ObjectsContext& objectsContext = pdfWriter.GetObjectsContext();
+  objectsContext.StartNewIndirectObject (job->id);
+  DictionaryContext* streamContext = objectsContext.StartDictionary();
+  if (job->ok) {
+    streamContext->WriteKey ("Filter");
+    streamContext->WriteNameValue ("FlateDecode");
+  }
+  streamContext->WriteKey ("Length");
+  streamContext->WriteIntegerValue (data.size ());
+  objectsContext.EndDictionary (streamContext);
+  objectsContext.WriteKeyword ("stream");
+  objectsContext.StartFreeContext()
+    ->Write ((const IOBasicTypes::Byte*) data.data (), data.size ());
+  objectsContext.EndFreeContext();
+  objectsContext.EndLine();
+  objectsContext.WriteKeyword ("endstream");
+  objectsContext.EndIndirectObject();
+  delete job;
 }
 
 void
@@ -581,9 +688,10 @@ public:
   url u;
   int w,h;
   ObjectIDType id;
+  string data; // contents of the file, until the image has been flushed
   
-  pdf_image_rep(url _u, ObjectIDType _id)
-    : u(_u), id(_id)
+  pdf_image_rep(url _u, ObjectIDType _id, string _data)
+    : u(_u), id(_id), data(_data)
   { image_size (u, w, h); } 
   ~pdf_image_rep() {}
 
@@ -596,12 +704,42 @@ public:
 
 class pdf_image {
   CONCRETE_NULL(pdf_image);
-  pdf_image (url _u, ObjectIDType _id):
-    rep (tm_new<pdf_image_rep> (_u,_id)) {};
+  pdf_image (url _u, ObjectIDType _id, string _data):
+    rep (tm_new<pdf_image_rep> (_u,_id,_data)) {};
 };
 
 CONCRETE_NULL_CODE(pdf_image);
 
+static string
+image_fingerprint (url name, string& data) {
+  // key which only depends on the type and the contents of an image file
+  if (is_none (name) || load_string (name, data, false)) return "";
+  return suffix (name) * ":" * as_string (N(data)) * ":" * cache_key (data);
+}
+
+pdf_image
+pdf_hummus_renderer_rep::make_pdf_image (url u,
+                                         hashmap<string,pdf_image>& contents,
+                                         array<pdf_image>& distinct) {
+  // Image files with identical contents (the same logo at several places,
+  // pictures which were rasterized in the same way, ...) share a single
+  // XObject, so that they are only encoded and written once.  Each file
+  // is read once; its contents are kept for comparison with later images
+  // with the same fingerprint, until the XObject has been written
+  string data;
+  string key= image_fingerprint (resolve (u), data);
+  if (key != "" && contents->contains (key)) {
+    pdf_image im= contents[key];
+    if (im->data == data) return im;
+  }
+  ObjectIDType id= pdfWriter.GetObjectsContext()
+    .GetInDirectObjectsRegistry().AllocateNewObjectID();
+  pdf_image im (u, id, data);
+  if (key != "") contents (key)= im;
+  distinct << im;
+  return im;
+}
+
 /******************************************************************************
  * Tiled patterns
  ******************************************************************************/
@@ -692,9 +830,7 @@ pdf_hummus_renderer_rep::register_pattern_image (brush br, SI pixel) {
     url temp= url_temp (".png");
     pim->save (utf8_to_qstring (concretize (temp)), "PNG");
     temp_images << temp;
-    ObjectIDType image_id= pdfWriter.GetObjectsContext()
-      .GetInDirectObjectsRegistry().AllocateNewObjectID();
-    image_pdf= pdf_image (temp, image_id);
+    image_pdf= make_pdf_image (temp, pattern_image_contents, pattern_images);
     pattern_image_pool(key) = image_pdf;
   }
   // debug_convert << "  insert pattern\n";
@@ -1967,25 +2103,24 @@ pdf_image_rep::flush_jpg (PDFWriter& pdfw, url image) {
 void
 pdf_hummus_renderer_rep::flush_images ()
 {
-  // flush all images
-  iterator<tree> it = iterate (image_pool);
-  while (it->busy()) {
-    pdf_image im = image_pool[it->next()];
-    im->flush(pdfWriter);
+  // flush all images; image_pool may contain several references
+  // to the same image, so we use the list of distinct images
+  for (int i=0; i<N(images); i++) {
+    images[i]->flush(pdfWriter);
+    images[i]->data= "";
   }
 }
 
 void
 pdf_hummus_renderer_rep::flush_patterns ()
 {
-  // flush all pattern images
-  iterator<tree> it = iterate (pattern_image_pool);
-  while (it->busy()) {
-    pdf_image im = pattern_image_pool[it->next()];
-    im->flush_for_pattern(pdfWriter);
+  // flush all distinct pattern images
+  for (int i=0; i<N(pattern_images); i++) {
+    pattern_images[i]->flush_for_pattern(pdfWriter);
+    pattern_images[i]->data= "";
   }
   // flush all patterns
-  it = iterate (pattern_pool);
+  iterator<tree> it = iterate (pattern_pool);
   while (it->busy()) {
     pdf_pattern pa = pattern_pool[it->next()];
     pa->flush(pdfWriter);
@@ -2002,7 +2137,7 @@ pdf_hummus_renderer_rep::image (
   pdf_image im = ( image_pool->contains(lookup) ? image_pool[lookup] : pdf_image() );
   
   if (is_nil(im)) {
-    im = pdf_image(u, pdfWriter.GetObjectsContext().GetInDirectObjectsRegistry().AllocateNewObjectID());
+    im = make_pdf_image (u, image_contents, images);
     image_pool(lookup) = im;
   }
 
@@ -2444,7 +2579,8 @@ pdf_hummus_renderer (url pdf_file_name, int dpi, int nr_pages,
                      string page_type, bool landscape, double paper_w, double paper_h)
 {
   //cout << "Hummus print to " << pdf_file_name << " at " << dpi << " dpi\n";
-  page_type= as_string (call ("standard-paper-size", object (page_type)));
+  // NOTE: the size of the pages is given by paper_w and paper_h,
+  // so the page type need not be normalized by standard-paper-size
   return tm_new<pdf_hummus_renderer_rep> (pdf_file_name, dpi, nr_pages,
 			  page_type, landscape, paper_w, paper_h);
 }
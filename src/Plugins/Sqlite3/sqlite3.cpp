@@ -13,6 +13,7 @@
 #include "dyn_link.hpp"
 #include "hashmap.hpp"
 #include "analyze.hpp"
+#include "iterator.hpp"
 #include "config.h"
 
 #ifdef USE_SQLITE3
@@ -33,16 +34,36 @@ int (*SQLITE3_open) (
 
 int (*SQLITE3_close) (sqlite3 *db);
 
-int (*SQLITE3_get_table) (
-  sqlite3 *db,          /* An open database */
-  const char *zSql,     /* SQL to be evaluated */
-  char ***pazResult,    /* Results of the query */
-  int *pnRow,           /* Number of result rows written here */
-  int *pnColumn,        /* Number of result columns written here */
-  char **pzErrmsg       /* Error msg written here */
+int (*SQLITE3_prepare_v2) (
+  sqlite3 *db,            /* Database handle */
+  const char *zSql,       /* SQL statement, UTF-8 encoded */
+  int nByte,              /* Maximum length of zSql in bytes. */
+  sqlite3_stmt **ppStmt,  /* OUT: Statement handle */
+  const char **pzTail     /* OUT: Pointer to unused portion of zSql */
 );
 
-void (*SQLITE3_free_table) (char **result);
+int (*SQLITE3_step) (sqlite3_stmt *stmt);
+int (*SQLITE3_reset) (sqlite3_stmt *stmt);
+int (*SQLITE3_finalize) (sqlite3_stmt *stmt);
+int (*SQLITE3_clear_bindings) (sqlite3_stmt *stmt);
+int (*SQLITE3_bind_parameter_count) (sqlite3_stmt *stmt);
+
+int (*SQLITE3_bind_text) (
+  sqlite3_stmt *stmt,     /* Prepared statement */
+  int i,                  /* Index of the parameter, starting at 1 */
+  const char *zData,      /* Value of the parameter */
+  int nData,              /* Number of bytes of the value */
+  void (*xDel) (void*)    /* Destructor for the value */
+);
+
+int (*SQLITE3_column_count) (sqlite3_stmt *stmt);
+const char* (*SQLITE3_column_name) (sqlite3_stmt *stmt, int i);
+const unsigned char* (*SQLITE3_column_text) (sqlite3_stmt *stmt, int i);
+int (*SQLITE3_column_bytes) (sqlite3_stmt *stmt, int i);
+
+const char* (*SQLITE3_errmsg) (sqlite3 *db);
+int (*SQLITE3_busy_timeout) (sqlite3 *db, int ms);
+int (*SQLITE3_get_autocommit) (sqlite3 *db);
 
 /******************************************************************************
 * Initialization
@@ -74,8 +95,20 @@ tm_sqlite3_initialize () {
   int status= debug_off ();
   sqlite3_bind (sqlite3_open, SQLITE3_open);
   sqlite3_bind (sqlite3_close, SQLITE3_close);
-  sqlite3_bind (sqlite3_get_table, SQLITE3_get_table);
-  sqlite3_bind (sqlite3_free_table, SQLITE3_free_table);
+  sqlite3_bind (sqlite3_prepare_v2, SQLITE3_prepare_v2);
+  sqlite3_bind (sqlite3_step, SQLITE3_step);
+  sqlite3_bind (sqlite3_reset, SQLITE3_reset);
+  sqlite3_bind (sqlite3_finalize, SQLITE3_finalize);
+  sqlite3_bind (sqlite3_clear_bindings, SQLITE3_clear_bindings);
+  sqlite3_bind (sqlite3_bind_parameter_count, SQLITE3_bind_parameter_count);
+  sqlite3_bind (sqlite3_bind_text, SQLITE3_bind_text);
+  sqlite3_bind (sqlite3_column_count, SQLITE3_column_count);
+  sqlite3_bind (sqlite3_column_name, SQLITE3_column_name);
+  sqlite3_bind (sqlite3_column_text, SQLITE3_column_text);
+  sqlite3_bind (sqlite3_column_bytes, SQLITE3_column_bytes);
+  sqlite3_bind (sqlite3_errmsg, SQLITE3_errmsg);
+  sqlite3_bind (sqlite3_busy_timeout, SQLITE3_busy_timeout);
+  sqlite3_bind (sqlite3_get_autocommit, SQLITE3_get_autocommit);
   debug_on (status);
 
 #ifdef LINKED_SQLITE3
@@ -98,8 +131,6 @@ sqlite3_present () {
   return !sqlite3_error;
 }
 
-hashmap<tree,pointer> sqlite3_connections (NULL);
-
 string
 sql_escape (string s) {
   //return cork_to_utf8 (s);
@@ -112,13 +143,125 @@ sql_unescape (string s) {
   return s;
 }
 
-tree
-sql_exec (url db_name, string cmd) {
+/******************************************************************************
+* Connections and their caches of prepared statements
+******************************************************************************/
+
+struct sql_statement {
+  string        cmd;       // the SQL command
+  sqlite3_stmt* stmt;      // the prepared statement for this command
+  int           prev, next;// neighbours in the least recently used order
+};
+
+struct sql_connection {
+  sqlite3*             db;      // the database handle
+  array<sql_statement> cache;   // slots for the prepared statements
+  array<int>           unused;  // slots which can be reused
+  hashmap<string,int>  slot;    // slots of the statements by command
+  int                  first;   // most recently used statement
+  int                  last;    // least recently used statement
+  int                  hits;    // number of reused statements
+  int                  misses;  // number of prepared statements
+
+  sql_connection (sqlite3* db2):
+    db (db2), slot (-1), first (-1), last (-1), hits (0), misses (0) {}
+};
+
+hashmap<tree,pointer> sqlite3_connections (NULL);
+
+static void
+sql_report (sql_connection* c) {
+  // TODO: improve error handling
+  cout << "TeXmacs] SQL error\n";
+  cout << "TeXmacs] " << SQLITE3_errmsg (c->db) << "\n";
+}
+
+static void
+sql_unlink (sql_connection* c, int i) {
+  sql_statement& st= c->cache[i];
+  if (st.prev >= 0) c->cache[st.prev].next= st.next; else c->first= st.next;
+  if (st.next >= 0) c->cache[st.next].prev= st.prev; else c->last= st.prev;
+  st.prev= st.next= -1;
+}
+
+static void
+sql_remove (sql_connection* c, int i) {
+  // remove the statement from the cache, but do not finalize it
+  sql_unlink (c, i);
+  c->slot->reset (c->cache[i].cmd);
+  c->cache[i].cmd = "";
+  c->cache[i].stmt= NULL;
+  c->unused << i;
+}
+
+static sqlite3_stmt*
+sql_take (sql_connection* c, string cmd, int& tail) {
+  // prepare the first statement of cmd or take it from the cache;
+  // tail is the position of the remaining statements inside cmd,
+  // or -1 in case of an error
+  int i= c->slot[cmd];
+  if (i >= 0) {
+    sqlite3_stmt* stmt= c->cache[i].stmt;
+    sql_remove (c, i);
+    c->hits++;
+    tail= N(cmd);
+    return stmt;
+  }
+  c->misses++;
+  c_string _cmd (cmd);
+  const char* end= NULL;
+  sqlite3_stmt* stmt= NULL;
+  int status= SQLITE3_prepare_v2 (c->db, _cmd, N(cmd), &stmt, &end);
+  if (status != SQLITE_OK) {
+    sql_report (c);
+    if (stmt != NULL) SQLITE3_finalize (stmt);
+    tail= -1;
+    return NULL;
+  }
+  tail= (end == NULL? N(cmd): (int) (end - ((char*) _cmd)));
+  while (tail < N(cmd) && is_space (cmd[tail])) tail++;
+  return stmt;
+}
+
+static void
+sql_release (sql_connection* c, string cmd, sqlite3_stmt* stmt) {
+  // put a statement which is no longer in use back into the cache
+  SQLITE3_reset (stmt);
+  SQLITE3_clear_bindings (stmt);
+  if (c->slot->contains (cmd)) {
+    SQLITE3_finalize (stmt);
+    return;
+  }
+  while (N(c->cache) - N(c->unused) >= SQL_STATEMENT_CACHE) {
+    int last= c->last;
+    sqlite3_stmt* old= c->cache[last].stmt;
+    sql_remove (c, last);
+    SQLITE3_finalize (old);
+  }
+  int i;
+  if (N(c->unused) > 0) {
+    i= c->unused[N(c->unused) - 1];
+    c->unused->resize (N(c->unused) - 1);
+  }
+  else {
+    i= N(c->cache);
+    c->cache << sql_statement ();
+  }
+  sql_statement& st= c->cache[i];
+  st.cmd= cmd; st.stmt= stmt; st.prev= -1; st.next= c->first;
+  if (c->first >= 0) c->cache[c->first].prev= i;
+  c->first= i;
+  if (c->last < 0) c->last= i;
+  c->slot (cmd)= i;
+}
+
+static sql_connection*
+sql_connect (url db_name) {
   if (!sqlite3_initialized)
     tm_sqlite3_initialize ();
   if (sqlite3_error) {
     cout << "TeXmacs] ERROR: SQLite support not properly configured.\n";
-    return tree (TUPLE);
+    return NULL;
   }
   string name= concretize (db_name);
   if (!sqlite3_connections->contains (name)) {
@@ -126,56 +269,259 @@ sql_exec (url db_name, string cmd) {
     sqlite3* db= NULL;
     //cout << "Opening " << _name << "\n";
     int status= SQLITE3_open (_name, &db);
-    if (status == SQLITE_OK)
-      sqlite3_connections (name) = (void*) db;
+    if (status == SQLITE_OK) {
+      // wait for other processes which lock the database
+      SQLITE3_busy_timeout (db, 10000);
+      sqlite3_connections (name)= (pointer) tm_new<sql_connection> (db);
+    }
+    else if (db != NULL) SQLITE3_close (db);
   }
   if (!sqlite3_connections->contains (name)) {
     cout << "TeXmacs] SQL error: database " << name << " could not be opened\n";
-    return tree (TUPLE);
+    return NULL;
   }
-  tree ret (TUPLE);
-  sqlite3* db= (sqlite3*) sqlite3_connections [name];
-  c_string _cmd (sql_escape (cmd));
-  char** tab;
-  int rows, cols;
-  char* err;
-  //cout << "Executing " << _cmd << "\n";
-  int status= SQLITE3_get_table (db, _cmd, &tab, &rows, &cols, &err);
-
-  int attempt= 0;
-  while (status != SQLITE_OK &&
-         string (err) == string ("database is locked") &&
-         attempt < 100) {
-    usleep (100000);
-    attempt++;
-    status= SQLITE3_get_table (db, _cmd, &tab, &rows, &cols, &err);
+  return (sql_connection*) sqlite3_connections [name];
+}
+
+/******************************************************************************
+* Executing statements
+******************************************************************************/
+
+static void
+sql_bind (sqlite3_stmt* stmt, array<string> args) {
+  int n= min (N(args), SQLITE3_bind_parameter_count (stmt));
+  for (int i=0; i<n; i++) {
+    string arg= sql_escape (args[i]);
+    c_string _arg (arg);
+    SQLITE3_bind_text (stmt, i+1, _arg, N(arg), SQLITE_TRANSIENT);
   }
+}
 
-  if (status != SQLITE_OK) {
-    // TODO: improve error handling
-    cout << "TeXmacs] SQL error\n";
-    if (err != NULL) cout << "TeXmacs] " << err << "\n";
-  }
-
-  for (int r=0; r<=rows; r++) {
-    tree row (TUPLE);
-    //cout << "  Row " << r << LF;
-    for (int c=0; c<cols; c++) {
-      int i= r*cols + c;
-      if (tab[i] == NULL) row << tree (TUPLE);
-      else {
-        row << tree (scm_quote (sql_unescape (tab[i])));
-        //cout << "    Column " << c << ": " << tab[i] << LF;
-      }
+static tree
+sql_columns (sqlite3_stmt* stmt) {
+  tree row (TUPLE);
+  int cols= SQLITE3_column_count (stmt);
+  for (int c=0; c<cols; c++)
+    row << tree (scm_quote (sql_unescape (SQLITE3_column_name (stmt, c))));
+  return row;
+}
+
+static tree
+sql_row (sqlite3_stmt* stmt) {
+  tree row (TUPLE);
+  int cols= SQLITE3_column_count (stmt);
+  for (int c=0; c<cols; c++) {
+    const unsigned char* val= SQLITE3_column_text (stmt, c);
+    if (val == NULL) row << tree (TUPLE);
+    else {
+      string s ((char*) val, SQLITE3_column_bytes (stmt, c));
+      row << tree (scm_quote (sql_unescape (s)));
+    }
+  }
+  return row;
+}
+
+static bool
+sql_run (sql_connection* c, string cmd, array<string> args, tree* ret) {
+  // execute all statements in cmd and append the resulting rows to ret,
+  // preceded by the names of the columns; returns true on error
+  bool header= false;
+  while (true) {
+    int tail;
+    sqlite3_stmt* stmt= sql_take (c, cmd, tail);
+    if (stmt == NULL) {
+      // errors, or empty statements such as comments
+      if (tail < 0) return true;
+      if (tail >= N(cmd)) return false;
+      cmd= cmd (tail, N(cmd));
+      continue;
     }
-    ret << row;
+    sql_bind (stmt, args);
+    int status;
+    while ((status= SQLITE3_step (stmt)) == SQLITE_ROW)
+      if (ret != NULL) {
+        if (!header) *ret << sql_columns (stmt);
+        header= true;
+        *ret << sql_row (stmt);
+      }
+    if (status != SQLITE_DONE) sql_report (c);
+    if (tail >= N(cmd)) sql_release (c, cmd, stmt);
+    else SQLITE3_finalize (stmt);
+    if (status != SQLITE_DONE) return true;
+    if (tail >= N(cmd)) return false;
+    cmd= cmd (tail, N(cmd));
   }
+}
 
-  SQLITE3_free_table (tab);
+tree
+sql_exec (url db_name, string cmd, array<string> args) {
+  // NOTE: the arguments are bound to the parameters of each statement
+  sql_connection* c= sql_connect (db_name);
+  if (c == NULL) return tree (TUPLE);
+  tree ret (TUPLE);
+  //cout << "Executing " << cmd << "\n";
+  if (sql_run (c, sql_escape (cmd), args, &ret)) ret= tree (TUPLE);
+  if (N(ret) == 0) ret << tree (TUPLE);
   //cout << "Return " << ret << "\n";
   return ret;
 }
 
+tree
+sql_exec (url db_name, string cmd) {
+  return sql_exec (db_name, cmd, array<string> ());
+}
+
+/******************************************************************************
+* Transactions
+******************************************************************************/
+
+void
+sql_begin (url db_name) {
+  sql_connection* c= sql_connect (db_name);
+  if (c != NULL) (void) sql_run (c, "BEGIN", array<string> (), NULL);
+}
+
+void
+sql_commit (url db_name) {
+  sql_connection* c= sql_connect (db_name);
+  if (c != NULL) (void) sql_run (c, "COMMIT", array<string> (), NULL);
+}
+
+void
+sql_rollback (url db_name) {
+  sql_connection* c= sql_connect (db_name);
+  if (c != NULL) (void) sql_run (c, "ROLLBACK", array<string> (), NULL);
+}
+
+int
+sql_exec_batch (url db_name, string cmd, tree rows) {
+  // execute cmd once for each row of arguments, inside a transaction
+  // unless one is already open; returns the number of executions or -1.
+  // As in the results of sql_exec, the arguments are quoted strings
+  sql_connection* c= sql_connect (db_name);
+  if (c == NULL) return -1;
+  bool own= SQLITE3_get_autocommit (c->db) != 0;
+  if (own && sql_run (c, "BEGIN", array<string> (), NULL)) return -1;
+  cmd= sql_escape (cmd);
+  int tail, done= 0;
+  sqlite3_stmt* stmt= sql_take (c, cmd, tail);
+  bool error= (stmt == NULL);
+  if (tail >= 0) cmd= cmd (0, tail);
+  for (int i=0; !error && i<N(rows); i++) {
+    array<string> args;
+    for (int j=0; j<N(rows[i]); j++)
+      args << (is_atomic (rows[i][j])? scm_unquote (rows[i][j]->label): "");
+    SQLITE3_reset (stmt);
+    SQLITE3_clear_bindings (stmt);
+    sql_bind (stmt, args);
+    while (SQLITE3_step (stmt) == SQLITE_ROW) {}
+    if (SQLITE3_reset (stmt) != SQLITE_OK) { sql_report (c); error= true; }
+    else done++;
+  }
+  if (stmt != NULL) sql_release (c, cmd, stmt);
+  if (own) (void) sql_run (c, error? "ROLLBACK": "COMMIT",
+                           array<string> (), NULL);
+  return error? -1: done;
+}
+
+/******************************************************************************
+* Cursors for reading large results in chunks
+******************************************************************************/
+
+struct sql_cursor {
+  sql_connection* c;       // the connection
+  string          cmd;     // the command
+  sqlite3_stmt*   stmt;    // its statement, which is not in the cache
+  bool            done;    // all rows have been read
+};
+
+static hashmap<int,pointer> sql_cursors (NULL);
+static int sql_cursor_count= 0;
+
+int
+sql_cursor_open (url db_name, string cmd, array<string> args) {
+  // NOTE: only the first statement of cmd is executed
+  sql_connection* c= sql_connect (db_name);
+  if (c == NULL) return -1;
+  cmd= sql_escape (cmd);
+  int tail;
+  sqlite3_stmt* stmt= sql_take (c, cmd, tail);
+  if (stmt == NULL) return -1;
+  cmd= cmd (0, tail);
+  sql_bind (stmt, args);
+  sql_cursor* cur= tm_new<sql_cursor> ();
+  cur->c= c; cur->cmd= cmd; cur->stmt= stmt; cur->done= false;
+  int id= ++sql_cursor_count;
+  sql_cursors (id)= (pointer) cur;
+  return id;
+}
+
+tree
+sql_cursor_columns (int id) {
+  if (!sql_cursors->contains (id)) return tree (TUPLE);
+  sql_cursor* cur= (sql_cursor*) sql_cursors [id];
+  return sql_columns (cur->stmt);
+}
+
+tree
+sql_cursor_fetch (int id, int nr) {
+  // the next nr rows at most, fewer rows meaning that all rows were read
+  tree ret (TUPLE);
+  if (!sql_cursors->contains (id)) return ret;
+  sql_cursor* cur= (sql_cursor*) sql_cursors [id];
+  while (!cur->done && N(ret) < nr) {
+    int status= SQLITE3_step (cur->stmt);
+    if (status == SQLITE_ROW) ret << sql_row (cur->stmt);
+    else {
+      if (status != SQLITE_DONE) sql_report (cur->c);
+      cur->done= true;
+    }
+  }
+  return ret;
+}
+
+void
+sql_cursor_close (int id) {
+  if (!sql_cursors->contains (id)) return;
+  sql_cursor* cur= (sql_cursor*) sql_cursors [id];
+  sql_release (cur->c, cur->cmd, cur->stmt);
+  sql_cursors->reset (id);
+  tm_delete (cur);
+}
+
+/******************************************************************************
+* Closing connections
+******************************************************************************/
+
+void
+sql_close (url db_name) {
+  string name= concretize (db_name);
+  if (!sqlite3_connections->contains (name)) return;
+  sql_connection* c= (sql_connection*) sqlite3_connections [name];
+  array<int> ids;
+  iterator<int> it= iterate (sql_cursors);
+  while (it->busy ()) {
+    int id= it->next ();
+    if (((sql_cursor*) sql_cursors [id])->c == c) ids << id;
+  }
+  for (int i=0; i<N(ids); i++) sql_cursor_close (ids[i]);
+  while (c->first >= 0) {
+    sqlite3_stmt* stmt= c->cache[c->first].stmt;
+    sql_remove (c, c->first);
+    SQLITE3_finalize (stmt);
+  }
+  SQLITE3_close (c->db);
+  sqlite3_connections->reset (name);
+  tm_delete (c);
+}
+
+void
+sql_cache_statistics (url db_name, int& hits, int& misses) {
+  sql_connection* c= sql_connect (db_name);
+  hits  = (c == NULL? 0: c->hits);
+  misses= (c == NULL? 0: c->misses);
+}
+
 #else // USE_SQLITE3
 
 /******************************************************************************
@@ -186,6 +532,28 @@ bool sqlite3_present () {
   return false; }
 tree sql_exec (url db_name, string cmd) {
   (void) db_name; (void) cmd; return tree (TUPLE); }
+tree sql_exec (url db_name, string cmd, array<string> args) {
+  (void) db_name; (void) cmd; (void) args; return tree (TUPLE); }
+void sql_close (url db_name) {
+  (void) db_name; }
+void sql_cache_statistics (url db_name, int& hits, int& misses) {
+  (void) db_name; hits= misses= 0; }
+void sql_begin (url db_name) {
+  (void) db_name; }
+void sql_commit (url db_name) {
+  (void) db_name; }
+void sql_rollback (url db_name) {
+  (void) db_name; }
+int sql_exec_batch (url db_name, string cmd, tree rows) {
+  (void) db_name; (void) cmd; (void) rows; return -1; }
+int sql_cursor_open (url db_name, string cmd, array<string> args) {
+  (void) db_name; (void) cmd; (void) args; return -1; }
+tree sql_cursor_columns (int id) {
+  (void) id; return tree (TUPLE); }
+tree sql_cursor_fetch (int id, int nr) {
+  (void) id; (void) nr; return tree (TUPLE); }
+void sql_cursor_close (int id) {
+  (void) id; }
 
 #endif // USE_SQLITE3
 
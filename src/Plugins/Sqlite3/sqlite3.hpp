@@ -13,8 +13,23 @@
 #define TM_SQLITE3_H
 #include "url.hpp"
 
+#define SQL_STATEMENT_CACHE 32
+
 bool sqlite3_present ();
 tree sql_exec (url db_name, string cmd);
+tree sql_exec (url db_name, string cmd, array<string> args);
+void sql_close (url db_name);
+void sql_cache_statistics (url db_name, int& hits, int& misses);
 string sql_quote (string s);
 
+void sql_begin (url db_name);
+void sql_commit (url db_name);
+void sql_rollback (url db_name);
+int  sql_exec_batch (url db_name, string cmd, tree rows);
+
+int  sql_cursor_open (url db_name, string cmd, array<string> args);
+tree sql_cursor_columns (int id);
+tree sql_cursor_fetch (int id, int nr);
+void sql_cursor_close (int id);
+
 #endif // TM_SQLITE3_H
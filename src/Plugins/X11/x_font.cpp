@@ -203,11 +203,14 @@ x_gui_rep::default_font (bool tt, bool mini, bool bold) {
 
 void
 set_default_font (string name) {
-  the_gui->set_default_font (name);
+  if (the_gui != NULL) the_gui->set_default_font (name);
 }
 
 font
 get_default_font (bool tt, bool mini, bool bold) {
+  if (the_gui == NULL) // no display, as for conversion daemons
+    return find_font ("roman", tt? "tt": (mini? "ss": "rm"),
+                      bold? "bold": "medium", "right", 10, 300);
   return the_gui->default_font (tt, mini, bold);
 }
 
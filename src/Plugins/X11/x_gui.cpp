@@ -612,12 +612,12 @@ show_help_balloon (widget wid, SI x, SI y) {
 
 void
 show_wait_indicator (widget w, string message, string arg) {
-  the_gui->show_wait_indicator (w, message, arg);
+  if (the_gui != NULL) the_gui->show_wait_indicator (w, message, arg);
 }
 
 void
 external_event (string type, time_t t) {
-  the_gui->external_event (type, t);
+  if (the_gui != NULL) the_gui->external_event (type, t);
 }
 
 void
@@ -626,7 +626,7 @@ needs_update () {
 
 bool
 check_event (int type) {
-  return the_gui->check_event (type);
+  return the_gui != NULL && the_gui->check_event (type);
 }
 
 bool
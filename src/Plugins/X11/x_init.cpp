@@ -735,12 +735,14 @@ gui_close () {
 
 void
 gui_root_extents (SI& width, SI& height) {
-  the_gui->get_extents (width, height);
+  if (the_gui == NULL) { width= 1024 * PIXEL; height= 768 * PIXEL; }
+  else the_gui->get_extents (width, height);
 }
 
 void
 gui_maximal_extents (SI& width, SI& height) {
-  the_gui->get_max_size (width, height);
+  if (the_gui == NULL) { width= 1024 * PIXEL; height= 768 * PIXEL; }
+  else the_gui->get_max_size (width, height);
 }
 
 void
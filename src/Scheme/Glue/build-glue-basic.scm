@@ -56,6 +56,7 @@
   (get-texmacs-home-path get_texmacs_home_path (url))
   (plugin-list plugin_list (scheme_tree))
   (set-fast-environments set_fast_environments (void bool))
+  (set-history-limits global_history_limits (void int int))
   (font-exists-in-tt? tt_font_exists (bool string))
   (eval-system eval_system (string string))
   (var-eval-system var_eval_system (string string))
@@ -68,6 +69,8 @@
   (texmacs-time texmacs_time (int))
   (pretty-time pretty_time (string int))
   (texmacs-memory mem_used (int))
+  (bench-start bench_start (void string))
+  (bench-cumul bench_cumul (void string))
   (bench-print bench_print (void string))
   (bench-print-all bench_print (void))
   (system-wait system_wait (void string string))
@@ -239,6 +242,7 @@
   (tree-search-sections search_sections (array_tree tree))
   (tree-search-tree search (array_path content content path int))
   (tree-search-tree-at search (array_path content content path path int))
+  (tree-search-done search_done (void tree))
   (tree-spell spell (array_path string content path int))
   (tree-spell-at spell (array_path string content path path int))
   (tree-spell-selection spell (array_path string content path path path int))
@@ -257,6 +261,7 @@
   (tree-split tree_split (tree tree int int))
   (tree-join tree_join (tree tree int))
   (tree-assign-node tree_assign_node (tree tree tree_label))
+  (tree-assign-changes tree_assign_changes (tree tree content))
   (tree-insert-node tree_insert_node (tree tree int content))
   (tree-remove-node tree_remove_node (tree tree int))
 
@@ -493,6 +498,8 @@
   (texmacs->stm tree_to_scheme (string tree))
   (stm->texmacs scheme_document_to_tree (tree string))
   (stm-snippet->texmacs scheme_to_tree (tree string))
+  (texmacs->binary tree_to_binary (string tree))
+  (binary->texmacs binary_to_tree (tree string))
   (cpp-texmacs->verbatim tree_to_verbatim (string tree bool string))
   (cpp-verbatim-snippet->texmacs verbatim_to_tree (tree string bool string))
   (cpp-verbatim->texmacs verbatim_document_to_tree (tree string bool string))
@@ -636,6 +643,16 @@
   (supports-sql? sqlite3_present (bool))
   (sql-exec sql_exec (scheme_tree url string))
   (sql-quote sql_quote (string string))
+  (sql-exec-with sql_exec (scheme_tree url string array_string))
+  (sql-close sql_close (void url))
+  (sql-begin sql_begin (void url))
+  (sql-commit sql_commit (void url))
+  (sql-rollback sql_rollback (void url))
+  (sql-exec-batch sql_exec_batch (int url string scheme_tree))
+  (sql-cursor-open sql_cursor_open (int url string array_string))
+  (sql-cursor-columns sql_cursor_columns (scheme_tree int))
+  (sql-cursor-fetch sql_cursor_fetch (scheme_tree int int))
+  (sql-cursor-close sql_cursor_close (void int))
 
   ;; TeXmacs servers and clients
   (server-start server_start (void))
@@ -744,6 +761,10 @@
   (buffer-load buffer_load (bool url))
   (buffer-export buffer_export (bool url url string))
   (buffer-save buffer_save (bool url))
+  (buffer-autosave buffer_autosave (string url url string))
+  (autosave-cancel autosave_cancel (void url))
+  (autosave-reap autosave_reap (void))
+  (autosave-recover autosave_recover (tree url string))
   (tree-import-loaded import_loaded_tree (tree string url string))
   (tree-import import_tree (tree url string))
   (tree-inclusion load_inclusion (tree url))
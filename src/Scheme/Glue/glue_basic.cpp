@@ -408,6 +408,21 @@ tmg_set_fast_environments (tmscm arg1) {
   return TMSCM_UNSPECIFIED;
 }
 
+tmscm
+tmg_set_history_limits (tmscm arg1, tmscm arg2) {
+  TMSCM_ASSERT_INT (arg1, TMSCM_ARG1, "set-history-limits");
+  TMSCM_ASSERT_INT (arg2, TMSCM_ARG2, "set-history-limits");
+
+  int in1= tmscm_to_int (arg1);
+  int in2= tmscm_to_int (arg2);
+
+  // TMSCM_DEFER_INTS;
+  global_history_limits (in1, in2);
+  // TMSCM_ALLOW_INTS;
+
+  return TMSCM_UNSPECIFIED;
+}
+
 tmscm
 tmg_font_exists_in_ttP (tmscm arg1) {
   TMSCM_ASSERT_STRING (arg1, TMSCM_ARG1, "font-exists-in-tt?");
@@ -541,6 +556,32 @@ tmg_texmacs_memory () {
   return int_to_tmscm (out);
 }
 
+tmscm
+tmg_bench_start (tmscm arg1) {
+  TMSCM_ASSERT_STRING (arg1, TMSCM_ARG1, "bench-start");
+
+  string in1= tmscm_to_string (arg1);
+
+  // TMSCM_DEFER_INTS;
+  bench_start (in1);
+  // TMSCM_ALLOW_INTS;
+
+  return TMSCM_UNSPECIFIED;
+}
+
+tmscm
+tmg_bench_cumul (tmscm arg1) {
+  TMSCM_ASSERT_STRING (arg1, TMSCM_ARG1, "bench-cumul");
+
+  string in1= tmscm_to_string (arg1);
+
+  // TMSCM_DEFER_INTS;
+  bench_cumul (in1);
+  // TMSCM_ALLOW_INTS;
+
+  return TMSCM_UNSPECIFIED;
+}
+
 tmscm
 tmg_bench_print (tmscm arg1) {
   TMSCM_ASSERT_STRING (arg1, TMSCM_ARG1, "bench-print");
@@ -2667,6 +2708,19 @@ tmg_tree_search_tree_at (tmscm arg1, tmscm arg2, tmscm arg3, tmscm arg4, tmscm a
   return array_path_to_tmscm (out);
 }
 
+tmscm
+tmg_tree_search_done (tmscm arg1) {
+  TMSCM_ASSERT_TREE (arg1, TMSCM_ARG1, "tree-search-done");
+
+  tree in1= tmscm_to_tree (arg1);
+
+  // TMSCM_DEFER_INTS;
+  search_done (in1);
+  // TMSCM_ALLOW_INTS;
+
+  return TMSCM_UNSPECIFIED;
+}
+
 tmscm
 tmg_tree_spell (tmscm arg1, tmscm arg2, tmscm arg3, tmscm arg4) {
   TMSCM_ASSERT_STRING (arg1, TMSCM_ARG1, "tree-spell");
@@ -2942,6 +2996,21 @@ tmg_tree_assign_node (tmscm arg1, tmscm arg2) {
   return tree_to_tmscm (out);
 }
 
+tmscm
+tmg_tree_assign_changes (tmscm arg1, tmscm arg2) {
+  TMSCM_ASSERT_TREE (arg1, TMSCM_ARG1, "tree-assign-changes");
+  TMSCM_ASSERT_CONTENT (arg2, TMSCM_ARG2, "tree-assign-changes");
+
+  tree in1= tmscm_to_tree (arg1);
+  content in2= tmscm_to_content (arg2);
+
+  // TMSCM_DEFER_INTS;
+  tree out= tree_assign_changes (in1, in2);
+  // TMSCM_ALLOW_INTS;
+
+  return tree_to_tmscm (out);
+}
+
 tmscm
 tmg_tree_insert_node (tmscm arg1, tmscm arg2, tmscm arg3) {
   TMSCM_ASSERT_TREE (arg1, TMSCM_ARG1, "tree-insert-node");
@@ -5851,6 +5920,32 @@ tmg_stm_snippet_2texmacs (tmscm arg1) {
   return tree_to_tmscm (out);
 }
 
+tmscm
+tmg_texmacs_2binary (tmscm arg1) {
+  TMSCM_ASSERT_TREE (arg1, TMSCM_ARG1, "texmacs->binary");
+
+  tree in1= tmscm_to_tree (arg1);
+
+  // TMSCM_DEFER_INTS;
+  string out= tree_to_binary (in1);
+  // TMSCM_ALLOW_INTS;
+
+  return string_to_tmscm (out);
+}
+
+tmscm
+tmg_binary_2texmacs (tmscm arg1) {
+  TMSCM_ASSERT_STRING (arg1, TMSCM_ARG1, "binary->texmacs");
+
+  string in1= tmscm_to_string (arg1);
+
+  // TMSCM_DEFER_INTS;
+  tree out= binary_to_tree (in1);
+  // TMSCM_ALLOW_INTS;
+
+  return tree_to_tmscm (out);
+}
+
 tmscm
 tmg_cpp_texmacs_2verbatim (tmscm arg1, tmscm arg2, tmscm arg3) {
   TMSCM_ASSERT_TREE (arg1, TMSCM_ARG1, "cpp-texmacs->verbatim");
@@ -7694,6 +7789,150 @@ tmg_sql_quote (tmscm arg1) {
   return string_to_tmscm (out);
 }
 
+tmscm
+tmg_sql_exec_with (tmscm arg1, tmscm arg2, tmscm arg3) {
+  TMSCM_ASSERT_URL (arg1, TMSCM_ARG1, "sql-exec-with");
+  TMSCM_ASSERT_STRING (arg2, TMSCM_ARG2, "sql-exec-with");
+  TMSCM_ASSERT_ARRAY_STRING (arg3, TMSCM_ARG3, "sql-exec-with");
+
+  url in1= tmscm_to_url (arg1);
+  string in2= tmscm_to_string (arg2);
+  array_string in3= tmscm_to_array_string (arg3);
+
+  // TMSCM_DEFER_INTS;
+  scheme_tree out= sql_exec (in1, in2, in3);
+  // TMSCM_ALLOW_INTS;
+
+  return scheme_tree_to_tmscm (out);
+}
+
+tmscm
+tmg_sql_close (tmscm arg1) {
+  TMSCM_ASSERT_URL (arg1, TMSCM_ARG1, "sql-close");
+
+  url in1= tmscm_to_url (arg1);
+
+  // TMSCM_DEFER_INTS;
+  sql_close (in1);
+  // TMSCM_ALLOW_INTS;
+
+  return TMSCM_UNSPECIFIED;
+}
+
+tmscm
+tmg_sql_begin (tmscm arg1) {
+  TMSCM_ASSERT_URL (arg1, TMSCM_ARG1, "sql-begin");
+
+  url in1= tmscm_to_url (arg1);
+
+  // TMSCM_DEFER_INTS;
+  sql_begin (in1);
+  // TMSCM_ALLOW_INTS;
+
+  return TMSCM_UNSPECIFIED;
+}
+
+tmscm
+tmg_sql_commit (tmscm arg1) {
+  TMSCM_ASSERT_URL (arg1, TMSCM_ARG1, "sql-commit");
+
+  url in1= tmscm_to_url (arg1);
+
+  // TMSCM_DEFER_INTS;
+  sql_commit (in1);
+  // TMSCM_ALLOW_INTS;
+
+  return TMSCM_UNSPECIFIED;
+}
+
+tmscm
+tmg_sql_rollback (tmscm arg1) {
+  TMSCM_ASSERT_URL (arg1, TMSCM_ARG1, "sql-rollback");
+
+  url in1= tmscm_to_url (arg1);
+
+  // TMSCM_DEFER_INTS;
+  sql_rollback (in1);
+  // TMSCM_ALLOW_INTS;
+
+  return TMSCM_UNSPECIFIED;
+}
+
+tmscm
+tmg_sql_exec_batch (tmscm arg1, tmscm arg2, tmscm arg3) {
+  TMSCM_ASSERT_URL (arg1, TMSCM_ARG1, "sql-exec-batch");
+  TMSCM_ASSERT_STRING (arg2, TMSCM_ARG2, "sql-exec-batch");
+  TMSCM_ASSERT_SCHEME_TREE (arg3, TMSCM_ARG3, "sql-exec-batch");
+
+  url in1= tmscm_to_url (arg1);
+  string in2= tmscm_to_string (arg2);
+  scheme_tree in3= tmscm_to_scheme_tree (arg3);
+
+  // TMSCM_DEFER_INTS;
+  int out= sql_exec_batch (in1, in2, in3);
+  // TMSCM_ALLOW_INTS;
+
+  return int_to_tmscm (out);
+}
+
+tmscm
+tmg_sql_cursor_open (tmscm arg1, tmscm arg2, tmscm arg3) {
+  TMSCM_ASSERT_URL (arg1, TMSCM_ARG1, "sql-cursor-open");
+  TMSCM_ASSERT_STRING (arg2, TMSCM_ARG2, "sql-cursor-open");
+  TMSCM_ASSERT_ARRAY_STRING (arg3, TMSCM_ARG3, "sql-cursor-open");
+
+  url in1= tmscm_to_url (arg1);
+  string in2= tmscm_to_string (arg2);
+  array_string in3= tmscm_to_array_string (arg3);
+
+  // TMSCM_DEFER_INTS;
+  int out= sql_cursor_open (in1, in2, in3);
+  // TMSCM_ALLOW_INTS;
+
+  return int_to_tmscm (out);
+}
+
+tmscm
+tmg_sql_cursor_columns (tmscm arg1) {
+  TMSCM_ASSERT_INT (arg1, TMSCM_ARG1, "sql-cursor-columns");
+
+  int in1= tmscm_to_int (arg1);
+
+  // TMSCM_DEFER_INTS;
+  scheme_tree out= sql_cursor_columns (in1);
+  // TMSCM_ALLOW_INTS;
+
+  return scheme_tree_to_tmscm (out);
+}
+
+tmscm
+tmg_sql_cursor_fetch (tmscm arg1, tmscm arg2) {
+  TMSCM_ASSERT_INT (arg1, TMSCM_ARG1, "sql-cursor-fetch");
+  TMSCM_ASSERT_INT (arg2, TMSCM_ARG2, "sql-cursor-fetch");
+
+  int in1= tmscm_to_int (arg1);
+  int in2= tmscm_to_int (arg2);
+
+  // TMSCM_DEFER_INTS;
+  scheme_tree out= sql_cursor_fetch (in1, in2);
+  // TMSCM_ALLOW_INTS;
+
+  return scheme_tree_to_tmscm (out);
+}
+
+tmscm
+tmg_sql_cursor_close (tmscm arg1) {
+  TMSCM_ASSERT_INT (arg1, TMSCM_ARG1, "sql-cursor-close");
+
+  int in1= tmscm_to_int (arg1);
+
+  // TMSCM_DEFER_INTS;
+  sql_cursor_close (in1);
+  // TMSCM_ALLOW_INTS;
+
+  return TMSCM_UNSPECIFIED;
+}
+
 tmscm
 tmg_server_start () {
   // TMSCM_DEFER_INTS;
@@ -9082,6 +9321,60 @@ tmg_buffer_save (tmscm arg1) {
   return bool_to_tmscm (out);
 }
 
+tmscm
+tmg_buffer_autosave (tmscm arg1, tmscm arg2, tmscm arg3) {
+  TMSCM_ASSERT_URL (arg1, TMSCM_ARG1, "buffer-autosave");
+  TMSCM_ASSERT_URL (arg2, TMSCM_ARG2, "buffer-autosave");
+  TMSCM_ASSERT_STRING (arg3, TMSCM_ARG3, "buffer-autosave");
+
+  url in1= tmscm_to_url (arg1);
+  url in2= tmscm_to_url (arg2);
+  string in3= tmscm_to_string (arg3);
+
+  // TMSCM_DEFER_INTS;
+  string out= buffer_autosave (in1, in2, in3);
+  // TMSCM_ALLOW_INTS;
+
+  return string_to_tmscm (out);
+}
+
+tmscm
+tmg_autosave_cancel (tmscm arg1) {
+  TMSCM_ASSERT_URL (arg1, TMSCM_ARG1, "autosave-cancel");
+
+  url in1= tmscm_to_url (arg1);
+
+  // TMSCM_DEFER_INTS;
+  autosave_cancel (in1);
+  // TMSCM_ALLOW_INTS;
+
+  return TMSCM_UNSPECIFIED;
+}
+
+tmscm
+tmg_autosave_reap () {
+  // TMSCM_DEFER_INTS;
+  autosave_reap ();
+  // TMSCM_ALLOW_INTS;
+
+  return TMSCM_UNSPECIFIED;
+}
+
+tmscm
+tmg_autosave_recover (tmscm arg1, tmscm arg2) {
+  TMSCM_ASSERT_URL (arg1, TMSCM_ARG1, "autosave-recover");
+  TMSCM_ASSERT_STRING (arg2, TMSCM_ARG2, "autosave-recover");
+
+  url in1= tmscm_to_url (arg1);
+  string in2= tmscm_to_string (arg2);
+
+  // TMSCM_DEFER_INTS;
+  tree out= autosave_recover (in1, in2);
+  // TMSCM_ALLOW_INTS;
+
+  return tree_to_tmscm (out);
+}
+
 tmscm
 tmg_tree_import_loaded (tmscm arg1, tmscm arg2, tmscm arg3) {
   TMSCM_ASSERT_STRING (arg1, TMSCM_ARG1, "tree-import-loaded");
@@ -9942,6 +10235,7 @@ initialize_glue_basic () {
   tmscm_install_procedure ("get-texmacs-home-path",  tmg_get_texmacs_home_path, 0, 0, 0);
   tmscm_install_procedure ("plugin-list",  tmg_plugin_list, 0, 0, 0);
   tmscm_install_procedure ("set-fast-environments",  tmg_set_fast_environments, 1, 0, 0);
+  tmscm_install_procedure ("set-history-limits",  tmg_set_history_limits, 2, 0, 0);
   tmscm_install_procedure ("font-exists-in-tt?",  tmg_font_exists_in_ttP, 1, 0, 0);
   tmscm_install_procedure ("eval-system",  tmg_eval_system, 1, 0, 0);
   tmscm_install_procedure ("var-eval-system",  tmg_var_eval_system, 1, 0, 0);
@@ -9953,6 +10247,8 @@ initialize_glue_basic () {
   tmscm_install_procedure ("texmacs-time",  tmg_texmacs_time, 0, 0, 0);
   tmscm_install_procedure ("pretty-time",  tmg_pretty_time, 1, 0, 0);
   tmscm_install_procedure ("texmacs-memory",  tmg_texmacs_memory, 0, 0, 0);
+  tmscm_install_procedure ("bench-start",  tmg_bench_start, 1, 0, 0);
+  tmscm_install_procedure ("bench-cumul",  tmg_bench_cumul, 1, 0, 0);
   tmscm_install_procedure ("bench-print",  tmg_bench_print, 1, 0, 0);
   tmscm_install_procedure ("bench-print-all",  tmg_bench_print_all, 0, 0, 0);
   tmscm_install_procedure ("system-wait",  tmg_system_wait, 2, 0, 0);
@@ -10113,6 +10409,7 @@ initialize_glue_basic () {
   tmscm_install_procedure ("tree-search-sections",  tmg_tree_search_sections, 1, 0, 0);
   tmscm_install_procedure ("tree-search-tree",  tmg_tree_search_tree, 4, 0, 0);
   tmscm_install_procedure ("tree-search-tree-at",  tmg_tree_search_tree_at, 5, 0, 0);
+  tmscm_install_procedure ("tree-search-done",  tmg_tree_search_done, 1, 0, 0);
   tmscm_install_procedure ("tree-spell",  tmg_tree_spell, 4, 0, 0);
   tmscm_install_procedure ("tree-spell-at",  tmg_tree_spell_at, 5, 0, 0);
   tmscm_install_procedure ("tree-spell-selection",  tmg_tree_spell_selection, 6, 0, 0);
@@ -10130,6 +10427,7 @@ initialize_glue_basic () {
   tmscm_install_procedure ("tree-split",  tmg_tree_split, 3, 0, 0);
   tmscm_install_procedure ("tree-join",  tmg_tree_join, 2, 0, 0);
   tmscm_install_procedure ("tree-assign-node",  tmg_tree_assign_node, 2, 0, 0);
+  tmscm_install_procedure ("tree-assign-changes",  tmg_tree_assign_changes, 2, 0, 0);
   tmscm_install_procedure ("tree-insert-node",  tmg_tree_insert_node, 3, 0, 0);
   tmscm_install_procedure ("tree-remove-node",  tmg_tree_remove_node, 2, 0, 0);
   tmscm_install_procedure ("cpp-tree-correct-node",  tmg_cpp_tree_correct_node, 1, 0, 0);
@@ -10337,6 +10635,8 @@ initialize_glue_basic () {
   tmscm_install_procedure ("texmacs->stm",  tmg_texmacs_2stm, 1, 0, 0);
   tmscm_install_procedure ("stm->texmacs",  tmg_stm_2texmacs, 1, 0, 0);
   tmscm_install_procedure ("stm-snippet->texmacs",  tmg_stm_snippet_2texmacs, 1, 0, 0);
+  tmscm_install_procedure ("texmacs->binary",  tmg_texmacs_2binary, 1, 0, 0);
+  tmscm_install_procedure ("binary->texmacs",  tmg_binary_2texmacs, 1, 0, 0);
   tmscm_install_procedure ("cpp-texmacs->verbatim",  tmg_cpp_texmacs_2verbatim, 3, 0, 0);
   tmscm_install_procedure ("cpp-verbatim-snippet->texmacs",  tmg_cpp_verbatim_snippet_2texmacs, 3, 0, 0);
   tmscm_install_procedure ("cpp-verbatim->texmacs",  tmg_cpp_verbatim_2texmacs, 3, 0, 0);
@@ -10468,6 +10768,16 @@ initialize_glue_basic () {
   tmscm_install_procedure ("supports-sql?",  tmg_supports_sqlP, 0, 0, 0);
   tmscm_install_procedure ("sql-exec",  tmg_sql_exec, 2, 0, 0);
   tmscm_install_procedure ("sql-quote",  tmg_sql_quote, 1, 0, 0);
+  tmscm_install_procedure ("sql-exec-with",  tmg_sql_exec_with, 3, 0, 0);
+  tmscm_install_procedure ("sql-close",  tmg_sql_close, 1, 0, 0);
+  tmscm_install_procedure ("sql-begin",  tmg_sql_begin, 1, 0, 0);
+  tmscm_install_procedure ("sql-commit",  tmg_sql_commit, 1, 0, 0);
+  tmscm_install_procedure ("sql-rollback",  tmg_sql_rollback, 1, 0, 0);
+  tmscm_install_procedure ("sql-exec-batch",  tmg_sql_exec_batch, 3, 0, 0);
+  tmscm_install_procedure ("sql-cursor-open",  tmg_sql_cursor_open, 3, 0, 0);
+  tmscm_install_procedure ("sql-cursor-columns",  tmg_sql_cursor_columns, 1, 0, 0);
+  tmscm_install_procedure ("sql-cursor-fetch",  tmg_sql_cursor_fetch, 2, 0, 0);
+  tmscm_install_procedure ("sql-cursor-close",  tmg_sql_cursor_close, 1, 0, 0);
   tmscm_install_procedure ("server-start",  tmg_server_start, 0, 0, 0);
   tmscm_install_procedure ("server-stop",  tmg_server_stop, 0, 0, 0);
   tmscm_install_procedure ("server-read",  tmg_server_read, 1, 0, 0);
@@ -10564,6 +10874,10 @@ initialize_glue_basic () {
   tmscm_install_procedure ("buffer-load",  tmg_buffer_load, 1, 0, 0);
   tmscm_install_procedure ("buffer-export",  tmg_buffer_export, 3, 0, 0);
   tmscm_install_procedure ("buffer-save",  tmg_buffer_save, 1, 0, 0);
+  tmscm_install_procedure ("buffer-autosave",  tmg_buffer_autosave, 3, 0, 0);
+  tmscm_install_procedure ("autosave-cancel",  tmg_autosave_cancel, 1, 0, 0);
+  tmscm_install_procedure ("autosave-reap",  tmg_autosave_reap, 0, 0, 0);
+  tmscm_install_procedure ("autosave-recover",  tmg_autosave_recover, 2, 0, 0);
   tmscm_install_procedure ("tree-import-loaded",  tmg_tree_import_loaded, 3, 0, 0);
   tmscm_install_procedure ("tree-import",  tmg_tree_import, 2, 0, 0);
   tmscm_install_procedure ("tree-inclusion",  tmg_tree_inclusion, 1, 0, 0);
@@ -301,6 +301,29 @@ tree_assign (tree r, tree t) {
   }
 }
 
+static void
+assign_changes (path p, tree t, tree u) {
+  // replace the subtree t at p by u, by only assigning modified subtrees
+  if (strong_equal (t, u)) return;
+  if (is_compound (t) && is_compound (u) && L(t) == L(u) && N(t) == N(u))
+    for (int i=0; i<N(t); i++)
+      assign_changes (p * i, t[i], u[i]);
+  else if (t != u) assign (p, copy (u));
+}
+
+tree
+tree_assign_changes (tree r, tree t) {
+  path ip= copy (obtain_ip (r));
+  if (ip_attached (ip)) {
+    assign_changes (reverse (ip), r, t);
+    return subtree (the_et, reverse (ip));
+  }
+  else {
+    assign (r, copy (t));
+    return r;
+  }
+}
+
 tree
 tree_insert (tree r, int pos, tree t) {
   path ip= copy (obtain_ip (r));
@@ -1191,6 +1214,7 @@ tmscm_to_list_tree (tmscm p) {
 #include "link.hpp"
 #include "dictionary.hpp"
 #include "patch.hpp"
+#include "archiver.hpp"
 #include "packrat.hpp"
 #include "new_style.hpp"
 #include "persistent.hpp"
@@ -69,9 +69,10 @@ int tracing;
 
 
 #define CELL_SEGSIZE    5000  /* # of cells in one segment */
-#define CELL_NSEGMENT   10    /* # of segments for cells */
-char *alloc_seg[CELL_NSEGMENT];
-cell_ptr cell_seg[CELL_NSEGMENT];
+#define CELL_NSEGMENT   10    /* initial # of slots in the segment tables */
+char  **alloc_seg;
+cell_ptr *cell_seg;
+int     nr_cell_seg;     /* # of slots in the segment tables */
 int     last_cell_seg;
 
 /* We use 4 registers. */
@@ -124,6 +125,12 @@ int file_i;
 int nesting;
 
 char    gc_verbose;      /* if gc_verbose is not zero, print gc status */
+long    gc_count;        /* # of garbage collections */
+long    gc_total_time;   /* total time spent in garbage collection (ms) */
+long    gc_max_time;     /* longest garbage collection (ms) */
+long    gc_last_time;    /* duration of the last garbage collection (ms) */
+long    gc_last_live;    /* # of live cells after the last collection */
+long    gc_freed_segs;   /* # of idle segments given back to the system */
 char    no_memory;       /* Whether mem. alloc. has failed */
 
 #define LINESIZE 1024
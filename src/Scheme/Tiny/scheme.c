@@ -68,6 +68,8 @@
 
 #include <string.h>
 #include <stdlib.h>
+#include <time.h>
+#include <stdint.h>
 
 #ifdef __APPLE__
 static int stricmp(const char *s1, const char *s2)
@@ -109,6 +111,13 @@ static const char *strlwr(char *s) {
 # define FIRST_CELLSEGS 3
 #endif
 
+/* idle segments are only released if the collector already found
+   at least that many free cells in other segments, and if these cover
+   at least half of the remaining heap */
+#ifndef CELL_GC_HEADROOM
+# define CELL_GC_HEADROOM (2*CELL_SEGSIZE)
+#endif
+
 enum scheme_types {
   T_STRING=1,
   T_NUMBER=2,
@@ -332,6 +341,7 @@ static void file_pop(scheme *sc);
 static int file_interactive(scheme *sc);
 static INLINE int is_one_of(char *s, int c);
 static int alloc_cellseg(scheme *sc, int n);
+static void free_cellseg(scheme *sc, int i);
 static long binary_decode(const char *s);
 static INLINE cell_ptr get_cell(scheme *sc, cell_ptr a, cell_ptr b);
 static cell_ptr _get_cell(scheme *sc, cell_ptr a, cell_ptr b);
@@ -562,6 +572,28 @@ static long binary_decode(const char *s) {
  return x;
 }
 
+/* make room for one more segment in the segment tables */
+static int grow_cellseg_tables(scheme *sc) {
+     int n = sc->nr_cell_seg == 0 ? CELL_NSEGMENT : 2 * sc->nr_cell_seg;
+     char **a = (char**) sc->malloc(n * sizeof(char*));
+     cell_ptr *c = (cell_ptr*) sc->malloc(n * sizeof(cell_ptr));
+     if (a == 0 || c == 0) {
+          if (a != 0) sc->free(a);
+          if (c != 0) sc->free(c);
+          return 0;
+     }
+     if (sc->nr_cell_seg > 0) {
+          memcpy(a, sc->alloc_seg, (sc->last_cell_seg + 1) * sizeof(char*));
+          memcpy(c, sc->cell_seg, (sc->last_cell_seg + 1) * sizeof(cell_ptr));
+          sc->free(sc->alloc_seg);
+          sc->free(sc->cell_seg);
+     }
+     sc->alloc_seg = a;
+     sc->cell_seg = c;
+     sc->nr_cell_seg = n;
+     return 1;
+}
+
 /* allocate new cell segment */
 static int alloc_cellseg(scheme *sc, int n) {
      cell_ptr newp;
@@ -577,7 +609,8 @@ static int alloc_cellseg(scheme *sc, int n) {
      }
 
      for (k = 0; k < n; k++) {
-          if (sc->last_cell_seg >= CELL_NSEGMENT - 1)
+          if (sc->last_cell_seg >= sc->nr_cell_seg - 1 &&
+              !grow_cellseg_tables(sc))
                return k;
           cp = (char*) sc->malloc(CELL_SEGSIZE * sizeof(struct cell)+adj);
           if (cp == 0)
@@ -593,7 +626,10 @@ static int alloc_cellseg(scheme *sc, int n) {
         sc->cell_seg[i] = newp;
         while (i > 0 && sc->cell_seg[i - 1] > sc->cell_seg[i]) {
               p = sc->cell_seg[i];
+              cp = sc->alloc_seg[i];
             sc->cell_seg[i] = sc->cell_seg[i - 1];
+            sc->alloc_seg[i] = sc->alloc_seg[i - 1];
+            sc->alloc_seg[i - 1] = cp;
             sc->cell_seg[--i] = p;
         }
           sc->fcells += CELL_SEGSIZE;
@@ -618,6 +654,18 @@ static int alloc_cellseg(scheme *sc, int n) {
      return n;
 }
 
+/* give an idle cell segment back to the system;
+   its cells must not be on the free list */
+static void free_cellseg(scheme *sc, int i) {
+     sc->free(sc->alloc_seg[i]);
+     for (; i < sc->last_cell_seg; i++) {
+          sc->alloc_seg[i] = sc->alloc_seg[i + 1];
+          sc->cell_seg[i] = sc->cell_seg[i + 1];
+     }
+     sc->last_cell_seg--;
+     sc->gc_freed_segs++;
+}
+
 static INLINE cell_ptr get_cell_x(scheme *sc, cell_ptr a, cell_ptr b) {
   if (sc->free_cell != sc->NIL) {
     cell_ptr x = sc->free_cell;
@@ -638,12 +686,15 @@ static cell_ptr _get_cell(scheme *sc, cell_ptr a, cell_ptr b) {
   }
 
   if (sc->free_cell == sc->NIL) {
-    const int min_to_be_recovered = sc->last_cell_seg*8;
     gc(sc,a, b);
-    if (sc->fcells < min_to_be_recovered
+    if (sc->fcells < (long) (sc->last_cell_seg + 1) * CELL_SEGSIZE / 2
     || sc->free_cell == sc->NIL) {
-      /* if only a few recovered, get more to avoid fruitless gc's */
-      if (!alloc_cellseg(sc,1) && sc->free_cell == sc->NIL) {
+      /* if only a few recovered, get more to avoid fruitless gc's;
+         the heap grows proportionally to its size, so that the number
+         of collections remains logarithmic in the size of the heap */
+      int n = (sc->last_cell_seg + 1) / 2;
+      if (n < 1) n = 1;
+      if (!alloc_cellseg(sc,n) && sc->free_cell == sc->NIL) {
     sc->no_memory=1;
     return sc->sink;
       }
@@ -1014,7 +1065,7 @@ INTERFACE cell_ptr mk_empty_string(scheme *sc, int len, char fill) {
 INTERFACE cell_ptr mk_blackbox(scheme *sc, void *blackbox) {
 	cell_ptr x = get_cell(sc, sc->NIL, sc->NIL);
 	typeflag(x) = (T_BLACKBOX | T_ATOM);
-	car(x) = blackbox;
+	car(x) = (cell_ptr) blackbox;
 	return (x);
 }
 
@@ -1266,6 +1317,7 @@ E6:   /* up.  Undo the link switching from steps E4 and E5. */
 static void gc(scheme *sc, cell_ptr a, cell_ptr b) {
   cell_ptr p;
   int i;
+  clock_t start = clock();
 
   if(sc->gc_verbose) {
     putstr(sc, "gc...");
@@ -1305,10 +1357,14 @@ static void gc(scheme *sc, cell_ptr a, cell_ptr b) {
      free-list in sorted order.
   */
   for (i = sc->last_cell_seg; i >= 0; i--) {
+    cell_ptr free_above = sc->free_cell;
+    long fcells_above = sc->fcells;
+    int live = 0;
     p = sc->cell_seg[i] + CELL_SEGSIZE;
     while (--p >= sc->cell_seg[i]) {
       if (is_mark(p)) {
     clrmark(p);
+    live = 1;
       } else {
     /* reclaim cell */
         if (typeflag(p) != 0) {
@@ -1321,6 +1377,24 @@ static void gc(scheme *sc, cell_ptr a, cell_ptr b) {
         sc->free_cell = p;
       }
     }
+    /* the heap shrinks again when segments become idle, as long as
+       enough free cells remain for the allocation to continue */
+    if (!live && sc->last_cell_seg >= FIRST_CELLSEGS &&
+        fcells_above >= CELL_GC_HEADROOM &&
+        2 * fcells_above >= (long) sc->last_cell_seg * CELL_SEGSIZE) {
+      sc->free_cell = free_above;
+      sc->fcells = fcells_above;
+      free_cellseg(sc, i);
+    }
+  }
+
+  {
+    long elapsed = (long) ((clock() - start) * 1000 / CLOCKS_PER_SEC);
+    sc->gc_count++;
+    sc->gc_total_time += elapsed;
+    sc->gc_last_time = elapsed;
+    if (elapsed > sc->gc_max_time) sc->gc_max_time = elapsed;
+    sc->gc_last_live = (long) (sc->last_cell_seg + 1) * CELL_SEGSIZE - sc->fcells;
   }
 
   if (sc->gc_verbose) {
@@ -1474,7 +1548,7 @@ static port *port_rep_from_scratch(scheme *sc) {
   if(pt==0) {
     return 0;
   }
-  start=sc->malloc(BLOCK_SIZE);
+  start=(char*)sc->malloc(BLOCK_SIZE);
   if(start==0) {
     return 0;
   }
@@ -1567,7 +1641,7 @@ static int realloc_port_string(scheme *sc, port *p)
 {
   char *start=p->rep.string.start;
   size_t new_size=p->rep.string.past_the_end-start+1+BLOCK_SIZE;
-  char *str=sc->malloc(new_size);
+  char *str=(char*)sc->malloc(new_size);
   if(str) {
     memset(str,' ',new_size-1);
     str[new_size-1]='\0';
@@ -3790,6 +3864,27 @@ static cell_ptr opexe_4(scheme *sc, enum scheme_opcodes op) {
           s_retbool(was);
      }
 
+     case OP_GCSTATS:         /* gc-statistics */
+     {    cell_ptr x = sc->NIL;
+          x = cons(sc, cons(sc, mk_symbol(sc, "freed-segments"),
+                            mk_integer(sc, sc->gc_freed_segs)), x);
+          x = cons(sc, cons(sc, mk_symbol(sc, "segments"),
+                            mk_integer(sc, sc->last_cell_seg + 1)), x);
+          x = cons(sc, cons(sc, mk_symbol(sc, "free-cells"),
+                            mk_integer(sc, sc->fcells)), x);
+          x = cons(sc, cons(sc, mk_symbol(sc, "live-cells"),
+                            mk_integer(sc, sc->gc_last_live)), x);
+          x = cons(sc, cons(sc, mk_symbol(sc, "last-pause"),
+                            mk_integer(sc, sc->gc_last_time)), x);
+          x = cons(sc, cons(sc, mk_symbol(sc, "max-pause"),
+                            mk_integer(sc, sc->gc_max_time)), x);
+          x = cons(sc, cons(sc, mk_symbol(sc, "total-time"),
+                            mk_integer(sc, sc->gc_total_time)), x);
+          x = cons(sc, cons(sc, mk_symbol(sc, "collections"),
+                            mk_integer(sc, sc->gc_count)), x);
+          s_return(sc,x);
+     }
+
      case OP_NEWSEGMENT: /* new-segment */
           if (!is_pair(sc->args) || !is_number(car(sc->args))) {
                Error_0(sc,"new-segment: argument must be a number");
@@ -3864,7 +3959,7 @@ static cell_ptr opexe_4(scheme *sc, enum scheme_opcodes op) {
            char *str;
 
            size=p->rep.string.curr-p->rep.string.start+1;
-           str=sc->malloc(size);
+           str=(char*)sc->malloc(size);
            if(str != NULL) {
                 cell_ptr s;
 
@@ -4569,7 +4664,16 @@ int scheme_init_custom_alloc(scheme *sc, func_alloc malloc, func_dealloc free) {
   sc->gensym_cnt=0;
   sc->malloc=malloc;
   sc->free=free;
+  sc->alloc_seg = 0;
+  sc->cell_seg = 0;
+  sc->nr_cell_seg = 0;
   sc->last_cell_seg = -1;
+  sc->gc_count = 0;
+  sc->gc_total_time = 0;
+  sc->gc_max_time = 0;
+  sc->gc_last_time = 0;
+  sc->gc_last_live = 0;
+  sc->gc_freed_segs = 0;
   sc->sink = &sc->_sink;
   sc->NIL = &sc->_NIL;
   sc->T = &sc->_HASHT;
@@ -4708,6 +4812,11 @@ void scheme_deinit(scheme *sc) {
   for(i=0; i<=sc->last_cell_seg; i++) {
     sc->free(sc->alloc_seg[i]);
   }
+  if (sc->nr_cell_seg > 0) {
+    sc->free(sc->alloc_seg);
+    sc->free(sc->cell_seg);
+    sc->nr_cell_seg = 0;
+  }
 
 #if SHOW_ERROR_LINE
   fname = sc->load_stack[i].rep.stdio.filename;
@@ -4719,6 +4828,366 @@ void scheme_deinit(scheme *sc) {
 #endif
 }
 
+/* ========== Heap images ========== */
+
+/* The heap can be written to a file once the interpreter has been
+   initialized, and restored in a later session instead of evaluating
+   the same initialization files again.  Cells keep their position in
+   the segments, so that pointers are stored as (segment, offset)
+   pairs.  Strings are stored with their contents, foreign functions
+   relative to the address of scheme_init, which only works for the
+   same executable.  Images of heaps with live blackboxes, or with ports
+   other than the standard ones, cannot be made. */
+
+#define IMAGE_MAGIC "TinyScheme heap image 1\n"
+
+enum { IMG_NULL, IMG_SINK, IMG_NIL, IMG_T, IMG_F, IMG_EOF, IMG_CELLS=16 };
+enum { IMG_PORT_FREE, IMG_PORT_STDIN, IMG_PORT_STDOUT, IMG_PORT_STDERR,
+       IMG_PORT_LOAD=16 };
+
+static int image_write(FILE *f, const void *p, size_t n) {
+     return fwrite(p, 1, n, f) == n;
+}
+
+static int image_read(FILE *f, void *p, size_t n) {
+     return fread(p, 1, n, f) == n;
+}
+
+static int image_encode(scheme *sc, cell_ptr p, long *code) {
+     int lo = 0, hi = sc->last_cell_seg;
+     if (p == 0) { *code = IMG_NULL; return 1; }
+     if (p == sc->sink) { *code = IMG_SINK; return 1; }
+     if (p == sc->NIL) { *code = IMG_NIL; return 1; }
+     if (p == sc->T) { *code = IMG_T; return 1; }
+     if (p == sc->F) { *code = IMG_F; return 1; }
+     if (p == sc->EOF_OBJ) { *code = IMG_EOF; return 1; }
+     /* the segments are sorted by address */
+     while (lo <= hi) {
+          int mid = (lo + hi) / 2;
+          if (p < sc->cell_seg[mid]) hi = mid - 1;
+          else if (p >= sc->cell_seg[mid] + CELL_SEGSIZE) lo = mid + 1;
+          else {
+               *code = IMG_CELLS + (long) mid * CELL_SEGSIZE +
+                       (long) (p - sc->cell_seg[mid]);
+               return 1;
+          }
+     }
+     return 0;
+}
+
+static int image_decode(scheme *sc, cell_ptr *segs, int nsegs,
+                        long code, cell_ptr *p) {
+     switch (code) {
+     case IMG_NULL: *p = 0; return 1;
+     case IMG_SINK: *p = sc->sink; return 1;
+     case IMG_NIL: *p = sc->NIL; return 1;
+     case IMG_T: *p = sc->T; return 1;
+     case IMG_F: *p = sc->F; return 1;
+     case IMG_EOF: *p = sc->EOF_OBJ; return 1;
+     }
+     code -= IMG_CELLS;
+     if (code < 0 || code >= (long) nsegs * CELL_SEGSIZE) return 0;
+     *p = segs[code / CELL_SEGSIZE] + code % CELL_SEGSIZE;
+     return 1;
+}
+
+static int image_write_pointer(scheme *sc, FILE *f, cell_ptr p) {
+     long code;
+     return image_encode(sc, p, &code) && image_write(f, &code, sizeof(long));
+}
+
+static int image_read_pointer(scheme *sc, FILE *f, cell_ptr *segs, int nsegs,
+                              cell_ptr *p) {
+     long code;
+     return image_read(f, &code, sizeof(long)) &&
+            image_decode(sc, segs, nsegs, code, p);
+}
+
+/* the registers which survive between two evaluations */
+static cell_ptr *image_register(scheme *sc, int i) {
+     switch (i) {
+     case 0: return &sc->oblist;
+     case 1: return &sc->global_env;
+     case 2: return &sc->value;
+     case 3: return &sc->inport;
+     case 4: return &sc->outport;
+     case 5: return &sc->save_inport;
+     case 6: return &sc->loadport;
+     case 7: return &sc->LAMBDA;
+     case 8: return &sc->QUOTE;
+     case 9: return &sc->QQUOTE;
+     case 10: return &sc->UNQUOTE;
+     case 11: return &sc->UNQUOTESP;
+     case 12: return &sc->FEED_TO;
+     case 13: return &sc->COLON_HOOK;
+     case 14: return &sc->ERROR_HOOK;
+     case 15: return &sc->SHARP_HOOK;
+     case 16: return &sc->COMPILE_HOOK;
+     default: return 0;
+     }
+}
+
+static int image_write_port(scheme *sc, FILE *f, port *pt) {
+     long code;
+     if (pt >= sc->load_stack && pt < sc->load_stack + MAXFIL)
+          code = IMG_PORT_LOAD + (long) (pt - sc->load_stack);
+     else if (pt->kind == port_free) code = IMG_PORT_FREE;
+     else if (!(pt->kind & port_file)) return 0;
+     else if (pt->rep.stdio.file == stdin) code = IMG_PORT_STDIN;
+     else if (pt->rep.stdio.file == stdout) code = IMG_PORT_STDOUT;
+     else if (pt->rep.stdio.file == stderr) code = IMG_PORT_STDERR;
+     else return 0;
+     return image_write(f, &code, sizeof(long)) &&
+            image_write(f, &pt->kind, sizeof(pt->kind));
+}
+
+static port *image_read_port(scheme *sc, FILE *f) {
+     long code;
+     unsigned char kind;
+     port *pt;
+     if (!image_read(f, &code, sizeof(long)) ||
+         !image_read(f, &kind, sizeof(kind)))
+          return 0;
+     if (code >= IMG_PORT_LOAD && code < IMG_PORT_LOAD + MAXFIL)
+          return sc->load_stack + (code - IMG_PORT_LOAD);
+     if (code > IMG_PORT_STDERR) return 0;
+     pt = (port*) sc->malloc(sizeof(port));
+     if (pt == 0) return 0;
+     memset(pt, 0, sizeof(port));
+     pt->kind = kind;
+     if (code == IMG_PORT_FREE) pt->kind = port_free;
+     else pt->rep.stdio.file =
+            code == IMG_PORT_STDIN? stdin:
+            code == IMG_PORT_STDOUT? stdout: stderr;
+     return pt;
+}
+
+static int image_write_cell(scheme *sc, FILE *f, cell_ptr p) {
+     unsigned int flag = typeflag(p) & UNMARK;
+     if (!image_write(f, &flag, sizeof(flag))) return 0;
+     if (flag == 0) return 1;
+     switch (type(p)) {
+     case 0:
+          /* ports which are no longer in use */
+          return 1;
+     case T_STRING:
+     {    long len = strlength(p);
+          return image_write(f, &len, sizeof(long)) &&
+                 image_write(f, strvalue(p), len);
+     }
+     case T_NUMBER:
+     case T_CHARACTER:
+     case T_PROC:
+     case T_VECTOR:
+          return image_write(f, &p->_object._number, sizeof(num));
+     case T_FOREIGN:
+     {    long offset = (long) ((intptr_t) p->_object._ff -
+                                (intptr_t) scheme_init);
+          return image_write(f, &offset, sizeof(long));
+     }
+     case T_PORT:
+          return image_write_port(sc, f, p->_object._port);
+     case T_SYMBOL:
+     case T_PAIR:
+     case T_CLOSURE:
+     case T_CONTINUATION:
+     case T_MACRO:
+     case T_PROMISE:
+     case T_ENVIRONMENT:
+          return image_write_pointer(sc, f, car(p)) &&
+                 image_write_pointer(sc, f, cdr(p));
+     default:
+          /* blackboxes and unknown types */
+          return 0;
+     }
+}
+
+static int image_read_payload(scheme *sc, FILE *f, cell_ptr *segs, int nsegs,
+                              unsigned int flag, cell_ptr p) {
+     switch (flag & T_MASKTYPE) {
+     case 0:
+          return 1;
+     case T_STRING:
+     {    long len;
+          char *s;
+          if (!image_read(f, &len, sizeof(long)) || len < 0) return 0;
+          s = (char*) sc->malloc(len + 1);
+          if (s == 0) return 0;
+          s[len] = 0;
+          if (!image_read(f, s, len)) {
+               sc->free(s);
+               return 0;
+          }
+          strvalue(p) = s;
+          strlength(p) = (int) len;
+          return 1;
+     }
+     case T_NUMBER:
+     case T_CHARACTER:
+     case T_PROC:
+     case T_VECTOR:
+          return image_read(f, &p->_object._number, sizeof(num));
+     case T_FOREIGN:
+     {    long offset;
+          if (!image_read(f, &offset, sizeof(long))) return 0;
+          p->_object._ff = (foreign_func) ((intptr_t) scheme_init + offset);
+          return 1;
+     }
+     case T_PORT:
+          p->_object._port = image_read_port(sc, f);
+          return p->_object._port != 0;
+     default:
+          return image_read_pointer(sc, f, segs, nsegs, &car(p)) &&
+                 image_read_pointer(sc, f, segs, nsegs, &cdr(p));
+     }
+}
+
+static int image_read_cell(scheme *sc, FILE *f, cell_ptr *segs, int nsegs,
+                           cell_ptr p) {
+     /* the type is only set once the cell is complete, so that
+        incomplete images can be freed with finalize_cell */
+     unsigned int flag;
+     car(p) = sc->NIL;
+     cdr(p) = sc->NIL;
+     if (!image_read(f, &flag, sizeof(flag)) ||
+         !image_read_payload(sc, f, segs, nsegs, flag, p))
+          return 0;
+     typeflag(p) = flag;
+     return 1;
+}
+
+int scheme_save_image(scheme *sc, FILE *f) {
+     int i, nsegs;
+     long header[3];
+     cell_ptr p;
+     /* only the cells which are reachable from the registers remain */
+     sc->envir = sc->global_env;
+     sc->code = sc->NIL;
+     sc->args = sc->NIL;
+     dump_stack_reset(sc);
+     car(sc->sink) = sc->NIL;
+     sc->c_nest = sc->NIL;
+     gc(sc, sc->NIL, sc->NIL);
+     nsegs = sc->last_cell_seg + 1;
+     header[0] = sizeof(struct cell);
+     header[1] = CELL_SEGSIZE;
+     header[2] = nsegs;
+     if (!image_write(f, IMAGE_MAGIC, strlen(IMAGE_MAGIC)) ||
+         !image_write(f, header, sizeof(header)) ||
+         !image_write(f, &sc->gensym_cnt, sizeof(long)))
+          return 0;
+     for (i = 0; image_register(sc, i) != 0; i++)
+          if (!image_write_pointer(sc, f, *image_register(sc, i)))
+               return 0;
+     for (i = 0; i < nsegs; i++)
+          for (p = sc->cell_seg[i]; p < sc->cell_seg[i] + CELL_SEGSIZE; p++)
+               if (!image_write_cell(sc, f, p))
+                    return 0;
+     return 1;
+}
+
+static void image_free_segments(scheme *sc, char **blocks, cell_ptr *segs,
+                                int n) {
+     int i;
+     cell_ptr p;
+     for (i = 0; i < n; i++) {
+          for (p = segs[i]; p < segs[i] + CELL_SEGSIZE; p++)
+               if (is_port(p) && p->_object._port >= sc->load_stack &&
+                   p->_object._port < sc->load_stack + MAXFIL);
+               else if (typeflag(p) != 0) finalize_cell(sc, p);
+          sc->free(blocks[i]);
+     }
+     sc->free(blocks);
+     sc->free(segs);
+}
+
+int scheme_load_image(scheme *sc, FILE *f) {
+     /* sc should have been initialized by scheme_init */
+     char magic[sizeof(IMAGE_MAGIC)];
+     long header[3], gensym_cnt;
+     int i, j, nsegs, adj = ADJ;
+     char **blocks;
+     cell_ptr *segs, regs[17], p;
+     if (adj < (int) sizeof(struct cell)) adj = sizeof(struct cell);
+     if (!image_read(f, magic, strlen(IMAGE_MAGIC)) ||
+         memcmp(magic, IMAGE_MAGIC, strlen(IMAGE_MAGIC)) != 0 ||
+         !image_read(f, header, sizeof(header)) ||
+         header[0] != (long) sizeof(struct cell) ||
+         header[1] != CELL_SEGSIZE || header[2] <= 0 ||
+         !image_read(f, &gensym_cnt, sizeof(long)))
+          return 0;
+     nsegs = (int) header[2];
+     blocks = (char**) sc->malloc(nsegs * sizeof(char*));
+     segs = (cell_ptr*) sc->malloc(nsegs * sizeof(cell_ptr));
+     if (blocks == 0 || segs == 0) {
+          if (blocks != 0) sc->free(blocks);
+          if (segs != 0) sc->free(segs);
+          return 0;
+     }
+     for (i = 0; i < nsegs; i++) {
+          char *cp = (char*) sc->malloc(CELL_SEGSIZE * sizeof(struct cell)+adj);
+          if (cp == 0) {
+               image_free_segments(sc, blocks, segs, i);
+               return 0;
+          }
+          blocks[i] = cp;
+          if (((unsigned long) cp) % adj != 0)
+               cp = (char*) (adj * ((unsigned long) cp / adj + 1));
+          segs[i] = (cell_ptr) cp;
+          for (p = segs[i]; p < segs[i] + CELL_SEGSIZE; p++)
+               typeflag(p) = 0;
+     }
+     for (i = 0; image_register(sc, i) != 0; i++)
+          if (!image_read_pointer(sc, f, segs, nsegs, &regs[i])) {
+               image_free_segments(sc, blocks, segs, nsegs);
+               return 0;
+          }
+     for (i = 0; i < nsegs; i++)
+          for (p = segs[i]; p < segs[i] + CELL_SEGSIZE; p++)
+               if (!image_read_cell(sc, f, segs, nsegs, p)) {
+                    image_free_segments(sc, blocks, segs, nsegs);
+                    return 0;
+               }
+
+     /* replace the current heap */
+     image_free_segments(sc, sc->alloc_seg, sc->cell_seg,
+                         sc->last_cell_seg + 1);
+     sc->nr_cell_seg = 0;
+     sc->last_cell_seg = -1;
+     while (sc->nr_cell_seg < nsegs)
+          if (!grow_cellseg_tables(sc)) {
+               /* cannot happen for sensible images */
+               sc->no_memory = 1;
+               return 0;
+          }
+     for (i = 0; i < nsegs; i++) {
+          /* keep the segments sorted by address */
+          for (j = i; j > 0 && sc->cell_seg[j - 1] > segs[i]; j--) {
+               sc->cell_seg[j] = sc->cell_seg[j - 1];
+               sc->alloc_seg[j] = sc->alloc_seg[j - 1];
+          }
+          sc->cell_seg[j] = segs[i];
+          sc->alloc_seg[j] = blocks[i];
+          sc->last_cell_seg++;
+     }
+     sc->free(blocks);
+     sc->free(segs);
+     for (i = 0; image_register(sc, i) != 0; i++)
+          *image_register(sc, i) = regs[i];
+     sc->gensym_cnt = gensym_cnt;
+     sc->envir = sc->global_env;
+     sc->code = sc->NIL;
+     sc->args = sc->NIL;
+     sc->c_nest = sc->NIL;
+     car(sc->sink) = sc->NIL;
+     dump_stack_reset(sc);
+     /* rebuild the free list */
+     sc->free_cell = sc->NIL;
+     sc->fcells = 0;
+     gc(sc, sc->NIL, sc->NIL);
+     return 1;
+}
+
 void scheme_load_file(scheme *sc, FILE *fin)
 { scheme_load_named_file(sc,fin,0); }
 void scheme_load_named_file(scheme *sc, FILE *fin, const char *filename) {
@@ -132,6 +132,8 @@ SCHEME_EXPORT scheme *scheme_init_new_custom_alloc(func_alloc malloc, func_deall
 SCHEME_EXPORT int scheme_init(scheme *sc);
 SCHEME_EXPORT int scheme_init_custom_alloc(scheme *sc, func_alloc, func_dealloc);
 SCHEME_EXPORT void scheme_deinit(scheme *sc);
+SCHEME_EXPORT int scheme_save_image(scheme *sc, FILE *f);
+SCHEME_EXPORT int scheme_load_image(scheme *sc, FILE *f);
 void scheme_set_input_port_file(scheme *sc, FILE *fin);
 void scheme_set_input_port_string(scheme *sc, char *start, char *past_the_end);
 SCHEME_EXPORT void scheme_set_output_port_file(scheme *sc, FILE *fin);
@@ -12,6 +12,8 @@
 #include "tinyscheme_tm.hpp"
 #include "object.hpp"
 #include "glue.hpp"
+#include "file.hpp"
+#include "tm_timer.hpp"
 
 
 
@@ -75,6 +77,58 @@ start_scheme (int argc, char** argv, void (*call_back) (int, char**)) {
 	
 }
 
+/******************************************************************************
+ * Heap images of the initialized interpreter
+ ******************************************************************************/
+
+static url
+scheme_image () {
+	// foreign functions are saved relative to the code of the interpreter,
+	// so images are only valid for the binary which wrote them
+#ifdef OS_GNU_LINUX
+	int stamp= last_modified (url_system ("/proc/self/exe"), false);
+	if (stamp <= 0) return url_none ();
+	string key= string (TEXMACS_VERSION) * ":" * as_string (stamp);
+	url progs ("$TEXMACS_PATH/progs");
+	key << ":" * as_string (last_modified (progs * "init-tinyscheme.scm"));
+	key << ":" * as_string (last_modified (progs * "init-scheme-tm.scm"));
+	return url ("$TEXMACS_HOME_PATH/system/cache") *
+	       ("__tinyscheme-" * cache_key (key) * ".img");
+#else
+	return url_none ();
+#endif
+}
+
+static bool
+load_scheme_image () {
+	url u= scheme_image ();
+	if (is_none (u) || !exists (u)) return false;
+	c_string name (concretize (u));
+	FILE* f= fopen (name, "rb");
+	if (f == NULL) return false;
+	bool ok= scheme_load_image (the_scheme, f);
+	fclose (f);
+	return ok;
+}
+
+static void
+save_scheme_image () {
+	// heaps which hold C++ objects cannot be saved; we then simply
+	// initialize the interpreter from scratch during the next session
+	url u= scheme_image ();
+	if (is_none (u)) return;
+	c_string name (concretize (u));
+	FILE* f= fopen (name, "wb");
+	if (f == NULL) return;
+	bool ok= scheme_save_image (the_scheme, f);
+	fclose (f);
+	if (!ok) remove (u);
+}
+
+/******************************************************************************
+ * Initialization of the interpreter
+ ******************************************************************************/
+
 void
 initialize_scheme () {
 	if(!scheme_init(the_scheme)) {
@@ -101,14 +155,18 @@ initialize_scheme () {
 	"(define (texmacs-version) \"" TEXMACS_VERSION "\")\n"
 	"(define object-stack '(()))";
 	
-	scm_eval_string (init_prg);
-	initialize_glue ();
+	bench_start ("load scheme image");
+	bool restored= load_scheme_image ();
+	bench_cumul ("load scheme image");
+	if (!restored) {
+		scm_eval_string (init_prg);
+		initialize_glue ();
+		scm_eval_string("(load (url-concretize \"$TEXMACS_PATH/progs/init-tinyscheme.scm\"))");
+		scm_eval_string("(load (url-concretize \"$TEXMACS_PATH/progs/init-scheme-tm.scm\"))");
+		save_scheme_image ();
+	}
 	object_stack= scm_lookup_string ("object-stack");
 	
-	
-	scm_eval_string("(load (url-concretize \"$TEXMACS_PATH/progs/init-tinyscheme.scm\"))");
-	scm_eval_string("(load (url-concretize \"$TEXMACS_PATH/progs/init-scheme-tm.scm\"))");
-	
 	//REPL
 	//scm_eval_file (stdin);
 	scheme_load_named_file(the_scheme,stdin,0);
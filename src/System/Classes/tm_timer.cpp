@@ -17,6 +17,7 @@ static hashmap<string,int> timing_level (0);
 static hashmap<string,int> timing_nr    (0);
 static hashmap<string,int> timing_cumul (0);
 static hashmap<string,int> timing_last  (0);
+static hashmap<string,int> memory_peak  (0);
 
 /******************************************************************************
 * Getting the time
@@ -89,6 +90,31 @@ bench_reset (string task) {
   timing_nr   ->reset (task);
   timing_cumul->reset (task);
   timing_last ->reset (task);
+  memory_peak ->reset (task);
+}
+
+void
+bench_reset () {
+  // reset timers for all types of tasks
+  timing_level= hashmap<string,int> (0);
+  timing_nr   = hashmap<string,int> (0);
+  timing_cumul= hashmap<string,int> (0);
+  timing_last = hashmap<string,int> (0);
+  memory_peak = hashmap<string,int> (0);
+}
+
+void
+bench_memory (string task) {
+  // record the memory held by the allocator as a candidate peak
+  // for a given task; this is cheap enough to be done at all times
+  int held= mem_held ();
+  if (held > memory_peak [task]) memory_peak (task)= held;
+}
+
+int
+bench_peak (string task) {
+  // peak memory which has been recorded for a given task
+  return memory_peak [task];
 }
 
 void
@@ -99,6 +125,8 @@ bench_print (string task) {
     std_bench << "Task '" << task << "' took "
               << timing_cumul [task] << " ms";
     if (nr > 1) std_bench << " (" << nr << " invocations)";
+    if (memory_peak->contains (task))
+      std_bench << ", peak memory " << (memory_peak [task] >> 10) << " kB";
     std_bench << "\n";
   }
 }
@@ -45,6 +45,9 @@ void   bench_start (string task);
 void   bench_cumul (string task);
 void   bench_end   (string task);
 void   bench_reset (string task);
+void   bench_reset ();
+void   bench_memory (string task);
+int    bench_peak (string task);
 void   bench_print (string task);
 void   bench_print ();
 
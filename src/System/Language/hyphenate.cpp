@@ -13,6 +13,9 @@
 #include "hyphenate.hpp"
 #include "analyze.hpp"
 #include "converter.hpp"
+#include "iterator.hpp"
+#include "merge_sort.hpp"
+#include "sys_utils.hpp"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -20,6 +23,7 @@
 
 #define MAX_SEARCH 10
 #define MAX_BUFFER_SIZE 256
+#define MAX_CACHED_WORDS 4096
 
 /*
 static bool
@@ -54,19 +58,202 @@ hyphen_normalize (string s) {
   return r;
 }
 
+/******************************************************************************
+* Compilation of the patterns into a trie
+******************************************************************************/
+
+hyphen_trie_rep::hyphen_trie_rep ():
+  first (), label (""), value (), weights (""), words (array<int> ()) {
+    first << 0 << 0;
+    value << -1; }
+
+hyphen_trie::hyphen_trie (): rep (tm_new<hyphen_trie_rep> ()) {}
+
+hyphen_trie::hyphen_trie (hashmap<string,string> patterns):
+  rep (tm_new<hyphen_trie_rep> ())
+{
+  // Compute the nodes of each depth in lexicographical order
+  array<array<string> > levels;
+  hashmap<string,bool> done (false);
+  iterator<string> it= iterate (patterns);
+  while (it->busy ()) {
+    string key= it->next ();
+    for (int i=1; i<=N(key); i++)
+      if (!done->contains (key (0, i))) {
+        done (key (0, i))= true;
+        while (N(levels) < i) levels << array<string> ();
+        levels[i-1] << key (0, i);
+      }
+  }
+  for (int d=0; d<N(levels); d++)
+    merge_sort (levels[d]);
+
+  // Number the nodes in breadth first order and pack the edges
+  rep->first= array<int> ();
+  rep->value= array<int> ();
+  array<string> prev;
+  prev << string ("");
+  int nr= 1;
+  for (int d=0; d<=N(levels); d++) {
+    array<string> cur= (d < N(levels)? levels[d]: array<string> ());
+    int j= 0;
+    for (int i=0; i<N(prev); i++) {
+      rep->first << nr - 1 + j;
+      while (j < N(cur) && cur[j] (0, d) == prev[i]) {
+        rep->label << cur[j][d];
+        j++;
+      }
+      string r= patterns[prev[i]];
+      if (d == 0 || r == "?") rep->value << -1;
+      else {
+        // same weights as those computed by the former pattern lookup
+        rep->value << N(rep->weights);
+        for (int k=0, l=0; l<=d; l++, k++) {
+          int m= 0;
+          if (k<N(r) && is_digit (r[k])) m= ((int) r[k++]) - ((int) '0');
+          rep->weights << ((char) m);
+        }
+      }
+    }
+    nr += N(cur);
+    prev= cur;
+  }
+  rep->first << N(rep->label);
+}
+
+int
+hyphen_trie_rep::step (int node, char c) {
+  int lo= first[node], hi= first[node+1];
+  while (lo < hi) {
+    int mid= (lo + hi) >> 1;
+    if (label[mid] < c) lo= mid + 1;
+    else hi= mid;
+  }
+  if (lo < first[node+1] && label[lo] == c) return lo + 1;
+  return -1;
+}
+
+/******************************************************************************
+* Loading and caching the hyphenation tables
+******************************************************************************/
+
+#define HYPHEN_CACHE_MAGIC "TMHY1"
+
+static void
+hyphen_write_int (string& s, int i) {
+  for (int k=0; k<4; k++) s << ((char) ((i >> (8*k)) & 255));
+}
+
+static void
+hyphen_write_string (string& s, string x) {
+  hyphen_write_int (s, N(x));
+  s << x;
+}
+
+static bool
+hyphen_read_int (string s, int& pos, int& i) {
+  if (pos < 0 || pos + 4 > N(s)) return false;
+  i= 0;
+  for (int k=0; k<4; k++) i |= ((int) (unsigned char) s[pos++]) << (8*k);
+  return true;
+}
+
+static bool
+hyphen_read_string (string s, int& pos, string& x) {
+  int n;
+  if (!hyphen_read_int (s, pos, n) || n < 0 || n > N(s) - pos) return false;
+  x= s (pos, pos + n);
+  pos += n;
+  return true;
+}
+
+static string
+hyphen_tables_to_string (hyphen_trie patterns,
+                         hashmap<string,string> hyphenations) {
+  string s= HYPHEN_CACHE_MAGIC;
+  int i, n= N(patterns->value);
+  hyphen_write_int (s, n);
+  for (i=0; i<=n; i++) hyphen_write_int (s, patterns->first[i]);
+  for (i=0; i<n; i++) hyphen_write_int (s, patterns->value[i]);
+  hyphen_write_string (s, patterns->label);
+  hyphen_write_string (s, patterns->weights);
+  hyphen_write_int (s, N(hyphenations));
+  iterator<string> it= iterate (hyphenations);
+  while (it->busy ()) {
+    string word= it->next ();
+    hyphen_write_string (s, word);
+    hyphen_write_string (s, hyphenations[word]);
+  }
+  return s;
+}
+
+static bool
+string_to_hyphen_tables (string s, hyphen_trie& patterns,
+                         hashmap<string,string>& hyphenations) {
+  if (!starts (s, HYPHEN_CACHE_MAGIC)) return false;
+  int i, n, pos= N(string (HYPHEN_CACHE_MAGIC));
+  if (!hyphen_read_int (s, pos, n) || n <= 0 || n > N(s)) return false;
+  hyphen_trie t;
+  t->first= array<int> (n+1);
+  t->value= array<int> (n);
+  for (i=0; i<=n; i++)
+    if (!hyphen_read_int (s, pos, t->first[i])) return false;
+  for (i=0; i<n; i++)
+    if (!hyphen_read_int (s, pos, t->value[i])) return false;
+  if (!hyphen_read_string (s, pos, t->label)) return false;
+  if (!hyphen_read_string (s, pos, t->weights)) return false;
+  if (N(t->label) != n-1 || t->first[0] != 0 || t->first[n] != n-1)
+    return false;
+  array<int> depth (n);
+  depth[0]= 0;
+  for (i=0; i<n; i++) {
+    if (t->first[i] < i || t->first[i] > t->first[i+1]) return false;
+    for (int e= t->first[i]; e < t->first[i+1]; e++) depth[e+1]= depth[i] + 1;
+    if (t->value[i] < -1 || t->value[i] + depth[i] >= N(t->weights))
+      return false;
+  }
+  int nr;
+  if (!hyphen_read_int (s, pos, nr)) return false;
+  hashmap<string,string> h ("?");
+  for (i=0; i<nr; i++) {
+    string word, hyph;
+    if (!hyphen_read_string (s, pos, word) || !hyphen_read_string (s, pos, hyph))
+      return false;
+    h (word)= hyph;
+  }
+  if (pos != N(s)) return false;
+  patterns= t;
+  hyphenations= h;
+  return true;
+}
+
 void
 load_hyphen_tables (string file_name,
-                    hashmap<string,string>& patterns,
+                    hyphen_trie& trie,
                     hashmap<string,string>& hyphenations, bool toCork) {
   string s;
   file_name= string ("hyphen.") * file_name;
-  load_string (url ("$TEXMACS_PATH/langs/natural/hyphen", file_name), s, true);
+  url src ("$TEXMACS_PATH/langs/natural/hyphen", file_name);
+  url cache_dir ("$TEXMACS_HOME_PATH/system/cache");
+  url cache= cache_dir * (file_name * (toCork? ".cork": ".utf8") * ".bin");
+  bool use_cache= get_env ("TEXMACS_HOME_PATH") != "" &&
+                  is_directory (cache_dir);
+  if (use_cache && exists (cache) &&
+      last_modified (cache, false) >= last_modified (src, false) &&
+      !load_string (cache, s, false) &&
+      string_to_hyphen_tables (s, trie, hyphenations)) {
+    if (DEBUG_VERBOSE)
+      debug_automatic << "TeXmacs] Loaded compiled " << file_name << "\n";
+    return;
+  }
+
+  load_string (src, s, true);
   if (DEBUG_VERBOSE)
     debug_automatic << "TeXmacs] Loading " << file_name << "\n";
 
   if (toCork) s= utf8_to_cork (s);
 
-  hashmap<string,string> H ("?");
+  hashmap<string,string> patterns ("?");
   bool pattern_flag=false;
   bool hyphenation_flag=false;
   int i=0, n= N(s);
@@ -94,11 +281,15 @@ load_hyphen_tables (string file_name,
     if (buffer == "\\patterns{") pattern_flag=true;
     if (buffer == "\\hyphenation{") hyphenation_flag=true;
   }
+  trie= hyphen_trie (patterns);
+  if (use_cache)
+    (void) save_string (cache, hyphen_tables_to_string (trie, hyphenations),
+                        false);
 }
 
 array<int>
 get_hyphens (string s,
-             hashmap<string,string> patterns,
+             hyphen_trie patterns,
              hashmap<string,string> hyphenations) {
   return get_hyphens (s, patterns, hyphenations, false);
 }
@@ -129,10 +320,10 @@ str_length (string s, bool utf8) {
   else return N(s);
 }
 
-array<int>
-get_hyphens (string s,
-             hashmap<string,string> patterns,
-             hashmap<string,string> hyphenations, bool utf8) {
+static array<int>
+compute_hyphens (string s,
+                 hyphen_trie patterns,
+                 hashmap<string,string> hyphenations, bool utf8) {
   ASSERT (N(s) != 0, "hyphenation of empty string");
 
   if (utf8) s= cork_to_utf8 (s);
@@ -158,24 +349,20 @@ get_hyphens (string s,
   else {
     s= "." * locase_all (s) * ".";
     // cout << s << "\n";
-    int i, j, k, l, m, len;
+    int i, j, l, len;
     array<int> T (str_length (s, utf8)+1);
     for (i=0; i<N(T); i++) T[i]=0;
-    for (len=1; len < MAX_SEARCH; len++)
-      for (i=0, l=0; i<N(s) - len; goto_next_char (s, i, utf8), l++) {
-        string r= patterns [s (i, i+len)];
-        if (!(r == "?")) {
-          // cout << "  " << s (i, i+len) << " => " << r << "\n";
-          for (j=0, k=0; j<=len; j++, k++) {
-            if (k<N(r) && is_digit (r[k])) {
-              m= ((int) r[k])-((int) '0');
-              k++;
-            }
-            else m=0;
-            if (m>T[l+j]) T[l+j]=m;
-          }
-        }
+    for (i=0, l=0; i<N(s)-1; goto_next_char (s, i, utf8), l++) {
+      int node= 0;
+      for (len=1; len < MAX_SEARCH && i+len < N(s); len++) {
+        node= patterns->step (node, s[i+len-1]);
+        if (node < 0) break;
+        int v= patterns->value[node];
+        if (v >= 0)
+          for (j=0; j<=len && l+j<N(T); j++)
+            if (patterns->weights[v+j] > T[l+j]) T[l+j]= patterns->weights[v+j];
       }
+    }
 
     array<int> penalty (N(T)-4);
     for (i=2; i < N(T)-4; i++)
@@ -188,6 +375,18 @@ get_hyphens (string s,
   }
 }
 
+array<int>
+get_hyphens (string s,
+             hyphen_trie patterns,
+             hashmap<string,string> hyphenations, bool utf8) {
+  if (patterns->words->contains (s)) return patterns->words[s];
+  array<int> penalty= compute_hyphens (s, patterns, hyphenations, utf8);
+  if (N(patterns->words) >= MAX_CACHED_WORDS)
+    patterns->words= hashmap<string,array<int> > (array<int> ());
+  patterns->words (s)= penalty;
+  return penalty;
+}
+
 void
 std_hyphenate (string s, int after, string& left, string& right, int penalty) {
   std_hyphenate (s, after, left, right, penalty, false);
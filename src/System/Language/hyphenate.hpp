@@ -13,14 +13,48 @@
 #define HYPHENATE_H
 #include "language.hpp"
 
+/******************************************************************************
+* Hyphenation patterns compiled into a packed trie
+*******************************************************************************
+* The nodes are numbered in breadth first order, so that the children of
+* each node are consecutive and every node except the root is the target
+* of exactly one edge: the edges leaving node n are first[n] .. first[n+1]-1,
+* edge e leads to node e+1 and is labeled by the byte label[e].
+* If some pattern ends at node n, then its inter-letter weights can be
+* found in weights, starting at offset value[n]; otherwise value[n] = -1.
+* The trie also caches the penalties for recently hyphenated words.
+******************************************************************************/
+
+class hyphen_trie;
+class hyphen_trie_rep: concrete_struct {
+public:
+  array<int> first;                   // first edge leaving each node
+  string     label;                   // byte read along each edge
+  array<int> value;                   // weights of the pattern ending here
+  string     weights;                 // weights of all patterns
+  hashmap<string,array<int> > words;  // already hyphenated words
+
+  hyphen_trie_rep ();
+  int step (int node, char c);
+
+  friend class hyphen_trie;
+};
+
+class hyphen_trie {
+  CONCRETE(hyphen_trie);
+  hyphen_trie ();
+  hyphen_trie (hashmap<string,string> patterns);
+};
+CONCRETE_CODE(hyphen_trie);
+
 void load_hyphen_tables (string language_name,
-                         hashmap<string,string>& patterns,
+                         hyphen_trie& patterns,
                          hashmap<string,string>& hyphenations, bool toCork);
 array<int> get_hyphens (string s,
-                        hashmap<string,string> patterns,
+                        hyphen_trie patterns,
                         hashmap<string,string> hyphenations);
 array<int> get_hyphens (string s,
-                        hashmap<string,string> patterns,
+                        hyphen_trie patterns,
                         hashmap<string,string> hyphenations, bool utf8);
 void std_hyphenate (string s, int after, string& left, string& right, int pen);
 void std_hyphenate (string s, int after, string& left, string& right, int pen,
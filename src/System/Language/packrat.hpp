@@ -18,6 +18,7 @@ void   packrat_define (string lan, string s, tree t);
 void   packrat_property (string lan, string s, string var, string val);
 void   packrat_inherit (string lan, string from);
 int    packrat_abbreviation (string lan, string s);
+void   flush_packrat_parsers ();
 
 path   packrat_parse (string lan, string s, tree in);
 bool   packrat_correct (string lan, string s, tree in);
@@ -10,6 +10,7 @@
 ******************************************************************************/
 
 #include "packrat_grammar.hpp"
+#include "packrat.hpp"
 #include "analyze.hpp"
 #include "iterator.hpp"
 
@@ -171,6 +172,7 @@ singleton (C c) {
 
 packrat_grammar_rep::packrat_grammar_rep (string s):
   rep<packrat_grammar> (s),
+  lan_name (s),
   grammar (singleton (PACKRAT_TM_FAIL)),
   productions (packrat_uninit)
 {
@@ -379,12 +381,14 @@ void
 packrat_define (string lan, string s, tree t) {
   packrat_grammar gr= find_packrat_grammar (lan);
   gr->define (s, t);
+  flush_packrat_parsers ();
 }
 
 void
 packrat_property (string lan, string s, string var, string val) {
   packrat_grammar gr= find_packrat_grammar (lan);
   gr->set_property (s, var, val);
+  flush_packrat_parsers ();
 }
 
 void
@@ -405,6 +409,7 @@ packrat_inherit (string lan, string from) {
     //cout << "Inherit " << p << " -> " << inh->properties (p) << LF;
     gr->properties (p)= inh->properties (p);
   }
+  flush_packrat_parsers ();
 }
 
 int
@@ -35,36 +35,80 @@ packrat_parser_rep::packrat_parser_rep (packrat_grammar gr):
   current_cursor (-1),
   current_input (),
   current_cache (PACKRAT_UNDEFINED),
+  current_reach (PACKRAT_UNDEFINED),
+  current_examined (0),
+  old_cache (PACKRAT_UNDEFINED),
+  old_reach (PACKRAT_UNDEFINED),
+  old_prefix (0),
+  old_suffix (0),
+  old_delta (0),
   current_production (packrat_uninit) {}
 
-packrat_parser
-make_packrat_parser (string lan, tree in) {
-  static string         last_lan   = "";
-  static tree           last_in    = "";
-  static packrat_parser last_par;
-  if (lan != last_lan || in != last_in) {
-    packrat_grammar gr= find_packrat_grammar (lan);
-    last_lan   = lan;
-    last_in    = copy (in);
-    last_par   = packrat_parser (gr, last_in);
-  }
-  return last_par;
+/******************************************************************************
+* Cache of recently used parsers
+*******************************************************************************
+* The most recently used parsers are kept in a small cache, most recent first.
+* When the input changed, the parser for the new input may reuse all
+* memoized results of the most recent parser for the same language which
+* do not depend on the modified part of the input (see reuse below).
+******************************************************************************/
+
+#define PACKRAT_PARSERS 8
+
+static array<packrat_parser> recent_parsers;
+static array<tree>           recent_inputs;
+static array<path>           recent_cursors;
+
+void
+flush_packrat_parsers () {
+  recent_parsers= array<packrat_parser> ();
+  recent_inputs = array<tree> ();
+  recent_cursors= array<path> ();
 }
 
 packrat_parser
 make_packrat_parser (string lan, tree in, path in_pos) {
-  static string         last_lan   = "";
-  static tree           last_in    = "";
-  static path           last_in_pos= path ();
-  static packrat_parser last_par;
-  if (lan != last_lan || in != last_in || in_pos != last_in_pos) {
+  int i, n= N(recent_parsers);
+  for (i=0; i<n; i++)
+    if (recent_parsers[i]->lan_name == lan &&
+        recent_cursors[i] == in_pos && recent_inputs[i] == in) break;
+  packrat_parser par;
+  tree           t;
+  if (i < n) {
+    par= recent_parsers[i];
+    t  = recent_inputs[i];
+  }
+  else {
     packrat_grammar gr= find_packrat_grammar (lan);
-    last_lan   = lan;
-    last_in    = copy (in);
-    last_in_pos= copy (in_pos);
-    last_par   = packrat_parser (gr, last_in, last_in_pos);
+    t  = copy (in);
+    par= packrat_parser (gr, t, copy (in_pos));
+    for (i=0; i<n; i++)
+      if (recent_parsers[i]->lan_name == lan) {
+        par->reuse (recent_parsers[i]);
+        break;
+      }
+    if (n < PACKRAT_PARSERS) {
+      recent_parsers << par;
+      recent_inputs  << t;
+      recent_cursors << path ();
+      n++;
+    }
+    i= n-1;
   }
-  return last_par;
+  for (; i>0; i--) {
+    recent_parsers[i]= recent_parsers[i-1];
+    recent_inputs [i]= recent_inputs [i-1];
+    recent_cursors[i]= recent_cursors[i-1];
+  }
+  recent_parsers[0]= par;
+  recent_inputs [0]= t;
+  recent_cursors[0]= copy (in_pos);
+  return par;
+}
+
+packrat_parser
+make_packrat_parser (string lan, tree in) {
+  return make_packrat_parser (lan, in, path ());
 }
 
 /******************************************************************************
@@ -182,10 +226,17 @@ C
 packrat_parser_rep::parse (C sym, C pos) {
   D key= (((D) sym) << 32) + ((D) (sym^pos));
   C im = current_cache [key];
+  if (im == PACKRAT_UNDEFINED && N(old_cache) != 0) im= reused (sym, pos);
   if (im != PACKRAT_UNDEFINED) {
     //cout << "Cached " << sym << " at " << pos << " -> " << im << LF;
+    C reach= current_reach [key];
+    // results obtained while (sym, pos) is still being parsed are not reused
+    if (reach == PACKRAT_UNDEFINED) reach= N (current_input) + 2;
+    current_examined= max (current_examined, reach);
     return im;
   }
+  C outer= current_examined;
+  current_examined= pos;
   current_cache (key)= PACKRAT_FAILED;
   if (DEBUG_PACKRAT)
     debug_packrat << "Parse " << packrat_decode[sym]
@@ -301,13 +352,74 @@ packrat_parser_rep::parse (C sym, C pos) {
     if (pos < N (current_input) && current_input[pos] == sym) im= pos + 1;
     else im= PACKRAT_FAILED;
   }
+  // besides the input examined by subparsers, we always looked at
+  // the token at which the parse of sym failed or ended
+  C reach= max (current_examined, (im == PACKRAT_FAILED? pos: im) + 1);
   current_cache (key)= im;
+  current_reach (key)= reach;
+  current_examined= max (outer, reach);
   if (DEBUG_PACKRAT)
     debug_packrat << UNINDENT << "Parsed " << packrat_decode[sym]
                   << " at " << pos << " -> " << im << LF;
   return im;
 }
 
+/******************************************************************************
+* Reusing the memoized results of a parser for a previous input
+*******************************************************************************
+* For each memoized result, current_reach contains the position right after
+* the last token which was examined in order to obtain it.  Consider the
+* longest common prefix and suffix of the old and the new input.  Results
+* which only examined the common prefix remain valid as is, whereas results
+* which start inside the common suffix remain valid after shifting.
+* The memo tables of the old parser are only consulted on cache misses,
+* so that the cost of an edit is proportional to the number of results
+* which are actually needed for the new parse.
+******************************************************************************/
+
+void
+packrat_parser_rep::reuse (packrat_parser old) {
+  array<C>& a= old->current_input;
+  array<C>& b= current_input;
+  C n= N(a), m= N(b), pre= 0, suf= 0;
+  while (pre < n && pre < m && a[pre] == b[pre]) pre++;
+  while (suf < n - pre && suf < m - pre && a[n-1-suf] == b[m-1-suf]) suf++;
+  C delta= m - n, oc= old->current_cursor, nc= current_cursor;
+  // the results may also depend on the cursor position
+  if (oc != nc && ((oc >= 0 && oc < pre) || (nc >= 0 && nc < pre))) pre= 0;
+  if ((oc < 0 || nc != oc + delta) &&
+      (oc >= n - suf || nc >= m - suf)) suf= 0;
+  if (pre == 0 && suf == 0) return;
+  old_cache = old->current_cache;
+  old_reach = old->current_reach;
+  old_prefix= pre;
+  old_suffix= m - suf;
+  old_delta = delta;
+}
+
+C
+packrat_parser_rep::reused (C sym, C pos) {
+  C opos;
+  if (pos < old_prefix) opos= pos;
+  else if (pos >= old_suffix) opos= pos - old_delta;
+  else return PACKRAT_UNDEFINED;
+  D okey = (((D) sym) << 32) + ((D) (sym^opos));
+  C reach= old_reach [okey];
+  if (reach == PACKRAT_UNDEFINED) return PACKRAT_UNDEFINED;
+  if (pos < old_prefix && reach > old_prefix) return PACKRAT_UNDEFINED;
+  if (pos >= old_suffix && reach > N(current_input) - old_delta + 1)
+    return PACKRAT_UNDEFINED;
+  C im = old_cache [okey];
+  if (pos >= old_suffix) {
+    if (im != PACKRAT_FAILED) im += old_delta;
+    reach += old_delta;
+  }
+  D key= (((D) sym) << 32) + ((D) (sym^pos));
+  current_cache (key)= im;
+  current_reach (key)= reach;
+  return im;
+}
+
 /******************************************************************************
 * Inspecting the parse tree
 ******************************************************************************/
@@ -16,6 +16,7 @@
 #define PACKRAT_UNDEFINED ((C) (-2))
 #define PACKRAT_FAILED    ((C) (-1))
 
+class packrat_parser;
 class packrat_parser_rep: concrete_struct {
 public:
   string                    lan_name;
@@ -35,6 +36,13 @@ public:
 
   array<C>                  current_input;
   hashmap<D,C>              current_cache;
+  hashmap<D,C>              current_reach;
+  C                         current_examined;
+  hashmap<D,C>              old_cache;
+  hashmap<D,C>              old_reach;
+  C                         old_prefix;
+  C                         old_suffix;
+  C                         old_delta;
   hashmap<D,tree>           current_production;
 
 protected:
@@ -54,6 +62,8 @@ public:
   path decode_tree_position (C pos);
   C    encode_tree_position (path p);
   C    parse (C sym, C pos);
+  void reuse (packrat_parser old);
+  C    reused (C sym, C pos);
 
   void inspect (C sym, C pos, array<C>& syms, array<C>& poss);
   bool is_left_recursive (C sym);
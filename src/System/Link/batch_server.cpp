@@ -0,0 +1,392 @@
+
+/******************************************************************************
+* MODULE     : batch_server.cpp
+* DESCRIPTION: Headless server for batch conversions over a local socket
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "batch_server.hpp"
+#include "analyze.hpp"
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+#ifndef OS_MINGW
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <poll.h>
+#endif
+
+#ifndef OS_MINGW
+
+/******************************************************************************
+* Constructors and destructors
+******************************************************************************/
+
+batch_server_rep::batch_server_rep (string name2, int nr, batch_handler h):
+  name (name2), nr_workers (max (nr, 1)), handler (h),
+  server (-1), alive (false), inbox (""),
+  next_id (1), done (0), failed (0), busy (0) {}
+
+batch_server_rep::~batch_server_rep () {
+  stop ();
+}
+
+/******************************************************************************
+* Low level input and output
+******************************************************************************/
+
+static bool
+write_all (int fd, string s) {
+  int i= 0, n= N(s);
+  while (i < n) {
+    int r= ::send (fd, &s[i], n - i, MSG_NOSIGNAL);
+    if (r < 0 && errno == ENOTSOCK) r= ::write (fd, &s[i], n - i);
+    if (r < 0 && errno == EINTR) continue;
+    if (r <= 0) return false;
+    i += r;
+  }
+  return true;
+}
+
+static bool
+next_line (string& buf, string& line) {
+  int pos= search_forwards ("\n", buf);
+  if (pos < 0) return false;
+  line= buf (0, pos);
+  buf = buf (pos + 1, N(buf));
+  if (N(line) > 0 && line[N(line) - 1] == '\r') line= line (0, N(line) - 1);
+  return true;
+}
+
+static string
+one_line (string s) {
+  return replace (replace (s, "\n", " "), "\t", " ");
+}
+
+/******************************************************************************
+* Worker processes
+******************************************************************************/
+
+static void
+worker_loop (int in, int out, batch_handler handler) {
+  string buf, line;
+  char tmp[4096];
+  while (true) {
+    if (!next_line (buf, line)) {
+      int r= ::read (in, tmp, sizeof (tmp));
+      if (r < 0 && errno == EINTR) continue;
+      if (r <= 0) return;
+      buf << string (tmp, r);
+      continue;
+    }
+    string err= handler (tokenize (line, "\t"));
+    string answer= (err == ""? string ("ok"): "error\t" * one_line (err));
+    if (!write_all (out, answer * "\n")) return;
+  }
+}
+
+void
+batch_server_rep::spawn (int i) {
+  batch_worker& w= workers[i];
+  w.pid= -1; w.in= -1; w.out= -1; w.busy= false; w.buf= "";
+  int to[2], from[2];
+  if (pipe (to) != 0) {
+    io_warning << "Call to 'pipe' failed\n";
+    return;
+  }
+  if (pipe (from) != 0) {
+    io_warning << "Call to 'pipe' failed\n";
+    ::close (to[0]); ::close (to[1]);
+    return;
+  }
+  int pid= fork ();
+  if (pid == 0) {
+    // the worker only keeps its own pipes
+    ::close (to[1]); ::close (from[0]);
+    if (server >= 0) ::close (server);
+    for (int j=0; j<N(clients); j++) ::close (clients[j]);
+    for (int j=0; j<N(workers); j++)
+      if (j != i && workers[j].pid > 0) {
+        ::close (workers[j].in);
+        ::close (workers[j].out);
+      }
+    worker_loop (to[0], from[1], handler);
+    _exit (0);
+  }
+  ::close (to[0]); ::close (from[1]);
+  if (pid < 0) {
+    io_warning << "Call to 'fork' failed\n";
+    ::close (to[1]); ::close (from[0]);
+    return;
+  }
+  w.pid= pid;
+  w.in = to[1];
+  w.out= from[0];
+}
+
+/******************************************************************************
+* Starting and stopping the server
+******************************************************************************/
+
+string
+batch_server_rep::start () {
+  if (alive) return "ok";
+  signal (SIGPIPE, SIG_IGN);
+  struct sockaddr_un addr;
+  if (N(name) == 0 || N(name) >= (int) sizeof (addr.sun_path))
+    return "Error: invalid socket name";
+  if ((server= socket (AF_UNIX, SOCK_STREAM, 0)) == -1)
+    return "Error: call to 'socket' failed";
+  memset (&addr, 0, sizeof (addr));
+  addr.sun_family= AF_UNIX;
+  memcpy (addr.sun_path, &name[0], N(name));
+  ::unlink (addr.sun_path);
+  if (bind (server, (struct sockaddr*) &addr, sizeof (addr)) == -1) {
+    ::close (server);
+    server= -1;
+    return "Error: call to 'bind' failed";
+  }
+  if (::listen (server, 64) == -1) {
+    ::close (server);
+    server= -1;
+    return "Error: call to 'listen' failed";
+  }
+  alive= true;
+  workers= array<batch_worker> (nr_workers);
+  for (int i=0; i<nr_workers; i++) spawn (i);
+  return "ok";
+}
+
+void
+batch_server_rep::stop () {
+  for (int i=0; i<N(clients); i++) ::close (clients[i]);
+  clients= array<int> ();
+  inbox= hashmap<int,string> ("");
+  for (int i=0; i<N(workers); i++)
+    if (workers[i].pid > 0) {
+      ::close (workers[i].in);
+      ::close (workers[i].out);
+      if (workers[i].busy) kill (workers[i].pid, SIGKILL);
+      waitpid (workers[i].pid, NULL, 0);
+      workers[i].pid= -1;
+    }
+  workers= array<batch_worker> ();
+  queue= array<batch_job> ();
+  if (server >= 0) {
+    ::close (server);
+    c_string _name (name);
+    ::unlink (_name);
+    server= -1;
+  }
+  alive= false;
+}
+
+void
+batch_server_rep::run () {
+  while (alive) listen (1000);
+  stop ();
+}
+
+/******************************************************************************
+* Communication with the clients
+******************************************************************************/
+
+void
+batch_server_rep::reply (int fd, string s) {
+  if (fd >= 0) (void) write_all (fd, s * "\n");
+}
+
+void
+batch_server_rep::accept_client () {
+  int client= accept (server, NULL, NULL);
+  if (client == -1) io_warning << "Call to 'accept' failed\n";
+  else clients << client;
+}
+
+void
+batch_server_rep::close_client (int fd) {
+  ::close (fd);
+  array<int> update;
+  for (int i=0; i<N(clients); i++)
+    if (clients[i] != fd) update << clients[i];
+  clients= update;
+  inbox->reset (fd);
+  // the jobs of the client are still executed, but nobody gets the answer
+  for (int i=0; i<N(queue); i++)
+    if (queue[i].client == fd) queue[i].client= -1;
+  for (int i=0; i<N(workers); i++)
+    if (workers[i].busy && workers[i].job.client == fd)
+      workers[i].job.client= -1;
+}
+
+void
+batch_server_rep::read_client (int fd) {
+  char tmp[4096];
+  int r= ::recv (fd, tmp, sizeof (tmp), 0);
+  if (r < 0 && errno == EINTR) return;
+  if (r <= 0) { close_client (fd); return; }
+  string buf= inbox[fd] * string (tmp, r), line;
+  while (alive && next_line (buf, line)) request (fd, line);
+  inbox (fd)= buf;
+}
+
+void
+batch_server_rep::request (int fd, string line) {
+  if (line == "") return;
+  if (line == "status") reply (fd, status ());
+  else if (line == "quit") {
+    reply (fd, "bye");
+    alive= false;
+  }
+  else {
+    batch_job job;
+    job.id     = next_id++;
+    job.client = fd;
+    job.cmd    = line;
+    job.queued = texmacs_time ();
+    job.started= 0;
+    queue << job;
+    reply (fd, "queued\t" * as_string (job.id) * "\t" *
+               as_string (N(queue)));
+  }
+}
+
+int
+batch_server_rep::running () {
+  int r= 0;
+  for (int i=0; i<N(workers); i++)
+    if (workers[i].busy) r++;
+  return r;
+}
+
+string
+batch_server_rep::status () {
+  int live= 0;
+  for (int i=0; i<N(workers); i++)
+    if (workers[i].pid > 0) live++;
+  return "status\t" * as_string (N(queue)) *
+         "\t" * as_string (running ()) *
+         "\t" * as_string (live) *
+         "\t" * as_string (done) *
+         "\t" * as_string (failed) *
+         "\t" * as_string ((int) busy);
+}
+
+/******************************************************************************
+* Communication with the workers
+******************************************************************************/
+
+void
+batch_server_rep::dispatch () {
+  for (int i=0; i<N(workers) && N(queue) > 0; i++) {
+    batch_worker& w= workers[i];
+    if (w.pid <= 0 || w.busy) continue;
+    w.job= queue[0];
+    queue= range (queue, 1, N(queue));
+    w.job.started= texmacs_time ();
+    w.busy= true;
+    if (!write_all (w.in, w.job.cmd * "\n")) read_worker (i);
+  }
+}
+
+void
+batch_server_rep::finish (int i, string answer) {
+  batch_worker& w= workers[i];
+  if (!w.busy) return;
+  w.busy= false;
+  time_t now= texmacs_time ();
+  int run = (int) (now - w.job.started);
+  int wait= (int) (w.job.started - w.job.queued);
+  busy += run;
+  if (answer == "ok") {
+    done++;
+    reply (w.job.client, "done\t" * as_string (w.job.id) *
+                         "\t" * as_string (wait) *
+                         "\t" * as_string (run) *
+                         "\t" * as_string (N(queue)));
+  }
+  else {
+    failed++;
+    string msg= (starts (answer, "error\t")? answer (6, N(answer)): answer);
+    reply (w.job.client, "failed\t" * as_string (w.job.id) *
+                         "\t" * as_string (run) * "\t" * msg);
+  }
+}
+
+void
+batch_server_rep::read_worker (int i) {
+  batch_worker& w= workers[i];
+  char tmp[4096];
+  int r= ::read (w.out, tmp, sizeof (tmp));
+  if (r < 0 && errno == EINTR) return;
+  if (r <= 0) {
+    // the worker died; report its job and replace it by a new one
+    ::close (w.in);
+    ::close (w.out);
+    waitpid (w.pid, NULL, 0);
+    w.pid= -1;
+    finish (i, "error\tworker died");
+    if (alive) spawn (i);
+    return;
+  }
+  w.buf << string (tmp, r);
+  string line;
+  while (next_line (w.buf, line)) finish (i, line);
+}
+
+/******************************************************************************
+* The event loop
+******************************************************************************/
+
+void
+batch_server_rep::listen (int msecs) {
+  if (!alive) return;
+  dispatch ();
+  int nc= N(clients), nw= N(workers);
+  array<int> fds, kinds;
+  fds << server; kinds << -1;
+  for (int i=0; i<nc; i++) { fds << clients[i]; kinds << -2; }
+  for (int i=0; i<nw; i++)
+    if (workers[i].pid > 0) { fds << workers[i].out; kinds << i; }
+  int n= N(fds);
+  struct pollfd* pfds= tm_new_array<struct pollfd> (n);
+  for (int i=0; i<n; i++) {
+    pfds[i].fd     = fds[i];
+    pfds[i].events = POLLIN;
+    pfds[i].revents= 0;
+  }
+  int r= poll (pfds, n, msecs);
+  if (r > 0)
+    for (int i=0; i<n && alive; i++)
+      if (pfds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+        if (kinds[i] == -1) accept_client ();
+        else if (kinds[i] == -2) read_client (fds[i]);
+        else read_worker (kinds[i]);
+      }
+  tm_delete_array (pfds);
+  dispatch ();
+}
+
+#else // OS_MINGW
+
+batch_server_rep::batch_server_rep (string name2, int nr, batch_handler h):
+  name (name2), nr_workers (max (nr, 1)), handler (h),
+  server (-1), alive (false), inbox (""),
+  next_id (1), done (0), failed (0), busy (0) {}
+batch_server_rep::~batch_server_rep () {}
+string batch_server_rep::start () {
+  return "Error: batch servers are not supported on this platform"; }
+void batch_server_rep::stop () {}
+void batch_server_rep::listen (int msecs) { (void) msecs; }
+void batch_server_rep::run () {}
+string batch_server_rep::status () { return "status"; }
+int batch_server_rep::running () { return 0; }
+
+#endif // OS_MINGW
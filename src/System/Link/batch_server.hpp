@@ -0,0 +1,89 @@
+
+/******************************************************************************
+* MODULE     : batch_server.hpp
+* DESCRIPTION: Headless server for batch conversions over a local socket
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#ifndef BATCH_SERVER_H
+#define BATCH_SERVER_H
+#include "string.hpp"
+#include "array.hpp"
+#include "hashmap.hpp"
+#include "tm_timer.hpp"
+
+/******************************************************************************
+* Clients send requests as lines with tab separated fields:
+*   <command> <arguments>   queue a job, answered by
+*                           "queued <id> <depth>" and later by either
+*                           "done <id> <wait ms> <run ms> <depth>" or
+*                           "failed <id> <run ms> <message>"
+*   status                  "status <queued> <running> <workers>
+*                                   <done> <failed> <busy ms>"
+*   quit                    "bye", after which the server stops
+* Jobs are executed by worker processes, which are forked from the server
+* once it has booted, so that they share its initialized state.
+* The handler returns the empty string on success and an error otherwise.
+******************************************************************************/
+
+typedef string (*batch_handler) (array<string> job);
+
+struct batch_job {
+  int    id;               // number of the job
+  int    client;           // descriptor of the client or -1 if gone
+  string cmd;              // the request
+  time_t queued;           // time at which the job was received
+  time_t started;          // time at which the job was handed out
+};
+
+struct batch_worker {
+  int       pid;           // process identifier
+  int       in, out;       // pipes to and from the worker
+  bool      busy;          // whether the worker is executing a job
+  batch_job job;           // the job which is being executed
+  string    buf;           // incomplete answer of the worker
+};
+
+struct batch_server_rep {
+  string  name;            // path of the local socket
+  int     nr_workers;      // number of worker processes
+  batch_handler handler;   // routine which executes jobs
+  int     server;          // listening socket descriptor
+  bool    alive;           // whether the server is running
+
+  array<int>          clients;   // connected clients
+  hashmap<int,string> inbox;     // incomplete requests of clients
+  array<batch_worker> workers;   // the worker processes
+  array<batch_job>    queue;     // jobs waiting for a worker
+  int     next_id;         // number of the next job
+  int     done, failed;    // statistics on finished jobs
+  time_t  busy;            // total time spent by the workers
+
+public:
+  batch_server_rep (string name, int nr_workers, batch_handler handler);
+  ~batch_server_rep ();
+
+  string start ();
+  void   stop ();
+  void   listen (int msecs);
+  void   run ();
+  string status ();
+  int    running ();
+
+protected:
+  void   spawn (int i);
+  void   accept_client ();
+  void   read_client (int fd);
+  void   close_client (int fd);
+  void   request (int fd, string line);
+  void   read_worker (int i);
+  void   finish (int i, string answer);
+  void   dispatch ();
+  void   reply (int fd, string s);
+};
+
+#endif // defined BATCH_SERVER_H
@@ -18,6 +18,7 @@ void   server_stop ();
 string server_read (int fd);
 void   server_write (int fd, string s);
 bool   server_started ();
+void   batch_server_start (string name, int workers);
 
 int    client_start (string host);
 void   client_stop (int fd);
@@ -84,6 +84,7 @@ connection_rep::start (bool again) {
     message= ln->start ();
     tm_in  = texmacs_input ("output");
     tm_err = texmacs_input ("error");
+    if (ln->frames) tm_in->accept_frames ();
     status = WAITING_FOR_OUTPUT;
     if (again && (message == "ok")) {
       beep ();
@@ -108,18 +109,14 @@ void
 connection_rep::read (int channel) {
   if (channel == LINK_OUT) {
     string s= ln->read (LINK_OUT);
-    int i, n= N(s);
-    for (i=0; i<n; i++)
-      if (tm_in->put (s[i])) {
-        status= WAITING_FOR_INPUT;
-        if (DEBUG_IO) debug_io << LF << HRULE;
-      }
+    if (tm_in->put (s)) {
+      status= WAITING_FOR_INPUT;
+      if (DEBUG_IO) debug_io << LF << HRULE;
+    }
   }
   else if (channel == LINK_ERR) {
     string s= ln->read (LINK_ERR);
-    int i, n= N(s);
-    for (i=0; i<n; i++)
-      (void) tm_err->put (s[i]);
+    (void) tm_err->put (s);
   }
   if (!ln->alive) {
     tm_in ->eof ();
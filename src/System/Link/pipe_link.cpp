@@ -29,6 +29,7 @@
 #include <unistd.h>
 #include <signal.h>
 #include <sys/wait.h>
+#include <poll.h>
 #endif
 #if !defined(__APPLE__) && !defined(__FreeBSD__)
 #include <malloc.h>
@@ -44,6 +45,8 @@ extern char **environ;
 #define IN 0
 #define OUT 1
 #define TERMCHAR '\1'
+#define PIPE_CHUNK 16384
+#define PIPE_BUFFER_LIMIT (1 << 22)
 
 /******************************************************************************
 * The pipe_link class
@@ -61,6 +64,7 @@ struct pipe_link_rep: tm_link_rep {
 
   string outbuf;        // pending output from plugin
   string errbuf;        // pending errors from plugin
+  bool   throttled;     // stopped reading output until outbuf is consumed
 
   socket_notifier snout, snerr;
   
@@ -77,6 +81,7 @@ public:
   void    stop ();
 
   void    feed (int channel);
+  bool    drain ();
 };
 
 pipe_link_rep::pipe_link_rep (string cmd2): cmd (cmd2) {
@@ -86,6 +91,7 @@ pipe_link_rep::pipe_link_rep (string cmd2): cmd (cmd2) {
   err    = pp_err[0]= pp_err[1]= -1;
   outbuf = "";
   errbuf = "";
+  throttled= false;
   alive  = false;
 }
 
@@ -130,6 +136,22 @@ process_all_pipes () {
 ******************************************************************************/
 
 #ifndef OS_MINGW
+static void
+terminate (int pid) {
+  // terminate the process group of the child and reap the child itself;
+  // other children, such as autosave writers, must not be reaped here
+  if (-1 == killpg (pid, SIGTERM)) {
+    waitpid (pid, NULL, WNOHANG);
+    return;
+  }
+  for (int i=0; i<200; i++) {
+    if (waitpid (pid, NULL, WNOHANG) != 0) break;
+    usleep (10000);
+  }
+  killpg (pid, SIGKILL);
+  waitpid (pid, NULL, 0);
+}
+
 void
 execute_shell (string s) {
   c_string _s (s);
@@ -164,6 +186,7 @@ pipe_link_rep::start () {
     dup2  (pp_err [OUT], STDERR);
     close (pp_err [OUT]);
 
+    setenv ("TEXMACS_LINK_FRAMES", "1", 1);
     execute_shell (cmd);
     exit (127);
     // exit (system (cmd) != 0);
@@ -177,8 +200,10 @@ pipe_link_rep::start () {
     close (pp_err [OUT]);
 
     alive= true;
-    snout = socket_notifier (out, &pipe_callback, this, NULL);
-    snerr = socket_notifier (err, &pipe_callback, this, NULL);
+    frames= true;
+    throttled= false;
+    snout = socket_notifier (out, &pipe_callback, this, NULL, true);
+    snerr = socket_notifier (err, &pipe_callback, this, NULL, true);
     add_notifier (snout);
     add_notifier (snerr);
     
@@ -189,11 +214,7 @@ pipe_link_rep::start () {
       r= ::read (out, outbuf, 1024);
       if (r == 1 && outbuf[0] == TERMCHAR) return "ok";
       alive= false;
-      if (-1 != killpg(pid,SIGTERM)) {
-        sleep(2);
-        killpg(pid,SIGKILL);
-      }
-      wait (NULL);
+      terminate (pid);
       if (r == -1) return "Error: the application does not reply";
       else
         return "Error: the application did not send its usual startup banner";
@@ -238,19 +259,15 @@ pipe_link_rep::feed (int channel) {
 #ifndef OS_MINGW
   if ((!alive) || ((channel != LINK_OUT) && (channel != LINK_ERR))) return;
   int r;
-  char tempout[1024];
-  if (channel == LINK_OUT) r = ::read (out, tempout, 1024);
-  else r = ::read (err, tempout, 1024);
+  char tempout[PIPE_CHUNK];
+  if (channel == LINK_OUT) r = ::read (out, tempout, PIPE_CHUNK);
+  else r = ::read (err, tempout, PIPE_CHUNK);
   if (r == -1) {
     io_error << "Read failed for '" << cmd << "'\n";
-    wait (NULL);
+    waitpid (pid, NULL, WNOHANG);
   }
   else if (r == 0) {
-    if (-1 != killpg(pid,SIGTERM)) {
-      sleep(2);
-      killpg(pid,SIGKILL);
-    }
-
+    terminate (pid);
     alive= false;
     remove_notifier (snout);      
     remove_notifier (snerr);      
@@ -276,6 +293,15 @@ pipe_link_rep::read (int channel) {
   if (channel == LINK_OUT) {
     string r= outbuf;
     outbuf= "";
+    if (throttled) {
+      // resume reading; since the notifier is edge triggered and the
+      // plugin is blocked, no new event would arrive for the pending
+      // output.  Registering the notifier again reports it at the next
+      // perform_select, whose callback then calls the feed command.
+      throttled= false;
+      remove_notifier (snout);
+      add_notifier (snout);
+    }
     return r;
   }
   else if (channel == LINK_ERR) {
@@ -317,14 +343,9 @@ void
 pipe_link_rep::stop () {
 #ifndef OS_MINGW
   if (!alive) return;
-  if (-1 != killpg(pid,SIGTERM)) {
-    sleep(2);
-    killpg(pid,SIGKILL);
-  }
-  alive= false;    
-  close (in);
   alive= false;
-  wait (NULL);
+  close (in);
+  terminate (pid);
 
   remove_notifier (snout);
   remove_notifier (snerr);
@@ -335,36 +356,46 @@ pipe_link_rep::stop () {
 * Call back for new information on pipe
 ******************************************************************************/
 
-void pipe_callback (void *obj, void *info) {
+bool
+pipe_link_rep::drain () {
+  // Read all pending data from the plugin, except when the plugin
+  // produces output faster than we consume it.  In that case, we stop
+  // reading the output pipe, so that the plugin blocks on its writes.
+  bool news= false;
 #ifndef OS_MINGW
-  (void) info;
-  pipe_link_rep* con= (pipe_link_rep*) obj;  
   bool busy= true;
-  bool news= false;
   while (busy) {
-    fd_set rfds;
-    FD_ZERO (&rfds);
-    int max_fd= max (con->err, con->out) + 1;
-    FD_SET (con->out, &rfds);
-    FD_SET (con->err, &rfds);
-  
-    struct timeval tv;
-    tv.tv_sec  = 0;
-    tv.tv_usec = 0;
-    select (max_fd, &rfds, NULL, NULL, &tv);
+    struct pollfd fds[2];
+    fds[0].fd= out; fds[0].events= POLLIN; fds[0].revents= 0;
+    fds[1].fd= err; fds[1].events= POLLIN; fds[1].revents= 0;
+    poll (fds, 2, 0);
+    bool out_ready= (fds[0].revents & (POLLIN | POLLHUP | POLLERR)) != 0;
+    bool err_ready= (fds[1].revents & (POLLIN | POLLHUP | POLLERR)) != 0;
+    // the end of the error channel closes the link, so it is only
+    // handled once the output channel has been read completely
+    if (out_ready && (fds[1].revents & POLLIN) == 0) err_ready= false;
+    if (throttled) out_ready= false;
 
     busy= false;
-    if (con->alive && FD_ISSET (con->out, &rfds)) {
-      //cout << "pipe_callback OUT" << LF;
-      con->feed (LINK_OUT);
+    if (alive && out_ready) {
+      feed (LINK_OUT);
       busy= news= true;
+      if (N(outbuf) >= PIPE_BUFFER_LIMIT) throttled= true;
     }
-    if (con->alive && FD_ISSET (con->err, &rfds)) {
-      //cout << "pipe_callback ERR" << LF;
-      con->feed (LINK_ERR);
+    if (alive && err_ready) {
+      feed (LINK_ERR);
       busy= news= true;
     }
   }
+#endif
+  return news;
+}
+
+void pipe_callback (void *obj, void *info) {
+#ifndef OS_MINGW
+  (void) info;
+  pipe_link_rep* con= (pipe_link_rep*) obj;  
+  bool news= con->drain ();
   /* FIXME: find out the appropriate place to call the callback
      Currently, the callback is called in tm_server_rep::interpose_handler */
   if (!is_nil (con->feed_cmd) && news) {
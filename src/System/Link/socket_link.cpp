@@ -27,6 +27,7 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <netdb.h>
+#include <poll.h>
 #else
 namespace wsoc {
 #include <sys/types.h>
@@ -321,7 +322,6 @@ socket_link_rep::stop () {
   WSACleanup();
 #else
   //  close (io);  //fix it?
-  wait (NULL);
 #endif
   
 }
@@ -345,6 +345,7 @@ socket_callback (void *obj, void* info) {
   bool busy= true;
   bool news= false;
   while (busy) {
+#ifdef OS_MINGW
     fd_set rfds;
     FD_ZERO (&rfds);
     int max_fd= con->io + 1;
@@ -354,9 +355,16 @@ socket_callback (void *obj, void* info) {
     tv.tv_sec  = 0;
     tv.tv_usec = 0;
     select (max_fd, &rfds, NULL, NULL, &tv);
+    bool ready= FD_ISSET (con->io, &rfds);
+#else
+    struct pollfd fds;
+    fds.fd= con->io; fds.events= POLLIN; fds.revents= 0;
+    poll (&fds, 1, 0);
+    bool ready= (fds.revents & (POLLIN | POLLHUP | POLLERR)) != 0;
+#endif
 
     busy= false;
-    if (con->alive && FD_ISSET (con->io, &rfds)) {
+    if (con->alive && ready) {
       //cout << "socket_callback OUT" << LF;
       con->feed (LINK_OUT);
       busy= news= true;
@@ -27,8 +27,64 @@
 #include "socket_notifier.hpp"
 #include "list.hpp"
 #include "iterator.hpp"
+#include "tm_timer.hpp"
+
+#ifndef OS_MINGW
+#include <poll.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#define USE_EPOLL
+#endif
+#endif
+
+/******************************************************************************
+* Registration of notifiers
+*******************************************************************************
+* File descriptors stay registered with the kernel between two calls of
+* perform_select.  We use epoll when available; notifiers for which epoll
+* cannot be used are watched using poll, whose array of file descriptors is
+* only rebuilt when such a notifier is added or removed.  There is at most
+* one notifier for each file descriptor.
+******************************************************************************/
 
 static hashset<socket_notifier> notifiers;
+static hashmap<int,socket_notifier> fd_notifier;
+static array<socket_notifier> polled;
+static bool polled_changed= false;
+
+#ifdef USE_EPOLL
+static int epoll_fd= -2;
+
+static bool
+epoll_register (socket_notifier sn) {
+  if (epoll_fd == -2) epoll_fd= epoll_create1 (EPOLL_CLOEXEC);
+  if (epoll_fd < 0) return false;
+  struct epoll_event ev;
+  ev.events = EPOLLIN | (sn->edge? (uint32_t) EPOLLET: 0u);
+  ev.data.fd= sn->fd;
+  if (epoll_ctl (epoll_fd, EPOLL_CTL_ADD, sn->fd, &ev) == 0) return true;
+  if (errno == EEXIST && epoll_ctl (epoll_fd, EPOLL_CTL_MOD, sn->fd, &ev) == 0)
+    return true;
+  return false;
+}
+
+static void
+epoll_unregister (socket_notifier sn) {
+  struct epoll_event ev;
+  if (epoll_fd >= 0) (void) epoll_ctl (epoll_fd, EPOLL_CTL_DEL, sn->fd, &ev);
+}
+#endif
+
+static void
+remove_polled (socket_notifier sn) {
+  for (int i=0; i<N(polled); i++)
+    if (polled[i] == sn) {
+      polled[i]= polled[N(polled)-1];
+      polled->resize (N(polled)-1);
+      polled_changed= true;
+      return;
+    }
+}
 
 void
 socket_notifier_rep::notify () {
@@ -38,43 +94,106 @@ socket_notifier_rep::notify () {
 void
 add_notifier (socket_notifier sn)  {
   //cout << "enable notifier " << LF;
+  if (notifiers->contains (sn)) return;
+  if (fd_notifier->contains (sn->fd)) remove_notifier (fd_notifier[sn->fd]);
   notifiers->insert (sn);
+  fd_notifier (sn->fd)= sn;
+#ifdef USE_EPOLL
+  if (epoll_register (sn)) return;
+#endif
+  polled << sn;
+  polled_changed= true;
 } 
 
 void
 remove_notifier (socket_notifier sn)  {
   //cout << "disable notifier " << LF;
+  if (!notifiers->contains (sn)) return;
   notifiers->remove (sn);
+  if (fd_notifier[sn->fd] == sn) fd_notifier->reset (sn->fd);
+#ifdef USE_EPOLL
+  epoll_unregister (sn);
+#endif
+  remove_polled (sn);
+  if (DEBUG_BENCH && sn->nr_events > 0)
+    std_bench << "Notifier for file descriptor " << sn->fd << ": "
+              << sn->nr_events << " events, average latency "
+              << (sn->total_latency / sn->nr_events) << " us, maximal latency "
+              << sn->max_latency << " us\n";
+}
+
+/******************************************************************************
+* Waiting for activity
+******************************************************************************/
+
+#ifndef OS_MINGW
+static long
+current_usec () {
+#ifdef HAVE_GETTIMEOFDAY
+  struct timeval tp;
+  gettimeofday (&tp, NULL);
+  return ((long) tp.tv_sec) * 1000000 + ((long) tp.tv_usec);
+#else
+  return 1000 * ((long) texmacs_time ());
+#endif
 }
 
+static void
+ready_notifiers (array<socket_notifier>& ready) {
+#ifdef USE_EPOLL
+  if (epoll_fd >= 0) {
+    struct epoll_event events[64];
+    int nr= epoll_wait (epoll_fd, events, 64, 0);
+    for (int i=0; i<nr; i++)
+      if (fd_notifier->contains (events[i].data.fd))
+        ready << fd_notifier[events[i].data.fd];
+  }
+#endif
+  static array<struct pollfd> fds;
+  if (polled_changed) {
+    fds= array<struct pollfd> (N(polled));
+    for (int i=0; i<N(polled); i++) {
+      fds[i].fd    = polled[i]->fd;
+      fds[i].events= POLLIN;
+    }
+    polled_changed= false;
+  }
+  if (N(fds) == 0) return;
+  int nr= poll (A(fds), N(fds), 0);
+  for (int i=0; i<N(fds) && nr>0; i++)
+    if ((fds[i].revents & (POLLIN | POLLHUP | POLLERR)) != 0) {
+      ready << polled[i];
+      nr--;
+    }
+}
+#endif
+
 void 
 perform_select () {
 #ifndef OS_MINGW
-  //FIXME: this can be optimizied
+  // A file descriptor which is reported as ready became ready after the
+  // previous check, so the time since this check bounds the latency
+  static long last_check= 0;
   while (true) {
-    fd_set rfds;
-    FD_ZERO (&rfds);
-    int max_fd= 0;
-    iterator<socket_notifier> it = iterate (notifiers);
-    while (it->busy ()) {
-      socket_notifier sn= it->next ();
-      FD_SET (sn->fd, &rfds);
-      if (sn->fd >= max_fd) max_fd= sn->fd+1;
+    array<socket_notifier> ready;
+    long since= last_check;
+    if (DEBUG_BENCH) last_check= current_usec ();
+    ready_notifiers (ready);
+    if (N(ready) == 0) break;
+    if (since == 0) since= last_check;
+    for (int i=0; i<N(ready); i++) {
+      socket_notifier sn= ready[i];
+      // an earlier callback may have removed this notifier
+      if (!notifiers->contains (sn)) continue;
+      if (DEBUG_BENCH) {
+        long latency= current_usec () - since;
+        sn->nr_events++;
+        sn->total_latency += latency;
+        if (latency > sn->max_latency) sn->max_latency= latency;
+      }
+      sn->notify ();
     }
-    if (max_fd == 0) break;
-    
-    struct timeval tv;
-    tv.tv_sec  = 0;
-    tv.tv_usec = 0;
-    int nr = select (max_fd, &rfds, NULL, NULL, &tv);
-    if (nr==0) break;
-    
-    it = iterate (notifiers);
-    while (it->busy ()) {
-      socket_notifier sn=  it->next ();
-      if (FD_ISSET (sn->fd, &rfds)) sn->notify ();
-    }
-  }  
-#endif  
+  }
+#endif
 }
 #endif
@@ -19,18 +19,24 @@
 struct socket_notifier_rep: concrete_struct {
   int fd; // file descriptor for the socket
   command cmd;
-  
+  bool edge;          // edge triggered: the callback reads all available data
+  int  nr_events;     // number of times the callback was invoked
+  long total_latency; // total time between readiness and callback (in us)
+  long max_latency;   // maximal time between readiness and callback (in us)
+
 public:
-  socket_notifier_rep (int _fd, command _cmd):
-    fd (_fd), cmd (_cmd) {}
+  socket_notifier_rep (int _fd, command _cmd, bool _edge):
+    fd (_fd), cmd (_cmd), edge (_edge),
+    nr_events (0), total_latency (0), max_latency (0) {}
   void notify ();
 };
 
 class socket_notifier {
 CONCRETE_NULL(socket_notifier);
   inline socket_notifier (int _fd, void (*_cb) (void*, void*),
-			  void *_obj, void *_info = NULL):
-    rep (tm_new<socket_notifier_rep> (_fd, command (_cb, _obj, _info))) {}
+			  void *_obj, void *_info = NULL, bool _edge= false):
+    rep (tm_new<socket_notifier_rep> (_fd, command (_cb, _obj, _info),
+                                      _edge)) {}
   friend bool operator == (socket_notifier sn1, socket_notifier sn2) {
     return (sn1.rep == sn2.rep); }
   friend int hash (socket_notifier sn) {
@@ -21,6 +21,7 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <sys/wait.h>
+#include <poll.h>
 #ifdef __FreeBSD__
 #include <sys/time.h>
 #include <sys/select.h>
@@ -207,7 +208,6 @@ socket_server_rep::stop () {
   WSACleanup();
 #else
   close (server);
-  wait (NULL);
 #endif
 }
 
@@ -225,6 +225,7 @@ socket_server_callback (void *obj, void *info) {
   bool busy= true;
   bool news= false;
   while (busy) {
+#ifdef OS_MINGW
     fd_set rfds;
     FD_ZERO (&rfds);
     int max_fd= ss->server + 1;
@@ -234,9 +235,16 @@ socket_server_callback (void *obj, void *info) {
     tv.tv_sec  = 0;
     tv.tv_usec = 0;
     select (max_fd, &rfds, NULL, NULL, &tv);
+    bool ready= FD_ISSET (ss->server, &rfds);
+#else
+    struct pollfd fds;
+    fds.fd= ss->server; fds.events= POLLIN; fds.revents= 0;
+    poll (&fds, 1, 0);
+    bool ready= (fds.revents & POLLIN) != 0;
+#endif
 
     busy= false;
-    if (ss->alive && FD_ISSET (ss->server, &rfds)) {
+    if (ss->alive && ready) {
       //cout << "server_callback" << LF;
       ss->start_client ();
       busy= news= true;
@@ -13,6 +13,9 @@
 #include "client_server.hpp"
 #include "socket_server.hpp"
 #include "scheme.hpp"
+#include "batch_server.hpp"
+#include "analyze.hpp"
+#include "file.hpp"
 
 #ifdef QTTEXMACS
 #include "Qt/QTMSockets.hpp"
@@ -122,3 +125,40 @@ server_write (int fd, string s) {
   ln->write_packet (s, LINK_IN);
 }
 #endif
+
+/******************************************************************************
+* Headless server for batch conversions
+******************************************************************************/
+
+static string
+batch_conversion (array<string> job) {
+  if (N(job) != 3 || (job[0] != "convert" && job[0] != "export"))
+    return "unknown job " * job[0];
+  url in  ("$PWD", job[1]);
+  url out ("$PWD", job[2]);
+  if (!exists (in)) return "file not found";
+  string name= scm_quote (as_string (in));
+  string cmd=
+    "(catch #t (lambda () "
+    "(load-buffer " * name * " :strict) "
+    "(export-buffer " * scm_quote (as_string (out)) * ") "
+    "(buffer-close (string->url " * name * ")) \"\") "
+    "(lambda args (object->string args)))";
+  string err= as_string (eval (cmd));
+  exec_pending_commands ();
+  if (err == "" && !exists (out)) return "conversion failed";
+  return err;
+}
+
+void
+batch_server_start (string name, int workers) {
+  // the workers are forked after the boot, so that the styles and fonts
+  // which were loaded before remain available for all jobs
+  exec_pending_commands ();
+  batch_server_rep* srv=
+    tm_new<batch_server_rep> (name, workers, batch_conversion);
+  string r= srv->start ();
+  cout << "TeXmacs] Starting batch server on " << name << "... " << r << "\n";
+  if (r == "ok") srv->run ();
+  tm_delete (srv);
+}
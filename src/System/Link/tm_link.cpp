@@ -12,6 +12,7 @@
 #include "tm_link.hpp"
 #include "../Plugins/Openssl/openssl.hpp"
 #include "tm_timer.hpp"
+#include <string.h>
 
 /******************************************************************************
 * Sending data by packets
@@ -76,6 +77,36 @@ tm_link_rep::read_packet (int channel, int timeout, bool& success) {
   }
 }
 
+/******************************************************************************
+* Length-prefixed frames
+******************************************************************************/
+
+string
+data_frame (char type, string payload) {
+  // a frame consists of a type byte, the payload length as four bytes
+  // in big endian order and the unescaped payload
+  int n= N(payload);
+  string r (FRAME_HEADER_SIZE + n);
+  r[0]= type;
+  r[1]= (char) ((n >> 24) & 255);
+  r[2]= (char) ((n >> 16) & 255);
+  r[3]= (char) ((n >>  8) & 255);
+  r[4]= (char) ( n        & 255);
+  if (n > 0) memcpy (&r[FRAME_HEADER_SIZE], &payload[0], n);
+  return r;
+}
+
+int
+data_frame_length (string s, int pos) {
+  // total length of the frame at position pos or -1 if incomplete
+  if (pos + FRAME_HEADER_SIZE > N(s)) return -1;
+  const unsigned char* h= (const unsigned char*) &s[pos + 1];
+  int n= (((int) h[0]) << 24) + (((int) h[1]) << 16) +
+         (((int) h[2]) <<  8) +  ((int) h[3]);
+  if (n < 0 || pos + FRAME_HEADER_SIZE + n > N(s)) return -1;
+  return FRAME_HEADER_SIZE + n;
+}
+
 /******************************************************************************
 * Data encryption
 ******************************************************************************/
@@ -25,6 +25,13 @@
 #define DATA_COMMAND ((char) 16)
 #define DATA_ESCAPE  ((char) 27)
 
+#define FRAME_DATA   'D'
+#define FRAME_BEGIN  'B'
+#define FRAME_END    'E'
+#define FRAME_ABORT  'A'
+#define FRAME_HEADER_SIZE 5
+#define FRAMES_HANDSHAKE  "\002frames:1\005"
+
 #define LINK_IN   0
 #define LINK_OUT  0
 #define LINK_ERR  1
@@ -39,12 +46,13 @@
 
 struct tm_link_rep: abstract_struct {
   bool   alive;   // link is alive
+  bool   frames;  // the plugin was offered length-prefixed frames
   string secret;  // empty string or secret key for encrypted connections
 
   command feed_cmd; // called when async data available
   
 public:
-  inline tm_link_rep () {}
+  inline tm_link_rep (): frames (false) {}
   inline virtual ~tm_link_rep () {}
 
   virtual string  start () = 0;
@@ -78,6 +86,9 @@ ABSTRACT_NULL_CODE(tm_link);
 inline bool tm_link::operator == (tm_link l) { return rep == l.rep; }
 inline bool tm_link::operator != (tm_link l) { return rep != l.rep; }
 
+string  data_frame (char type, string payload);
+int     data_frame_length (string s, int pos);
+
 tm_link make_pipe_link (string cmd);
 tm_link make_dynamic_link (string lib, string symb, string init, string ses);
 tm_link make_socket_link (string h, int p, int t= SOCKET_DEFAULT, int fd= -1);
@@ -171,15 +171,12 @@ cache_save (string buffer) {
       }
     }
     else {
-      cached << "(tuple\n";
+      tree t (TUPLE);
       while (it->busy ()) {
         tree ckey= it->next ();
-        if (ckey[0] == buffer) {
-          cached << tree_to_scheme (ckey[1]) << " ";
-          cached << tree_to_scheme (cache_data [ckey]) << "\n";
-        }
+        if (ckey[0] == buffer) t << ckey[1] << cache_data [ckey];
       }
-      cached << ")";
+      cached= tree_to_binary (t);
     }
     (void) save_string (cache_file, cached);
     cache_changed->remove (buffer);
@@ -212,7 +209,8 @@ cache_load (string buffer) {
         }
       }
       else {
-        tree t= scheme_to_tree (cached);
+        tree t= is_binary_tree (cached)?
+                  binary_to_tree (cached): scheme_to_tree (cached);
         for (int i=0; i<N(t)-1; i+=2)
           cache_data (tuple (buffer, t[i]))= t[i+1];
       }
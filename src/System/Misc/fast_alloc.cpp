@@ -236,6 +236,12 @@ mem_used () {
   return small_uses+ large_uses;
 }
 
+int
+mem_held () {
+  // memory held by the allocator, without walking the free lists
+  return BLOCK_SIZE*fast_chunks- alloc_remains+ large_uses;
+}
+
 void
 mem_info () {
   cout << "\n---------------- memory statistics ----------------\n";
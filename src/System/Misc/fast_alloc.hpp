@@ -50,6 +50,7 @@ extern void* fast_new (size_t s);
 extern void  fast_delete (void* ptr);
 
 extern int   mem_used ();
+extern int   mem_held ();
 extern void  mem_info ();
 void* alloc_check(const char *msg,void *ptr,size_t* sp);
 
@@ -0,0 +1,391 @@
+
+/******************************************************************************
+* MODULE     : new_autosave.cpp
+* DESCRIPTION: Asynchronous and incremental autosaving of documents
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* Autosave files are written by a child process, so that the editor does
+* not stall on the serialization and the disk.  The fork itself serves as
+* a cheap snapshot of the document.  The child writes to a temporary file,
+* synchronizes it with the disk and renames it over the autosave file,
+* so that the autosave file is always either the previous or the new
+* complete version, even if the writer gets interrupted.
+*
+* Optionally, a journal is kept next to the autosave file.  It starts with
+* a binary snapshot of the document, which is followed by the
+* modifications since this snapshot, as recorded by a journal observer.
+* Subsequent autosaves only append the new modifications to the journal,
+* until it becomes larger than the snapshot.  When recovering a document,
+* the modifications of the journal are replayed on top of its snapshot.
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "new_buffer.hpp"
+#include "convert.hpp"
+#include "file.hpp"
+#include "modification.hpp"
+#include "analyze.hpp"
+#include "tm_timer.hpp"
+#include "iterator.hpp"
+#include <errno.h>
+#include <fcntl.h>
+#ifndef OS_MINGW
+#include <unistd.h>
+#include <signal.h>
+#include <sys/wait.h>
+#endif
+
+static int autosave_timeout= 60000;              // maximal duration of writers
+static hashmap<string,int> writer_pid (0);       // running writers
+static hashmap<string,int> writer_start (0);     // starting times of writers
+static hashmap<string,url> writer_buffer (url_none ()); // autosaved buffers
+static hashmap<string,bool> writer_journal (false); // writer starts journal
+static hashmap<string,int> journal_budget (0);   // bytes before new snapshot
+static hashmap<string,tree> journal_header (""); // last header in journal
+
+/******************************************************************************
+* Low level file routines
+******************************************************************************/
+
+static bool
+write_file (url u, string s, bool append) {
+  // write s to u and wait until it reaches the disk; returns true on error
+  c_string _u (concretize (u));
+  int flags= O_WRONLY | O_CREAT | (append? O_APPEND: O_TRUNC);
+#ifdef OS_MINGW
+  flags |= O_BINARY;
+#endif
+  int fd= open (_u, flags, 0644);
+  if (fd == -1) return true;
+  int i= 0, n= N(s);
+  while (i < n) {
+    int r= write (fd, &(s[i]), n - i);
+    if (r > 0) i += r;
+    else if (r == -1 && errno == EINTR) continue;
+    else { close (fd); return true; }
+  }
+#ifndef OS_MINGW
+  if (fsync (fd) == -1) { close (fd); return true; }
+#endif
+  return close (fd) == -1;
+}
+
+static bool
+replace_file (url u, string s, url obsolete= url_none ()) {
+  // atomically replace the contents of u by s; returns true on error
+  url tmp= glue (u, ".part");
+  if (write_file (tmp, s, false)) return true;
+  if (!is_none (obsolete)) remove (obsolete);
+  c_string _tmp (concretize (tmp));
+  c_string _u (concretize (u));
+  return rename (_tmp, _u) == -1;
+}
+
+/******************************************************************************
+* Journals
+******************************************************************************/
+
+static url
+journal_file (url dest) {
+  return glue (dest, ".journal");
+}
+
+static string
+journal_record (tree t) {
+  string s= tree_to_binary (t);
+  return as_string (N(s)) * "\n" * s;
+}
+
+static tree
+encode_path (path p) {
+  tree t (TUPLE);
+  for (; !is_nil (p); p= p->next)
+    t << as_string (p->item);
+  return t;
+}
+
+static path
+decode_path (tree t) {
+  path p;
+  for (int i=N(t)-1; i>=0; i--)
+    p= path (as_int (t[i]), p);
+  return p;
+}
+
+static tree
+journal_header_of (tree doc) {
+  return change_doc_attr (doc, "body", "");
+}
+
+static string
+journal_base (tree doc) {
+  tree header= journal_header_of (doc);
+  return journal_record (tuple ("base", header, extract (doc, "body")));
+}
+
+static string
+journal_entries (string key, tree doc, list<modification> mods) {
+  string r;
+  for (; !is_nil (mods); mods= mods->next)
+    r << journal_record (tuple ("mod", get_type (mods->item),
+                                encode_path (mods->item->p), mods->item->t));
+  tree header= journal_header_of (doc);
+  if (header != journal_header [key]) {
+    r << journal_record (tuple ("header", header));
+    journal_header (key)= header;
+  }
+  return r;
+}
+
+static bool
+encrypted (tree doc) {
+  tree init= extract (doc, "initial");
+  for (int i=0; i<N(init); i++)
+    if (is_func (init[i], ASSOCIATE, 2) && init[i][0] == "encryption")
+      return true;
+  return false;
+}
+
+static array<tree>
+journal_records (string s) {
+  // the records of a journal, ignoring an incomplete last record
+  array<tree> r;
+  int i= 0, n= N(s);
+  while (i < n) {
+    int j= i;
+    while (j < n && is_digit (s[j])) j++;
+    if (j == i || j >= n || s[j] != '\n') break;
+    int len= as_int (s (i, j));
+    if (len > n - (j+1)) break;
+    r << binary_to_tree (s (j+1, j+1+len));
+    i= j+1+len;
+  }
+  return r;
+}
+
+tree
+autosave_replay (url dest, tree doc) {
+  url j= journal_file (dest);
+  if (!exists (j)) return doc;
+  if (exists (dest) && last_modified (j, false) < last_modified (dest, false))
+    return doc;
+  string s;
+  if (load_string (j, s, false)) return doc;
+  array<tree> a= journal_records (s);
+  if (N(a) == 0 || !is_tuple (a[0], "base", 2)) return doc;
+  tree header= a[0][1], body= a[0][2];
+  for (int i=1; i<N(a); i++)
+    if (is_tuple (a[i], "header", 1)) header= a[i][1];
+    else if (is_tuple (a[i], "mod", 3) && is_atomic (a[i][1])) {
+      modification mod= make_modification (a[i][1]->label,
+                                           decode_path (a[i][2]), a[i][3]);
+      if (!is_applicable (body, mod)) break;
+      body= clean_apply (body, mod);
+    }
+    else break;
+  return change_doc_attr (header, "body", body);
+}
+
+tree
+autosave_recover (url dest, string fm) {
+  tree doc= import_tree (dest, fm);
+  if (fm != "texmacs" || encrypted (doc)) return doc;
+  return autosave_replay (dest, doc);
+}
+
+/******************************************************************************
+* Background writers
+******************************************************************************/
+
+static bool
+plain_texmacs (tree doc, string fm) {
+  // documents which can be serialized without the help of scheme
+  return fm == "texmacs" && !encrypted (doc);
+}
+
+static bool
+write_snapshot (url dest, tree doc, string fm, string s, bool journal) {
+  // returns true on error; the journal is replaced before the autosave file,
+  // since it is only used if it is at least as recent as the autosave file
+  url j= journal_file (dest);
+  if (journal && replace_file (j, journal_base (doc))) return true;
+  if (plain_texmacs (doc, fm)) s= tree_to_texmacs (doc);
+  return replace_file (dest, s, journal? url_none (): j);
+}
+
+void
+set_autosave_timeout (int ms) {
+  autosave_timeout= ms;
+}
+
+static void
+reap (string key, bool block) {
+  // check whether the writer for key has finished; writers which take
+  // longer than the timeout (e.g. on a hanging network drive) are killed
+  if (!writer_pid->contains (key)) return;
+#ifndef OS_MINGW
+  int pid= writer_pid [key], status= 0;
+  int r= waitpid (pid, &status, WNOHANG);
+  while (r == 0 && block &&
+         texmacs_time () - writer_start [key] < autosave_timeout) {
+    usleep (1000);
+    r= waitpid (pid, &status, WNOHANG);
+  }
+  if (r == 0) {
+    if (texmacs_time () - writer_start [key] < autosave_timeout) return;
+    kill (pid, SIGKILL);
+    r= waitpid (pid, &status, 0);
+  }
+  bool ok= (r > 0 && WIFEXITED (status) && WEXITSTATUS (status) == 0);
+  if (ok && writer_journal [key]) {
+    // appending to the journal is allowed until it doubles in size
+    url j= journal_file (url (key));
+    journal_budget (key)= max (file_size (j), 4096);
+  }
+  else journal_budget->reset (key);
+  if (ok) confirm_buffer_autosave (writer_buffer [key]);
+  else std_warning << "Failed to autosave " << key << LF;
+#endif
+  writer_pid->reset (key);
+  writer_start->reset (key);
+  writer_buffer->reset (key);
+  writer_journal->reset (key);
+}
+
+static void
+reap_all () {
+  array<string> keys;
+  iterator<string> it= iterate (writer_pid);
+  while (it->busy ()) keys << it->next ();
+  for (int i=0; i<N(keys); i++) reap (keys[i], false);
+}
+
+void
+autosave_reap () {
+  // writers of closed buffers are only reaped here
+  reap_all ();
+}
+
+void
+autosave_forget (url name) {
+  // the buffer is closed; its writers no longer confirm anything
+  reap_all ();
+  array<string> keys;
+  iterator<string> it= iterate (writer_buffer);
+  while (it->busy ()) keys << it->next ();
+  for (int i=0; i<N(keys); i++)
+    if (writer_buffer [keys[i]] == name) writer_buffer (keys[i])= url_none ();
+}
+
+void
+autosave_cancel (url dest) {
+  // the autosave file became obsolete, e.g. because the document was saved;
+  // a running writer must not rename its file over it afterwards
+  string key= as_string (dest);
+#ifndef OS_MINGW
+  if (writer_pid->contains (key)) {
+    int pid= writer_pid [key], status= 0;
+    kill (pid, SIGKILL);
+    (void) waitpid (pid, &status, 0);
+  }
+  // the temporary files need not be regular files for remove (url)
+  c_string _part (concretize (glue (dest, ".part")));
+  c_string _jpart (concretize (glue (journal_file (dest), ".part")));
+  (void) unlink (_part);
+  (void) unlink (_jpart);
+#else
+  remove (glue (dest, ".part"));
+  remove (glue (journal_file (dest), ".part"));
+#endif
+  writer_pid->reset (key);
+  writer_start->reset (key);
+  writer_buffer->reset (key);
+  writer_journal->reset (key);
+  journal_budget->reset (key);
+}
+
+bool
+autosave_busy (url dest) {
+  string key= as_string (dest);
+  reap (key, false);
+  return writer_pid->contains (key);
+}
+
+int
+autosave_writer (url dest) {
+  string key= as_string (dest);
+  reap (key, false);
+  if (!writer_pid->contains (key)) return 0;
+  return writer_pid [key];
+}
+
+void
+autosave_wait (url dest) {
+  reap (as_string (dest), true);
+}
+
+string
+autosave_document (url dest, tree& root, tree doc, string fm, bool journal,
+                   url name) {
+  string key= as_string (dest);
+  reap_all ();
+  if (writer_pid->contains (key)) return "busy";
+  // journals are only replayed on texmacs documents; since they are
+  // stored in clear, encrypted documents have none
+  if (!plain_texmacs (doc, fm)) {
+    journal= false;
+    remove (journal_file (dest));
+  }
+
+  list<modification> mods;
+  bool valid= journal_take (root, mods);
+  if (journal && valid && journal_budget->contains (key) &&
+      exists (journal_file (dest))) {
+    string s= journal_entries (key, doc, mods);
+    if (N(s) <= journal_budget [key]) {
+      if (write_file (journal_file (dest), s, true)) {
+        journal_budget->reset (key);
+        return "error";
+      }
+      journal_budget (key) -= N(s);
+      confirm_buffer_autosave (name);
+      return "journal";
+    }
+  }
+  journal_budget->reset (key);
+  if (journal) {
+    attach_journal (root);
+    journal_header (key)= journal_header_of (doc);
+  }
+  else detach_journal (root);
+
+  // documents with special formats are serialized in advance
+  string s;
+  if (!plain_texmacs (doc, fm))
+    if (export_string (doc, dest, fm, s)) return "error";
+
+#ifndef OS_MINGW
+  int pid= fork ();
+  if (pid == 0) {
+    bool err= write_snapshot (dest, doc, fm, s, journal);
+    _exit (err? 1: 0);
+  }
+  if (pid > 0) {
+    writer_pid (key)= pid;
+    writer_start (key)= (int) texmacs_time ();
+    writer_buffer (key)= name;
+    writer_journal (key)= journal;
+    return "snapshot";
+  }
+#endif
+
+  // write synchronously if no child process could be created
+  if (write_snapshot (dest, doc, fm, s, journal)) return "error";
+  if (journal)
+    journal_budget (key)= max (file_size (journal_file (dest)), 4096);
+  confirm_buffer_autosave (name);
+  return "snapshot";
+}
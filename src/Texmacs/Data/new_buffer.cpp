@@ -21,6 +21,12 @@
 
 array<tm_buffer> bufs;
 
+// indices for sessions with many buffers, by name, by document root
+// and by title; they are updated whenever these properties change
+static hashmap<tree,tm_buffer> buffer_table (NULL);
+static hashmap<int,tm_buffer> buffer_root_table (NULL);
+static hashmap<string,int> buffer_title_table (0);
+
 string propose_title (string old_title, url u, tree doc);
 
 /******************************************************************************
@@ -60,12 +66,28 @@ tm_buffer_rep::needs_to_be_autosaved () {
 * Manipulation of buffer list
 ******************************************************************************/
 
+static void
+forget_title (string title) {
+  if (buffer_title_table [title] <= 1) buffer_title_table->reset (title);
+  else buffer_title_table (title) -= 1;
+}
+
+static void
+set_title (tm_buffer buf, string title) {
+  forget_title (buf->buf->title);
+  buf->buf->title= title;
+  buffer_title_table (title) += 1;
+}
+
 void
 insert_buffer (url name) {
   if (is_none (name)) return;
   if (!is_nil (concrete_buffer (name))) return;
   tm_buffer buf= tm_new<tm_buffer_rep> (name);
   bufs << buf;
+  buffer_table (name->t)= buf;
+  buffer_root_table (buf->rp->item)= buf;
+  buffer_title_table (buf->buf->title) += 1;
 }
 
 void
@@ -80,6 +102,11 @@ remove_buffer (tm_buffer buf) {
       for (int i=nr; i<n-1; i++)
         bufs[i]= bufs[i+1];
       bufs->resize (n-1);
+      autosave_forget (buf->buf->name);
+      detach_search_index (subtree (the_et, buf->rp));
+      buffer_table->reset (buf->buf->name->t);
+      buffer_root_table->reset (buf->rp->item);
+      forget_title (buf->buf->title);
       tm_delete (buf);
       return;
     }
@@ -106,11 +133,7 @@ get_all_buffers () {
 
 tm_buffer
 concrete_buffer (url name) {
-  int i, n= N(bufs);
-  for (i=0; i<n; i++)
-    if (bufs[i]->buf->name == name)
-      return bufs[i];
-  return nil_buffer ();
+  return buffer_table [name->t];
 }
 
 tm_buffer
@@ -140,10 +163,10 @@ get_current_buffer_safe () {
 
 url
 path_to_buffer (path p) {
-  int i;
-  for (i=0; i<N(bufs); i++)
-    if (bufs[i]->rp <= p)
-      return bufs[i]->buf->name;
+  // the root of each buffer is a path of length one
+  if (is_nil (p)) return url_none ();
+  tm_buffer buf= buffer_root_table [p->item];
+  if (!is_nil (buf) && buf->rp <= p) return buf->buf->name;
   return url_none ();
 }
 
@@ -154,8 +177,10 @@ rename_buffer (url name, url new_name) {
   tm_buffer buf= concrete_buffer (name);
   if (is_nil (buf)) return;
   notify_rename_before (name);
+  buffer_table->reset (name->t);
   buf->buf->name= new_name;
   buf->buf->master= new_name;
+  buffer_table (new_name->t)= buf;
   array<url> vs= buffer_to_views (new_name);
   for (int i=0; i<N(vs); i++)
     view_to_editor (vs[i]) -> notify_change (THE_ENVIRONMENT);
@@ -204,14 +229,13 @@ propose_title (string old_title, url u, tree doc) {
   if (is_rooted_tmfs (u))
     name= as_string (call ("tmfs-title", as_string (u), object (doc)));
 
-  int i, j;
+  int j;
   for (j=1; true; j++) {
     bool flag= true;
     string ret (name);
     if (j>1) ret= name * " (" * as_string (j) * ")";
     if (ret == old_title) return ret;
-    for (i=0; i<N(bufs); i++)
-      if (bufs[i]->buf->title == ret) flag= false;
+    if (buffer_title_table->contains (ret)) flag= false;
     if (flag) return ret;
   }
 }
@@ -228,7 +252,7 @@ set_title_buffer (url name, string title) {
   tm_buffer buf= concrete_buffer (name);
   if (is_nil (buf)) return;
   if (buf->buf->title == title) return;
-  buf->buf->title= title;
+  set_title (buf, title);
   array<url> vs= buffer_to_views (name);
   for (int i=0; i<N(vs); i++) {
     tm_window win= concrete_window (view_to_window (vs[i]));
@@ -260,7 +284,7 @@ set_buffer_tree (url name, tree doc) {
     buf= concrete_buffer (name);
     tree body= detach_data (doc, buf->data);
     set_document (buf->rp, body);
-    buf->buf->title= propose_title (buf->buf->title, name, body);
+    set_title (buf, propose_title (buf->buf->title, name, body));
     if (buf->data->project != "") {
       url prj_name= head (name) * as_string (buf->data->project);
       buf->prj= concrete_buffer_insist (prj_name);
@@ -272,7 +296,7 @@ set_buffer_tree (url name, tree doc) {
     tree body= detach_data (doc, buf->data);
     assign (buf->rp, body);
     set_buffer_data (name, buf->data);
-    buf->buf->title= propose_title (old_title, name, body);
+    set_title (buf, propose_title (old_title, name, body));
     if (buf->data->project != "" && buf->data->project != old_project) {
       url prj_name= head (name) * as_string (buf->data->project);
       buf->prj= concrete_buffer_insist (prj_name);
@@ -405,6 +429,24 @@ pretend_buffer_autosaved (url name) {
     view_to_editor (vs[i]) -> notify_save (false);
 }
 
+void
+prepare_buffer_autosave (url name) {
+  tm_buffer buf= concrete_buffer (name);
+  if (is_nil (buf)) return;
+  array<url> vs= buffer_to_views (name);
+  for (int i=0; i<N(vs); i++)
+    view_to_editor (vs[i]) -> prepare_autosave ();
+}
+
+void
+confirm_buffer_autosave (url name) {
+  tm_buffer buf= concrete_buffer (name);
+  if (is_nil (buf)) return;
+  array<url> vs= buffer_to_views (name);
+  for (int i=0; i<N(vs); i++)
+    view_to_editor (vs[i]) -> confirm_autosave ();
+}
+
 void
 attach_buffer_notifier (url name) {
   tm_buffer buf= concrete_buffer (name);
@@ -513,7 +555,7 @@ with_package_definitions (string package, tree body) {
 ******************************************************************************/
 
 bool
-export_tree (tree doc, url u, string fm) {
+export_string (tree doc, url u, string fm, string& s) {
   tree aux= doc;
   // NOTE: hook for encryption
   tree init= extract (aux, "initial");
@@ -525,11 +567,33 @@ export_tree (tree doc, url u, string fm) {
       }
   // END hook
   if (fm == "generic") fm= "verbatim";
-  string s= tree_to_generic (aux, fm * "-document");
-  if (s == "* error: unknown format *") return true;
+  s= tree_to_generic (aux, fm * "-document");
+  return s == "* error: unknown format *";
+}
+
+bool
+export_tree (tree doc, url u, string fm) {
+  string s;
+  if (export_string (doc, u, fm, s)) return true;
   return save_string (u, s);
 }
 
+static tree
+export_document (tm_view vw, tree body, string fm) {
+  vw->ed->get_data (vw->buf->data);
+  tree doc= attach_data (body, vw->buf->data, !vw->ed->get_save_aux());
+
+  if (fm == "latex")
+    doc= change_doc_attr (doc, "view", as_string (abstract_view (vw)));
+
+  object arg1 (vw->buf->buf->name);
+  object arg2 (body);
+  tree links= as_tree (call ("get-link-locations", arg1, arg2));
+  if (N (links) != 0)
+    doc << compound ("links", links);
+  return doc;
+}
+
 bool
 buffer_export (url name, url dest, string fm) {
   tm_view vw= concrete_view (get_recent_view (name));
@@ -550,19 +614,20 @@ buffer_export (url name, url dest, string fm) {
   //if (fm == "latex")
   //body= vw->ed->exec_latex (body);
 
-  vw->ed->get_data (vw->buf->data);
-  tree doc= attach_data (body, vw->buf->data, !vw->ed->get_save_aux());
-
-  if (fm == "latex")
-    doc= change_doc_attr (doc, "view", as_string (abstract_view (vw)));
+  return export_tree (export_document (vw, body, fm), dest, fm);
+}
 
-  object arg1 (vw->buf->buf->name);
-  object arg2 (body);
-  tree links= as_tree (call ("get-link-locations", arg1, arg2));
-  if (N (links) != 0)
-    doc << compound ("links", links);
-  
-  return export_tree (doc, dest, fm);
+string
+buffer_autosave (url name, url dest, string fm) {
+  // the buffer is only marked as autosaved once the writer succeeded
+  if (autosave_busy (dest)) return "busy";
+  tm_view vw= concrete_view (get_recent_view (name));
+  ASSERT (vw != NULL, "view expected");
+  tree& body= subtree (the_et, vw->buf->rp);
+  tree doc= export_document (vw, body, fm);
+  bool journal= (get_preference ("autosave journal", "off") == "on");
+  prepare_buffer_autosave (name);
+  return autosave_document (dest, body, doc, fm, journal, name);
 }
 
 tree
@@ -95,6 +95,8 @@ bool buffer_modified_since_autosave (url name);
 void pretend_buffer_modified (url name);
 void pretend_buffer_saved (url name);
 void pretend_buffer_autosaved (url name);
+void prepare_buffer_autosave (url name);
+void confirm_buffer_autosave (url name);
 void attach_buffer_notifier (url name);
 bool buffer_has_name (url name);
 bool buffer_import (url name, url src, string fm);
@@ -103,8 +105,26 @@ bool buffer_export (url name, url dest, string fm);
 bool buffer_save (url name);
 tree import_loaded_tree (string s, url u, string fm);
 tree import_tree (url u, string fm);
+bool export_string (tree doc, url u, string fm, string& s);
 bool export_tree (tree doc, url u, string fm);
 tree load_style_tree (string package);
 tree with_package_definitions (string package, tree body);
 
+/******************************************************************************
+* Autosaving
+******************************************************************************/
+
+string buffer_autosave (url name, url dest, string fm);
+string autosave_document (url dest, tree& root, tree doc, string fm,
+                          bool journal, url name= url_none ());
+void set_autosave_timeout (int ms);
+bool autosave_busy (url dest);
+int  autosave_writer (url dest);
+void autosave_wait (url dest);
+void autosave_cancel (url dest);
+void autosave_reap ();
+void autosave_forget (url name);
+tree autosave_replay (url dest, tree doc);
+tree autosave_recover (url dest, string fm);
+
 #endif // NEW_BUFFER_H
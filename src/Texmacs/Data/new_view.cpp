@@ -29,6 +29,7 @@
 
 static hashmap<tree,int> view_number_table (0);
 static hashmap<tree,pointer> view_table (NULL);
+static hashmap<tree,pointer> window_view_table (NULL);
 
 static int
 new_view_number (url u) {
@@ -74,9 +75,23 @@ abstract_view (tm_view vw) {
   return "tmfs://view/" * nr * "/" * name;
 }
 
+static void
+register_view (tm_view vw) {
+  view_table (abstract_view (vw)->t)= (pointer) vw;
+}
+
+static void
+unregister_view (tm_view vw) {
+  view_table->reset (abstract_view (vw)->t);
+}
+
 tm_view
 concrete_view (url u) {
   if (is_none (u)) return NULL;
+  // the names of the views are registered as they are generated,
+  // and their other spellings are decoded below
+  tm_view vw= (tm_view) view_table [u->t];
+  if (vw != NULL) return vw;
   string s= as_string (u);
   if (!starts (s, "tmfs://view/")) return NULL;
   s= s (N (string ("tmfs://view/")), N(s));
@@ -252,6 +267,7 @@ get_new_view (url name) {
   editor    ed = new_editor (get_server () -> get_server (), buf);
   tm_view   vw = tm_new<tm_view_rep> (buf, ed);
   buf->vws << vw;
+  register_view (vw);
   ed->set_data (buf->data);
 
   url temp= get_current_view_safe ();
@@ -315,6 +331,8 @@ delete_view (url u) {
         else a[j]= buf->vws[j+1];
       buf->vws= a;
     }
+  unregister_view (vw);
+  if (vw->win != NULL) window_view_table->reset (vw->win->id->t);
   notify_delete_view (u);
   tm_delete (vw);
 }
@@ -322,15 +340,19 @@ delete_view (url u) {
 void
 notify_rename_before (url old_name) {
   array<url> vs= buffer_to_views (old_name);
-  for (int i=0; i<N(vs); i++)
+  for (int i=0; i<N(vs); i++) {
+    unregister_view (concrete_view (vs[i]));
     notify_delete_view (vs[i]);
+  }
 }
 
 void
 notify_rename_after (url new_name) {
   array<url> vs= buffer_to_views (new_name);
-  for (int i=0; i<N(vs); i++)
+  for (int i=0; i<N(vs); i++) {
+    register_view (concrete_view (vs[i]));
     notify_set_view (vs[i]);
+  }
 }
 
 /******************************************************************************
@@ -344,6 +366,7 @@ attach_view (url win_u, url u) {
   if (win == NULL || vw == NULL) return;
   // cout << "Attach view " << vw->buf->buf->name << "\n";
   vw->win= win;
+  window_view_table (win->id->t)= (pointer) vw;
   widget wid= win->wid;
   set_scrollable (wid, vw->ed);
   vw->ed->cvw= wid.rep;
@@ -363,6 +386,7 @@ detach_view (url u) {
   if (win == NULL) return;
   // cout << "Detach view " << vw->buf->buf->name << "\n";
   vw->win= NULL;
+  window_view_table->reset (win->id->t);
   widget wid= win->wid;
   ASSERT (is_attached (wid), "widget should be attached");
   vw->ed->suspend ();
@@ -372,6 +396,18 @@ detach_view (url u) {
   // cout << "View detached\n";
 }
 
+url
+window_to_view (url win) {
+  tm_view vw= (tm_view) window_view_table [win->t];
+  if (vw != NULL) return abstract_view (vw);
+  // views of embedded widgets are not attached in the usual way
+  array<url> vs= get_all_views ();
+  for (int i=0; i<N(vs); i++)
+    if (view_to_window (vs[i]) == win)
+      return vs[i];
+  return url_none ();
+}
+
 /******************************************************************************
 * Switching views
 ******************************************************************************/
@@ -99,16 +99,13 @@ new_window (bool map_flag= true, tree geom= "") {
 
 static bool
 delete_view_from_window (url win) {
-  array<url> vs= get_all_views ();
-  for (int i=0; i<N(vs); i++)
-    if (view_to_window (vs[i]) == win) {
-      detach_view (vs[i]);
-      // delete_view (vs[i]);
-      // Don't delete view alltogether, because at least one view is needed
-      // for making the 'buffer_modified' predicate function appropriately
-      return true;
-    }
-  return false;
+  url vw= window_to_view (win);
+  if (is_none (vw)) return false;
+  detach_view (vw);
+  // delete_view (vw);
+  // Don't delete view alltogether, because at least one view is needed
+  // for making the 'buffer_modified' predicate function appropriately
+  return true;
 }
 
 void
@@ -175,15 +172,6 @@ window_to_buffer (url win) {
   return view_to_buffer (window_to_view (win));
 }
 
-url
-window_to_view (url win) {
-  array<url> vs= get_all_views ();
-  for (int i=0; i<N(vs); i++)
-    if (view_to_window (vs[i]) == win)
-      return vs[i];
-  return url_none ();
-}
-
 void
 window_set_buffer (url win, url name) {
   url old= window_to_view (win);
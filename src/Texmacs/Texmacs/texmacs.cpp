@@ -63,8 +63,11 @@ extern bool texmacs_started;
 
 bool disable_error_recovery= false;
 bool start_server_flag= false;
+string batch_server_name;
+int batch_server_workers= 1;
 string extra_init_cmd;
 void server_start ();
+void batch_server_start (string name, int workers);
 
 /******************************************************************************
 * For testing
@@ -338,6 +341,19 @@ TeXmacs_main (int argc, char** argv) {
         if (i<argc) my_init_cmds= (my_init_cmds * " ") * argv[i];
       }
       else if (s == "-server") start_server_flag= true;
+      else if (s == "-daemon") {
+        i++;
+        if (i<argc) batch_server_name= argv[i];
+#ifdef QTTEXMACS
+        // batch conversions do not need a display
+        if (get_env ("QT_QPA_PLATFORM") == "")
+          set_env ("QT_QPA_PLATFORM", "offscreen");
+#endif
+      }
+      else if (s == "-workers") {
+        i++;
+        if (i<argc) batch_server_workers= max (as_int (string (argv[i])), 1);
+      }
       else if (s == "-log-file") i++;
       else if ((s == "-Oc") || (s == "-no-char-clipping")) char_clip= false;
       else if ((s == "+Oc") || (s == "-char-clipping")) char_clip= true;
@@ -368,6 +384,7 @@ TeXmacs_main (int argc, char** argv) {
         cout << "  -b [file]  Specify scheme buffers initialization file\n";
         cout << "  -c [i] [o] Convert file 'i' into file 'o'\n";
         cout << "  -d         For debugging purposes\n";
+        cout << "  -daemon [s] Serve batch conversions on the local socket 's'\n";
         cout << "  -fn [font] Set the default TeX font\n";
         cout << "  -g [geom]  Set geometry of window in pixels\n";
         cout << "  -h         Display this help message\n";
@@ -378,6 +395,7 @@ TeXmacs_main (int argc, char** argv) {
         cout << "  -s         Suppress information messages\n";
         cout << "  -S         Rerun TeXmacs setup program before starting\n";
         cout << "  -v         Display current TeXmacs version\n";
+        cout << "  -workers [n] Number of worker processes for -daemon\n";
         cout << "  -V         Show some informative messages\n";
         cout << "  -x [cmd]   Execute scheme command\n";
         cout << "  -Oc        TeX characters bitmap clipping off\n";
@@ -433,7 +451,13 @@ TeXmacs_main (int argc, char** argv) {
   init_mac_application ();
 #endif
     
-  gui_open (argc, argv);
+#ifdef X11TEXMACS
+  // conversion daemons do not need a display
+  bool headless= N(batch_server_name) > 0;
+#else
+  bool headless= false;
+#endif
+  if (!headless) gui_open (argc, argv);
   set_default_font (the_default_font);
   if (DEBUG_STD) debug_boot << "Starting server...\n";
   { // opening scope for server sv
@@ -466,6 +490,7 @@ TeXmacs_main (int argc, char** argv) {
              (s == "-g") || (s == "-geometry") ||
              (s == "-x") || (s == "-execute") ||
              (s == "-log-file") ||
+             (s == "-daemon") || (s == "-workers") ||
              (s == "-build-manual") ||
              (s == "-reference-suite") || (s == "-test-suite")) i++;
   }
@@ -483,15 +508,13 @@ TeXmacs_main (int argc, char** argv) {
     where= " :new-window";
     exec_delayed (scheme_cmd (cmd));
   }
-  if (number_buffers () == 0) {
+  if (number_buffers () == 0 && N(batch_server_name) == 0) {
     if (DEBUG_STD) debug_boot << "Creating 'no name' buffer...\n";
     open_window ();
   }
 
   bench_print ();
-  bench_reset ("initialize texmacs");
-  bench_reset ("initialize plugins");
-  bench_reset ("initialize scheme");
+  bench_reset ();
 
   if (DEBUG_STD) debug_boot << "Starting event loop...\n";
   texmacs_started= true;
@@ -499,13 +522,15 @@ TeXmacs_main (int argc, char** argv) {
   if (start_server_flag) server_start ();
   release_boot_lock ();
   if (N(extra_init_cmd) > 0) exec_delayed (scheme_cmd (extra_init_cmd));
-  gui_start_loop ();
+  if (N(batch_server_name) > 0)
+    batch_server_start (batch_server_name, batch_server_workers);
+  else gui_start_loop ();
 
   if (DEBUG_STD) debug_boot << "Stopping server...\n";
   } // ending scope for server sv
 
   if (DEBUG_STD) debug_boot << "Closing display...\n";
-  gui_close ();
+  if (!headless) gui_close ();
   
 #if defined(X11TEXMACS) && defined(MACOSX_EXTENSIONS)
   finalize_mac_application ();
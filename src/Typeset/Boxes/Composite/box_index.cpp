@@ -0,0 +1,200 @@
+
+/******************************************************************************
+* MODULE     : box_index.cpp
+* DESCRIPTION: Spatial index over the children of composite boxes
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* Boxes with many children (large tables, pictures, long stacks) are
+* equipped on demand with a bounding volume hierarchy over the extents
+* of their children: the children are recursively split at the median
+* of their centers along the widest direction, until at most
+* BOX_INDEX_LEAF children remain.  The index is built when the first
+* query is made and dropped whenever the children are moved.
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "Boxes/composite.hpp"
+#include "merge_sort.hpp"
+
+#define BOX_INDEX_LEAF 8
+
+/******************************************************************************
+* Construction
+******************************************************************************/
+
+box_index::box_index (box_rep* b): rep (tm_new<box_index_rep> (b)) {}
+
+box_index_rep::box_index_rep (box_rep* b) {
+  int i, n= b->subnr ();
+  order= array<int> (n);
+  for (i=0; i<n; i++) order[i]= i;
+  (void) build (b, 0, n);
+}
+
+int
+box_index_rep::build (box_rep* b, int lo, int hi) {
+  int i;
+  box_index_node nd;
+  nd.lo= lo; nd.hi= hi;
+  nd.left= nd.right= -1;
+  nd.first= MAX_SI;
+  nd.x1= nd.y1= nd.gx1= nd.gy1= MAX_SI;
+  nd.x2= nd.y2= nd.gx2= nd.gy2= -MAX_SI;
+  for (i=lo; i<hi; i++) {
+    int c= order[i];
+    nd.first= min (nd.first, c);
+    nd.x1 = min (nd.x1, b->sx1 (c));
+    nd.y1 = min (nd.y1, b->sy1 (c));
+    nd.x2 = max (nd.x2, b->sx2 (c));
+    nd.y2 = max (nd.y2, b->sy2 (c));
+    nd.gx1= min (nd.gx1, min (b->sx1 (c), b->sx3 (c)));
+    nd.gy1= min (nd.gy1, min (b->sy1 (c), b->sy3 (c)));
+    nd.gx2= max (nd.gx2, max (b->sx2 (c), b->sx4 (c)));
+    nd.gy2= max (nd.gy2, max (b->sy2 (c), b->sy4 (c)));
+  }
+  int k= N(nodes);
+  nodes << nd;
+  if (hi - lo > BOX_INDEX_LEAF) {
+    bool hor= ((DI) nd.x2 - (DI) nd.x1) >= ((DI) nd.y2 - (DI) nd.y1);
+    array<DI> keys (hi - lo);
+    for (i=lo; i<hi; i++) {
+      int c= order[i];
+      SI  m= (hor? (b->sx1 (c) >> 1) + (b->sx2 (c) >> 1):
+                   (b->sy1 (c) >> 1) + (b->sy2 (c) >> 1));
+      keys[i-lo]= ((DI) m) * 4294967296LL + ((DI) c);
+    }
+    merge_sort (keys);
+    for (i=lo; i<hi; i++)
+      order[i]= (int) (keys[i-lo] & 0xffffffff);
+    int mid= (lo + hi) >> 1;
+    int l= build (b, lo, mid);
+    int r= build (b, mid, hi);
+    nodes[k].left = l;
+    nodes[k].right= r;
+  }
+  return k;
+}
+
+/******************************************************************************
+* Queries
+******************************************************************************/
+
+static inline SI
+gap (SI x, SI a, SI b) {
+  if (x <= a) return a - x;
+  if (x >= b) return x - b;
+  return 0;
+}
+
+static inline SI
+lower_bound (box_index_node& nd, SI x, SI y) {
+  // box_rep::distance may be one less than the geometric distance
+  return gap (x, nd.x1, nd.x2) + gap (y, nd.y1, nd.y2) - 1;
+}
+
+void
+box_index_rep::nearest (box_rep* b, int k, SI x, SI y, SI delta, bool force,
+                        SI& d, int& m)
+{
+  // Same result as a linear scan for the first accessible child
+  // which minimizes box_rep::distance
+  box_index_node& nd= nodes[k];
+  SI lb= lower_bound (nd, x, y);
+  if (lb > d || (lb == d && nd.first > m)) return;
+  if (nd.left < 0) {
+    for (int i=nd.lo; i<nd.hi; i++) {
+      int c= order[i];
+      SI dc= b->distance (c, x, y, delta);
+      if (dc < d || (dc == d && c < m))
+        if (b->subbox (c)->accessible () || force) {
+          d= dc;
+          m= c;
+        }
+    }
+  }
+  else {
+    SI l1= lower_bound (nodes[nd.left], x, y);
+    SI l2= lower_bound (nodes[nd.right], x, y);
+    int k1= (l1 <= l2? nd.left: nd.right);
+    int k2= (l1 <= l2? nd.right: nd.left);
+    nearest (b, k1, x, y, delta, force, d, m);
+    nearest (b, k2, x, y, delta, force, d, m);
+  }
+}
+
+void
+box_index_rep::near (box_rep* b, int k, SI x, SI y, SI dist, array<int>& r) {
+  // children whose extents are at a distance at most dist from (x, y)
+  box_index_node& nd= nodes[k];
+  if (max (gap (x, nd.gx1, nd.gx2), gap (y, nd.gy1, nd.gy2)) > dist) return;
+  if (nd.left < 0) {
+    for (int i=nd.lo; i<nd.hi; i++) {
+      int c= order[i];
+      SI cx1= min (b->sx1 (c), b->sx3 (c)), cx2= max (b->sx2 (c), b->sx4 (c));
+      SI cy1= min (b->sy1 (c), b->sy3 (c)), cy2= max (b->sy2 (c), b->sy4 (c));
+      if (max (gap (x, cx1, cx2), gap (y, cy1, cy2)) <= dist) r << c;
+    }
+  }
+  else {
+    near (b, nd.left , x, y, dist, r);
+    near (b, nd.right, x, y, dist, r);
+  }
+}
+
+void
+box_index_rep::meeting (box_rep* b, int k, SI x1, SI y1, SI x2, SI y2,
+                        array<int>& r)
+{
+  // children whose extents meet the rectangle (x1, y1)--(x2, y2)
+  box_index_node& nd= nodes[k];
+  if (nd.gx2 < x1 || nd.gx1 > x2 || nd.gy2 < y1 || nd.gy1 > y2) return;
+  if (nd.left < 0) {
+    for (int i=nd.lo; i<nd.hi; i++) {
+      int c= order[i];
+      SI cx1= min (b->sx1 (c), b->sx3 (c)), cx2= max (b->sx2 (c), b->sx4 (c));
+      SI cy1= min (b->sy1 (c), b->sy3 (c)), cy2= max (b->sy2 (c), b->sy4 (c));
+      if (cx2 >= x1 && cx1 <= x2 && cy2 >= y1 && cy1 <= y2) r << c;
+    }
+  }
+  else {
+    meeting (b, nd.left , x1, y1, x2, y2, r);
+    meeting (b, nd.right, x1, y1, x2, y2, r);
+  }
+}
+
+/******************************************************************************
+* Interface for composite boxes
+******************************************************************************/
+
+box_index
+composite_box_rep::index () {
+  if (is_nil (idx)) idx= box_index (this);
+  return idx;
+}
+
+int
+composite_box_rep::nearest_child (SI x, SI y, SI delta, bool force) {
+  SI  d= MAX_SI;
+  int m= -1;
+  index () -> nearest (this, 0, x, y, delta, force, d, m);
+  return m;
+}
+
+array<int>
+composite_box_rep::children_near (SI x, SI y, SI dist) {
+  array<int> r;
+  index () -> near (this, 0, x, y, dist, r);
+  merge_sort (r);
+  return r;
+}
+
+array<int>
+composite_box_rep::children_meeting (SI x1, SI y1, SI x2, SI y2) {
+  array<int> r;
+  index () -> meeting (this, 0, x1, y1, x2, y2, r);
+  merge_sort (r);
+  return r;
+}
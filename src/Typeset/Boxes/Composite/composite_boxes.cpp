@@ -59,11 +59,13 @@ composite_box_rep::insert (box b, SI x, SI y) {
   bs << b;
   sx(n)= x;
   sy(n)= y;
+  idx= box_index ();
 }
 
 void
 composite_box_rep::position () {
   int i, n= subnr();
+  idx= box_index ();
   if (n == 0) {
     x1= y1= x3= y3= 0;
     x2= y2= x4= y4= 0;
@@ -91,6 +93,7 @@ composite_box_rep::left_justify () {
   SI d= x1;
   x1-=d; x2-=d; x3-=d; x4-=d;
   for (i=0; i<n; i++) sx(i) -= d;
+  idx= box_index ();
 }
 
 /******************************************************************************
@@ -202,6 +205,7 @@ int
 composite_box_rep::find_child (SI x, SI y, SI delta, bool force) {
   if (outside (x, delta, x1, x2) && (is_accessible (ip) || force)) return -1;
   int i, n= subnr(), d= MAX_SI, m= -1;
+  if (n >= BOX_INDEX_THRESHOLD) return nearest_child (x, y, delta, force);
   for (i=0; i<n; i++)
     if (distance (i, x, y, delta)< d)
       if (bs[i]->accessible () || force) {
@@ -349,8 +353,16 @@ composite_box_rep::graphical_select (SI x, SI y, SI dist) {
   gr_selections res;
   if (graphical_distance (x, y) <= dist) {
     int i, n= subnr();
-    for (i=n-1; i>=0; i--)
-      res << bs[i]->graphical_select (x- sx(i), y- sy(i), dist);
+    if (n >= BOX_INDEX_THRESHOLD) {
+      array<int> a= children_near (x, y, dist);
+      for (int k=N(a)-1; k>=0; k--) {
+        i= a[k];
+        res << bs[i]->graphical_select (x- sx(i), y- sy(i), dist);
+      }
+    }
+    else
+      for (i=n-1; i>=0; i--)
+        res << bs[i]->graphical_select (x- sx(i), y- sy(i), dist);
   }
   return res;
 }
@@ -360,9 +372,18 @@ composite_box_rep::graphical_select (SI x1, SI y1, SI x2, SI y2) {
   gr_selections res;
   if (contains_rectangle (x1, y1, x2, y2)) {
     int i, n= subnr();
-    for (i=n-1; i>=0; i--)
-      res << bs[i]->graphical_select (x1- sx(i), y1- sy(i),
-				      x2- sx(i), y2- sy(i));
+    if (n >= BOX_INDEX_THRESHOLD) {
+      array<int> a= children_meeting (x1, y1, x2, y2);
+      for (int k=N(a)-1; k>=0; k--) {
+        i= a[k];
+        res << bs[i]->graphical_select (x1- sx(i), y1- sy(i),
+                                        x2- sx(i), y2- sy(i));
+      }
+    }
+    else
+      for (i=n-1; i>=0; i--)
+        res << bs[i]->graphical_select (x1- sx(i), y1- sy(i),
+                                        x2- sx(i), y2- sy(i));
   }
   return res;
 }
@@ -377,6 +398,7 @@ concrete_composite_box_rep::find_child (SI x, SI y, SI delta, bool force) {
       outside (x, delta, x1, x2) &&
       (is_accessible (ip) || force)) return -1;
   int i, n= subnr(), d= MAX_SI, m= -1;
+  if (n >= BOX_INDEX_THRESHOLD) return nearest_child (x, y, delta, force);
   for (i=0; i<n; i++)
     if (distance (i, x, y, delta)< d)
       if (bs[i]->accessible () || force) {
@@ -14,6 +14,42 @@
 #include "boxes.hpp"
 #include "array.hpp"
 
+/******************************************************************************
+* Spatial index over the children of composite boxes
+******************************************************************************/
+
+#define BOX_INDEX_THRESHOLD 32
+
+struct box_index_node {
+  int lo, hi;              // range of children in the order array
+  int left, right;         // sub-nodes or -1 for leaves
+  int first;               // smallest child number inside the node
+  SI  x1, y1, x2, y2;      // logical extents of the children
+  SI  gx1, gy1, gx2, gy2;  // union of the logical and ink extents
+};
+
+class box_index;
+class box_index_rep: concrete_struct {
+public:
+  array<int> order;            // children, grouped by node
+  array<box_index_node> nodes; // node 0 is the root
+
+  box_index_rep (box_rep* b);
+  int  build (box_rep* b, int lo, int hi);
+  void nearest (box_rep* b, int k, SI x, SI y, SI delta, bool force,
+                SI& d, int& m);
+  void near (box_rep* b, int k, SI x, SI y, SI dist, array<int>& r);
+  void meeting (box_rep* b, int k, SI x1, SI y1, SI x2, SI y2,
+                array<int>& r);
+  friend class box_index;
+};
+
+class box_index {
+  CONCRETE_NULL(box_index);
+  box_index (box_rep* b);
+};
+CONCRETE_NULL_CODE(box_index);
+
 /******************************************************************************
 * Composite boxes
 ******************************************************************************/
@@ -21,6 +57,7 @@
 struct composite_box_rep: public box_rep {
   array<box> bs;  // the children
   path lip, rip;  // left-most and right-most inverse paths
+  box_index idx;  // lazily built index for large numbers of children
 
   composite_box_rep (path ip);
   composite_box_rep (path ip, array<box> bs);
@@ -37,6 +74,11 @@ struct composite_box_rep: public box_rep {
   box     subbox (int i);
   void    display (renderer ren);
 
+  box_index  index ();
+  int        nearest_child (SI x, SI y, SI delta, bool force);
+  array<int> children_near (SI x, SI y, SI dist);
+  array<int> children_meeting (SI x1, SI y1, SI x2, SI y2);
+
   virtual int             find_child (SI x, SI y, SI delta, bool force);
   virtual path            find_box_path (SI x, SI y, SI delta,
                                          bool force, bool & found);
@@ -0,0 +1,163 @@
+
+/******************************************************************************
+* MODULE     : parsetex_test.cpp
+* DESCRIPTION: Tests on the block by block parsing of LaTeX sources
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "convert.hpp"
+#include "Tex/convert_tex.hpp"
+#include "file.hpp"
+#include "tm_timer.hpp"
+#include "test_dir.hpp"
+
+static void
+init_latex () {
+  // the tests run without scheme, so the types of the standard
+  // commands are defined before they are looked up for the first time
+  static bool done= false;
+  if (done) return;
+  done= true;
+  const char* commands[]= {
+    "\\documentclass", "\\section", "\\emph", "\\mathbb" };
+  for (int i=0; i<4; i++) {
+    command_type  (commands[i])= "command";
+    command_arity (commands[i])= 1;
+  }
+  command_type  ("\\item")= "command";
+  command_arity ("\\item")= 0;
+  const char* envs[]= { "document", "itemize", "quote", "verbatim" };
+  for (int i=0; i<4; i++) {
+    string type= (i == 1? string ("list"): string ("environment"));
+    command_type  ("\\begin-" * string (envs[i]))= type;
+    command_type  ("\\end-" * string (envs[i]))= type;
+    command_arity ("\\begin-" * string (envs[i]))= 0;
+    command_arity ("\\end-" * string (envs[i]))= 0;
+  }
+  command_type ("\\<sup>")= "command";
+  command_arity ("\\<sup>")= 1;
+  // macros which are defined by the documents themselves
+  const char* defined[]= {
+    "\\def", "\\R", "\\foo", "\\bar", "\\x", "\\y" };
+  for (int i=0; i<6; i++) command_type (defined[i])= "undefined";
+}
+
+static url
+scratch_dir () {
+  url dir= test_dir () * "parsetex";
+  mkdir (dir);
+  return dir;
+}
+
+static string
+splice (string main, string name, string body) {
+  // the source with \input{name} replaced by the body of the file
+  string macro= "\\input{" * name * "}";
+  int i= search_forwards (macro, main);
+  if (i < 0) return main;
+  return main (0, i) * "\n" * body * "\n" * main (i + N(macro), N(main));
+}
+
+static void
+check_include (string main, string name, string body) {
+  init_latex ();
+  url dir= scratch_dir ();
+  ASSERT_FALSE (save_string (dir * (name * ".tex"), body, false));
+  set_file_focus (dir * "main.tex");
+  tree t1= parse_latex (main);
+  tree t2= parse_latex (splice (main, name, body));
+  set_file_focus (url_none ());
+  ASSERT_TRUE (t1 == t2);
+}
+
+static string
+latex_document (string body) {
+  return "\\documentclass{article}\n"
+         "\\newcommand{\\R}{\\mathbb{R}}\n"
+         "\\begin{document}\n" * body * "\n\\end{document}\n";
+}
+
+/******************************************************************************
+* Tests
+******************************************************************************/
+
+TEST (parsetex, blocks_across_files) {
+  // environments which span blocks and files
+  check_include (latex_document ("\\section{One}\n"
+                           "\\begin{itemize}\n"
+                           "\\input{items}\n"
+                           "\\end{itemize}\n"
+                           "\\section{Two}\nText $\\R$."),
+                 "items",
+                 "\\item first\n\\section{Inside}\n\\item second");
+  // verbatim material containing cut points
+  check_include (latex_document ("\\input{verb}\n\\section{After}\nText."),
+                 "verb",
+                 "\\begin{verbatim}\n\\section{Not a section}\n"
+                 "\\newcommand{\\x}{y}\n\\end{verbatim}\nafter");
+  // comments, also at the start and the end of included files
+  check_include (latex_document ("Text % comment \\input{other}\n"
+                           "\\input{comments}\n% \\section{Hidden}\n"
+                           "\\section{Visible}"),
+                 "comments",
+                 "% first line\n\\section{Commented} % here\n"
+                 "\\def\\y{z}\n\\y % last line");
+  // definitions in included files are used afterwards
+  check_include (latex_document ("\\input{defs}\n\\section{Use}\n\\foo{a}\\bar"),
+                 "defs",
+                 "\\newcommand{\\foo}[1]{[#1]}\n\\def\\bar{B}");
+  // nested includes
+  url dir= scratch_dir ();
+  ASSERT_FALSE (save_string (dir * "inner.tex",
+                             "\\section{Inner}\n\\begin{quote}\nq",
+                             false));
+  check_include (latex_document ("\\input{outer}\n\\end{quote}\n\\section{End}"),
+                 "outer",
+                 "\\section{Outer}\n\\input{inner}\nouter text");
+  set_file_focus (dir * "main.tex");
+  tree t= parse_latex (latex_document ("\\input{outer}\n\\end{quote}"));
+  set_file_focus (url_none ());
+  ASSERT_TRUE (t == parse_latex (latex_document ("\n\\section{Outer}\n"
+                                           "\n\\section{Inner}\n"
+                                           "\\begin{quote}\nq\n"
+                                           "\nouter text\n"
+                                           "\n\\end{quote}")));
+  system ("rm -rf", dir);
+}
+
+TEST (parsetex, long_include_chains) {
+  // a long document split into many chapters
+  init_latex ();
+  url dir= scratch_dir ();
+  string chapter;
+  for (int i=0; i<100; i++)
+    chapter << "\\section{Section}\nSome text with $x^2 + \\R$ and "
+            << "\\emph{emphasis}.\n\\begin{itemize}\n\\item one\n"
+            << "\\item two\n\\end{itemize}\n";
+  int nr= 20;
+  string main, spliced;
+  for (int i=0; i<nr; i++) {
+    string name= "chapter" * as_string (i);
+    ASSERT_FALSE (save_string (dir * (name * ".tex"), chapter, false));
+    main << "\\input{" << name << "}\n";
+    spliced << "\n" << chapter << "\n\n";
+  }
+  set_file_focus (dir * "main.tex");
+  bench_reset ("latex import");
+  int before= mem_held ();
+  tree t= parse_latex (latex_document (main));
+  int peak= bench_peak ("latex import");
+  set_file_focus (url_none ());
+  ASSERT_TRUE (t == parse_latex (latex_document (spliced)));
+  // the peak is sampled while parsing, also without DEBUG_BENCH,
+  // and the memory grows linearly with the size of the source
+  ASSERT_GT (peak, 0);
+  ASSERT_LT (peak - before, 256 * nr * N(chapter));
+  system ("rm -rf", dir);
+}
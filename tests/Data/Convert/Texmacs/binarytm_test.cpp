@@ -0,0 +1,114 @@
+
+/******************************************************************************
+* MODULE     : binarytm_test.cpp
+* DESCRIPTION: Tests on the binary serialization of trees
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "convert.hpp"
+#include "drd_std.hpp"
+#include "tm_timer.hpp"
+#include "Texmacs/binarytm.hpp"
+
+static tree
+sample_document (int n) {
+  tree body (DOCUMENT);
+  for (int i=0; i<n; i++)
+    body << tree (CONCAT, "Paragraph ", as_string (i), " with ",
+                  tree (WITH, "font-series", "bold", "some bold text"),
+                  " and ", tree (WITH, "mode", "math",
+                                 tree (FRAC, "x" * as_string (i % 10), "2")));
+  return tree (DOCUMENT,
+               compound ("TeXmacs", "1.99.12"),
+               compound ("style", tree (TUPLE, "generic")),
+               compound ("body", body));
+}
+
+TEST (binarytm, round_trip) {
+  init_std_drd ();
+  tree samples[]= {
+    tree (""), tree ("hello"), tree (CONCAT),
+    tree (CONCAT, "a", tree (WITH, "color", "red", "b"), "a"),
+    compound ("my-macro", "x", compound ("my-macro", "x")),
+    sample_document (20)
+  };
+  for (int i=0; i<6; i++) {
+    string s= tree_to_binary (samples[i]);
+    ASSERT_TRUE (is_binary_tree (s));
+    ASSERT_TRUE (binary_to_tree (s) == samples[i]);
+  }
+}
+
+TEST (binarytm, zero_bytes) {
+  init_std_drd ();
+  string s ("a");
+  s << '\0' << "b" << '\xff';
+  tree t (CONCAT, s, tree (ERROR, s));
+  ASSERT_TRUE (binary_to_tree (tree_to_binary (t)) == t);
+}
+
+TEST (binarytm, deduplication) {
+  tree t (CONCAT);
+  string long_atom= "a rather long string that occurs many times";
+  for (int i=0; i<100; i++) t << tree (long_atom);
+  string s= tree_to_binary (t);
+  ASSERT_LT (N(s), N(long_atom) + 300);
+  tree u= binary_to_tree (s);
+  ASSERT_TRUE (u == t);
+}
+
+TEST (binarytm, streaming) {
+  init_std_drd ();
+  tm_binary_writer w;
+  for (int i=0; i<10; i++) w.write (tree (TUPLE, "key", as_string (i)));
+  tm_binary_reader r (w.contents ());
+  int i= 0;
+  while (r.busy ()) {
+    ASSERT_TRUE (r.read () == tree (TUPLE, "key", as_string (i)));
+    i++;
+  }
+  ASSERT_FALSE (r.error);
+  ASSERT_EQ (i, 10);
+}
+
+TEST (binarytm, malformed) {
+  ASSERT_FALSE (is_binary_tree ("<TeXmacs|1.0>"));
+  ASSERT_TRUE (is_func (binary_to_tree ("<TeXmacs|1.0>"), ERROR));
+  string s= tree_to_binary (sample_document (5));
+  for (int i=4; i<N(s); i += 7)
+    ASSERT_TRUE (is_func (binary_to_tree (s (0, i)), ERROR));
+}
+
+TEST (binarytm, benchmark) {
+  init_std_drd ();
+  tree doc= sample_document (5000);
+  time_t t0= texmacs_time ();
+  string tm= tree_to_texmacs (doc);
+  time_t t1= texmacs_time ();
+  tree doc_tm= texmacs_to_tree (tm);
+  time_t t2= texmacs_time ();
+  string stm= tree_to_scheme (doc);
+  time_t t3= texmacs_time ();
+  tree doc_stm= scheme_to_tree (stm);
+  time_t t4= texmacs_time ();
+  string bin= tree_to_binary (doc);
+  time_t t5= texmacs_time ();
+  tree doc_bin= binary_to_tree (bin);
+  time_t t6= texmacs_time ();
+  ASSERT_TRUE (doc_bin == doc);
+  if (DEBUG_BENCH) {
+    cout << "texmacs: " << N(tm) << " bytes, write " << (t1-t0)
+         << " ms, read " << (t2-t1) << " ms\n";
+    cout << "scheme : " << N(stm) << " bytes, write " << (t3-t2)
+         << " ms, read " << (t4-t3) << " ms\n";
+    cout << "binary : " << N(bin) << " bytes, write " << (t5-t4)
+         << " ms, read " << (t6-t5) << " ms\n";
+  }
+  ASSERT_LT (N(bin), N(tm));
+}
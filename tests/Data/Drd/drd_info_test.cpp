@@ -0,0 +1,165 @@
+
+/******************************************************************************
+* MODULE     : drd_info_test.cpp
+* DESCRIPTION: Tests on flattened drd tables and cached heuristics
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "drd_std.hpp"
+#include "file.hpp"
+#include "sys_utils.hpp"
+#include "tm_timer.hpp"
+#include "test_dir.hpp"
+
+static hashmap<string,tree>
+style_environment (string prefix, int n) {
+  // short chains of macros, so that several rounds are needed
+  hashmap<string,tree> env (UNINIT);
+  for (int i=0; i<n; i++) {
+    string name= prefix * as_string (i);
+    tree body (CONCAT, tree (ARG, "x"),
+               tree (WITH, "font-series", "bold", tree (ARG, "y")));
+    if (i % 5 > 0) {
+      tree_label prev= make_tree_label (prefix * as_string (i-1));
+      body= tree (prev, tree (ARG, "y"), tree (ARG, "x"));
+    }
+    env (name)= tree (MACRO, "x", "y", body);
+    env (prefix * "-length-" * as_string (i))= "1cm";
+    env (prefix * "-flag-" * as_string (i))= "true";
+  }
+  return env;
+}
+
+static drd_info
+style_drd (hashmap<string,tree> env) {
+  init_std_drd ();
+  drd_info drd ("test", std_drd);
+  drd->heuristic_init (env);
+  return drd;
+}
+
+static array<tree>
+sample_trees (string prefix, int n) {
+  array<tree> r;
+  r << tree (WITH, "color", "red", "text")
+    << tree (CONCAT, "a", tree (FRAC, "1", "2"))
+    << tree (DOCUMENT, "x", "y")
+    << tree (EXTERN, "f", "x")
+    << tree (HLINK, "text", "url");
+  for (int i=0; i<n; i+=7)
+    r << tree (make_tree_label (prefix * as_string (i)), "a", "b");
+  return r;
+}
+
+TEST (drd_info, flattened_tables) {
+  hashmap<string,tree> env= style_environment ("flat", 100);
+  drd_info drd= style_drd (env);
+  array<tree> ts= sample_trees ("flat", 100);
+  for (int k=0; k<N(ts); k++) {
+    tree t= ts[k];
+    tree_label l= L(t);
+    ASSERT_TRUE (drd->get_info (l) == drd->info[l]);
+    for (int i=0; i<N(t); i++) {
+      int  type= drd->get_type_child (t, i);
+      bool acc = drd->is_accessible_child (t, i);
+      tree env1= drd->get_env_child (t, i, tree (ATTR));
+      // invalidate the table and compare with the chained lookups
+      drd_stamp++;
+      ASSERT_EQ (drd->get_type_child (t, i), type);
+      ASSERT_EQ (drd->is_accessible_child (t, i), acc);
+      ASSERT_TRUE (drd->get_env_child (t, i, tree (ATTR)) == env1);
+    }
+  }
+  // modifications are visible at once
+  drd->freeze_table ();
+  tree_label l= make_tree_label ("flat5");
+  drd->set_type (l, 0, TYPE_LENGTH);
+  ASSERT_EQ (drd->get_type (l, 0), TYPE_LENGTH);
+  drd_info sub ("sub", drd);
+  sub->freeze_table ();
+  drd->set_accessible (l, 1, ACCESSIBLE_NEVER);
+  ASSERT_EQ (sub->get_accessible (l, 1), ACCESSIBLE_NEVER);
+  tree_label fresh= make_tree_label ("flat-fresh-label");
+  ASSERT_EQ (sub->get_type (fresh), drd->info[fresh]->pi.type);
+}
+
+TEST (drd_info, heuristic_cache) {
+  // the cached drds are saved in the style cache of a scratch home
+  url home= test_dir () * "drd";
+  mkdir (home * "system" * "cache");
+  string old_home= get_env ("TEXMACS_HOME_PATH");
+  set_env ("TEXMACS_HOME_PATH", as_string (home));
+  drd_heuristic_cache (true);
+  hashmap<string,tree> env= style_environment ("cached", 200);
+  drd_info d1= style_drd (env);
+  drd_info d2= style_drd (env);
+  ASSERT_TRUE (d1->get_locals () == d2->get_locals ());
+  // results are read back from disk in a new session
+  drd_heuristic_cache (true);
+  drd_info d3= style_drd (env);
+  ASSERT_TRUE (d1->get_locals () == d3->get_locals ());
+  // a different environment gives different results
+  env ("cached3")= "3pt";
+  drd_info d4= style_drd (env);
+  ASSERT_NE (d4->get_type (make_tree_label ("cached3")),
+             d1->get_type (make_tree_label ("cached3")));
+  set_env ("TEXMACS_HOME_PATH", old_home);
+
+  // the memory used by the cache remains bounded
+  drd_heuristic_cache (false);
+  (void) style_drd (env);
+  int one= drd_heuristic_cache_size ();
+  ASSERT_GT (one, 0);
+  drd_heuristic_cache (false, one + one / 2);
+  for (int i=0; i<5; i++) {
+    env ("cached3")= as_string (i) * "pt";
+    (void) style_drd (env);
+    ASSERT_LE (drd_heuristic_cache_size (), one + one / 2);
+  }
+  env ("cached3")= "3pt";
+  ASSERT_TRUE (style_drd (env)->get_locals () == d4->get_locals ());
+  drd_heuristic_cache (false);
+}
+
+TEST (drd_info, benchmark) {
+  drd_heuristic_cache (false);
+  hashmap<string,tree> env= style_environment ("bench", 1500);
+  time_t t0= texmacs_time ();
+  drd_info drd= style_drd (env);
+  time_t t1= texmacs_time ();
+  drd_info again= style_drd (env);
+  time_t t2= texmacs_time ();
+  ASSERT_TRUE (again->get_locals () == drd->get_locals ());
+  if (DEBUG_BENCH)
+    cout << "style switch: " << (t1-t0) << " ms, cached "
+         << (t2-t1) << " ms\n";
+
+  array<tree> ts= sample_trees ("bench", 1500);
+  drd_info sub ("document", drd);
+  int nr= 200, check= 0;
+  time_t t3= texmacs_time ();
+  for (int k=0; k<nr; k++)
+    for (int j=0; j<N(ts); j++) {
+      drd_stamp++; // always use the chained lookups
+      check += sub->get_type_child (ts[j], 1);
+      check += sub->is_accessible_child (ts[j], 0);
+    }
+  time_t t4= texmacs_time ();
+  sub->freeze_table ();
+  for (int k=0; k<nr; k++)
+    for (int j=0; j<N(ts); j++) {
+      check -= sub->get_type_child (ts[j], 1);
+      check -= sub->is_accessible_child (ts[j], 0);
+    }
+  time_t t5= texmacs_time ();
+  ASSERT_EQ (check, 0);
+  if (DEBUG_BENCH)
+    cout << (2 * nr * N(ts)) << " lookups: chained " << (t4-t3)
+         << " ms, flattened " << (t5-t4) << " ms\n";
+}
@@ -0,0 +1,263 @@
+
+/******************************************************************************
+* MODULE     : archiver_test.cpp
+* DESCRIPTION: Tests on the compact storage of the undo/redo history
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "archiver.hpp"
+#include "drd_std.hpp"
+#include "tm_timer.hpp"
+
+extern tree the_et;
+
+static unsigned int seed= 4321;
+
+static int
+random_int (int n) {
+  seed= seed * 1103515245 + 12345;
+  return (int) ((seed >> 8) % ((unsigned int) n));
+}
+
+static void
+new_document () {
+  init_std_drd ();
+  the_et= tree (DOCUMENT, tree (DOCUMENT, "first paragraph", "second one"));
+  attach_ip (the_et, path ());
+}
+
+static void
+random_edit () {
+  tree doc= the_et[0];
+  int i= random_int (N(doc));
+  tree par= doc[i];
+  switch (random_int (8)) {
+  case 0:
+  case 1:
+  case 2:
+    if (is_atomic (par)) {
+      insert (path (0, i, random_int (N(par->label) + 1)),
+              tree ("typed " * as_string (random_int (100))));
+      break;
+    }
+  case 3:
+    if (is_atomic (par) && N(par->label) > 3) {
+      remove (path (0, i, random_int (N(par->label) - 3)), 3);
+      break;
+    }
+  case 4:
+    insert (path (0, i), tree (DOCUMENT, "inserted paragraph"));
+    break;
+  case 5:
+    if (is_atomic (par) && N(par->label) > 1) {
+      split (path (0, i, random_int (N(par->label))));
+      break;
+    }
+  case 6:
+    if (i+1 < N(doc) && is_atomic (par) && is_atomic (doc[i+1])) {
+      join (path (0, i));
+      break;
+    }
+  default:
+    if (N(doc) > 2 && random_int (2) == 0) remove (path (0, i), 1);
+    else assign (path (0, i),
+                 tree (CONCAT, "a ", tree (WITH, "color", "red", "b")));
+  }
+}
+
+static array<tree>
+edit_session (archiver arch, int nr) {
+  array<tree> states;
+  states << copy (the_et[0]);
+  for (int k=0; k<nr; k++) {
+    random_edit ();
+    arch->confirm ();
+    states << copy (the_et[0]);
+  }
+  return states;
+}
+
+static int
+text_size (tree t) {
+  if (is_atomic (t)) return N(t->label);
+  int r= 0;
+  for (int i=0; i<N(t); i++) r += text_size (t[i]);
+  return r;
+}
+
+TEST (archiver, encoded_patches) {
+  tree big (DOCUMENT, "some paragraph", tree (WITH, "color", "red", "text"));
+  for (int i=0; i<6; i++) big= tree (DOCUMENT, big, big, "x" * as_string (i));
+  patch p1 (mod_insert (path (0), 1, big), mod_remove (path (0), 1, 1));
+  patch p2 (mod_assign (path (0, 2), "abc"), mod_assign (path (0, 2), big));
+  patch p3 (mod_split (path (0, 1), 0, 3), mod_join (path (0, 1), 0));
+  patch p (1.5, patch (p1, patch (p2, p3)));
+  array<patch> a;
+  a << p << patch (2.5, true) << p3;
+  patch q (true, a);
+  ASSERT_TRUE (decode_patch (encode_patch (p)) == p);
+  ASSERT_TRUE (decode_patch (encode_patch (q)) == q);
+  // repeated subtrees are stored once
+  string s1= encode_patch (p1), s2= encode_patch (patch (p1, p2));
+  ASSERT_LT (N(s2), N(s1) + 50);
+  ASSERT_LT (N(s1), text_size (big));
+}
+
+TEST (archiver, undo_redo_round_trip) {
+  new_document ();
+  double author= new_author ();
+  set_author (author);
+  archiver arch (author, path (0));
+  int nr= 200;
+  array<tree> states= edit_session (arch, nr);
+  ASSERT_EQ (arch->history_steps (), nr);
+  ASSERT_GT (arch->history_memory (), 0);
+  for (int k=nr; k>0; k--) {
+    ASSERT_TRUE (the_et[0] == states[k]);
+    (void) arch->undo ();
+  }
+  ASSERT_TRUE (the_et[0] == states[0]);
+  ASSERT_EQ (arch->undo_possibilities (), 0);
+  for (int k=0; k<nr; k++) {
+    ASSERT_EQ (arch->redo_possibilities (), 1);
+    (void) arch->redo ();
+    ASSERT_TRUE (the_et[0] == states[k+1]);
+  }
+  ASSERT_EQ (arch->history_steps (), nr);
+}
+
+TEST (archiver, branches) {
+  new_document ();
+  double author= new_author ();
+  set_author (author);
+  archiver arch (author, path (0));
+  int nr= 200;
+  array<tree> states= edit_session (arch, nr);
+  // undo half of the way and make a new change in another branch
+  for (int k=0; k<nr/2; k++) (void) arch->undo ();
+  ASSERT_TRUE (the_et[0] == states[nr/2]);
+  random_edit ();
+  arch->confirm ();
+  (void) arch->undo ();
+  ASSERT_TRUE (the_et[0] == states[nr/2]);
+  ASSERT_EQ (arch->redo_possibilities (), 2);
+  for (int k=nr/2; k>0; k--) {
+    ASSERT_TRUE (the_et[0] == states[k]);
+    (void) arch->undo ();
+  }
+  ASSERT_TRUE (the_et[0] == states[0]);
+}
+
+TEST (archiver, pending_autosaves) {
+  new_document ();
+  double author= new_author ();
+  set_author (author);
+  archiver arch (author, path (0));
+  (void) edit_session (arch, 5);
+  ASSERT_FALSE (arch->conform_autosave ());
+  // an autosave only counts once it has been confirmed
+  arch->prepare_autosave ();
+  ASSERT_FALSE (arch->conform_autosave ());
+  arch->confirm_autosave ();
+  ASSERT_TRUE (arch->conform_autosave ());
+  // changes during the autosave are not considered as being autosaved
+  (void) edit_session (arch, 1);
+  arch->prepare_autosave ();
+  (void) edit_session (arch, 1);
+  arch->confirm_autosave ();
+  ASSERT_FALSE (arch->conform_autosave ());
+  (void) arch->undo ();
+  ASSERT_TRUE (arch->conform_autosave ());
+  // neither are new branches at the same depth
+  arch->prepare_autosave ();
+  (void) arch->undo ();
+  (void) edit_session (arch, 1);
+  arch->confirm_autosave ();
+  ASSERT_FALSE (arch->conform_autosave ());
+}
+
+TEST (archiver, limits) {
+  new_document ();
+  double author= new_author ();
+  set_author (author);
+  archiver arch (author, path (0));
+  arch->set_limits (50, 1 << 30);
+  int nr= 300;
+  array<tree> states= edit_session (arch, nr);
+  int steps= arch->history_steps ();
+  ASSERT_LE (steps, 50);
+  ASSERT_EQ (steps + arch->evicted_steps (), nr);
+  for (int k=0; k<steps; k++) (void) arch->undo ();
+  ASSERT_EQ (arch->undo_possibilities (), 0);
+  ASSERT_TRUE (the_et[0] == states[nr - steps]);
+  for (int k=0; k<steps; k++) (void) arch->redo ();
+  ASSERT_TRUE (the_et[0] == states[nr]);
+
+  // memory limits discard encoded parts of the history first,
+  // and then the oldest live undo steps, except for the last one
+  int cap= 8192;
+  arch->set_limits (-1, cap);
+  nr= 4 * HISTORY_LIVE_STEPS;
+  states= edit_session (arch, nr);
+  steps= arch->history_steps ();
+  ASSERT_LE (arch->history_memory (), cap);
+  ASSERT_GT (steps, 1);
+  ASSERT_LT (steps, nr);
+  for (int k=0; k<steps; k++) (void) arch->undo ();
+  ASSERT_EQ (arch->undo_possibilities (), 0);
+  ASSERT_TRUE (the_et[0] == states[nr - steps]);
+  for (int k=0; k<steps; k++) (void) arch->redo ();
+  ASSERT_TRUE (the_et[0] == states[nr]);
+  arch->set_limits (-1, 0);
+  ASSERT_EQ (arch->history_steps (), 1);
+  (void) edit_session (arch, 2 * HISTORY_LIVE_STEPS + 10);
+  ASSERT_EQ (arch->history_steps (), 1);
+
+  // open markers and the history below them are never discarded
+  arch->set_limits (-1, 1 << 30);
+  (void) edit_session (arch, 5);
+  double m1= new_marker (), m2= new_marker ();
+  arch->mark_start (m1);
+  (void) edit_session (arch, 3);
+  arch->set_limits (1, 1 << 30);
+  arch->mark_start (m2);
+  (void) edit_session (arch, 3 * HISTORY_LIVE_STEPS);
+  arch->set_limits (1, 0);
+  ASSERT_GT (arch->history_steps (), 3 * HISTORY_LIVE_STEPS);
+  arch->mark_end (m2);
+  arch->mark_end (m1);
+  ASSERT_EQ (arch->history_steps (), 1);
+  tree before= copy (the_et[0]);
+  arch->mark_start (m1);
+  (void) edit_session (arch, 3);
+  arch->set_limits (1, 0);
+  ASSERT_TRUE (arch->mark_cancel (m1));
+  ASSERT_TRUE (the_et[0] == before);
+}
+
+TEST (archiver, benchmark) {
+  new_document ();
+  double author= new_author ();
+  set_author (author);
+  archiver arch (author, path (0));
+  int nr= 2000;
+  time_t t0= texmacs_time ();
+  array<tree> states= edit_session (arch, nr);
+  time_t t1= texmacs_time ();
+  int bytes= arch->history_memory ();
+  for (int k=0; k<nr; k++) (void) arch->undo ();
+  time_t t2= texmacs_time ();
+  ASSERT_TRUE (the_et[0] == states[0]);
+  ASSERT_EQ (arch->undo_possibilities (), 0);
+  ASSERT_GT (bytes, 0);
+  if (DEBUG_BENCH)
+    cout << nr << " steps: edits " << (t1-t0) << " ms, "
+         << "undo " << (t2-t1) << " ms, "
+         << bytes << " bytes of history\n";
+}
@@ -0,0 +1,95 @@
+
+/******************************************************************************
+* MODULE     : link_test.cpp
+* DESCRIPTION: Tests on the repositories of loci and links
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "link.hpp"
+#include "modification.hpp"
+#include "tm_timer.hpp"
+
+static tree
+region (int n) {
+  tree t (DOCUMENT);
+  for (int i=0; i<n; i++)
+    t << tree (CONCAT, "paragraph " * as_string (i), tree (CONCAT, "x"));
+  return t;
+}
+
+static tree
+reference (string id, string target) {
+  return compound ("link", "reference",
+                   compound ("id", id), compound ("id", target));
+}
+
+static void
+insert_region (link_repository lns, tree t, string prefix) {
+  // each paragraph is a locus which refers to a common label
+  for (int i=0; i<N(t); i++) {
+    string id= prefix * as_string (i);
+    lns->insert_locus (id, t[i]);
+    lns->insert_locus ("label", t[i][1]);
+    lns->insert_link (soft_link (reference (id, "label")));
+  }
+}
+
+TEST (link, navigation) {
+  tree t= region (20);
+  link_repository lns1 (true);
+  link_repository lns2 (true);
+  insert_region (lns1, t (0, 10), "a");
+  insert_region (lns2, t (10, 20), "b");
+  ASSERT_TRUE (get_trees ("a3") == list<tree> (t[3]));
+  ASSERT_TRUE (get_ids (t[12]) == list<string> ("b2"));
+  ASSERT_EQ (N (get_trees ("label")), 20);
+  ASSERT_TRUE (get_trees ("label")->item == t[0][1]);
+  list<tree> lns= get_links (compound ("id", "label"));
+  ASSERT_EQ (N (lns), 20);
+  ASSERT_TRUE (lns->item == reference ("a0", "label"));
+  ASSERT_TRUE (get_links (compound ("id", "b5")) ==
+               list<tree> (reference ("b5", "label")));
+  ASSERT_TRUE (contains (all_link_types (), string ("reference")));
+
+  // removing one repository leaves the occurrences of the other one in order
+  lns1= link_repository ();
+  ASSERT_TRUE (is_nil (get_trees ("a3")));
+  ASSERT_TRUE (is_nil (get_ids (t[3])));
+  ASSERT_TRUE (get_trees ("b4") == list<tree> (t[14]));
+  list<tree> l= get_trees ("label");
+  ASSERT_EQ (N (l), 10);
+  for (int i=0; i<10; i++, l= l->next)
+    ASSERT_TRUE (l->item == t[10+i][1]);
+  ASSERT_EQ (N (get_links (compound ("id", "label"))), 10);
+  ASSERT_TRUE (is_nil (get_links (compound ("id", "a5"))));
+
+  lns2= link_repository ();
+  ASSERT_TRUE (is_nil (get_trees ("label")));
+  ASSERT_TRUE (is_nil (get_links (compound ("id", "label"))));
+  ASSERT_FALSE (contains (all_link_types (), string ("reference")));
+}
+
+TEST (link, benchmark) {
+  // insertion and deletion of large regions with references to one label
+  int n= 5000;
+  tree t= region (2 * n);
+  link_repository keep (true);
+  insert_region (keep, t (n, 2 * n), "keep");
+  time_t t0= texmacs_time ();
+  link_repository lns (true);
+  insert_region (lns, t (0, n), "id");
+  time_t t1= texmacs_time ();
+  lns= link_repository ();
+  time_t t2= texmacs_time ();
+  ASSERT_EQ (N (get_trees ("label")), n);
+  ASSERT_EQ (N (get_links (compound ("id", "label"))), n);
+  if (DEBUG_BENCH)
+    cout << n << " loci and links: insertion " << (t1-t0)
+         << " ms, deletion " << (t2-t1) << " ms\n";
+}
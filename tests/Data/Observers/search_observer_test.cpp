@@ -0,0 +1,149 @@
+
+/******************************************************************************
+* MODULE     : search_observer_test.cpp
+* DESCRIPTION: Tests on incrementally maintained search indices
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "modification.hpp"
+#include "drd_std.hpp"
+#include "tree_search.hpp"
+#include "boot.hpp"
+
+extern tree the_et;
+
+static array<path>
+candidates (string what) {
+  array<path> a;
+  (void) search_index_candidates (the_et[0], what, a);
+  return a;
+}
+
+static array<path>
+paths (path p1) {
+  array<path> a;
+  a << p1;
+  return a;
+}
+
+static array<path>
+paths (path p1, path p2) {
+  array<path> a;
+  a << p1 << p2;
+  return a;
+}
+
+TEST (search_observer, incremental_updates) {
+  init_std_drd ();
+  the_et= tree (DOCUMENT,
+                tree (DOCUMENT, "hello world",
+                      tree (CONCAT, "foo ",
+                            tree (WITH, "color", "red", "barbaz"))));
+  attach_ip (the_et, path ());
+  attach_search_index (the_et[0]);
+  ASSERT_TRUE (has_search_index (the_et[0]));
+  ASSERT_TRUE (candidates ("World") == paths (path (0)));
+  ASSERT_TRUE (candidates ("bar") == paths (path (1, 1, 2)));
+  ASSERT_EQ (N (candidates ("zzz")), 0);
+
+  insert (path (0, 0, 11), tree (" zzz"));
+  ASSERT_TRUE (candidates ("zzz") == paths (path (0)));
+  remove (path (0, 0, 0), 6);
+  ASSERT_EQ (N (candidates ("hello")), 0);
+
+  insert (path (0, 1), tree (DOCUMENT, "new paragraph zzz"));
+  ASSERT_TRUE (candidates ("zzz") == paths (path (0), path (1)));
+  ASSERT_TRUE (candidates ("bar") == paths (path (2, 1, 2)));
+
+  split (path (0, 0, 3));
+  ASSERT_TRUE (candidates ("ld zz") == paths (path (1)));
+  join (path (0, 0));
+  ASSERT_TRUE (candidates ("world") == paths (path (0)));
+
+  assign (path (0, 2, 1, 2), tree ("quux"));
+  ASSERT_EQ (N (candidates ("bar")), 0);
+  ASSERT_TRUE (candidates ("quux") == paths (path (2, 1, 2)));
+
+  insert_node (path (0, 0, 0), tree (CONCAT));
+  ASSERT_TRUE (candidates ("world") == paths (path (0, 0)));
+  remove_node (path (0, 0, 0));
+  ASSERT_TRUE (candidates ("world") == paths (path (0)));
+
+  assign (path (0), tree (DOCUMENT, "brand new"));
+  ASSERT_TRUE (candidates ("new") == paths (path (0)));
+  ASSERT_EQ (N (candidates ("world")), 0);
+}
+
+TEST (search_observer, short_queries) {
+  init_std_drd ();
+  the_et= tree (DOCUMENT, tree (DOCUMENT, "abc"));
+  attach_ip (the_et, path ());
+  attach_search_index (the_et[0]);
+  array<path> a;
+  ASSERT_FALSE (search_index_candidates (the_et[0], "ab", a));
+  ASSERT_TRUE (search_index_candidates (the_et[0], "abc", a));
+  detach_search_index (the_et[0]);
+  ASSERT_FALSE (has_search_index (the_et[0]));
+}
+
+static tree
+search_document () {
+  tree doc (DOCUMENT);
+  for (int i=0; i<60; i++) {
+    string s= "Paragraph " * as_string (i) * " about the Needle ";
+    if (i % 3 == 0) s << "and another needle";
+    if (i % 5 == 0)
+      doc << tree (CONCAT, "prefix nee", tree (WITH, "color", "red", s));
+    else if (i % 7 == 0)
+      doc << tree (CONCAT, "visible ", tree (HIDDEN, s));
+    else doc << tree (s);
+  }
+  return doc;
+}
+
+static void
+check_same_results (string what, path pos) {
+  tree plain= copy (the_et[0]);
+  range_set r1= search (the_et[0], what, path (0), pos, 1000);
+  range_set r2= search (plain, what, path (0), pos, 1000);
+  ASSERT_TRUE (has_search_index (the_et[0]));
+  ASSERT_FALSE (has_search_index (plain));
+  ASSERT_TRUE (r1 == r2);
+  ASSERT_TRUE (search (the_et[0], what, path (0)) ==
+               search (plain, what, path (0)));
+}
+
+TEST (search_observer, same_results) {
+  init_std_drd ();
+  the_et= tree (DOCUMENT, search_document ());
+  attach_ip (the_et, path ());
+  // only buffers are indexed; the editor is not notified of the edits below
+  observer ed= edit_observer (NULL);
+  attach_observer (the_et[0], ed);
+  // searches without a cursor position do not create an index
+  (void) search (the_et[0], "needle", path (0));
+  ASSERT_FALSE (has_search_index (the_et[0]));
+  check_same_results ("needle", path ());
+  check_same_results ("Needle", path (17, 0));
+  check_same_results ("graph 4", path (40, 1, 2, 3));
+  check_same_results ("nothing", path ());
+  detach_observer (the_et[0], ed);
+  insert (path (0, 8, 0), tree ("needle "));
+  remove (path (0, 20), 5);
+  attach_observer (the_et[0], ed);
+  check_same_results ("needle", path (10, 0));
+  set_user_preference ("case-insensitive-match", "on");
+  check_same_results ("NEEDLE", path ());
+  reset_user_preference ("case-insensitive-match");
+  // 20 paragraphs with 'needle', minus two removed ones, plus one insertion
+  ASSERT_EQ (N (search (the_et[0], "needle", path (0))), 2 * 19);
+  // the index is dropped when the search ends
+  search_done (the_et[0]);
+  ASSERT_FALSE (has_search_index (the_et[0]));
+}
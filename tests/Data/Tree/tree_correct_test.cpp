@@ -0,0 +1,226 @@
+
+/******************************************************************************
+* MODULE     : tree_correct_test.cpp
+* DESCRIPTION: Tests on the fused correction of mathematical formulas
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "tree_correct.hpp"
+#include "packrat.hpp"
+#include "packrat_parser.hpp"
+#include "vars.hpp"
+#include "tm_timer.hpp"
+
+packrat_grammar make_packrat_grammar (string s);
+
+static void
+define_class (string cl, string type, string members) {
+  // members are separated by spaces
+  tree t (compound ("or"));
+  int start= 0;
+  for (int i=0; i<=N(members); i++)
+    if (i == N(members) || members[i] == ' ') {
+      if (i > start) t << tree (members (start, i));
+      start= i+1;
+    }
+  packrat_define ("std-math", cl, t);
+  packrat_property ("std-math", cl, "type", type);
+}
+
+static void
+init_math () {
+  // the tests run without scheme, so we define a small part of the
+  // grammar for mathematics before it is used for the first time
+  static bool done= false;
+  if (done) return;
+  done= true;
+  init_std_drd ();
+  // fragments are corrected using the current drd once a style is loaded
+  the_drd->set_syntax (make_tree_label ("theorem"),
+                       tree (MACRO, "body", tree (ARG, "body")));
+  (void) make_packrat_grammar ("std-math");
+  define_class ("Plus-visible-symbol", "prefix-infix", "+ - <minus>");
+  define_class ("Times-visible-symbol", "infix", "<cdot> <times>");
+  define_class ("Times-invisible-symbol", "infix", "*");
+  define_class ("Relation-symbol", "infix", "= <less> <leq> <neq> <in> <nin>");
+  define_class ("Ponctuation-visible-symbol", "separator", ", ; :");
+  define_class ("Open-symbol", "opening-bracket", "( [");
+  define_class ("Close-symbol", "closing-bracket", ") ]");
+  define_class ("Letter-symbol", "symbol", "<alpha> <beta> <pi>");
+  define_class ("Unary-operator-textual-symbol", "unary", "sin cos log");
+  define_class ("Binary-operator-symbol", "binary", "mod");
+  define_class ("Other-postfix-symbol", "postfix", "!");
+  define_class ("Not-symbol", "prefix", "<neg>");
+}
+
+static tree
+math (tree t) {
+  return tree (WITH, MODE, "math", t);
+}
+
+static tree
+sequential_correct (tree t, int flags) {
+  // the corrections as they used to be applied
+  if ((flags & MATH_CORRECT_SUPERFLUOUS) != 0)
+    t= superfluous_invisible_correct (t);
+  if ((flags & MATH_CORRECT_HOMOGLYPH) != 0)
+    t= homoglyph_correct (t);
+  if ((flags & MATH_CORRECT_SUPERFLUOUS) != 0)
+    t= superfluous_invisible_correct (t);
+  if ((flags & MATH_CORRECT_MISSING) != 0)
+    t= missing_invisible_correct_twice (t);
+  if ((flags & MATH_CORRECT_ZEALOUS) != 0)
+    t= missing_invisible_correct (t, 1);
+  return t;
+}
+
+/******************************************************************************
+* Random formulas
+******************************************************************************/
+
+static unsigned int seed= 1;
+
+static int
+random (int n) {
+  seed= seed * 1103515245 + 12345;
+  return (int) ((seed >> 16) % ((unsigned int) n));
+}
+
+static const char* tokens[]= {
+  "a", "b", "x", "y", "2", "3", "ab", "+", "-", "<minus>", "*", " ", "=",
+  ",", ":", "(", ")", "<alpha>", "<pi>", "sin", "mod", "\\", "<backslash>",
+  "<cdot>", "!", "<neq>", "<in>", "<ldots>" };
+
+static tree
+random_formula (int depth) {
+  tree r (CONCAT);
+  int n= 1 + random (6);
+  for (int i=0; i<n; i++) {
+    int k= (depth > 0? random (16): 0);
+    if (k < 9) {
+      string s;
+      int m= 1 + random (3);
+      for (int j=0; j<m; j++)
+        s << string (tokens[random (sizeof (tokens) / sizeof (char*))]);
+      r << tree (s);
+    }
+    else if (k == 9)
+      r << tree (FRAC, random_formula (depth-1), random_formula (depth-1));
+    else if (k == 10)
+      r << (random (2) == 0? tree (SQRT, random_formula (depth-1)):
+                             tree (SQRT, random_formula (depth-1), ""));
+    else if (k == 11)
+      r << tree (random (2) == 0? RSUB: RSUP,
+                 random (3) == 0? tree (""): random_formula (depth-1));
+    else if (k == 12)
+      r << tree (NEG, random (2) == 0? tree ("="): tree ("<in>"));
+    else if (k == 13)
+      r << tree (AROUND, "(", random_formula (depth-1), ")");
+    else if (k == 14)
+      r << tree (WITH, "color", "red", random_formula (depth-1));
+    else
+      r << tree (INACTIVE, tree (RIGID, random_formula (depth-1)));
+  }
+  return r;
+}
+
+static tree
+random_document (int n) {
+  tree doc (DOCUMENT);
+  for (int i=0; i<n; i++) {
+    int k= random (5);
+    if (k == 0)
+      doc << tree (CONCAT, "text ", math (random_formula (2)), ".");
+    else if (k == 1)
+      doc << tree (CONCAT, " ", compound ("hide-preamble", "x"), "  ");
+    else if (k == 2)
+      doc << tree (INACTIVE, tree (RIGID, math (random_formula (2))));
+    else if (k == 3)
+      doc << tree (CONCAT, math (random_formula (2)), " and ",
+                   tree (WITH, "font-shape", "italic",
+                         math (random_formula (2))));
+    else doc << tree (CONCAT, "some plain text");
+  }
+  return doc;
+}
+
+/******************************************************************************
+* Tests
+******************************************************************************/
+
+TEST (tree_correct, equivalence) {
+  init_math ();
+  array<tree> docs;
+  docs << tree (DOCUMENT, math ("a<minus>b"))
+       << tree (DOCUMENT, math (tree (CONCAT, "x", tree (NEG, "="), "y")))
+       << tree (DOCUMENT, math ("a := b \\ c"))
+       << tree (DOCUMENT, math ("2 x + 3 * y"))
+       << tree (DOCUMENT, math (tree (CONCAT, "a ", tree (RSUB, ""), "*b")))
+       << tree (DOCUMENT, math (tree (CONCAT, "2", tree (SQRT, "x", ""), "y")))
+       << tree (DOCUMENT, math ("sin x + ab y + ab*y"))
+       << tree (DOCUMENT, math (tree (CONCAT, "x",
+                                      tree (AROUND, "(", "a+b", ")"))))
+       << tree (DOCUMENT, tree (CONCAT, " ", compound ("show-preamble", "")))
+       << tree (DOCUMENT, tree (INACTIVE, tree (RIGID, math ("a<minus>b"))));
+  for (int i=0; i<12; i++) docs << random_document (6);
+  for (int i=0; i<N(docs); i++)
+    for (int flags=0; flags<=MATH_CORRECT_ALL; flags++)
+      ASSERT_TRUE (math_correct (docs[i], flags) ==
+                   sequential_correct (docs[i], flags))
+        << "document " << i << ", flags " << flags << "\n";
+  ASSERT_TRUE (math_correct (docs[0]) == tree (DOCUMENT, math ("a-b")));
+}
+
+TEST (tree_correct, reuse) {
+  init_math ();
+  tree doc (DOCUMENT);
+  for (int i=0; i<20; i++)
+    doc << tree (CONCAT, "paragraph " * as_string (i), math ("a+b"));
+  doc << tree (CONCAT, "changed ", math ("a<minus>b"));
+  tree r= math_correct (doc);
+  ASSERT_TRUE (r == sequential_correct (doc, MATH_CORRECT_ALL));
+  ASSERT_FALSE (strong_equal (r, doc));
+  for (int i=0; i<20; i++)
+    ASSERT_TRUE (strong_equal (r[i], doc[i]));
+  ASSERT_FALSE (strong_equal (r[20], doc[20]));
+  ASSERT_TRUE (strong_equal (r[20][0], doc[20][0]));
+  // nothing is rebuilt if nothing needs to be corrected
+  tree u= doc (0, 20);
+  ASSERT_TRUE (strong_equal (math_correct (u), u));
+  ASSERT_TRUE (strong_equal (with_correct (u), u));
+  ASSERT_TRUE (strong_equal (superfluous_with_correct (u), u));
+  ASSERT_TRUE (strong_equal (superfluous_invisible_correct (u), u));
+  ASSERT_TRUE (strong_equal (homoglyph_correct (u), u));
+}
+
+TEST (tree_correct, benchmark) {
+  // correction of a large document with many formulas, most of which
+  // are short and occur several times, as in typical articles
+  init_math ();
+  seed= 1;
+  array<tree> common;
+  for (int i=0; i<50; i++) common << math (random_formula (1));
+  tree doc (DOCUMENT);
+  for (int i=0; i<500; i++)
+    if (i % 10 == 0) doc << tree (CONCAT, "text ", math (random_formula (2)));
+    else doc << tree (CONCAT, "text ", common[random (50)], " text ",
+                      common[random (50)], ".");
+  time_t t0= texmacs_time ();
+  tree r1= sequential_correct (doc, MATH_CORRECT_ALL);
+  time_t t1= texmacs_time ();
+  tree r2= math_correct (doc, MATH_CORRECT_ALL);
+  time_t t2= texmacs_time ();
+  tree r3= math_correct (r2, MATH_CORRECT_ALL);
+  time_t t3= texmacs_time ();
+  ASSERT_TRUE (r1 == r2);
+  if (DEBUG_BENCH)
+    cout << N(doc) << " paragraphs: sequential " << (t1-t0)
+         << " ms, fused " << (t2-t1) << " ms, corrected again "
+         << (t3-t2) << " ms\n";
+}
@@ -0,0 +1,261 @@
+
+/******************************************************************************
+* MODULE     : glyph_words_test.cpp
+* DESCRIPTION: Tests on the word-parallel glyph routines
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "bitmap_font.hpp"
+#include "renderer.hpp"
+#include "tm_timer.hpp"
+#include <math.h>
+
+glyph shrink (glyph gl, int xf, int yf, int dx, int dy, int tx, int ty,
+              SI& xo, SI& yo);
+int count_row_pixels (glyph g, int y);
+int count_row_changes (glyph g, int y);
+
+/******************************************************************************
+* The pixel by pixel versions of the routines
+******************************************************************************/
+
+static int
+ref_div (int a, int b) {
+  if (a>=0) return a/b;
+  else return -((b-1-a)/b);
+}
+
+static glyph
+ref_shrink (glyph gl, int xfactor, int yfactor,
+            int dx, int dy, int tx, int ty, SI& xo, SI& yo) {
+  int x1= dx- gl->xoff;
+  int x2= dx- gl->xoff+ gl->width+ tx;
+  int X1= ref_div (x1, xfactor);
+  int X2= ref_div (x2+xfactor-1, xfactor);
+  int y1= dy+ gl->yoff+ 1- gl->height;
+  int y2= dy+ gl->yoff+ 1+ ty;
+  int Y1= ref_div (y1, yfactor);
+  int Y2= ref_div (y2+yfactor-1, yfactor);
+  int frac_x= (dx- gl->xoff- X1*xfactor);
+  int frac_y= (dy+ gl->yoff- Y1*yfactor);
+  xo= (((-X1) *xfactor+ dx)*PIXEL + ((tx*PIXEL)>>1))/xfactor;
+  yo= (((Y2-1)*yfactor- dy)*PIXEL - ((ty*PIXEL)>>1))/yfactor;
+
+  int i, j, x, y, index, indey, entry;
+  int ww=(X2-X1)*xfactor, hh=(Y2-Y1)*yfactor;
+  int* bitmap= tm_new_array<int> (ww*hh);
+  for (i=0; i<ww*hh; i++) bitmap[i]=0;
+  for (y=0, index= ww*frac_y+ frac_x; y<gl->height; y++, index-=ww)
+    for (x=0; x<gl->width; x++)
+      if (gl->get_x (x, y))
+        for (j=0, indey=ww*ty; j<=ty; j++, indey-=ww) {
+          entry = index+indey+x;
+          for (i=0; i<=tx; i++, entry++)
+            bitmap[entry]= 1;
+        }
+
+  int X, Y, sum, nr= xfactor*yfactor, new_depth= 1;
+  while ((1 << (new_depth - 1)) < nr) new_depth++;
+  glyph CB (X2-X1, Y2-Y1, -X1, Y2-1, min (new_depth, 8), gl->status);
+  for (Y=Y1; Y<Y2; Y++)
+    for (X=X1; X<X2; X++) {
+      sum=0;
+      indey= ((Y-Y1)*ww+ (X-X1))*xfactor;
+      for (j=0, index= indey; j<yfactor; j++, index+=ww)
+        for (i=0; i<xfactor; i++)
+          sum += bitmap[index+ i];
+      if (nr >= 64) sum= (64 * sum) / nr;
+      CB->set (X, Y, sum);
+    }
+  tm_delete_array (bitmap);
+  return CB;
+}
+
+static glyph
+ref_slanted (glyph gl, double slant) {
+  int i, j;
+  int ww= gl->width, hh= gl->height;
+  int t= gl->yoff, b= (hh-1) - gl->yoff;
+  int l= (int) ceil (slant * b), r= (int) ceil (slant * t);
+  if (slant < 0) {
+    l= (int) ceil (-slant * t);
+    r= (int) ceil (-slant * b);
+  }
+  int nw= ww + l + r;
+  glyph bmr (nw, hh, gl->xoff + l, gl->yoff, gl->depth);
+  for (j=0; j<hh; j++) {
+    int dx= (int) (floor (slant * (gl->yoff - j) + 0.5));
+    for (i=0; i<ww; i++)
+      bmr->set_x (i+l+dx, j, gl->get_x (i, j));
+  }
+  bmr->lwidth= gl->lwidth;
+  return simplify (bmr);
+}
+
+static glyph
+ref_stretched (glyph gl, double xf, double yf) {
+  int i, j, I, J;
+  int ww= gl->width, hh= gl->height;
+  int x1= -gl->xoff, x2= ww - gl->xoff;
+  int X1= (int) floor (xf * x1), X2= (int) ceil (xf * x2);
+  int WW= X2 - X1;
+  int y1= gl->yoff - hh, y2= gl->yoff;
+  int Y1= (int) floor (yf * y1), Y2= (int) ceil (yf * y2);
+  int HH= Y2 - Y1;
+  glyph bmr (WW, HH, -X1, Y2, gl->depth);
+  for (I=0; I<WW; I++) {
+    int X = I + X1;
+    int i1= max (min (((int) floor (X / xf)) - x1, ww-1), 0);
+    int i2= max (min (((int) ceil  ((X + 1) / xf)) - x1, ww-1), 0);
+    for (J=0; J<HH; J++) {
+      int Y = J + Y1;
+      int j1= max (min (((int) floor (Y / yf)) - y1, hh-1), 0);
+      int j2= max (min (((int) ceil  ((Y + 1) / yf)) - y1, hh-1), 0);
+      double sum= 0.0;
+      for (i= i1; i<i2; i++)
+        for (j= j1; j<j2; j++)
+          if (gl->get_x (i, j)) {
+            double X1b= max (X + 0.0, xf * (i + x1));
+            double X2b= min (X + 1.0, xf * ((i + 1) + x1));
+            double Y1b= max (Y + 0.0, yf * (j + y1));
+            double Y2b= min (Y + 1.0, yf * ((j + 1) + y1));
+            if (X1b < X2b && Y1b < Y2b)
+              sum += (X2b - X1b) * (Y2b - Y1b);
+          }
+      bmr->set_x (I, J, sum >= 0.5? 1: 0);
+    }
+  }
+  bmr->lwidth= (SI) floor (xf * gl->lwidth + 0.5);
+  return simplify (bmr);
+}
+
+/******************************************************************************
+* Random glyphs
+******************************************************************************/
+
+static unsigned int seed= 1;
+
+static int
+random_int (int n) {
+  seed= seed * 1103515245 + 12345;
+  return (int) ((seed >> 8) % ((unsigned int) n));
+}
+
+static glyph
+random_glyph (int w, int h) {
+  glyph gl (w, h, random_int (w), random_int (h));
+  int density= 1 + random_int (8);
+  for (int j=0; j<h; j++)
+    for (int i=0; i<w; i++)
+      if (random_int (10) < density) gl->set_x (i, j, 1);
+  return gl;
+}
+
+static bool
+same_glyph (glyph g1, glyph g2) {
+  if (g1->width != g2->width || g1->height != g2->height ||
+      g1->xoff != g2->xoff || g1->yoff != g2->yoff ||
+      g1->depth != g2->depth || g1->lwidth != g2->lwidth) return false;
+  for (int j=0; j<g1->height; j++)
+    for (int i=0; i<g1->width; i++)
+      if (g1->get_x (i, j) != g2->get_x (i, j)) return false;
+  return true;
+}
+
+/******************************************************************************
+* Tests
+******************************************************************************/
+
+TEST (glyph_words, counting) {
+  for (int k=0; k<200; k++) {
+    glyph gl= random_glyph (1 + random_int (200), 1 + random_int (8));
+    int total= 0;
+    for (int j=0; j<gl->height; j++) {
+      int count= 0, changes= 0, cur= 0;
+      for (int i=0; i<gl->width; i++) {
+        int b= gl->get_x (i, j);
+        count += b;
+        if (b != cur && (cur= b) == 1) changes++;
+      }
+      ASSERT_EQ (count_row_pixels (gl, j), count);
+      ASSERT_EQ (count_row_changes (gl, j), changes);
+      total += count;
+    }
+    ASSERT_EQ (pixel_count (gl), total);
+  }
+}
+
+TEST (glyph_words, fields) {
+  glyph gl= random_glyph (150, 3);
+  for (int k=0; k<500; k++) {
+    int i= random_int (150), n= 1 + random_int (64), j= random_int (3);
+    DN w= row_field (gl, j, i, n);
+    for (int b=0; b<64; b++)
+      ASSERT_EQ ((int) ((w >> b) & 1), b < n? gl->get_x (i+b, j): 0);
+    int i2= i + random_int (100), j2= j + random_int (3);
+    bool empty= true;
+    for (int y=j; y<j2; y++)
+      for (int x=i; x<i2; x++)
+        if (gl->get_x (x, y)) empty= false;
+    ASSERT_EQ (empty_block (gl, i, i2, j, j2), empty);
+  }
+}
+
+TEST (glyph_words, shrink) {
+  for (int k=0; k<300; k++) {
+    glyph gl= random_glyph (1 + random_int (140), 1 + random_int (40));
+    int f = 1 + random_int (6);
+    int tx= random_int (3), ty= random_int (3);
+    int dx= random_int (f), dy= random_int (f);
+    SI xo1, yo1, xo2, yo2;
+    glyph g1= shrink (gl, f, f, dx, dy, tx, ty, xo1, yo1);
+    glyph g2= ref_shrink (gl, f, f, dx, dy, tx, ty, xo2, yo2);
+    ASSERT_TRUE (same_glyph (g1, g2));
+    ASSERT_EQ (xo1, xo2);
+    ASSERT_EQ (yo1, yo2);
+  }
+}
+
+TEST (glyph_words, transforms) {
+  for (int k=0; k<200; k++) {
+    glyph gl= random_glyph (1 + random_int (100), 1 + random_int (40));
+    double slant= (random_int (81) - 40) / 100.0;
+    ASSERT_TRUE (same_glyph (slanted (gl, slant), ref_slanted (gl, slant)));
+    double xf= 0.5 + random_int (20) / 10.0;
+    double yf= 0.5 + random_int (20) / 10.0;
+    ASSERT_TRUE (same_glyph (stretched (gl, xf, yf),
+                             ref_stretched (gl, xf, yf)));
+  }
+}
+
+TEST (glyph_words, benchmark) {
+  // throughput of the anti-aliasing of large glyphs
+  array<glyph> gs;
+  for (int k=0; k<200; k++) gs << random_glyph (120, 120);
+  array<glyph> r1, r2, r3, r4;
+  SI xo, yo;
+  time_t t0= texmacs_time ();
+  for (int k=0; k<N(gs); k++)
+    r1 << ref_shrink (gs[k], 4, 4, 0, 0, 1, 1, xo, yo);
+  time_t t1= texmacs_time ();
+  for (int k=0; k<N(gs); k++) r2 << shrink (gs[k], 4, 4, 0, 0, 1, 1, xo, yo);
+  time_t t2= texmacs_time ();
+  for (int k=0; k<N(gs); k++) r3 << ref_slanted (gs[k], 0.25);
+  time_t t3= texmacs_time ();
+  for (int k=0; k<N(gs); k++) r4 << slanted (gs[k], 0.25);
+  time_t t4= texmacs_time ();
+  for (int k=0; k<N(gs); k++) {
+    ASSERT_TRUE (same_glyph (r1[k], r2[k]));
+    ASSERT_TRUE (same_glyph (r3[k], r4[k]));
+  }
+  if (DEBUG_BENCH)
+    cout << N(gs) << " glyphs, shrink: pixels " << (t1-t0)
+         << " ms, words " << (t2-t1) << " ms; slant: pixels " << (t3-t2)
+         << " ms, words " << (t4-t3) << " ms\n";
+}
@@ -0,0 +1,149 @@
+
+/******************************************************************************
+* MODULE     : printer_test.cpp
+* DESCRIPTION: Tests on the streaming PostScript printer
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "printer.hpp"
+#include "file.hpp"
+#include "fast_alloc.hpp"
+#include "tm_timer.hpp"
+#include "test_dir.hpp"
+
+static url
+temp_file () {
+  (void) test_home ();
+  return url_temp (".ps");
+}
+
+static printer_rep*
+make_printer (url u, int nr_pages) {
+  return tm_new<printer_rep> (u, 600, nr_pages, "a4", false, 21.0, 29.7);
+}
+
+static void
+draw_page (printer_rep* ren, int page, int n) {
+  SI u= 1000 * PIXEL;
+  for (int i=0; i<n; i++)
+    ren->line (i * u, -page * u, (i + 7) * u, -(page + i) * u);
+  ren->fill (0, -u, u, 0);
+}
+
+static string
+load_ps (url u) {
+  string s;
+  (void) load_string (u, s, false);
+  return s;
+}
+
+TEST (printer, streamed_pages) {
+  url u= temp_file ();
+  printer_rep* ren= make_printer (u, 3);
+  for (int p=1; p<=3; p++) {
+    draw_page (ren, p, 10);
+    if (p < 3) ren->next_page ();
+  }
+  tm_delete (ren);
+  string s= load_ps (u);
+  ASSERT_TRUE (starts (s, "%!PS-Adobe-2.0\n"));
+  ASSERT_TRUE (ends (s, "%%EOF\n"));
+  // the definitions of the prologue precede the spooled pages
+  int def= search_forwards ("/ln {", s);
+  int eop= search_forwards ("%%EndProlog", s);
+  int p1 = search_forwards ("%%Page: 1 1", s);
+  int p3 = search_forwards ("%%Page: 3 3", s);
+  ASSERT_TRUE (def >= 0 && def < eop && eop < p1 && p1 < p3);
+  ASSERT_EQ (search_forwards ("%%Page: 4 4", s), -1);
+  ASSERT_GT (search_forwards ("eop\n", p3, s), p3);
+  remove (u);
+}
+
+static int
+nr_temp_files (url except) {
+  bool error_flag;
+  array<string> a= read_directory (url_temp_dir (), error_flag);
+  int n= 0;
+  for (int i=0; i<N(a); i++)
+    if (starts (a[i], "tmp_") && a[i] != as_string (tail (except))) n++;
+  return n;
+}
+
+TEST (printer, spooling) {
+  // small documents are kept in memory, large ones are spooled
+  url u= temp_file ();
+  int before= nr_temp_files (u);
+  printer_rep* ren= make_printer (u, 2);
+  draw_page (ren, 1, 10);
+  ren->next_page ();
+  ASSERT_EQ (nr_temp_files (u), before);
+  tm_delete (ren);
+  ASSERT_EQ (nr_temp_files (u), before);
+  ASSERT_TRUE (ends (load_ps (u), "%%EOF\n"));
+  remove (u);
+  int nr= 200;
+  ren= make_printer (u, nr);
+  for (int p=1; p<=nr; p++) {
+    draw_page (ren, p, 100);
+    if (p < nr) ren->next_page ();
+  }
+  ASSERT_EQ (nr_temp_files (u), before + 1);
+  tm_delete (ren);
+  ASSERT_EQ (nr_temp_files (u), before);
+  string s= load_ps (u);
+  ASSERT_GT (N(s), PRINTER_SPOOL_SIZE);
+  ASSERT_LT (search_forwards ("%%EndProlog", s),
+             search_forwards ("%%Page: 1 1", s));
+  ASSERT_TRUE (ends (s, "%%EOF\n"));
+  remove (u);
+}
+
+TEST (printer, tex_chars) {
+  glyph gl (8, 2, 0, 0);
+  for (int i=0; i<8; i++) gl->set_x (i, 0, 1);
+  gl->lwidth= 9;
+  string defs[2];
+  for (int k=0; k<2; k++) {
+    url u= temp_file ();
+    printer_rep* ren= make_printer (u, 1);
+    ren->make_tex_char ("test10.600pk", 65, gl);
+    ren->select_tex_font ("test10.600pk");
+    tm_delete (ren);
+    string s= load_ps (u);
+    int pos= search_forwards ("/F0 1 66 df\n", s);
+    ASSERT_GE (pos, 0);
+    int end= search_forwards ("\n", pos + 12, s);
+    defs[k]= s (pos, end);
+    remove (u);
+  }
+  // the second printer uses the cached definition
+  ASSERT_TRUE (defs[0] == "/F0 1 66 df\n<FF000802827E09>65 D E");
+  ASSERT_TRUE (defs[1] == defs[0]);
+}
+
+TEST (printer, benchmark) {
+  // memory usage and throughput for a document with many pages
+  url u= temp_file ();
+  int nr= 1000, peak= 0, base= mem_used ();
+  time_t t0= texmacs_time ();
+  printer_rep* ren= make_printer (u, nr);
+  for (int p=1; p<=nr; p++) {
+    draw_page (ren, p, 100);
+    if (p < nr) ren->next_page ();
+    peak= max (peak, mem_used () - base);
+  }
+  tm_delete (ren);
+  time_t t1= texmacs_time ();
+  int size= file_size (u);
+  if (DEBUG_BENCH)
+    cout << nr << " pages, " << size << " bytes in " << (t1-t0)
+         << " ms, peak memory " << peak << " bytes\n";
+  ASSERT_LT (peak, size / 10);
+  remove (u);
+}
@@ -0,0 +1,374 @@
+
+/******************************************************************************
+* MODULE     : tile_cache_test.cpp
+* DESCRIPTION: Tests on the cache of rendered tiles
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "tile_cache.hpp"
+#include "renderer.hpp"
+#include "tm_timer.hpp"
+
+/******************************************************************************
+* A synthetic document which is rendered on raster pictures
+******************************************************************************/
+
+static int nr_rendered= 0;
+static rectangle changed (0, 0, 0, 0);
+static int version= 0;
+
+static color
+document_pixel (int x, int y) {
+  int v= 0;
+  if (x >= changed->x1 && x < changed->x2 &&
+      y >= changed->y1 && y < changed->y2) v= version;
+  return 0xff000000 | ((x & 255) << 16) | ((y & 255) << 8) | (v & 255);
+}
+
+static picture
+render_tile (tile_cache tc, int z, int tx, int ty) {
+  // one unit in document coordinates is one pixel
+  rectangle r= tc->extents (z, tx, ty);
+  int w= r->x2 - r->x1, h= r->y2 - r->y1;
+  picture pic= raster_picture (w, h);
+  for (int y=0; y<h; y++)
+    for (int x=0; x<w; x++)
+      pic->set_pixel (x, y, document_pixel (r->x1 + x, r->y1 + y));
+  nr_rendered++;
+  return pic;
+}
+
+static bool
+check_view (tile_cache tc, int z, rectangle view, bool verify= true) {
+  // compose the view from tiles and compare it with the document
+  int tx1, ty1, tx2, ty2;
+  tc->range (z, view, tx1, ty1, tx2, ty2);
+  for (int tx=tx1; tx<=tx2; tx++)
+    for (int ty=ty1; ty<=ty2; ty++) {
+      picture pic;
+      SI ox, oy;
+      if (!tc->lookup (z, tx, ty, pic, ox, oy)) {
+        pic= render_tile (tc, z, tx, ty);
+        tc->store (z, tx, ty, pic, 0, 0);
+      }
+      if (!verify) continue;
+      rectangle r= tc->extents (z, tx, ty);
+      for (int y= max (r->y1, view->y1); y < min (r->y2, view->y2); y++)
+        for (int x= max (r->x1, view->x1); x < min (r->x2, view->x2); x++)
+          if (pic->get_pixel (x - r->x1, y - r->y1) != document_pixel (x, y))
+            return false;
+    }
+  return true;
+}
+
+/******************************************************************************
+* A headless renderer on raster pictures
+******************************************************************************/
+
+static color
+raw_get (picture p, int x, int y) {
+  return p->get_pixel (x - p->get_origin_x (), y - p->get_origin_y ());
+}
+
+static void
+raw_set (picture p, int x, int y, color c) {
+  if (x < 0 || y < 0 || x >= p->get_width () || y >= p->get_height ()) return;
+  p->set_pixel (x - p->get_origin_x (), y - p->get_origin_y (), c);
+}
+
+class test_renderer_rep: public renderer_rep {
+public:
+  picture pict;
+  pencil  pen;
+
+  test_renderer_rep (picture p):
+    renderer_rep (true), pict (p), pen ((color) 0xff000000) {
+      pixel= PIXEL;
+      cx1= 0; cy1= 0;
+      cx2= p->get_width () * pixel; cy2= p->get_height () * pixel; }
+
+  pencil get_pencil () { return pen; }
+  brush get_background () { return brush ((color) 0xffffffff); }
+  void set_pencil (pencil p) { pen= p; }
+  void set_background (brush b) { (void) b; }
+
+  void fill (SI x1, SI y1, SI x2, SI y2) {
+    decode (x1, y1);
+    decode (x2, y2);
+    for (int y=y2; y<y1; y++)
+      for (int x=x1; x<x2; x++)
+        raw_set (pict, x, y, pen->get_color ());
+  }
+
+  void draw_picture (picture p, SI x, SI y, int alpha) {
+    // rows are counted from the top, origins from the bottom
+    (void) alpha;
+    decode (x, y);
+    int x0= x - p->get_origin_x ();
+    int y0= y - (p->get_height () - 1 - p->get_origin_y ());
+    for (int j=0; j<p->get_height (); j++)
+      for (int i=0; i<p->get_width (); i++)
+        raw_set (pict, x0 + i, y0 + j, raw_get (p, i, j));
+  }
+
+  renderer shadow (picture& p, SI x1, SI y1, SI x2, SI y2) {
+    // as renderer_rep::shadow, but on raster pictures
+    SI x0= 0, y0= 0;
+    decode (x0, y0);
+    outer_round (x1, y1, x2, y2);
+    decode (x1, y1);
+    decode (x2, y2);
+    p= raster_picture (x2-x1, y1-y2, x0 - x1, (y1 - y2 - 1) - (y0 - y2));
+    test_renderer_rep* ren= tm_new<test_renderer_rep> (p);
+    ren->ox= ox - x1 * pixel;
+    ren->oy= oy + y2 * pixel;
+    return ren;
+  }
+
+  void draw (int c, font_glyphs fn, SI x, SI y) {
+    (void) c; (void) fn; (void) x; (void) y; }
+  void line (SI x1, SI y1, SI x2, SI y2) {
+    (void) x1; (void) y1; (void) x2; (void) y2; }
+  void lines (array<SI> x, array<SI> y) { (void) x; (void) y; }
+  void clear (SI x1, SI y1, SI x2, SI y2) {
+    (void) x1; (void) y1; (void) x2; (void) y2; }
+  void arc (SI x1, SI y1, SI x2, SI y2, int alpha, int delta) {
+    (void) x1; (void) y1; (void) x2; (void) y2; (void) alpha; (void) delta; }
+  void fill_arc (SI x1, SI y1, SI x2, SI y2, int alpha, int delta) {
+    (void) x1; (void) y1; (void) x2; (void) y2; (void) alpha; (void) delta; }
+  void polygon (array<SI> x, array<SI> y, bool convex) {
+    (void) x; (void) y; (void) convex; }
+  void fetch (SI x1, SI y1, SI x2, SI y2, renderer ren, SI x, SI y) {
+    (void) x1; (void) y1; (void) x2; (void) y2;
+    (void) ren; (void) x; (void) y; }
+  void new_shadow (renderer& ren) { ren= NULL; }
+  void delete_shadow (renderer& ren) { ren= NULL; }
+  void get_shadow (renderer ren, SI x1, SI y1, SI x2, SI y2) {
+    (void) ren; (void) x1; (void) y1; (void) x2; (void) y2; }
+  void put_shadow (renderer ren, SI x1, SI y1, SI x2, SI y2) {
+    (void) ren; (void) x1; (void) y1; (void) x2; (void) y2; }
+  void apply_shadow (SI x1, SI y1, SI x2, SI y2) {
+    (void) x1; (void) y1; (void) x2; (void) y2; }
+};
+
+#define CELL (5 * PIXEL + 37)
+
+static int
+cell_index (SI x) {
+  return (int) (x >= 0? x / CELL: -((-x + CELL - 1) / CELL));
+}
+
+static void
+draw_cells (renderer ren, rectangle r) {
+  // a document made of cells which are not aligned on pixels
+  for (int cy= cell_index (r->y1 - PIXEL); cy <= cell_index (r->y2 + PIXEL);
+       cy++)
+    for (int cx= cell_index (r->x1 - PIXEL); cx <= cell_index (r->x2 + PIXEL);
+         cx++) {
+      ren->set_pencil (pencil ((color) (0xff000000 | ((cx & 255) << 16) |
+                                        ((cy & 255) << 8) |
+                                        ((cx * 7 + cy * 13) & 255))));
+      ren->fill (cx * CELL, cy * CELL, (cx + 1) * CELL, (cy + 1) * CELL);
+    }
+}
+
+static bool
+render_cells (void* obj, renderer win, rectangle tr, picture& pic) {
+  (void) obj;
+  renderer ren= win->shadow (pic, tr->x1, tr->y1, tr->x2, tr->y2);
+  draw_cells (ren, tr);
+  tm_delete (ren);
+  nr_rendered++;
+  return true;
+}
+
+static rectangle
+window_extents (SI ox, SI oy) {
+  // the part of the document which is visible on a 120x90 window
+  return rectangle (-ox - PIXEL, -90 * PIXEL - oy,
+                    121 * PIXEL - ox, PIXEL - oy);
+}
+
+static int
+window_tiles (tile_cache tc, int z, SI ox, SI oy) {
+  int tx1, ty1, tx2, ty2;
+  tc->range (z, window_extents (ox, oy), tx1, ty1, tx2, ty2);
+  return (tx2 - tx1 + 1) * (ty2 - ty1 + 1);
+}
+
+static picture
+repaint (tile_cache tc, int z, SI ox, SI oy, bool cached) {
+  picture pic= raster_picture (120, 90);
+  renderer win= tm_new<test_renderer_rep> (pic);
+  win->ox= ox;
+  win->oy= oy;
+  rectangle r= window_extents (ox, oy);
+  if (cached) (void) tc->draw (win, win, z, r, render_cells, NULL);
+  else draw_cells (win, r);
+  tm_delete (win);
+  return pic;
+}
+
+static bool
+same_pixels (picture p1, picture p2) {
+  for (int y=0; y<p1->get_height (); y++)
+    for (int x=0; x<p1->get_width (); x++)
+      if (raw_get (p1, x, y) != raw_get (p2, x, y)) return false;
+  return true;
+}
+
+/******************************************************************************
+* Tests
+******************************************************************************/
+
+TEST (tile_cache, hits_and_misses) {
+  tile_cache tc;
+  int z= tc->zoom_index (1.0, 16);
+  ASSERT_EQ (tc->zoom_index (2.0, 8), 1);
+  ASSERT_EQ (tc->zoom_index (1.0, 16), z);
+  picture pic;
+  SI ox, oy;
+  ASSERT_FALSE (tc->lookup (z, 3, -2, pic, ox, oy));
+  tc->store (z, 3, -2, raster_picture (16, 16), 5, 7);
+  ASSERT_TRUE (tc->lookup (z, 3, -2, pic, ox, oy));
+  ASSERT_EQ (ox, 5);
+  ASSERT_EQ (oy, 7);
+  ASSERT_FALSE (tc->lookup (1, 3, -2, pic, ox, oy));
+  ASSERT_EQ (tc->hits, 1);
+  ASSERT_EQ (tc->misses, 2);
+  ASSERT_EQ (tc->used, 4 * 16 * 16);
+}
+
+TEST (tile_cache, invalidation) {
+  tile_cache tc;
+  int z1= tc->zoom_index (1.0, 16), z2= tc->zoom_index (2.0, 8);
+  for (int tx=-4; tx<4; tx++)
+    for (int ty=-4; ty<4; ty++) {
+      tc->store (z1, tx, ty, raster_picture (16, 16), 0, 0);
+      tc->store (z2, tx, ty, raster_picture (8, 8), 0, 0);
+    }
+  ASSERT_EQ (tc->size (), 128);
+  tc->invalidate (rectangle (1, 1, 9, 9));
+  picture pic;
+  SI ox, oy;
+  ASSERT_FALSE (tc->lookup (z1, 0, 0, pic, ox, oy));
+  ASSERT_TRUE  (tc->lookup (z1, 1, 0, pic, ox, oy));
+  ASSERT_FALSE (tc->lookup (z2, 0, 0, pic, ox, oy));
+  ASSERT_FALSE (tc->lookup (z2, 1, 1, pic, ox, oy));
+  ASSERT_TRUE  (tc->lookup (z2, 2, 1, pic, ox, oy));
+  ASSERT_EQ (tc->invalidations, 5);
+  // large regions are handled by visiting the tiles
+  tc->invalidate (rectangle (-1000000, -1000000, 1000000, -1));
+  ASSERT_EQ (tc->size (), 123 - 64);
+  ASSERT_TRUE (tc->lookup (z1, -4, 0, pic, ox, oy));
+  ASSERT_FALSE (tc->lookup (z1, -4, -1, pic, ox, oy));
+  tc->invalidate_all ();
+  ASSERT_EQ (tc->size (), 0);
+  ASSERT_EQ (tc->used, 0);
+}
+
+TEST (tile_cache, eviction) {
+  tile_cache tc (3 * 4 * 16 * 16);
+  int z= tc->zoom_index (1.0, 16);
+  for (int i=0; i<3; i++)
+    tc->store (z, i, 0, raster_picture (16, 16), 0, 0);
+  picture pic;
+  SI ox, oy;
+  ASSERT_TRUE (tc->lookup (z, 0, 0, pic, ox, oy));
+  tc->store (z, 3, 0, raster_picture (16, 16), 0, 0);
+  ASSERT_EQ (tc->evictions, 1);
+  ASSERT_FALSE (tc->lookup (z, 1, 0, pic, ox, oy));
+  ASSERT_TRUE  (tc->lookup (z, 0, 0, pic, ox, oy));
+  ASSERT_TRUE  (tc->lookup (z, 2, 0, pic, ox, oy));
+  ASSERT_TRUE  (tc->lookup (z, 3, 0, pic, ox, oy));
+  ASSERT_LE (tc->used, tc->budget);
+  tc->store (z, 4, 0, raster_picture (64, 64), 0, 0);
+  ASSERT_FALSE (tc->lookup (z, 4, 0, pic, ox, oy));
+  ASSERT_EQ (tc->size (), 3);
+}
+
+TEST (tile_cache, scrolling) {
+  tile_cache tc (1 << 20);
+  int z= tc->zoom_index (1.0, 32);
+  nr_rendered= 0;
+  for (int k=0; k<3; k++)
+    for (int y=0; y<600; y+=7)
+      ASSERT_TRUE (check_view (tc, z, rectangle (0, y, 100, y + 80)));
+  int first= nr_rendered;
+  ASSERT_EQ (first, 4 * 22);
+  changed= rectangle (40, 100, 70, 130);
+  version= 1;
+  tc->invalidate (changed);
+  for (int y=0; y<600; y+=7)
+    ASSERT_TRUE (check_view (tc, z, rectangle (0, y, 100, y + 80)));
+  ASSERT_EQ (nr_rendered - first, 4);
+  if (DEBUG_BENCH)
+    cout << tc << "\n";
+  changed= rectangle (0, 0, 0, 0);
+  version= 0;
+}
+
+TEST (tile_cache, repainting) {
+  // scroll the window and compare with repaints without the cache
+  tile_cache tc;
+  int z= tc->zoom_index (1.0, 32 * PIXEL);
+  SI  scroll[6][2]= {
+    { 0, 0 }, { 0, 50 * PIXEL }, { 45 * PIXEL, 130 * PIXEL }, { 0, 0 },
+    { 45 * PIXEL + PIXEL/3, 130 * PIXEL - PIXEL/2 },
+    { 45 * PIXEL + PIXEL/3, 130 * PIXEL - PIXEL/2 } };
+  int rendered[6];
+  for (int i=0; i<6; i++) {
+    SI ox= scroll[i][0], oy= scroll[i][1];
+    nr_rendered= 0;
+    picture cached= repaint (tc, z, ox, oy, true);
+    rendered[i]= nr_rendered;
+    ASSERT_TRUE (same_pixels (cached, repaint (tc, z, ox, oy, false)));
+  }
+  // whole pixel scrolls only render the tiles which become visible,
+  // subpixel scrolls render all tiles again
+  ASSERT_EQ (rendered[0], window_tiles (tc, z, 0, 0));
+  ASSERT_GT (rendered[1], 0);
+  ASSERT_LT (rendered[1], window_tiles (tc, z, 0, 50 * PIXEL));
+  ASSERT_EQ (rendered[3], 0);
+  ASSERT_EQ (rendered[4], window_tiles (tc, z, scroll[4][0], scroll[4][1]));
+  ASSERT_EQ (rendered[5], 0);
+}
+
+TEST (tile_cache, benchmark) {
+  // repainting while scrolling back and forth through a document
+  tile_cache tc;
+  int z= tc->zoom_index (1.0, 64);
+  time_t t0= texmacs_time ();
+  nr_rendered= 0;
+  for (int k=0; k<4; k++)
+    for (int y=0; y<1000; y+=50) {
+      rectangle view (0, y, 400, y + 300);
+      int tx1, ty1, tx2, ty2;
+      tc->range (z, view, tx1, ty1, tx2, ty2);
+      for (int tx=tx1; tx<=tx2; tx++)
+        for (int ty=ty1; ty<=ty2; ty++)
+          (void) render_tile (tc, z, tx, ty);
+    }
+  time_t t1= texmacs_time ();
+  int direct= nr_rendered;
+  nr_rendered= 0;
+  for (int k=0; k<4; k++)
+    for (int y=0; y<1000; y+=50)
+      ASSERT_TRUE (check_view (tc, z, rectangle (0, y, 400, y + 300),
+                               false));
+  time_t t2= texmacs_time ();
+  // each tile is only rendered once with the cache
+  ASSERT_LE (4 * nr_rendered, direct);
+  if (DEBUG_BENCH) {
+    cout << "without cache: " << direct << " tiles in " << (t1-t0) << " ms, "
+         << "with cache: " << nr_rendered << " tiles in " << (t2-t1)
+         << " ms\n";
+    cout << tc << "\n";
+  }
+}
@@ -34,3 +34,13 @@ TEST (tree, is_concat) {
   ASSERT_TRUE (is_concat (concat (tree (), tree (), tree (), tree ())));
   ASSERT_TRUE (is_concat (concat (tree (), tree (), tree (), tree (), tree ())));
 }
+
+TEST (tree, cache_key) {
+  tree t1 (CONCAT, "a", "b"), t2 (CONCAT, "ab"), t3 (CONCAT, "a", "b");
+  ASSERT_EQ (N(cache_key (t1)), 16);
+  ASSERT_TRUE (cache_key (t1) == cache_key (t3));
+  ASSERT_TRUE (cache_key (t1) != cache_key (t2));
+  ASSERT_TRUE (cache_key (t1) != cache_key (tree (DOCUMENT, "a", "b")));
+  ASSERT_TRUE (cache_key (string ("ab")) != cache_key (string ("ba")));
+  ASSERT_EQ (stable_hash (t1), stable_hash (t3));
+}
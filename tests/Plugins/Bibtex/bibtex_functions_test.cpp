@@ -0,0 +1,243 @@
+
+/******************************************************************************
+* MODULE     : bibtex_functions_test.cpp
+* DESCRIPTION: Tests on the memoization of bibliographic conversions
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "Bibtex/bibtex_functions.hpp"
+#include "boot.hpp"
+#include "drd_std.hpp"
+#include "file.hpp"
+#include "sys_utils.hpp"
+#include "tm_timer.hpp"
+#include "test_dir.hpp"
+
+static void
+fresh_cache () {
+  init_std_drd ();
+  url home= test_home ();
+  mkdir (home * "system");
+  mkdir (home * "system" * "cache");
+  set_env ("TEXMACS_HOME_PATH", as_string (home));
+  bib_cache_reset (true);
+}
+
+static tree
+raw_entry (int i) {
+  tree fields (DOCUMENT);
+  fields << compound ("bib-field", "author", "A. Author and B. Author")
+         << compound ("bib-field", "title",
+                      "On the {N}umber " * as_string (i) * " $x^2$")
+         << compound ("bib-field", "pages", as_string (i) * "--99999")
+         << compound ("bib-field", "year", as_string (1900 + i % 100));
+  return compound ("bib-entry", "article", "key" * as_string (i), fields);
+}
+
+static tree
+converted_entry (tree e) {
+  // stands for the result of a previous conversion of the fields
+  tree r= copy (e);
+  r[2][1][1]= compound ("with", "font-shape", "italic", e[2][1][1]);
+  r[2][2][1]= tuple (e[2][2][1]);
+  return r;
+}
+
+static tree
+synthetic_bib (int n) {
+  tree doc (DOCUMENT);
+  doc << compound ("bib-preamble",
+                   tree (DOCUMENT, compound ("bib-latex", "\\def\\x{y}")));
+  for (int i=0; i<n; i++) doc << raw_entry (i);
+  return doc;
+}
+
+static void
+remember_conversions (tree doc) {
+  for (int i=0; i<N(doc); i++)
+    if (is_compound (doc[i], "bib-entry"))
+      bib_cache_set ("fields", cache_key (doc[i]),
+                     converted_entry (doc[i]));
+  bib_cache_flush ();
+}
+
+static int hits0, misses0;
+
+static void
+check_statistics (int hits, int misses) {
+  int h, m;
+  bib_cache_statistics (h, m);
+  ASSERT_EQ (h - hits0, hits);
+  ASSERT_EQ (m - misses0, misses);
+  hits0= h; misses0= m;
+}
+
+/******************************************************************************
+* Tests
+******************************************************************************/
+
+TEST (bibtex_functions, cache_records) {
+  fresh_cache ();
+  bib_cache_statistics (hits0, misses0);
+  string k1= cache_key (string ("first"));
+  string k2= cache_key (string ("second"));
+  ASSERT_EQ (N(k1), 16);
+  ASSERT_TRUE (k1 != k2);
+  ASSERT_TRUE (cache_key (tree (CONCAT, "a", "b")) !=
+               cache_key (tree (CONCAT, "ab")));
+  ASSERT_TRUE (bib_cache_get ("test", k1) == UNINIT);
+  check_statistics (0, 1);
+  // the values may contain anything which looks like a record
+  tree v1 (CONCAT, "line\n" * k2 * " 3\nabc\n", compound ("bibitem", "x"));
+  bib_cache_set ("test", k1, v1);
+  bib_cache_set ("test", k2, "old");
+  bib_cache_flush ();
+  bib_cache_set ("test", k2, "new");
+  bib_cache_flush ();
+  ASSERT_TRUE (bib_cache_get ("test", k1) == v1);
+  check_statistics (1, 0);
+  // a new session reads the records back, the last one being valid
+  bib_cache_reset (true);
+  ASSERT_TRUE (bib_cache_get ("test", k1) == v1);
+  ASSERT_TRUE (bib_cache_get ("test", k2) == "new");
+  ASSERT_TRUE (bib_cache_get ("other", k1) == UNINIT);
+  check_statistics (2, 1);
+  // without the disk, nothing persists
+  bib_cache_reset (false);
+  ASSERT_TRUE (bib_cache_get ("test", k1) == UNINIT);
+  bib_cache_reset (true);
+}
+
+TEST (bibtex_functions, damaged_records) {
+  fresh_cache ();
+  bib_cache_statistics (hits0, misses0);
+  url name ("$TEXMACS_HOME_PATH/system/cache", "__bib-damaged");
+  remove (name);
+  string k1= cache_key (string ("one"));
+  string k2= cache_key (string ("two"));
+  string k3= cache_key (string ("three"));
+  bib_cache_set ("damaged", k1, "first");
+  bib_cache_flush ();
+  // an interrupted write, records from an older format and garbage
+  (void) append_string (name, k2 * " 1000 0123456789abcdef\nshort\n");
+  (void) append_string (name, k2 * " 5\nfalse\n");
+  bib_cache_set ("damaged", k3, tree (CONCAT, "third", "\n"));
+  bib_cache_flush ();
+  (void) append_string (name, "garbage without a newline");
+  // the valid records are still found in a new session
+  bib_cache_reset (true);
+  ASSERT_TRUE (bib_cache_get ("damaged", k1) == "first");
+  ASSERT_TRUE (bib_cache_get ("damaged", k3) ==
+               tree (CONCAT, "third", "\n"));
+  ASSERT_TRUE (bib_cache_get ("damaged", k2) == UNINIT);
+  check_statistics (2, 1);
+  // the damaged parts are dropped when the file is written again
+  int size= file_size (name);
+  bib_cache_set ("damaged", k2, "second");
+  bib_cache_flush ();
+  ASSERT_LT (file_size (name), size);
+  bib_cache_reset (true);
+  ASSERT_TRUE (bib_cache_get ("damaged", k1) == "first");
+  ASSERT_TRUE (bib_cache_get ("damaged", k2) == "second");
+  check_statistics (2, 0);
+}
+
+TEST (bibtex_functions, compaction) {
+  fresh_cache ();
+  url name ("$TEXMACS_HOME_PATH/system/cache", "__bib-compact");
+  remove (name);
+  bib_cache_reset (true, 20000);
+  string value (1000);
+  for (int i=0; i<N(value); i++) value[i]= 'a' + (i % 26);
+  for (int i=0; i<100; i++) {
+    bib_cache_set ("compact", cache_key (as_string (i)), value);
+    bib_cache_flush ();
+    ASSERT_LE (file_size (name), 20000);
+  }
+  // the most recent records are kept, the oldest ones are dropped
+  bib_cache_reset (true);
+  bib_cache_statistics (hits0, misses0);
+  ASSERT_TRUE (bib_cache_get ("compact", cache_key (string ("99"))) ==
+               value);
+  ASSERT_TRUE (bib_cache_get ("compact", cache_key (string ("0"))) ==
+               UNINIT);
+  check_statistics (1, 1);
+  url dir ("$TEXMACS_HOME_PATH/system/cache");
+  bool flag;
+  array<string> files= read_directory (dir, flag);
+  for (int i=0; i<N(files); i++)
+    ASSERT_FALSE (starts (files[i], "tmp_"));
+}
+
+TEST (bibtex_functions, import_options) {
+  // conversions made with other options of the importer are not reused
+  fresh_cache ();
+  bib_cache_statistics (hits0, misses0);
+  string k= cache_key (string ("options"));
+  bib_cache_set ("options", k, "default");
+  bib_cache_flush ();
+  set_user_preference ("latex->texmacs:conservative", "on");
+  bib_cache_context ();
+  ASSERT_TRUE (bib_cache_get ("options", k) == UNINIT);
+  bib_cache_set ("options", k, "conservative");
+  bib_cache_flush ();
+  reset_user_preference ("latex->texmacs:conservative");
+  bib_cache_reset (true);
+  ASSERT_TRUE (bib_cache_get ("options", k) == "default");
+  set_user_preference ("latex->texmacs:conservative", "on");
+  bib_cache_context ();
+  ASSERT_TRUE (bib_cache_get ("options", k) == "conservative");
+  reset_user_preference ("latex->texmacs:conservative");
+  bib_cache_context ();
+  check_statistics (2, 1);
+}
+
+TEST (bibtex_functions, memoized_fields) {
+  fresh_cache ();
+  tree doc= synthetic_bib (50);
+  remember_conversions (doc);
+  bib_cache_statistics (hits0, misses0);
+  tree t= copy (doc);
+  bib_parse_fields (t);
+  check_statistics (50, 0);
+  ASSERT_TRUE (t[0] == doc[0]);
+  for (int i=1; i<N(t); i++)
+    ASSERT_TRUE (t[i] == converted_entry (doc[i]));
+  // the results may be modified without altering the cache
+  t[1][2][0][1]= "changed";
+  tree t2= copy (doc);
+  bib_parse_fields (t2);
+  ASSERT_TRUE (t2[1] == converted_entry (doc[1]));
+  // the conversions are read back from disk in a new session
+  bib_cache_reset (true);
+  tree t3= copy (doc);
+  bib_parse_fields (t3);
+  ASSERT_TRUE (t3 == t2);
+  check_statistics (100, 0);
+}
+
+TEST (bibtex_functions, benchmark) {
+  // lookups of the conversions for a database with 10000 entries
+  fresh_cache ();
+  tree doc= synthetic_bib (10000);
+  time_t t0= texmacs_time ();
+  remember_conversions (doc);
+  time_t t1= texmacs_time ();
+  tree t= copy (doc);
+  bib_parse_fields (t);
+  time_t t2= texmacs_time ();
+  bib_cache_reset (true);
+  t= copy (doc);
+  bib_parse_fields (t);
+  time_t t3= texmacs_time ();
+  ASSERT_TRUE (t[N(t)-1] == converted_entry (doc[N(doc)-1]));
+  if (DEBUG_BENCH)
+    cout << N(doc)-1 << " entries: storing " << (t1-t0) << " ms, cached "
+         << (t2-t1) << " ms, from disk " << (t3-t2) << " ms\n";
+}
@@ -0,0 +1,280 @@
+
+/******************************************************************************
+* MODULE     : latex_preview_test.cpp
+* DESCRIPTION: Tests on the cache of pictures generated by LaTeX
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "LaTeX_Preview/latex_preview.hpp"
+#include "Tex/convert_tex.hpp"
+#include "analyze.hpp"
+#include "file.hpp"
+#include "sys_utils.hpp"
+#include "tm_timer.hpp"
+#include "test_dir.hpp"
+
+#include <unistd.h>
+
+/******************************************************************************
+* Stubs for latex and gs, which log their invocations
+******************************************************************************/
+
+static string stub_latex=
+  "#!/bin/sh\n"
+  "echo \"$*\" >> \"$(dirname \"$0\")/calls.log\"\n"
+  "out=.; job=temp; prev=; last=\n"
+  "for a in \"$@\"; do\n"
+  "  if [ \"$prev\" = -output-directory ]; then out=\"$a\"; fi\n"
+  "  case \"$a\" in -jobname=*) job=\"${a#-jobname=}\";; esac\n"
+  "  prev=\"$a\"; last=\"$a\"\n"
+  "done\n"
+  "if [ \"$job\" != temp ]; then echo dump > \"$out/$job.fmt\"; exit 0; fi\n"
+  "if grep -q FAIL \"$last\"; then exit 1; fi\n"
+  "grep -o 'begin{preview}.*end{preview}\\|pic{[^}]*}' \"$last\""
+  " > \"$out/temp.pdf\"\n";
+
+static string stub_pdflatex=
+  "#!/bin/sh\n"
+  "echo \"$*\" >> \"$(dirname \"$0\")/calls.log\"\n"
+  "exit 1\n";
+
+static string stub_dvips=
+  "#!/bin/sh\n"
+  "cp temp.pdf temp.ps\n";
+
+static string stub_gs=
+  "#!/bin/sh\n"
+  "if [ \"$1\" = --version ]; then echo 9.50; exit 0; fi\n"
+  "for a in \"$@\"; do last=\"$a\"; done\n"
+  "n=0\n"
+  "while read -r line; do\n"
+  "  n=$((n+1)); w=$(printf %s \"$line\" | wc -c)\n"
+  "  printf '%%!PS-Adobe-3.0 EPSF-3.0\\n%%%%BoundingBox: 0 0 %s 10\\n%% %s\\n'"
+  " $w \"$line\" > temp$n.eps\n"
+  "done < \"$last\"\n";
+
+static url
+install_stubs () {
+  url home= test_home ();
+  mkdir (home * "system");
+  mkdir (home * "system" * "cache");
+  set_env ("TEXMACS_HOME_PATH", as_string (home));
+  url bin= home * "bin";
+  mkdir (bin);
+  save_string (bin * "latex", stub_latex);
+  save_string (bin * "gs", stub_gs);
+  save_string (bin * "pdflatex", stub_pdflatex);
+  save_string (bin * "dvips", stub_dvips);
+  remove (bin * "calls.log");
+  (void) system ("chmod +x \"" * as_string (bin) * "\"/*");
+  string path= get_env ("PATH");
+  if (!starts (path, as_string (bin)))
+    set_env ("PATH", as_string (bin) * ":" * path);
+  set_latex_command ("latex");
+  return bin;
+}
+
+static array<string>
+stub_calls (url bin) {
+  // the invocations of latex since the last call
+  string s;
+  url log= bin * "calls.log";
+  if (exists (log)) (void) load_string (log, s, false);
+  remove (log);
+  array<string> r= tokenize (s, "\n");
+  if (N(r) > 0 && r[N(r)-1] == "") r->resize (N(r) - 1);
+  return r;
+}
+
+static string doc=
+  "\\documentclass{article}\n"
+  "\\usepackage{xy}\n"
+  "\\begin{document}\n"
+  "Some text\n"
+  "\\end{document}\n";
+
+static tree
+preview (string name, string code, bool math= false) {
+  if (math) return tuple ("\\latex_preview", name, compound ("text", code));
+  return tuple ("\\latex_preview", name, code);
+}
+
+static string
+eps_data (tree img) {
+  return as_string (img[0][0][0]);
+}
+
+static int hits0, misses0, ms0;
+
+static void
+reset_statistics () {
+  latex_preview_statistics (hits0, misses0, ms0);
+}
+
+static void
+check_statistics (int hits, int misses) {
+  int h, m, ms;
+  latex_preview_statistics (h, m, ms);
+  ASSERT_EQ (h - hits0, hits);
+  ASSERT_EQ (m - misses0, misses);
+  ASSERT_GE (ms, ms0);
+  reset_statistics ();
+}
+
+/******************************************************************************
+* Tests
+******************************************************************************/
+
+TEST (latex_preview, batched_compilation) {
+  url bin= install_stubs ();
+  latex_preview_cache (true);
+  (void) stub_calls (bin);
+  reset_statistics ();
+  tree t (CONCAT, preview ("xymatrix", "\\xymatrix{a}"), "text",
+          preview ("foo", "\\foo<less>b", true),
+          preview ("xymatrix", "\\xymatrix{a}"));
+  array<tree> r= latex_preview (doc, t);
+  ASSERT_EQ (N(r), 3);
+  ASSERT_TRUE (is_func (r[0], IMAGE, 5) && is_func (r[1], IMAGE, 5));
+  ASSERT_TRUE (r[0] == r[2]);
+  ASSERT_TRUE (r[1][1] == "35pt" && r[1][2] == "10pt");
+  ASSERT_GE (search_forwards ("{preview}$\\foo<b$\\end", eps_data (r[1])), 0);
+  check_statistics (0, 3);
+  // the preamble is dumped once, then both snippets are compiled in one run
+  array<string> calls= stub_calls (bin);
+  ASSERT_EQ (N(calls), 2);
+  ASSERT_GE (search_forwards ("-ini", calls[0]), 0);
+  ASSERT_GE (search_forwards ("-fmt=", calls[1]), 0);
+
+  // only the new snippet is compiled, using the precompiled preamble
+  t << preview ("xymatrix", "\\xymatrix{b}");
+  r= latex_preview (doc, t);
+  ASSERT_EQ (N(r), 4);
+  ASSERT_TRUE (is_func (r[3], IMAGE, 5));
+  check_statistics (3, 1);
+  calls= stub_calls (bin);
+  ASSERT_EQ (N(calls), 1);
+  ASSERT_GE (search_forwards ("-fmt=", calls[0]), 0);
+
+  // a different preamble gives different pictures
+  r= latex_preview ("\\documentclass{book}\n" * doc (24, N(doc)), t);
+  check_statistics (0, 4);
+  ASSERT_EQ (N(stub_calls (bin)), 2);
+}
+
+TEST (latex_preview, persistent_cache) {
+  url bin= install_stubs ();
+  latex_preview_cache (true);
+  tree t (CONCAT, preview ("a", "\\a{persistent}"), preview ("b", "\\b{1}"));
+  array<tree> r1= latex_preview (doc, t);
+  (void) stub_calls (bin);
+  // pictures are read back from disk in a new session, without compiling
+  latex_preview_cache (true);
+  reset_statistics ();
+  array<tree> r2= latex_preview (doc, t);
+  check_statistics (2, 0);
+  ASSERT_EQ (N(stub_calls (bin)), 0);
+  ASSERT_EQ (N(r2), 2);
+  ASSERT_TRUE (r1[0] == r2[0] && r1[1] == r2[1]);
+}
+
+TEST (latex_preview, failures) {
+  url bin= install_stubs ();
+  latex_preview_cache (true);
+  tree t (CONCAT, preview ("a", "\\a{ok}"));
+  (void) latex_preview (doc, t);
+  // pictures which could not be made are empty and are not cached
+  t << preview ("b", "\\b{FAIL}");
+  reset_statistics ();
+  array<tree> r= latex_preview (doc, t);
+  ASSERT_EQ (N(r), 2);
+  ASSERT_TRUE (is_func (r[0], IMAGE, 5));
+  ASSERT_TRUE (r[1] == "");
+  check_statistics (1, 1);
+  r= latex_preview (doc, t);
+  ASSERT_TRUE (r[1] == "");
+  check_statistics (1, 1);
+}
+
+TEST (latex_preview, definitions_in_body) {
+  // the whole document is compiled, so that its definitions are known
+  url bin= install_stubs ();
+  latex_preview_cache (true);
+  string body=
+    "\\documentclass{article}\n"
+    "\\begin{document}\n"
+    "\\newcommand{\\pic}[1]{\\fbox{#1}}\n"
+    "\\pic{x} and \\pic{y}\n"
+    "\\end{document}\n";
+  tree t (CONCAT, preview ("pic", "\\pic{x}"), " and ",
+          preview ("pic", "\\pic{y}"));
+  command_arity ("pic")= 1;
+  (void) stub_calls (bin);
+  reset_statistics ();
+  array<tree> r= latex_preview (body, t);
+  ASSERT_EQ (N(r), 2);
+  ASSERT_TRUE (is_func (r[0], IMAGE, 5) && is_func (r[1], IMAGE, 5));
+  ASSERT_LT (search_forwards ("begin{preview}", eps_data (r[0])), 0);
+  ASSERT_GE (search_forwards ("pic{x}", eps_data (r[0])), 0);
+  ASSERT_GE (search_forwards ("pic{y}", eps_data (r[1])), 0);
+  check_statistics (0, 2);
+  ASSERT_EQ (N(stub_calls (bin)), 2);
+  r= latex_preview (body, t);
+  check_statistics (2, 0);
+  ASSERT_EQ (N(stub_calls (bin)), 0);
+  // the definitions are part of the keys
+  body= replace (body, "fbox", "framebox");
+  r= latex_preview (body, t);
+  check_statistics (0, 2);
+  ASSERT_EQ (N(stub_calls (bin)), 1);
+}
+
+TEST (latex_preview, dvips_fallback) {
+  // pictures made with latex and dvips are found again without compiling
+  url bin= install_stubs ();
+  set_latex_command ("pdflatex");
+  latex_preview_cache (true);
+  tree t (CONCAT, preview ("a", "\\a{dvips}"));
+  (void) stub_calls (bin);
+  reset_statistics ();
+  array<tree> r= latex_preview (doc, t);
+  ASSERT_TRUE (is_func (r[0], IMAGE, 5));
+  check_statistics (0, 1);
+  array<string> calls= stub_calls (bin);
+  // pdflatex fails twice, then latex is run with a precompiled preamble
+  ASSERT_GE (N(calls), 3);
+  ASSERT_GE (search_forwards ("&pdflatex", calls[0]), 0);
+  ASSERT_LT (search_forwards ("-fmt=", calls[1]), 0);
+  ASSERT_GE (search_forwards ("-fmt=", calls[N(calls)-1]), 0);
+  latex_preview_cache (true);
+  array<tree> r2= latex_preview (doc, t);
+  check_statistics (1, 0);
+  ASSERT_EQ (N(stub_calls (bin)), 0);
+  ASSERT_TRUE (r2[0] == r[0]);
+  set_latex_command ("latex");
+}
+
+TEST (latex_preview, benchmark) {
+  // conversions of a document with many pictures, cold and warm
+  url bin= install_stubs ();
+  latex_preview_cache (false);
+  tree t (CONCAT);
+  for (int i=0; i<200; i++)
+    t << preview ("xymatrix", "\\xymatrix{" * as_string (i) * "}");
+  time_t t0= texmacs_time ();
+  array<tree> r1= latex_preview (doc, t);
+  time_t t1= texmacs_time ();
+  array<tree> r2= latex_preview (doc, t);
+  time_t t2= texmacs_time ();
+  ASSERT_EQ (N(stub_calls (bin)), 1);
+  ASSERT_TRUE (r1 == r2);
+  if (DEBUG_BENCH)
+    cout << N(t) << " pictures: cold " << (t1-t0) << " ms, cached "
+         << (t2-t1) << " ms\n";
+}
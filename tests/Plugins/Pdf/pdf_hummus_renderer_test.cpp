@@ -0,0 +1,141 @@
+
+/******************************************************************************
+* MODULE     : pdf_hummus_renderer_test.cpp
+* DESCRIPTION: Tests on the native Pdf renderer
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "Pdf/pdf_hummus_renderer.hpp"
+#include "analyze.hpp"
+#include "boot.hpp"
+#include "scalable.hpp"
+#include "file.hpp"
+#include "sys_utils.hpp"
+#include "test_dir.hpp"
+
+#include "Pdf/PDFWriter/InputFile.h"
+#include "Pdf/PDFWriter/PDFParser.h"
+#include "Pdf/PDFWriter/PDFDictionary.h"
+#include "Pdf/PDFWriter/PDFStreamInput.h"
+#include "Pdf/PDFWriter/PDFObjectCast.h"
+
+static url
+render_pages (int nr, bool parallel) {
+  (void) test_home ();
+  set_user_preference ("texmacs->pdf:parallel pages",
+                       parallel? string ("on"): string ("off"));
+  url u= url_temp (".pdf");
+  renderer ren= pdf_hummus_renderer (u, 600, nr);
+  for (int i=0; i<nr; i++) {
+    if (i != 0) ren->next_page ();
+    ren->set_pencil (pencil (rgb_color (i % 256, 0, 255 - i % 256)));
+    for (int j=0; j<=i % 7; j++)
+      ren->line (j * 1000 * PIXEL, 0, (i+1) * 500 * PIXEL, -j * 2000 * PIXEL);
+    ren->set_brush (brush (red));
+    ren->fill (0, -(i+1) * 300 * PIXEL, (i+1) * 300 * PIXEL, 0);
+  }
+  tm_delete (ren);
+  reset_user_preference ("texmacs->pdf:parallel pages");
+  return u;
+}
+
+static array<string>
+page_contents (url u) {
+  // decoded content streams of all pages
+  array<string> r;
+  InputFile file;
+  if (file.OpenFile (as_charp (concretize (u))) != PDFHummus::eSuccess)
+    return r;
+  PDFParser parser;
+  if (parser.StartPDFParsing (file.GetInputStream ()) != PDFHummus::eSuccess)
+    return r;
+  for (unsigned long i=0; i<parser.GetPagesCount (); i++) {
+    PDFObjectCastPtr<PDFDictionary> pg (parser.ParsePage (i));
+    PDFObjectCastPtr<PDFStreamInput> st
+      (parser.QueryDictionaryObject (pg.GetPtr (), "Contents"));
+    string s;
+    if (!st) { r << s; continue; }
+    IByteReader* in= parser.StartReadingFromStream (st.GetPtr ());
+    IOBasicTypes::Byte buf[4096];
+    while (in != NULL && in->NotEnded ()) {
+      IOBasicTypes::LongBufferSizeType n= in->Read (buf, 4096);
+      s << string ((char*) buf, (int) n);
+    }
+    delete in;
+    r << s;
+  }
+  return r;
+}
+
+static string
+without_id (string s) {
+  int i= search_forwards ("/ID [", s);
+  if (i < 0) return s;
+  int j= search_forwards ("]", i, s);
+  return s (0, i) * s (j, N(s));
+}
+
+TEST (pdf_hummus_renderer, parallel_pages) {
+  int nr= 13; // more pages than workers
+  url seq= render_pages (nr, false);
+  url par= render_pages (nr, true);
+  array<string> a= page_contents (seq);
+  array<string> b= page_contents (par);
+  ASSERT_EQ (N(a), nr);
+  ASSERT_EQ (N(b), nr);
+  for (int i=0; i<nr; i++) {
+    ASSERT_GT (N(a[i]), 0);
+    ASSERT_TRUE (a[i] == b[i]);
+  }
+  // the output only depends on the document, up to the identifier
+  // in the trailer, which is computed from the time of the export
+  string s0, s1, s2;
+  url again= render_pages (nr, true);
+  ASSERT_FALSE (load_string (seq, s0, false));
+  ASSERT_FALSE (load_string (par, s1, false));
+  ASSERT_FALSE (load_string (again, s2, false));
+  ASSERT_FALSE (without_id (s0) == without_id (s1));
+  ASSERT_TRUE (without_id (s1) == without_id (s2));
+  remove (seq);
+  remove (par);
+  remove (again);
+}
+
+static int
+occurrences (string what, string s) {
+  int r= 0;
+  for (int i= search_forwards (what, s); i >= 0;
+       i= search_forwards (what, i + N(what), s))
+    r++;
+  return r;
+}
+
+TEST (pdf_hummus_renderer, shared_images) {
+  // the same picture in two files is written as a single XObject
+  url pic= render_pages (1, false);
+  url a= url_temp (".pdf"), b= url_temp (".pdf");
+  string data;
+  ASSERT_FALSE (load_string (pic, data, false));
+  ASSERT_FALSE (save_string (a, data, false));
+  ASSERT_FALSE (save_string (b, data, false));
+  url u= url_temp (".pdf");
+  renderer ren= pdf_hummus_renderer (u, 600, 1);
+  SI sz= 1000 * PIXEL;
+  ren->draw_scalable (load_scalable_image (a, sz, sz, "", PIXEL), 0, 0, 255);
+  ren->draw_scalable (load_scalable_image (b, sz, sz, "", PIXEL), 0, -sz, 255);
+  ren->draw_scalable (load_scalable_image (a, sz, sz, "", PIXEL), sz, 0, 255);
+  tm_delete (ren);
+  string s;
+  ASSERT_FALSE (load_string (u, s, false));
+  ASSERT_EQ (occurrences ("/Subtype /Form", s), 1);
+  remove (pic);
+  remove (a);
+  remove (b);
+  remove (u);
+}
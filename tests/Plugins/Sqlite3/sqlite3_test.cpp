@@ -0,0 +1,195 @@
+
+/******************************************************************************
+* MODULE     : sqlite3_test.cpp
+* DESCRIPTION: Tests on prepared statements, cursors and transactions
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "Sqlite3/sqlite3.hpp"
+#include "analyze.hpp"
+#include "file.hpp"
+#include "tm_timer.hpp"
+#include "test_dir.hpp"
+
+static url
+temp_db (string name) {
+  url dir= test_dir ();
+  url u= dir * name;
+  sql_close (u);
+  remove (u);
+  return u;
+}
+
+static tree
+row (string a, string b) {
+  return tuple (scm_quote (a), scm_quote (b));
+}
+
+static array<string>
+args (string a, string b= "") {
+  array<string> r;
+  r << a;
+  if (b != "") r << b;
+  return r;
+}
+
+/******************************************************************************
+* Tests
+******************************************************************************/
+
+TEST (sqlite3, exec) {
+  if (!sqlite3_present ()) return;
+  url db= temp_db ("exec.db");
+  ASSERT_TRUE (sql_exec (db, "CREATE TABLE t (k TEXT, v TEXT);"
+                             "INSERT INTO t VALUES ('a', 'it''s');"
+                             "INSERT INTO t VALUES ('b', NULL);") ==
+               tuple (tuple ()));
+  tree r= sql_exec (db, "SELECT k, v FROM t ORDER BY k");
+  ASSERT_TRUE (r == tuple (row ("k", "v"), row ("a", "it's"),
+                           tuple (scm_quote ("b"), tuple ())));
+  ASSERT_TRUE (sql_exec (db, "SELECT k FROM t WHERE k = 'z'") ==
+               tuple (tuple ()));
+  ASSERT_TRUE (sql_exec (db, "SELECT v FROM t WHERE k = ?", args ("a")) ==
+               tuple (tuple (scm_quote ("v")), tuple (scm_quote ("it's"))));
+  ASSERT_TRUE (sql_exec (db, "SELECT * FROM missing") == tuple (tuple ()));
+  ASSERT_TRUE (sql_exec (db, "") == tuple (tuple ()));
+  sql_close (db);
+}
+
+TEST (sqlite3, statement_cache) {
+  if (!sqlite3_present ()) return;
+  url db= temp_db ("cache.db");
+  (void) sql_exec (db, "CREATE TABLE t (k TEXT, v TEXT)");
+  int hits, misses;
+  sql_cache_statistics (db, hits, misses);
+  for (int i=0; i<100; i++)
+    (void) sql_exec (db, "INSERT INTO t VALUES (?, ?)",
+                     args (as_string (i), as_string (i*i)));
+  int hits2, misses2;
+  sql_cache_statistics (db, hits2, misses2);
+  ASSERT_EQ (misses2 - misses, 1);
+  ASSERT_EQ (hits2 - hits, 99);
+  ASSERT_TRUE (sql_exec (db, "SELECT v FROM t WHERE k = ?", args ("7")) ==
+               tuple (tuple (scm_quote ("v")), tuple (scm_quote ("49"))));
+  // the least recently used statements are evicted
+  for (int i=0; i<2*SQL_STATEMENT_CACHE; i++)
+    (void) sql_exec (db, "SELECT " * as_string (i));
+  sql_cache_statistics (db, hits, misses);
+  (void) sql_exec (db, "SELECT v FROM t WHERE k = ?", args ("8"));
+  sql_cache_statistics (db, hits2, misses2);
+  ASSERT_EQ (misses2 - misses, 1);
+  sql_close (db);
+}
+
+TEST (sqlite3, cursors) {
+  if (!sqlite3_present ()) return;
+  url db= temp_db ("cursors.db");
+  (void) sql_exec (db, "CREATE TABLE t (k INTEGER)");
+  tree rows (TUPLE);
+  for (int i=0; i<250; i++) rows << tuple (scm_quote (as_string (i)));
+  ASSERT_EQ (sql_exec_batch (db, "INSERT INTO t VALUES (?)", rows), 250);
+  int id= sql_cursor_open (db, "SELECT k FROM t WHERE k >= ? ORDER BY k",
+                           args ("10"));
+  ASSERT_TRUE (id >= 0);
+  ASSERT_TRUE (sql_cursor_columns (id) == tuple (scm_quote ("k")));
+  int n= 10;
+  while (true) {
+    tree chunk= sql_cursor_fetch (id, 100);
+    for (int i=0; i<N(chunk); i++, n++)
+      ASSERT_TRUE (chunk[i] == tuple (scm_quote (as_string (n))));
+    if (N(chunk) < 100) break;
+  }
+  ASSERT_EQ (n, 250);
+  ASSERT_EQ (N (sql_cursor_fetch (id, 100)), 0);
+  sql_cursor_close (id);
+  ASSERT_EQ (N (sql_cursor_fetch (id, 100)), 0);
+  ASSERT_EQ (sql_cursor_open (db, "SELECT nonsense FROM t", args ("")), -1);
+  sql_close (db);
+}
+
+TEST (sqlite3, transactions) {
+  if (!sqlite3_present ()) return;
+  url db= temp_db ("transactions.db");
+  (void) sql_exec (db, "CREATE TABLE t (k TEXT PRIMARY KEY, v TEXT)");
+  tree rows= tuple (row ("a", "1"), row ("b", "2"), row ("a", "3"));
+  // a failing batch is rolled back entirely
+  ASSERT_EQ (sql_exec_batch (db, "INSERT INTO t VALUES (?, ?)", rows), -1);
+  ASSERT_TRUE (sql_exec (db, "SELECT k FROM t") == tuple (tuple ()));
+  ASSERT_EQ (sql_exec_batch (db, "INSERT INTO t VALUES (?, ?)",
+                             rows (0, 2)), 2);
+  ASSERT_EQ (N (sql_exec (db, "SELECT k FROM t")), 3);
+  // explicit transactions
+  sql_begin (db);
+  ASSERT_EQ (sql_exec_batch (db, "UPDATE t SET v = ? WHERE k = ?",
+                             tuple (row ("5", "a"))), 1);
+  (void) sql_exec (db, "DELETE FROM t WHERE k = 'b'");
+  sql_rollback (db);
+  ASSERT_TRUE (sql_exec (db, "SELECT k, v FROM t ORDER BY k") ==
+               tuple (row ("k", "v"), row ("a", "1"), row ("b", "2")));
+  sql_begin (db);
+  (void) sql_exec (db, "DELETE FROM t WHERE k = 'b'");
+  sql_commit (db);
+  ASSERT_TRUE (sql_exec (db, "SELECT k, v FROM t") ==
+               tuple (row ("k", "v"), row ("a", "1")));
+  sql_close (db);
+}
+
+TEST (sqlite3, benchmark) {
+  // a table with a million rows in a temporary file; only part of it is
+  // converted into trees, which dominates the time for reading rows
+  if (!sqlite3_present ()) return;
+  url db= temp_db ("benchmark.db");
+  int n= 1000000, q= 5000, m= 100000;
+  time_t t0= texmacs_time ();
+  (void) sql_exec (db, "CREATE TABLE t (k INTEGER PRIMARY KEY, v TEXT);"
+                   "INSERT INTO t WITH RECURSIVE c(x) AS "
+                   "(SELECT 1 UNION ALL SELECT x+1 FROM c WHERE x < " *
+                   as_string (n) * ") SELECT x, 'value ' || x FROM c");
+  tree rows (TUPLE);
+  for (int i=1; i<=10000; i++)
+    rows << row (as_string (n + i), "value " * as_string (n + i));
+  time_t t1= texmacs_time ();
+  ASSERT_EQ (sql_exec_batch (db, "INSERT INTO t VALUES (?, ?)", rows), 10000);
+  time_t t2= texmacs_time ();
+  for (int i=0; i<q; i++) {
+    string k= as_string (1 + (i * 7919) % n);
+    (void) sql_exec (db, "SELECT v FROM t WHERE k = " * k);
+  }
+  time_t t3= texmacs_time ();
+  for (int i=0; i<q; i++) {
+    string k= as_string (1 + (i * 7919) % n);
+    (void) sql_exec (db, "SELECT v FROM t WHERE k = ?", args (k));
+  }
+  time_t t4= texmacs_time ();
+  string cmd= "SELECT k, v FROM t WHERE k > ? LIMIT " * as_string (m);
+  tree all= sql_exec (db, cmd, args (as_string (n - m)));
+  ASSERT_EQ (N(all), m + 1);
+  all= tree ();
+  time_t t5= texmacs_time ();
+  int id= sql_cursor_open (db, cmd, args (as_string (n - m)));
+  int count= 0, largest= 0;
+  while (true) {
+    tree chunk= sql_cursor_fetch (id, 1000);
+    count += N(chunk);
+    largest= max (largest, N(chunk));
+    if (N(chunk) < 1000) break;
+  }
+  sql_cursor_close (id);
+  time_t t6= texmacs_time ();
+  ASSERT_EQ (count, m);
+  if (DEBUG_BENCH)
+    cout << n << " rows: creation " << (t1-t0)
+         << " ms, batch of 10000 insertions " << (t2-t1)
+         << " ms, " << q << " queries " << (t3-t2)
+         << " ms, with parameters " << (t4-t3) << " ms\n"
+         << m << " rows: complete result " << (t5-t4)
+         << " ms, by chunks of " << largest << " rows " << (t6-t5) << " ms\n";
+  sql_close (db);
+  remove (db);
+}
@@ -0,0 +1,131 @@
+
+/******************************************************************************
+* MODULE     : scheme_test.cpp
+* DESCRIPTION: Tests on the growable heap of TinyScheme
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "gtest/gtest.h"
+
+// TinyScheme is not part of the Guile based build,
+// so that the interpreter is compiled along with the test
+#include "Tiny/scheme.c"
+
+void finalize_blackbox (void* p) { (void) p; }
+
+static long
+eval_integer (scheme* sc, const char* cmd) {
+  scheme_load_string (sc, cmd);
+  return is_integer (sc->value)? ivalue (sc->value): -1;
+}
+
+static std::string
+eval_string (scheme* sc, const char* cmd) {
+  scheme_load_string (sc, cmd);
+  if (!is_string (sc->value)) return "";
+  return std::string (string_value (sc->value), string_length (sc->value));
+}
+
+static cell_ptr
+twice (scheme* sc, cell_ptr args) {
+  return mk_integer (sc, 2 * ivalue (pair_car (args)));
+}
+
+TEST (tinyscheme, segments) {
+  scheme* sc= scheme_init_new ();
+  ASSERT_TRUE (sc != NULL);
+  ASSERT_EQ (sc->last_cell_seg + 1, FIRST_CELLSEGS);
+  scheme_load_string (sc,
+    "(define (build n acc)"
+    "  (if (= n 0) acc (build (- n 1) (cons n acc))))"
+    "(define (sum l acc)"
+    "  (if (null? l) acc (sum (cdr l) (+ acc (car l)))))"
+    "(define (churn n)"
+    "  (if (> n 0) (begin (build 1000 '()) (churn (- n 1)))))");
+  // live data which spans many segments, interleaved with garbage
+  long n= 4 * CELL_SEGSIZE;
+  scheme_load_string (sc, "(define live (build 10000 '()))");
+  scheme_load_string (sc, "(churn 20)");
+  scheme_load_string (sc, "(define more (build 10000 '()))");
+  scheme_load_string (sc, "(churn 20)");
+  ASSERT_GT (sc->last_cell_seg + 1, n / CELL_SEGSIZE);
+  ASSERT_GT (sc->gc_count, 0);
+  // collections keep all live cells
+  scheme_load_string (sc, "(gc)");
+  ASSERT_EQ (eval_integer (sc, "(length live)"), 10000);
+  ASSERT_EQ (eval_integer (sc, "(sum live 0)"), 10000L * 10001L / 2);
+  ASSERT_EQ (eval_integer (sc, "(sum more 0)"), 10000L * 10001L / 2);
+  ASSERT_GE (sc->gc_last_live, n);
+  // idle segments are given back once the data are no longer used
+  int segments= sc->last_cell_seg + 1;
+  scheme_load_string (sc, "(set! live '())");
+  scheme_load_string (sc, "(set! more '())");
+  scheme_load_string (sc, "(gc)");
+  ASSERT_GT (sc->gc_freed_segs, 0);
+  ASSERT_LT (sc->last_cell_seg + 1, segments);
+  ASSERT_LT (sc->gc_last_live, n / 2);
+  // and the heap grows again on demand
+  scheme_load_string (sc, "(define live (build 10000 '()))");
+  scheme_load_string (sc, "(gc)");
+  ASSERT_EQ (eval_integer (sc, "(sum live 0)"), 10000L * 10001L / 2);
+  scheme_deinit (sc);
+  free (sc);
+}
+
+TEST (tinyscheme, heap_images) {
+  scheme* sc= scheme_init_new ();
+  ASSERT_TRUE (sc != NULL);
+  scheme_define (sc, sc->global_env, mk_symbol (sc, "twice"),
+                 mk_foreign_func (sc, twice));
+  scheme_load_string (sc,
+    "(define (build n acc)"
+    "  (if (= n 0) acc (build (- n 1) (cons n acc))))"
+    "(define live (build 10000 '()))"
+    "(define v (make-vector 5 'x))"
+    "(vector-set! v 3 \"three\")"
+    "(define (adder n) (lambda (x) (+ x n)))"
+    "(define add2 (adder 2))"
+    "(macro (swap form)"
+    "  (cons 'cons (cons (car (cdr (cdr form))) (cons (car (cdr form)) '()))))"
+    "(define text (string-append \"line\\n\" \"end\"))"
+    "(define ratio 2.5)");
+  FILE* f= tmpfile ();
+  ASSERT_TRUE (f != NULL);
+  ASSERT_TRUE (scheme_save_image (sc, f));
+  scheme_deinit (sc);
+  free (sc);
+
+  // the restored heap behaves as the original one
+  rewind (f);
+  sc= scheme_init_new ();
+  ASSERT_TRUE (scheme_load_image (sc, f));
+  fclose (f);
+  ASSERT_EQ (eval_integer (sc, "(length live)"), 10000);
+  ASSERT_EQ (eval_integer (sc, "(apply + live)"), 10000L * 10001L / 2);
+  ASSERT_EQ (eval_string (sc, "(vector-ref v 3)"), "three");
+  ASSERT_EQ (eval_integer (sc, "(if (eq? (vector-ref v 4) 'x) 1 0)"), 1);
+  ASSERT_EQ (eval_integer (sc, "(add2 40)"), 42);
+  ASSERT_EQ (eval_integer (sc, "(car (swap 1 2))"), 2);
+  ASSERT_EQ (eval_string (sc, "text"), "line\nend");
+  ASSERT_EQ (eval_integer (sc, "(inexact->exact (* ratio 2))"), 5);
+  ASSERT_EQ (eval_integer (sc, "(twice 21)"), 42);
+  // symbols are still unique, and new definitions work as usual
+  ASSERT_EQ (eval_integer (sc, "(if (eq? 'live (string->symbol \"live\"))"
+                               "    1 0)"), 1);
+  scheme_load_string (sc, "(define more (build 20000 live))");
+  scheme_load_string (sc, "(gc)");
+  ASSERT_EQ (eval_integer (sc, "(length more)"), 30000);
+
+  // heaps which refer to C++ objects cannot be saved
+  scheme_define (sc, sc->global_env, mk_symbol (sc, "box"),
+                 mk_blackbox (sc, NULL));
+  f= tmpfile ();
+  ASSERT_FALSE (scheme_save_image (sc, f));
+  fclose (f);
+  scheme_deinit (sc);
+  free (sc);
+}
@@ -0,0 +1,195 @@
+
+/******************************************************************************
+* MODULE     : hyphenate_test.cpp
+* DESCRIPTION: Tests on hyphenation by compiled pattern tries
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "hyphenate.hpp"
+#include "analyze.hpp"
+#include "converter.hpp"
+#include "file.hpp"
+#include "sys_utils.hpp"
+#include "tm_timer.hpp"
+#include "test_dir.hpp"
+
+void goto_next_char (string s, int &i, bool utf8);
+int  str_length (string s, bool utf8);
+
+/******************************************************************************
+* Reference implementation by lookups of all substrings in a hashmap
+******************************************************************************/
+
+static string
+unpattern (string s) {
+  string r;
+  for (int i=0; i<N(s); ) {
+    while (i<N(s) && is_digit (s[i])) i++;
+    if (i<N(s)) r << s[i++];
+  }
+  return r;
+}
+
+static hashmap<string,string>
+reference_patterns (string name, bool toCork) {
+  string s;
+  load_string (url ("$TEXMACS_PATH/langs/natural/hyphen",
+                    "hyphen." * name), s, true);
+  if (toCork) s= utf8_to_cork (s);
+  hashmap<string,string> patterns ("?");
+  bool flag= false;
+  int i=0, n= N(s);
+  while (i<n) {
+    string buffer;
+    while (i<n && s[i]!=' ' && s[i]!='\t' && s[i]!='\n' && s[i]!='\r') {
+      if (s[i] != '%') buffer << s[i++];
+      else while (i<n && s[i]!='\n') i++;
+    }
+    if (i<n) i++;
+    if (buffer == "}") flag= false;
+    if (flag && N(buffer) != 0) {
+      string norm;
+      for (int j=0; j<N(buffer); j++)
+        if (j+3<N(buffer) && buffer[j]=='^' && buffer[j+1]=='^') {
+          norm << from_hexadecimal (buffer (j+2, j+4));
+          j+=3;
+        }
+        else norm << buffer[j];
+      patterns (unpattern (norm))= norm;
+    }
+    if (buffer == "\\patterns{") flag= true;
+  }
+  return patterns;
+}
+
+static array<int>
+reference_hyphens (string s, hashmap<string,string> patterns, bool utf8) {
+  if (utf8) s= cork_to_utf8 (s);
+  s= "." * locase_all (s) * ".";
+  int i, j, k, l, m, len;
+  array<int> T (str_length (s, utf8)+1);
+  for (i=0; i<N(T); i++) T[i]=0;
+  for (len=1; len < 10; len++)
+    for (i=0, l=0; i<N(s) - len; goto_next_char (s, i, utf8), l++) {
+      string r= patterns [s (i, i+len)];
+      if (!(r == "?"))
+        for (j=0, k=0; j<=len; j++, k++) {
+          if (k<N(r) && is_digit (r[k])) {
+            m= ((int) r[k])-((int) '0');
+            k++;
+          }
+          else m=0;
+          if (l+j<N(T) && m>T[l+j]) T[l+j]=m;
+        }
+    }
+  array<int> penalty (N(T)-4);
+  for (i=2; i < N(T)-4; i++)
+    penalty [i-2]= (((T[i]&1)==1)? HYPH_STD: HYPH_INVALID);
+  if (N(penalty)>0) penalty[0] = penalty[N(penalty)-1] = HYPH_INVALID;
+  if (N(penalty)>1) penalty[1] = penalty[N(penalty)-2] = HYPH_INVALID;
+  if (N(penalty)>2) penalty[N(penalty)-3] = HYPH_INVALID;
+  return penalty;
+}
+
+/******************************************************************************
+* Tests
+******************************************************************************/
+
+static array<string>
+sample_words (string text, bool toCork) {
+  if (toCork) text= utf8_to_cork (text);
+  array<string> r;
+  int i= 0;
+  while (i < N(text)) {
+    int start= i;
+    while (i < N(text) && text[i] != ' ') i++;
+    if (i > start) r << text (start, i);
+    i++;
+  }
+  return r;
+}
+
+static void
+check_language (string name, string text, bool utf8) {
+  hyphen_trie trie;
+  hashmap<string,string> hyphenations ("?");
+  load_hyphen_tables (name, trie, hyphenations, !utf8);
+  hashmap<string,string> ref= reference_patterns (name, !utf8);
+  array<string> words= sample_words (text, true);
+  for (int i=0; i<N(words); i++) {
+    if (hyphenations->contains (utf8? cork_to_utf8 (words[i]): words[i]))
+      continue;
+    array<int> expected= reference_hyphens (words[i], ref, utf8);
+    ASSERT_TRUE (get_hyphens (words[i], trie, hyphenations, utf8) == expected);
+    // second time from the cache of hyphenated words
+    ASSERT_TRUE (get_hyphens (words[i], trie, hyphenations, utf8) == expected);
+  }
+}
+
+TEST (hyphenate, same_as_substring_lookup) {
+  check_language ("us", "hyphenation algorithm typesetting mathematical "
+                  "documents structured editing incomprehensibilities "
+                  "Supercalifragilisticexpialidocious a an the", false);
+  check_language ("german", "Silbentrennung Donaudampfschifffahrt "
+                  "Größenordnung Übermäßig Straße", false);
+  check_language ("russian", "переносы словарь математический "
+                  "документ редактор", true);
+}
+
+TEST (hyphenate, compiled_cache) {
+  // the compiled tables are saved in a scratch home directory
+  url dir= test_dir () * "hyphenate";
+  mkdir (dir * "system" * "cache");
+  string old_home= get_env ("TEXMACS_HOME_PATH");
+  set_env ("TEXMACS_HOME_PATH", as_string (dir));
+  hyphen_trie t1, t2;
+  hashmap<string,string> h1 ("?"), h2 ("?");
+  load_hyphen_tables ("us", t1, h1, true);
+  ASSERT_TRUE (exists (dir * "system" * "cache" * "hyphen.us.cork.bin"));
+  load_hyphen_tables ("us", t2, h2, true);
+  set_env ("TEXMACS_HOME_PATH", old_home);
+  ASSERT_TRUE (t1->first == t2->first);
+  ASSERT_TRUE (t1->value == t2->value);
+  ASSERT_TRUE (t1->label == t2->label);
+  ASSERT_TRUE (t1->weights == t2->weights);
+  ASSERT_TRUE (h1 == h2);
+}
+
+TEST (hyphenate, benchmark) {
+  hyphen_trie trie;
+  hashmap<string,string> hyphenations ("?");
+  load_hyphen_tables ("us", trie, hyphenations, true);
+  hashmap<string,string> ref= reference_patterns ("us", true);
+  array<string> words= sample_words ("hyphenation algorithm typesetting "
+                                     "mathematical documents structured "
+                                     "incomprehensibilities", false);
+  int nr= 2000, wrong= 0;
+  array<array<int> > expected, plain;
+  for (int i=0; i<N(words); i++)
+    plain << reference_hyphens (words[i], ref, false);
+  time_t t0= texmacs_time ();
+  for (int k=0; k<nr; k++)
+    for (int i=0; i<N(words); i++)
+      expected << reference_hyphens (words[i] * as_string (k), ref, false);
+  time_t t1= texmacs_time ();
+  for (int k=0, j=0; k<nr; k++)
+    for (int i=0; i<N(words); i++, j++)
+      if (get_hyphens (words[i] * as_string (k), trie, hyphenations, false)
+          != expected[j]) wrong++;
+  time_t t2= texmacs_time ();
+  for (int k=0; k<nr; k++)
+    for (int i=0; i<N(words); i++)
+      if (get_hyphens (words[i], trie, hyphenations, false) != plain[i])
+        wrong++;
+  time_t t3= texmacs_time ();
+  ASSERT_EQ (wrong, 0);
+  if (DEBUG_BENCH)
+    cout << "substrings: " << (t1-t0) << " ms, trie: " << (t2-t1)
+         << " ms, cached words: " << (t3-t2) << " ms\n";
+}
@@ -0,0 +1,127 @@
+
+/******************************************************************************
+* MODULE     : packrat_parser_test.cpp
+* DESCRIPTION: Tests on the reuse of packrat memo tables across edits
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "packrat.hpp"
+#include "packrat_parser.hpp"
+#include "drd_std.hpp"
+#include "tm_timer.hpp"
+#include "analyze.hpp"
+
+packrat_grammar make_packrat_grammar (string s);
+packrat_parser make_packrat_parser (string lan, tree in);
+packrat_parser make_packrat_parser (string lan, tree in, path in_pos);
+
+static tree
+sym (string s) {
+  return compound ("symbol", s);
+}
+
+static void
+define_test_grammar () {
+  (void) make_packrat_grammar ("test-arith");
+  packrat_define ("test-arith", "Number",
+                  compound ("repeat", compound ("range", "0", "9")));
+  packrat_define ("test-arith", "Atom",
+                  compound ("or", sym ("Number"),
+                            compound ("concat", "(", sym ("Sum"), ")")));
+  packrat_define ("test-arith", "Product",
+                  compound ("concat", sym ("Atom"),
+                            compound ("while",
+                                      compound ("concat", "*", sym ("Atom")))));
+  packrat_define ("test-arith", "Sum",
+                  compound ("concat", sym ("Product"),
+                            compound ("while",
+                                      compound ("concat",
+                                                compound ("or", "+", "-"),
+                                                sym ("Product")))));
+}
+
+static string
+formula (int n) {
+  string s;
+  for (int i=0; i<n; i++) {
+    if (i > 0) s << (i % 3 == 0? "+": "*");
+    s << "(" << as_string (i) << "-" << as_string (i+1) << ")";
+  }
+  return s;
+}
+
+static void
+check_same (packrat_parser par, tree in, path in_pos= path ()) {
+  packrat_grammar gr= find_packrat_grammar ("test-arith");
+  packrat_parser ref (gr, in, in_pos);
+  C names[]= { encode_symbol (sym ("Sum")), encode_symbol (sym ("Product")),
+               encode_symbol (sym ("Atom")), encode_symbol (sym ("Number")) };
+  for (int pos=0; pos<=N(ref->current_input); pos++)
+    for (int i=0; i<4; i++)
+      ASSERT_EQ (par->parse (names[i], pos), ref->parse (names[i], pos));
+}
+
+TEST (packrat_parser, reuse_after_edits) {
+  init_std_drd ();
+  define_test_grammar ();
+  string s= formula (30);
+  tree in (s);
+  ASSERT_TRUE (packrat_correct ("test-arith", "Sum", in));
+  int mid= N(s) / 2;
+  string edits[]= {
+    s (0, mid) * "7" * s (mid, N(s)),
+    s (0, mid) * "(" * s (mid, N(s)),
+    s (0, mid) * s (mid + 3, N(s)),
+    "1+" * s,
+    s * "*2",
+    s (1, N(s)),
+    s
+  };
+  for (int i=0; i<7; i++) {
+    tree t (edits[i]);
+    packrat_parser par= make_packrat_parser ("test-arith", t);
+    (void) par->parse (encode_symbol (sym ("Sum")), 0);
+    check_same (par, t);
+  }
+}
+
+TEST (packrat_parser, cursor) {
+  init_std_drd ();
+  define_test_grammar ();
+  string s= formula (10);
+  tree t (s);
+  path p (5);
+  (void) make_packrat_parser ("test-arith", t);
+  packrat_parser par= make_packrat_parser ("test-arith", t, p);
+  ASSERT_TRUE (par->current_cursor == par->encode_tree_position (p));
+  check_same (par, t, p);
+  ASSERT_TRUE (make_packrat_parser ("test-arith", t, p).operator-> () ==
+               par.operator-> ());
+}
+
+TEST (packrat_parser, benchmark) {
+  init_std_drd ();
+  define_test_grammar ();
+  string s= formula (2000);
+  tree t (s);
+  time_t t0= texmacs_time ();
+  ASSERT_TRUE (packrat_correct ("test-arith", "Sum", t));
+  time_t t1= texmacs_time ();
+  int nr= 20;
+  for (int i=0; i<nr; i++) {
+    int pos= N(s) - 1 - 20 * i;
+    while (!is_digit (s[pos])) pos--;
+    s= s (0, pos) * "1" * s (pos, N(s));
+    ASSERT_TRUE (packrat_correct ("test-arith", "Sum", tree (s)));
+  }
+  time_t t2= texmacs_time ();
+  if (DEBUG_BENCH)
+    cout << "initial parse: " << (t1-t0) << " ms, "
+         << "edit and reparse: " << ((t2-t1) / nr) << " ms\n";
+}
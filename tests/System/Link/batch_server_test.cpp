@@ -0,0 +1,288 @@
+
+/******************************************************************************
+* MODULE     : batch_server_test.cpp
+* DESCRIPTION: Tests on the headless server for batch conversions
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "batch_server.hpp"
+#include "analyze.hpp"
+#include "file.hpp"
+#include "sys_utils.hpp"
+#include "tm_timer.hpp"
+#include "test_dir.hpp"
+
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+static int startups= 0;
+
+static string
+test_handler (array<string> job) {
+  // conversions only check their arguments; other jobs probe the worker
+  if (job[0] == "convert" && N(job) == 3) {
+    if (job[1] == "") return "no input";
+    return "";
+  }
+  if (job[0] == "sleep") {
+    usleep (1000 * as_int (job[1]));
+    return "";
+  }
+  if (job[0] == "pid") return "pid " * as_string ((int) getpid ());
+  if (job[0] == "startups") return "startups " * as_string (startups);
+  if (job[0] == "crash") _exit (1);
+  return "unknown job\n" * job[0];
+}
+
+static string
+socket_name () {
+  return "/tmp/tm-batch-" * as_string ((int) getpid ()) * ".socket";
+}
+
+static int
+connect_client (string name) {
+  int fd= socket (AF_UNIX, SOCK_STREAM, 0);
+  struct sockaddr_un addr;
+  memset (&addr, 0, sizeof (addr));
+  addr.sun_family= AF_UNIX;
+  memcpy (addr.sun_path, &name[0], N(name));
+  if (connect (fd, (struct sockaddr*) &addr, sizeof (addr)) != 0) return -1;
+  return fd;
+}
+
+static void
+send_line (int fd, string s) {
+  s << "\n";
+  (void) ::write (fd, &s[0], N(s));
+}
+
+static string
+receive_line (batch_server_rep* srv, int fd, string& buf) {
+  // run the server until the client received a complete answer
+  time_t t0= texmacs_time ();
+  while (texmacs_time () - t0 < 3000) {
+    int pos= search_forwards ("\n", buf);
+    if (pos >= 0) {
+      string line= buf (0, pos);
+      buf= buf (pos + 1, N(buf));
+      return line;
+    }
+    srv->listen (5);
+    char tmp[1024];
+    int r= ::recv (fd, tmp, sizeof (tmp), MSG_DONTWAIT);
+    if (r > 0) buf << string (tmp, r);
+  }
+  return "timeout";
+}
+
+TEST (batch_server, jobs) {
+  batch_server_rep srv (socket_name (), 2, test_handler);
+  ASSERT_TRUE (srv.start () == "ok");
+  int fd= connect_client (socket_name ());
+  ASSERT_GE (fd, 0);
+  string buf;
+  for (int i=0; i<6; i++)
+    send_line (fd, "convert\tin" * as_string (i) * ".tm\tout.pdf");
+  int queued= 0, done= 0;
+  for (int i=0; i<12; i++) {
+    array<string> a= tokenize (receive_line (&srv, fd, buf), "\t");
+    if (a[0] == "queued") queued++;
+    else if (a[0] == "done") {
+      ASSERT_EQ (N(a), 5);
+      done++;
+    }
+    else FAIL () << "unexpected answer";
+  }
+  ASSERT_EQ (queued, 6);
+  ASSERT_EQ (done, 6);
+  send_line (fd, "status");
+  ASSERT_TRUE (starts (receive_line (&srv, fd, buf), "status\t0\t0\t2\t6\t0"));
+  send_line (fd, "quit");
+  ASSERT_TRUE (receive_line (&srv, fd, buf) == "bye");
+  ASSERT_FALSE (srv.alive);
+  ::close (fd);
+}
+
+TEST (batch_server, failures) {
+  batch_server_rep srv (socket_name (), 1, test_handler);
+  ASSERT_TRUE (srv.start () == "ok");
+  int fd= connect_client (socket_name ());
+  string buf;
+  send_line (fd, "convert\t\tout.pdf");
+  ASSERT_TRUE (starts (receive_line (&srv, fd, buf), "queued\t1"));
+  array<string> a= tokenize (receive_line (&srv, fd, buf), "\t");
+  ASSERT_TRUE (a[0] == "failed" && a[3] == "no input");
+  send_line (fd, "frobnicate");
+  (void) receive_line (&srv, fd, buf);
+  a= tokenize (receive_line (&srv, fd, buf), "\t");
+  ASSERT_TRUE (a[0] == "failed" && a[3] == "unknown job frobnicate");
+  // a crashing worker is replaced
+  send_line (fd, "crash");
+  (void) receive_line (&srv, fd, buf);
+  a= tokenize (receive_line (&srv, fd, buf), "\t");
+  ASSERT_TRUE (a[0] == "failed" && a[3] == "worker died");
+  send_line (fd, "convert\tin.tm\tout.pdf");
+  (void) receive_line (&srv, fd, buf);
+  ASSERT_TRUE (starts (receive_line (&srv, fd, buf), "done\t4"));
+  ::close (fd);
+  srv.stop ();
+}
+
+TEST (batch_server, warm_workers) {
+  // workers are forked once and keep their state between jobs
+  startups++;
+  batch_server_rep srv (socket_name (), 1, test_handler);
+  ASSERT_TRUE (srv.start () == "ok");
+  startups++;
+  int fd= connect_client (socket_name ());
+  string buf;
+  array<string> pids;
+  for (int i=0; i<3; i++) {
+    send_line (fd, "pid");
+    (void) receive_line (&srv, fd, buf);
+    pids << tokenize (receive_line (&srv, fd, buf), "\t") [3];
+  }
+  ASSERT_TRUE (pids[0] == pids[1] && pids[1] == pids[2]);
+  ASSERT_TRUE (pids[0] != "pid " * as_string ((int) getpid ()));
+  send_line (fd, "startups");
+  (void) receive_line (&srv, fd, buf);
+  ASSERT_TRUE (tokenize (receive_line (&srv, fd, buf), "\t") [3] ==
+               "startups 1");
+  ::close (fd);
+  srv.stop ();
+}
+
+TEST (batch_server, queue_depth) {
+  batch_server_rep srv (socket_name (), 1, test_handler);
+  ASSERT_TRUE (srv.start () == "ok");
+  int fd= connect_client (socket_name ());
+  string buf;
+  for (int i=0; i<3; i++) send_line (fd, "sleep\t100");
+  for (int i=0; i<3; i++)
+    ASSERT_TRUE (starts (receive_line (&srv, fd, buf), "queued"));
+  send_line (fd, "status");
+  ASSERT_TRUE (starts (receive_line (&srv, fd, buf), "status\t2\t1\t1\t0"));
+  array<string> a= tokenize (receive_line (&srv, fd, buf), "\t");
+  ASSERT_TRUE (a[0] == "done");
+  ASSERT_GE (as_int (a[3]), 90);
+  ASSERT_EQ (as_int (a[4]), 2);
+  a= tokenize (receive_line (&srv, fd, buf), "\t");
+  ASSERT_GE (as_int (a[2]), 90);
+  ASSERT_EQ (as_int (a[4]), 1);
+  ::close (fd);
+  srv.stop ();
+}
+
+static string
+receive_answer (int fd, string& buf, int msecs) {
+  // wait for a complete answer of a server in another process
+  time_t t0= texmacs_time ();
+  while (texmacs_time () - t0 < msecs) {
+    int pos= search_forwards ("\n", buf);
+    if (pos >= 0) {
+      string line= buf (0, pos);
+      buf= buf (pos + 1, N(buf));
+      return line;
+    }
+    struct pollfd pfd;
+    pfd.fd= fd;
+    pfd.events= POLLIN;
+    if (poll (&pfd, 1, 100) <= 0) continue;
+    char tmp[1024];
+    int r= ::recv (fd, tmp, sizeof (tmp), 0);
+    if (r <= 0) return "closed";
+    buf << string (tmp, r);
+  }
+  return "timeout";
+}
+
+struct daemon_process {
+  // make sure that the daemon does not survive failing tests
+  int pid;
+  daemon_process (int pid2): pid (pid2) {}
+  ~daemon_process () {
+    time_t t0= texmacs_time ();
+    while (waitpid (pid, NULL, WNOHANG) == 0) {
+      if (texmacs_time () - t0 > 10000) {
+        kill (pid, SIGKILL);
+        (void) waitpid (pid, NULL, 0);
+        break;
+      }
+      usleep (10000);
+    }
+  }
+};
+
+TEST (batch_server, conversion) {
+  // a real conversion by a TeXmacs daemon, if the binary has been built
+  string bin= get_env ("TEXMACS_BINARY");
+  if (bin == "" || !exists (url_system (bin))) return;
+  url dir= test_dir ();
+  url in= dir * "daemon.tm", out= dir * "daemon.html";
+  remove (out);
+  ASSERT_FALSE (save_string (in,
+    "<TeXmacs|2.1>\n\n<style|generic>\n\n"
+    "<\\body>\n  Converted by the daemon\n</body>\n"));
+  c_string _bin (bin), _name (socket_name ());
+  int pid= fork ();
+  if (pid == 0) {
+    set_env ("TEXMACS_HOME_PATH", as_string (dir * "home"));
+    if (freopen ("/dev/null", "w", stdout) == NULL) _exit (1);
+    execl (_bin, _bin, "-daemon", (char*) _name, "-workers", "1",
+           (char*) NULL);
+    _exit (1);
+  }
+  daemon_process daemon (pid);
+  int fd= -1;
+  time_t t0= texmacs_time ();
+  while (fd < 0 && texmacs_time () - t0 < 60000) {
+    usleep (100000);
+    fd= connect_client (socket_name ());
+    if (waitpid (pid, NULL, WNOHANG) != 0) break;
+  }
+  ASSERT_GE (fd, 0);
+  string buf;
+  send_line (fd, "convert\t" * as_string (in) * "\t" * as_string (out));
+  ASSERT_TRUE (starts (receive_answer (fd, buf, 5000), "queued\t1"));
+  array<string> a= tokenize (receive_answer (fd, buf, 60000), "\t");
+  ASSERT_TRUE (a[0] == "done");
+  string html;
+  ASSERT_FALSE (load_string (out, html, false));
+  ASSERT_GE (search_forwards ("Converted by the daemon", html), 0);
+  send_line (fd, "quit");
+  ASSERT_TRUE (receive_answer (fd, buf, 5000) == "bye");
+  ::close (fd);
+}
+
+TEST (batch_server, benchmark) {
+  // throughput for short jobs against the number of workers
+  int sizes[]= { 1, 4 };
+  for (int s=0; s<2; s++) {
+    batch_server_rep srv (socket_name (), sizes[s], test_handler);
+    ASSERT_TRUE (srv.start () == "ok");
+    int fd= connect_client (socket_name ());
+    string buf;
+    int nr= 40;
+    time_t t0= texmacs_time ();
+    for (int i=0; i<nr; i++) send_line (fd, "sleep\t5");
+    for (int i=0; i<2*nr; i++) (void) receive_line (&srv, fd, buf);
+    time_t t1= texmacs_time ();
+    ASSERT_EQ (srv.done, nr);
+    if (DEBUG_BENCH)
+      cout << sizes[s] << " workers: " << nr << " jobs in "
+           << (t1-t0) << " ms\n";
+    ::close (fd);
+    srv.stop ();
+  }
+}
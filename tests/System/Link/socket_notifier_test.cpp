@@ -0,0 +1,204 @@
+
+/******************************************************************************
+* MODULE     : socket_notifier_test.cpp
+* DESCRIPTION: Stress tests on notifiers for many pipes and sockets
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "socket_notifier.hpp"
+#include "tm_link.hpp"
+#include "tm_timer.hpp"
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+
+#define NR_LINKS 400
+#define NR_PLUGINS 40
+
+struct test_link {
+  int  fd[2];           // read and write end
+  int  received;        // number of bytes read so far
+  socket_notifier sn;
+};
+
+static test_link links[2*NR_LINKS];
+
+static void
+drain_callback (void* obj, void* info) {
+  (void) info;
+  test_link* l= (test_link*) obj;
+  char buf[256];
+  while (true) {
+    int r= ::read (l->fd[0], buf, 256);
+    if (r <= 0) break;
+    l->received += r;
+  }
+}
+
+static int
+open_links () {
+  struct rlimit rl;
+  getrlimit (RLIMIT_NOFILE, &rl);
+  if (rl.rlim_cur < rl.rlim_max) {
+    rl.rlim_cur= rl.rlim_max;
+    setrlimit (RLIMIT_NOFILE, &rl);
+  }
+  int n= 0;
+  for (int i=0; i<2*NR_LINKS; i++) {
+    int r= (i < NR_LINKS? pipe (links[i].fd):
+                          socketpair (AF_UNIX, SOCK_STREAM, 0, links[i].fd));
+    if (r != 0) break;
+    fcntl (links[i].fd[0], F_SETFL, O_NONBLOCK);
+    links[i].received= 0;
+    links[i].sn= socket_notifier (links[i].fd[0], &drain_callback,
+                                  (void*) &links[i], NULL, (i & 1) == 1);
+    add_notifier (links[i].sn);
+    n++;
+  }
+  return n;
+}
+
+static void
+close_links (int n) {
+  for (int i=0; i<n; i++) {
+    remove_notifier (links[i].sn);
+    links[i].sn= socket_notifier ();
+    close (links[i].fd[0]);
+    close (links[i].fd[1]);
+  }
+}
+
+TEST (socket_notifier, many_links) {
+  int n= open_links ();
+  ASSERT_GT (n, 2*NR_LINKS / 4);
+  bool beyond_fd_setsize= false;
+  for (int i=0; i<n; i++)
+    if (links[i].fd[0] >= FD_SETSIZE) beyond_fd_setsize= true;
+  time_t t0= texmacs_time ();
+  int rounds= 20;
+  for (int k=0; k<rounds; k++) {
+    for (int i=k%3; i<n; i+=3)
+      ASSERT_EQ (::write (links[i].fd[1], "0123456789", 10), 10);
+    perform_select ();
+  }
+  time_t t1= texmacs_time ();
+  for (int i=0; i<n; i++) {
+    int expected= 0;
+    for (int k=0; k<rounds; k++)
+      if (i%3 == k%3) expected += 10;
+    ASSERT_EQ (links[i].received, expected);
+  }
+  if (DEBUG_BENCH)
+    cout << n << " links" << (beyond_fd_setsize? " (beyond FD_SETSIZE)": "")
+         << ", " << rounds << " rounds in " << (t1-t0) << " ms\n";
+
+  // removed notifiers are no longer called
+  for (int i=0; i<n; i+=2) remove_notifier (links[i].sn);
+  for (int i=0; i<n; i++)
+    ASSERT_EQ (::write (links[i].fd[1], "x", 1), 1);
+  perform_select ();
+  for (int i=0; i<n; i++) {
+    int expected= 10 * ((rounds + 2 - (i%3)) / 3);
+    ASSERT_EQ (links[i].received, expected + (i%2));
+  }
+  close_links (n);
+}
+
+TEST (socket_notifier, latency_statistics) {
+  debug_set ("bench", true);
+  int fd[2];
+  ASSERT_EQ (pipe (fd), 0);
+  fcntl (fd[0], F_SETFL, O_NONBLOCK);
+  test_link l;
+  l.fd[0]= fd[0]; l.fd[1]= fd[1]; l.received= 0;
+  l.sn= socket_notifier (fd[0], &drain_callback, (void*) &l, NULL);
+  add_notifier (l.sn);
+  for (int k=0; k<5; k++) {
+    ASSERT_EQ (::write (fd[1], "abc", 3), 3);
+    perform_select ();
+  }
+  ASSERT_EQ (l.received, 15);
+  ASSERT_EQ (l.sn->nr_events, 5);
+  ASSERT_GE (l.sn->max_latency, 0);
+  // the latency is counted from the previous check, not from the dispatch
+  perform_select ();
+  ASSERT_EQ (::write (fd[1], "abc", 3), 3);
+  usleep (20000);
+  perform_select ();
+  ASSERT_EQ (l.sn->nr_events, 6);
+  ASSERT_GE (l.sn->max_latency, 20000);
+  remove_notifier (l.sn);
+  debug_set ("bench", false);
+  close (fd[0]);
+  close (fd[1]);
+}
+
+/******************************************************************************
+* Plugins which are connected through pipe links
+******************************************************************************/
+
+struct test_plugin {
+  tm_link ln;
+  string  received;
+};
+
+static test_plugin plugins[NR_PLUGINS];
+
+static void
+plugin_callback (void* obj, void* info) {
+  // reads the output like connection_rep::listen does
+  (void) info;
+  test_plugin* p= (test_plugin*) obj;
+  p->received << p->ln->read (LINK_OUT);
+}
+
+static string
+plugin_output (int i, int n) {
+  string r;
+  for (int k=0; k<n; k++)
+    r << "plugin " << as_string (i) << ", line " << as_string (k) << "\n";
+  return r;
+}
+
+TEST (socket_notifier, pipe_links) {
+  // the plugins write their output in several bursts and then exit
+  int n= 200;
+  time_t t0= texmacs_time ();
+  for (int i=0; i<NR_PLUGINS; i++) {
+    string cmd= "i=0; while [ $i -lt " * as_string (n) * " ]; do "
+                "echo \"plugin " * as_string (i) * ", line $i\"; "
+                "if [ $((i % 50)) = 0 ]; then sleep 0.01; fi; "
+                "i=$((i+1)); done";
+    plugins[i].ln= make_pipe_link (cmd);
+    plugins[i].received= "";
+    plugins[i].ln->set_command (command (plugin_callback, &plugins[i]));
+    ASSERT_EQ (plugins[i].ln->start (), string ("ok"));
+  }
+  time_t t1= texmacs_time ();
+  while (texmacs_time () - t1 < 4000) {
+    perform_select ();
+    bool done= true;
+    for (int i=0; i<NR_PLUGINS; i++)
+      if (plugins[i].ln->alive) done= false;
+    if (done) break;
+    usleep (1000);
+  }
+  time_t t2= texmacs_time ();
+  for (int i=0; i<NR_PLUGINS; i++) {
+    ASSERT_FALSE (plugins[i].ln->alive);
+    ASSERT_TRUE (plugins[i].received == plugin_output (i, n));
+    plugins[i].ln= tm_link ();
+  }
+  if (DEBUG_BENCH)
+    cout << NR_PLUGINS << " plugins started in " << (t1-t0)
+         << " ms, output received in " << (t2-t1) << " ms\n";
+}
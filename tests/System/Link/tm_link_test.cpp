@@ -0,0 +1,198 @@
+
+/******************************************************************************
+* MODULE     : tm_link_test.cpp
+* DESCRIPTION: Tests on the framed protocol for plugin output
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "hashmap.hpp"
+#include "tm_link.hpp"
+#include "Generic/input.hpp"
+#include "tm_timer.hpp"
+#include "socket_notifier.hpp"
+
+#include <unistd.h>
+#include <sys/wait.h>
+
+static string
+escaped (string s) {
+  string r;
+  for (int i=0; i<N(s); i++) {
+    if (s[i] == DATA_BEGIN || s[i] == DATA_END ||
+        s[i] == DATA_ESCAPE || s[i] == DATA_ABORT)
+      r << DATA_ESCAPE;
+    r << s[i];
+  }
+  return r;
+}
+
+static string
+escaped_session (string prompt, string body, string format= "verbatim") {
+  string r;
+  r << DATA_BEGIN << format << ":" << escaped (body)
+    << DATA_BEGIN << "prompt#" << escaped (prompt) << DATA_END
+    << DATA_END;
+  return r;
+}
+
+static string
+framed_session (string prompt, string body, string format= "verbatim") {
+  string r= FRAMES_HANDSHAKE;
+  r << data_frame (FRAME_BEGIN, format * ":")
+    << data_frame (FRAME_DATA, body)
+    << data_frame (FRAME_BEGIN, "prompt#")
+    << data_frame (FRAME_DATA, prompt)
+    << data_frame (FRAME_END, "")
+    << data_frame (FRAME_END, "");
+  return r;
+}
+
+static bool
+feed (texmacs_input tm_in, string s, int chunk) {
+  bool done= false;
+  for (int i=0; i<N(s); i+=chunk)
+    if (tm_in->put (s (i, min (i+chunk, N(s))))) done= true;
+  return done;
+}
+
+static string
+sample_output (int lines) {
+  string s;
+  for (int i=0; i<lines; i++)
+    s << "line " << as_string (i) << " of the output\n";
+  return s;
+}
+
+TEST (tm_link, data_frame) {
+  string f= data_frame (FRAME_DATA, "hello");
+  ASSERT_EQ (N(f), FRAME_HEADER_SIZE + 5);
+  ASSERT_EQ (data_frame_length (f, 0), N(f));
+  ASSERT_EQ (data_frame_length (f (0, N(f)-1), 0), -1);
+  ASSERT_EQ (data_frame_length (f (0, 3), 0), -1);
+  string big (70000);
+  for (int i=0; i<N(big); i++) big[i]= (char) (i & 255);
+  string g= data_frame (FRAME_DATA, big);
+  ASSERT_EQ (data_frame_length (g, 0), N(g));
+  ASSERT_TRUE (g (FRAME_HEADER_SIZE, N(g)) == big);
+}
+
+TEST (tm_link, framed_same_as_escaped) {
+  string body= sample_output (20);
+  body << "special " << DATA_BEGIN << DATA_ESCAPE << " characters\n";
+  int chunks[]= { 1, 3, 7, 100, 100000 };
+  for (int k=0; k<5; k++) {
+    texmacs_input t1 ("output"), t2 ("output");
+    t2->accept_frames ();
+    ASSERT_TRUE (feed (t1, escaped_session ("> ", body), chunks[k]));
+    ASSERT_TRUE (feed (t2, framed_session ("> ", body), chunks[k]));
+    ASSERT_TRUE (t1->get ("output") == t2->get ("output"));
+    ASSERT_TRUE (t1->get ("prompt") == t2->get ("prompt"));
+  }
+}
+
+TEST (tm_link, old_plugins) {
+  // plugins which do not answer the handshake are read as usual
+  string body= sample_output (5);
+  texmacs_input t1 ("output"), t2 ("output");
+  t2->accept_frames ();
+  ASSERT_TRUE (feed (t1, escaped_session ("> ", body), 2));
+  ASSERT_TRUE (feed (t2, escaped_session ("> ", body), 2));
+  ASSERT_TRUE (t1->get ("output") == t2->get ("output"));
+  texmacs_input t3 ("output");
+  t3->accept_frames ();
+  ASSERT_FALSE (t3->put (string ("\002")));
+  t3->eof ();
+  texmacs_input t4 ("output");
+  t4->accept_frames ();
+  ASSERT_FALSE (t4->put (string ("plain text\n")));
+  ASSERT_TRUE (t4->get ("output") != "");
+}
+
+static time_t
+echo_plugin (string session, texmacs_input tm_in) {
+  // a local plugin which writes a prepared session to a pipe
+  int fd[2];
+  if (pipe (fd) != 0) return -1;
+  time_t t0= texmacs_time ();
+  int pid= fork ();
+  if (pid == 0) {
+    close (fd[0]);
+    int i= 0, n= N(session);
+    while (i < n) {
+      int r= ::write (fd[1], &session[i], min (n - i, 65536));
+      if (r <= 0) break;
+      i += r;
+    }
+    _exit (0);
+  }
+  close (fd[1]);
+  char buf[16384];
+  while (true) {
+    int r= ::read (fd[0], buf, 16384);
+    if (r <= 0) break;
+    (void) tm_in->put (string (buf, r));
+  }
+  close (fd[0]);
+  waitpid (pid, NULL, 0);
+  return texmacs_time () - t0;
+}
+
+struct throttled_plugin {
+  tm_link ln;
+  int     received;
+};
+
+static void
+throttled_callback (void* obj, void* info) {
+  // only consume the output once pipe_link stopped reading it,
+  // after the plugin has written the remaining output and exited
+  (void) info;
+  throttled_plugin* p= (throttled_plugin*) obj;
+  if (N (p->ln->watch (LINK_OUT)) >= (1 << 22)) usleep (20000);
+  else if (p->ln->alive) return;
+  p->received += N (p->ln->read (LINK_OUT));
+}
+
+TEST (tm_link, throttled_pipe_link) {
+  // a little more output than the buffer limit of pipe links
+  int total= (1 << 22) + 32768;
+  throttled_plugin p;
+  p.ln= make_pipe_link ("head -c " * as_string (total) * " /dev/zero");
+  p.received= 0;
+  p.ln->set_command (command (throttled_callback, &p));
+  ASSERT_EQ (p.ln->start (), string ("ok"));
+  time_t t0= texmacs_time ();
+  while (p.received < total && texmacs_time () - t0 < 4000) {
+    perform_select ();
+    usleep (1000);
+  }
+  ASSERT_EQ (p.received, total);
+  ASSERT_FALSE (p.ln->alive);
+}
+
+TEST (tm_link, benchmark) {
+  // large binary output inside a block which is still open, so that
+  // we only measure the transfer and not the conversion to a tree
+  string body (1 << 22);
+  for (int i=0; i<N(body); i++) body[i]= (char) ((i * 7 + (i >> 9)) & 255);
+  string escaped_block, framed_block= FRAMES_HANDSHAKE;
+  escaped_block << DATA_BEGIN << "scheme:" << escaped (body);
+  framed_block << data_frame (FRAME_BEGIN, "scheme:");
+  for (int i=0; i<N(body); i+=(1 << 20))
+    framed_block << data_frame (FRAME_DATA, body (i, i + (1 << 20)));
+  texmacs_input t1 ("output"), t2 ("output");
+  t2->accept_frames ();
+  time_t d1= echo_plugin (escaped_block, t1);
+  time_t d2= echo_plugin (framed_block, t2);
+  ASSERT_TRUE (t1->buf == body);
+  ASSERT_TRUE (t2->buf == body);
+  if (DEBUG_BENCH)
+    cout << N(body) << " bytes, escaped: " << d1 << " ms, "
+         << "framed: " << d2 << " ms\n";
+}
@@ -0,0 +1,95 @@
+
+/******************************************************************************
+* MODULE     : new_buffer_test.cpp
+* DESCRIPTION: Tests on the registry of buffers
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "tm_data.hpp"
+#include "drd_std.hpp"
+#include "tm_timer.hpp"
+
+extern tree the_et;
+string propose_title (string old_title, url u, tree doc);
+
+static url
+doc_name (string dir, int i) {
+  return url ("/tmp") * dir * ("doc" * as_string (i) * ".tm");
+}
+
+static bool
+buffer_exists (url name) {
+  return !is_nil (concrete_buffer (name));
+}
+
+static tree
+make_document (string s) {
+  return tree (DOCUMENT, compound ("body", tree (DOCUMENT, s)));
+}
+
+static void
+create_buffers (string dir, int n) {
+  init_std_drd ();
+  if (!is_tuple (the_et)) the_et= tuple ();
+  for (int i=0; i<n; i++)
+    set_buffer_tree (doc_name (dir, i), make_document (as_string (i)));
+}
+
+/******************************************************************************
+* Tests
+******************************************************************************/
+
+TEST (new_buffer, lookups) {
+  create_buffers ("a", 10);
+  create_buffers ("b", 10);
+  url u= doc_name ("a", 3);
+  ASSERT_TRUE (get_buffer_body (u) == tree (DOCUMENT, "3"));
+  ASSERT_TRUE (buffer_exists (u));
+  ASSERT_FALSE (buffer_exists (doc_name ("a", 10)));
+  // new titles differ from the titles of the open buffers
+  ASSERT_TRUE (get_title_buffer (doc_name ("a", 5)) == "doc5.tm");
+  ASSERT_TRUE (propose_title ("", doc_name ("c", 5), "") == "doc5.tm (2)");
+  set_title_buffer (doc_name ("b", 5), "doc5.tm (2)");
+  ASSERT_TRUE (propose_title ("", doc_name ("c", 5), "") == "doc5.tm (3)");
+  // the buffers are found back from paths inside their documents
+  tm_buffer buf= concrete_buffer (u);
+  ASSERT_TRUE (path_to_buffer (buf->rp * path (0, 0)) == u);
+  ASSERT_TRUE (is_none (path_to_buffer (path ())));
+  // renamed buffers are only found under their new names
+  url v= doc_name ("c", 3);
+  rename_buffer (u, v);
+  ASSERT_FALSE (buffer_exists (u));
+  ASSERT_TRUE (get_buffer_body (v) == tree (DOCUMENT, "3"));
+  ASSERT_TRUE (path_to_buffer (buf->rp * 0) == v);
+  // the titles of removed buffers become available again
+  remove_buffer (doc_name ("a", 5));
+  ASSERT_FALSE (buffer_exists (doc_name ("a", 5)));
+  ASSERT_TRUE (propose_title ("", doc_name ("c", 5), "") == "doc5.tm");
+}
+
+TEST (new_buffer, benchmark) {
+  // a session with many open buffers
+  int n= 3000;
+  array<url> names;
+  for (int i=0; i<n; i++) names << doc_name ("many", i);
+  time_t t0= texmacs_time ();
+  create_buffers ("many", n);
+  time_t t1= texmacs_time ();
+  for (int k=0; k<10; k++)
+    for (int i=0; i<n; i++)
+      ASSERT_FALSE (is_nil (concrete_buffer (names[i])));
+  time_t t2= texmacs_time ();
+  for (int i=0; i<n; i+=2) remove_buffer (names[i]);
+  time_t t3= texmacs_time ();
+  ASSERT_FALSE (buffer_exists (doc_name ("many", n-2)));
+  ASSERT_TRUE (buffer_exists (doc_name ("many", n-1)));
+  if (DEBUG_BENCH)
+    cout << n << " buffers: creation " << (t1-t0) << " ms, lookups "
+         << (t2-t1) << " ms, removals " << (t3-t2) << " ms\n";
+}
@@ -0,0 +1,140 @@
+
+/******************************************************************************
+* MODULE     : box_index_test.cpp
+* DESCRIPTION: Tests on spatial indices over the children of boxes
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "Boxes/composite.hpp"
+#include "Boxes/construct.hpp"
+#include "tm_timer.hpp"
+#include <math.h>
+
+static unsigned int seed= 12345;
+
+static int
+random_int (int n) {
+  seed= seed * 1103515245 + 12345;
+  return (int) ((seed >> 8) % ((unsigned int) n));
+}
+
+static box
+random_composite (int n, bool grid) {
+  // children are laid out on a grid or scattered with overlaps;
+  // every seventh child is a decoration
+  array<box> bs (n);
+  array<SI>  x (n), y (n);
+  int cols= 1;
+  while (cols * cols < n) cols++;
+  for (int i=0; i<n; i++) {
+    path ip= (i % 7 == 3? path (-1): path (i));
+    SI w= 100 + random_int (900), h= 100 + random_int (900);
+    bs[i]= empty_box (ip, 0, 0, w, h);
+    if (grid) { x[i]= 1000 * (i % cols); y[i]= -1000 * (i / cols); }
+    else { x[i]= random_int (1000 * cols); y[i]= -random_int (1000 * cols); }
+  }
+  return composite_box (path (), bs, x, y, true);
+}
+
+static composite_box_rep*
+composite (box b) {
+  return (composite_box_rep*) b.operator-> ();
+}
+
+static int
+linear_find_child (box b, SI x, SI y, SI delta, bool force) {
+  int i, n= N(b), d= MAX_SI, m= -1;
+  for (i=0; i<n; i++)
+    if (b->distance (i, x, y, delta) < d)
+      if (b[i]->accessible () || force) {
+        d= b->distance (i, x, y, delta);
+        m= i;
+      }
+  return m;
+}
+
+TEST (box_index, find_child) {
+  bool grids[]= { true, false };
+  for (int g=0; g<2; g++) {
+    box b= random_composite (500, grids[g]);
+    composite_box_rep* c= composite (b);
+    for (int k=0; k<2000; k++) {
+      SI x= random_int (25000) - 1000, y= -random_int (25000) + 1000;
+      SI delta= random_int (3) - 1;
+      bool force= (k & 1) == 0;
+      if (k % 5 == 0) x= b->sx1 (random_int (500));
+      ASSERT_EQ (c->nearest_child (x, y, delta, force),
+                 linear_find_child (b, x, y, delta, force));
+    }
+  }
+}
+
+TEST (box_index, near_and_meeting) {
+  box b= random_composite (400, false);
+  composite_box_rep* c= composite (b);
+  for (int k=0; k<200; k++) {
+    SI x= random_int (20000), y= -random_int (20000);
+    SI dist= random_int (3000);
+    array<int> r1= c->children_near (x, y, dist), r2;
+    for (int i=0; i<N(b); i++)
+      if (b[i]->graphical_distance (x - b->sx (i), y - b->sy (i)) <= dist)
+        r2 << i;
+    // the index may return children at a larger euclidean distance
+    int j= 0;
+    for (int i=0; i<N(r1) && j<N(r2); i++)
+      if (r1[i] == r2[j]) j++;
+    ASSERT_EQ (j, N(r2));
+    SI x2= x + random_int (5000), y2= y + random_int (5000);
+    array<int> s1= c->children_meeting (x, y, x2, y2), s2;
+    for (int i=0; i<N(b); i++)
+      if (b->sx2 (i) >= x && b->sx1 (i) <= x2 &&
+          b->sy2 (i) >= y && b->sy1 (i) <= y2) s2 << i;
+    ASSERT_TRUE (s1 == s2);
+  }
+}
+
+TEST (box_index, invalidation) {
+  box b= random_composite (100, true);
+  composite_box_rep* c= composite (b);
+  ASSERT_EQ (c->nearest_child (50, -50, 0, true), 0);
+  c->insert (empty_box (path (100), 0, 0, 100, 100), -5000, 5000);
+  ASSERT_EQ (c->nearest_child (-4950, 5050, 0, true), 100);
+}
+
+TEST (box_index, benchmark) {
+  // pointer query latency against the number of children
+  int sizes[]= { 100, 1000, 10000, 30000 };
+  for (int s=0; s<4; s++) {
+    box b= random_composite (sizes[s], true);
+    composite_box_rep* c= composite (b);
+    SI ext= 1000 * (int) sqrt ((double) sizes[s]);
+    int nr1= 200, nr2= 2000;
+    array<SI> xs, ys;
+    array<int> r1, r2;
+    for (int k=0; k<nr2; k++) {
+      xs << random_int (ext);
+      ys << -random_int (ext);
+    }
+    time_t t0= texmacs_time ();
+    for (int k=0; k<nr1; k++)
+      r1 << linear_find_child (b, xs[k], ys[k], 0, false);
+    time_t t1= texmacs_time ();
+    (void) c->index ();
+    time_t t2= texmacs_time ();
+    for (int k=0; k<nr2; k++)
+      r2 << c->nearest_child (xs[k], ys[k], 0, false);
+    time_t t3= texmacs_time ();
+    for (int k=0; k<nr1; k++)
+      ASSERT_EQ (r2[k], r1[k]);
+    if (DEBUG_BENCH)
+      cout << sizes[s] << " children: linear " << (1000 * (t1-t0) / nr1)
+           << " us, indexed " << (1000 * (t3-t2) / nr2) << " us per query, "
+           << "index built in " << (t2-t1) << " ms\n";
+  }
+}
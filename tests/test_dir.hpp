@@ -0,0 +1,51 @@
+
+/******************************************************************************
+* MODULE     : test_dir.hpp
+* DESCRIPTION: Private temporary directory for the tests
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#ifndef TEST_DIR_H
+#define TEST_DIR_H
+#include "file.hpp"
+#include "sys_utils.hpp"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+static int test_dir_owner= 0;
+
+static void
+remove_test_dir () {
+  // forked children exit too, but the directory belongs to the parent
+  if (test_dir_owner != (int) getpid ()) return;
+  url dir= url_system ("/tmp/texmacs-test-" * as_string (test_dir_owner));
+  system ("rm -rf", dir);
+}
+
+inline url
+test_dir () {
+  // one directory per test process, which is removed at exit
+  if (test_dir_owner == 0) {
+    test_dir_owner= (int) getpid ();
+    atexit (remove_test_dir);
+  }
+  url dir= url_system ("/tmp/texmacs-test-" * as_string (test_dir_owner));
+  mkdir (dir);
+  return dir;
+}
+
+inline url
+test_home () {
+  // the tests run without booting TeXmacs, so the home directory,
+  // which contains the temporary directory, may be undefined;
+  // we also keep the caches of the tests out of the user's home
+  set_env ("TEXMACS_HOME_PATH", as_string (test_dir ()));
+  return url_temp_dir ();
+}
+
+#endif // defined TEST_DIR_H